@@ -59,6 +59,8 @@ struct CPUInfo
   bool bFP = false;
   bool bASIMD = false;
   bool bCRC32 = false;
+
+  // x86 SHA extensions or ARMv8 crypto extensions
   bool bSHA1 = false;
   bool bSHA2 = false;
 
@@ -2,38 +2,198 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <array>
 #include <mbedtls/aes.h>
+#include <memory>
 
+#include "Common/CPUDetect.h"
 #include "Common/Crypto/AES.h"
+#include "Common/Intrinsics.h"
 
 namespace Common
 {
 namespace AES
 {
-std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size, Mode mode)
+namespace
 {
-  mbedtls_aes_context aes_ctx;
-  std::vector<u8> buffer(size);
+class ContextGeneric final : public Context
+{
+public:
+  ContextGeneric(const u8* key, Mode mode) : m_mode(mode)
+  {
+    mbedtls_aes_init(&m_context);
+    if (mode == Mode::Encrypt)
+      mbedtls_aes_setkey_enc(&m_context, key, 128);
+    else
+      mbedtls_aes_setkey_dec(&m_context, key, 128);
+  }
+
+  ~ContextGeneric() { mbedtls_aes_free(&m_context); }
+
+  bool Crypt(u8* iv, const u8* src, u8* dst, size_t size) const override
+  {
+    const int mode = m_mode == Mode::Encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+    return mbedtls_aes_crypt_cbc(&m_context, mode, size, iv, src, dst) == 0;
+  }
+
+private:
+  // mbedtls doesn't modify the context when crypting, but doesn't take it as const either.
+  mutable mbedtls_aes_context m_context;
+  Mode m_mode;
+};
+
+#if defined(_M_X86_64)
+
+template <int rcon>
+FUNCTION_TARGET_AES static __m128i ExpandKey(__m128i key)
+{
+  __m128i assist = _mm_aeskeygenassist_si128(key, rcon);
+  assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+class ContextAESNI final : public Context
+{
+public:
+  FUNCTION_TARGET_AES ContextAESNI(const u8* key, Mode mode) : m_mode(mode)
+  {
+    std::array<__m128i, NUM_ROUND_KEYS> keys;
+    keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    keys[1] = ExpandKey<0x01>(keys[0]);
+    keys[2] = ExpandKey<0x02>(keys[1]);
+    keys[3] = ExpandKey<0x04>(keys[2]);
+    keys[4] = ExpandKey<0x08>(keys[3]);
+    keys[5] = ExpandKey<0x10>(keys[4]);
+    keys[6] = ExpandKey<0x20>(keys[5]);
+    keys[7] = ExpandKey<0x40>(keys[6]);
+    keys[8] = ExpandKey<0x80>(keys[7]);
+    keys[9] = ExpandKey<0x1B>(keys[8]);
+    keys[10] = ExpandKey<0x36>(keys[9]);
+
+    if (mode == Mode::Encrypt)
+    {
+      m_round_keys = keys;
+      return;
+    }
 
-  if (mode == Mode::Encrypt)
-    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-  else
-    mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
+    // The equivalent inverse cipher uses the round keys in reverse, with InvMixColumns applied
+    // to all but the first and last one.
+    m_round_keys[0] = keys[NUM_ROUND_KEYS - 1];
+    for (size_t i = 1; i < NUM_ROUND_KEYS - 1; ++i)
+      m_round_keys[i] = _mm_aesimc_si128(keys[NUM_ROUND_KEYS - 1 - i]);
+    m_round_keys[NUM_ROUND_KEYS - 1] = keys[0];
+  }
 
-  mbedtls_aes_crypt_cbc(&aes_ctx, mode == Mode::Encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT,
-                        size, iv, src, buffer.data());
+  bool Crypt(u8* iv, const u8* src, u8* dst, size_t size) const override
+  {
+    if (size % 16 != 0)
+      return false;
 
-  return buffer;
+    if (m_mode == Mode::Encrypt)
+      Encrypt(iv, src, dst, size);
+    else
+      Decrypt(iv, src, dst, size);
+    return true;
+  }
+
+private:
+  static constexpr size_t NUM_ROUND_KEYS = 11;
+  // Blocks which are decrypted at the same time. Unlike encryption, CBC decryption doesn't
+  // depend on the previous result, so this keeps the AES unit busy.
+  static constexpr size_t PARALLEL_BLOCKS = 8;
+
+  FUNCTION_TARGET_AES void Encrypt(u8* iv_ptr, const u8* src, u8* dst, size_t size) const
+  {
+    __m128i iv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv_ptr));
+    for (size_t i = 0; i < size; i += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      block = _mm_xor_si128(_mm_xor_si128(block, iv), m_round_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        block = _mm_aesenc_si128(block, m_round_keys[round]);
+      iv = _mm_aesenclast_si128(block, m_round_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), iv);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(iv_ptr), iv);
+  }
+
+  FUNCTION_TARGET_AES void Decrypt(u8* iv_ptr, const u8* src, u8* dst, size_t size) const
+  {
+    __m128i iv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv_ptr));
+    size_t i = 0;
+    for (; i + PARALLEL_BLOCKS * 16 <= size; i += PARALLEL_BLOCKS * 16)
+    {
+      // All input is loaded before anything is stored, which makes decrypting in place work.
+      __m128i input[PARALLEL_BLOCKS];
+      __m128i blocks[PARALLEL_BLOCKS];
+      for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+      {
+        input[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + j * 16));
+        blocks[j] = _mm_xor_si128(input[j], m_round_keys[0]);
+      }
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+      {
+        for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+          blocks[j] = _mm_aesdec_si128(blocks[j], m_round_keys[round]);
+      }
+      for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+      {
+        blocks[j] = _mm_aesdeclast_si128(blocks[j], m_round_keys[NUM_ROUND_KEYS - 1]);
+        blocks[j] = _mm_xor_si128(blocks[j], j == 0 ? iv : input[j - 1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + j * 16), blocks[j]);
+      }
+      iv = input[PARALLEL_BLOCKS - 1];
+    }
+
+    for (; i < size; i += 16)
+    {
+      const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      __m128i block = _mm_xor_si128(input, m_round_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        block = _mm_aesdec_si128(block, m_round_keys[round]);
+      block = _mm_aesdeclast_si128(block, m_round_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(block, iv));
+      iv = input;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(iv_ptr), iv);
+  }
+
+  std::array<__m128i, NUM_ROUND_KEYS> m_round_keys;
+  Mode m_mode;
+};
+
+#endif
+}  // Anonymous namespace
+
+std::unique_ptr<Context> CreateContext(const u8* key, Mode mode)
+{
+#if defined(_M_X86_64)
+  if (cpu_info.bAES)
+    return std::make_unique<ContextAESNI>(key, mode);
+#endif
+  return std::make_unique<ContextGeneric>(key, mode);
+}
+
+bool DecryptEncrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size, Mode mode)
+{
+#if defined(_M_X86_64)
+  if (cpu_info.bAES)
+    return ContextAESNI(key, mode).Crypt(iv, src, dst, size);
+#endif
+  return ContextGeneric(key, mode).Crypt(iv, src, dst, size);
 }
 
-std::vector<u8> Decrypt(const u8* key, u8* iv, const u8* src, size_t size)
+bool Decrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size)
 {
-  return DecryptEncrypt(key, iv, src, size, Mode::Decrypt);
+  return DecryptEncrypt(key, iv, src, dst, size, Mode::Decrypt);
 }
 
-std::vector<u8> Encrypt(const u8* key, u8* iv, const u8* src, size_t size)
+bool Encrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size)
 {
-  return DecryptEncrypt(key, iv, src, size, Mode::Encrypt);
+  return DecryptEncrypt(key, iv, src, dst, size, Mode::Encrypt);
 }
 }  // namespace AES
 }  // namespace Common
@@ -5,7 +5,7 @@
 #pragma once
 
 #include <cstddef>
-#include <vector>
+#include <memory>
 
 #include "Common/CommonTypes.h"
 
@@ -18,10 +18,23 @@ enum class Mode
   Decrypt,
   Encrypt,
 };
-std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size, Mode mode);
 
-// Convenience functions
-std::vector<u8> Decrypt(const u8* key, u8* iv, const u8* src, size_t size);
-std::vector<u8> Encrypt(const u8* key, u8* iv, const u8* src, size_t size);
+// An expanded AES-128 key for CBC mode. Uses AES-NI if the CPU supports it.
+class Context
+{
+public:
+  virtual ~Context() = default;
+
+  // Decrypts or encrypts size bytes from src to dst, which may point to the same buffer.
+  // size must be a multiple of 16. iv is updated so that the next call continues the chain.
+  virtual bool Crypt(u8* iv, const u8* src, u8* dst, size_t size) const = 0;
+};
+
+std::unique_ptr<Context> CreateContext(const u8* key, Mode mode);
+
+// Convenience functions for one-off operations
+bool DecryptEncrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size, Mode mode);
+bool Decrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size);
+bool Encrypt(const u8* key, u8* iv, const u8* src, u8* dst, size_t size);
 }  // namespace AES
 }  // namespace Common
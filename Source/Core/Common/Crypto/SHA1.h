@@ -0,0 +1,21 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+namespace SHA1
+{
+using Digest = std::array<u8, 20>;
+
+// Uses the SHA extensions if the CPU supports them.
+Digest CalculateDigest(const u8* msg, size_t size);
+}  // namespace SHA1
+}  // namespace Common
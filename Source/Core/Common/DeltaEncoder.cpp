@@ -0,0 +1,252 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/DeltaEncoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace Common
+{
+namespace
+{
+constexpr u32 DELTA_MAGIC = 0x41544C44;  // "DLTA"
+constexpr u32 FILTER_BITS = 20;
+
+enum Op : u8
+{
+  OP_COPY = 0,
+  OP_LITERAL = 1,
+};
+
+template <typename T>
+void Append(std::vector<u8>* out, const T& value)
+{
+  const u8* bytes = reinterpret_cast<const u8*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool Read(const u8** ptr, const u8* end, T* value)
+{
+  if (static_cast<size_t>(end - *ptr) < sizeof(T))
+    return false;
+  std::memcpy(value, *ptr, sizeof(T));
+  *ptr += sizeof(T);
+  return true;
+}
+
+// Writes the delta operations, merging copies of consecutive base pages.
+class OpWriter final
+{
+public:
+  explicit OpWriter(std::vector<u8>* out) : m_out(out) {}
+  void Copy(u64 offset, u64 length)
+  {
+    if (m_copy_length != 0 && m_copy_offset + m_copy_length == offset)
+    {
+      m_copy_length += length;
+      return;
+    }
+    FlushCopy();
+    m_copy_offset = offset;
+    m_copy_length = length;
+  }
+
+  void Literal(const u8* data, u64 length)
+  {
+    if (length == 0)
+      return;
+    FlushCopy();
+    Append(m_out, OP_LITERAL);
+    Append(m_out, length);
+    m_out->insert(m_out->end(), data, data + length);
+  }
+
+  void FlushCopy()
+  {
+    if (m_copy_length == 0)
+      return;
+    Append(m_out, OP_COPY);
+    Append(m_out, m_copy_offset);
+    Append(m_out, m_copy_length);
+    m_copy_length = 0;
+  }
+
+private:
+  std::vector<u8>* m_out;
+  u64 m_copy_offset = 0;
+  u64 m_copy_length = 0;
+};
+
+// The rolling checksum from rsync, over one page.
+template <size_t N>
+u32 PageChecksum(const u8* data)
+{
+  u32 a = 0;
+  u32 b = 0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    a += data[i];
+    b += static_cast<u32>(N - i) * data[i];
+  }
+  return (a & 0xFFFF) | (b << 16);
+}
+
+// Moves the page covered by a checksum forward by one byte.
+template <size_t N>
+u32 RollChecksum(u32 checksum, u8 removed, u8 added)
+{
+  const u32 a = ((checksum & 0xFFFF) - removed + added) & 0xFFFF;
+  const u32 b = ((checksum >> 16) - static_cast<u32>(N) * removed + a) & 0xFFFF;
+  return a | (b << 16);
+}
+
+u32 FilterIndex(u32 checksum)
+{
+  return (checksum * 0x9E3779B1) >> (32 - FILTER_BITS);
+}
+}  // Anonymous namespace
+
+DeltaEncoder::DeltaEncoder(std::vector<u8> base)
+    : m_base(std::move(base)), m_filter((1 << FILTER_BITS) / 64)
+{
+  static std::atomic<u64> s_next_id{1};
+  m_id = s_next_id++;
+
+  m_pages.reserve(m_base.size() / PAGE_SIZE);
+  for (size_t offset = 0; m_base.size() - offset >= PAGE_SIZE; offset += PAGE_SIZE)
+  {
+    const u32 checksum = PageChecksum<PAGE_SIZE>(&m_base[offset]);
+    m_pages.emplace(checksum, static_cast<u32>(offset));
+    const u32 index = FilterIndex(checksum);
+    m_filter[index / 64] |= u64(1) << (index % 64);
+  }
+}
+
+bool DeltaEncoder::MayContain(u32 checksum) const
+{
+  const u32 index = FilterIndex(checksum);
+  return (m_filter[index / 64] >> (index % 64)) & 1;
+}
+
+s64 DeltaEncoder::FindPage(u32 checksum, const u8* data) const
+{
+  if (!MayContain(checksum))
+    return -1;
+
+  const auto it = m_pages.find(checksum);
+  if (it == m_pages.end() || std::memcmp(&m_base[it->second], data, PAGE_SIZE) != 0)
+    return -1;
+
+  return it->second;
+}
+
+std::vector<u8> DeltaEncoder::Encode(const u8* data, size_t size) const
+{
+  std::vector<u8> delta;
+  Append(&delta, DELTA_MAGIC);
+  Append(&delta, m_id);
+  Append(&delta, static_cast<u64>(size));
+
+  OpWriter writer(&delta);
+  size_t literal_start = 0;
+  size_t pos = 0;
+  // Base offset minus data offset of the last match. Unchanged data usually continues there.
+  s64 shift = 0;
+
+  while (size - pos >= PAGE_SIZE)
+  {
+    s64 match = -1;
+    const s64 guess = static_cast<s64>(pos) + shift;
+    if (guess >= 0 && static_cast<size_t>(guess) + PAGE_SIZE <= m_base.size() &&
+        std::memcmp(&m_base[guess], data + pos, PAGE_SIZE) == 0)
+    {
+      match = guess;
+    }
+
+    if (match < 0)
+    {
+      // Look for a base page starting anywhere within the next page.
+      const size_t last = std::min(pos + PAGE_SIZE - 1, size - PAGE_SIZE);
+      u32 checksum = PageChecksum<PAGE_SIZE>(data + pos);
+      size_t start = pos;
+      while (true)
+      {
+        match = FindPage(checksum, data + start);
+        if (match >= 0 || start == last)
+          break;
+        checksum = RollChecksum<PAGE_SIZE>(checksum, data[start], data[start + PAGE_SIZE]);
+        start++;
+      }
+
+      if (match < 0)
+      {
+        // None of these bytes can start a match, they'll end up in the next literal.
+        pos = last + 1;
+        continue;
+      }
+      pos = start;
+    }
+
+    writer.Literal(data + literal_start, pos - literal_start);
+    writer.Copy(match, PAGE_SIZE);
+    shift = match - static_cast<s64>(pos);
+    pos += PAGE_SIZE;
+    literal_start = pos;
+  }
+
+  writer.Literal(data + literal_start, size - literal_start);
+  writer.FlushCopy();
+  return delta;
+}
+
+bool DeltaEncoder::Decode(const std::vector<u8>& delta, std::vector<u8>* data) const
+{
+  const u8* ptr = delta.data();
+  const u8* const end = ptr + delta.size();
+
+  u32 magic;
+  u64 id;
+  u64 size;
+  if (!Read(&ptr, end, &magic) || !Read(&ptr, end, &id) || !Read(&ptr, end, &size) ||
+      magic != DELTA_MAGIC || id != m_id)
+  {
+    return false;
+  }
+
+  data->clear();
+  data->reserve(size);
+  while (ptr != end)
+  {
+    u8 op;
+    u64 length;
+    Read(&ptr, end, &op);
+    if (op == OP_COPY)
+    {
+      u64 offset;
+      if (!Read(&ptr, end, &offset) || !Read(&ptr, end, &length) || offset > m_base.size() ||
+          length > m_base.size() - offset)
+      {
+        return false;
+      }
+      data->insert(data->end(), m_base.begin() + offset, m_base.begin() + offset + length);
+    }
+    else if (op == OP_LITERAL)
+    {
+      if (!Read(&ptr, end, &length) || length > static_cast<u64>(end - ptr))
+        return false;
+      data->insert(data->end(), ptr, ptr + length);
+      ptr += length;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return data->size() == size;
+}
+}  // namespace Common
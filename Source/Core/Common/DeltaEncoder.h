@@ -0,0 +1,50 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+// Encodes buffers as the difference to a fixed base buffer, for data which mostly consists of
+// the same pages as the base, like two savestates taken shortly after each other.
+//
+// The new buffer is split into pages, and every page which also occurs somewhere in the base
+// is stored as a reference into it. Matching pages are found with a rolling checksum, so data
+// which moved by an arbitrary number of bytes (because something in front of it changed size)
+// is still found. Only the pages without a match are stored as is.
+//
+// Deltas are only meant to be kept in memory and can only be decoded by the encoder which
+// created them.
+class DeltaEncoder final
+{
+public:
+  explicit DeltaEncoder(std::vector<u8> base);
+
+  const std::vector<u8>& GetBase() const { return m_base; }
+  std::vector<u8> Encode(const u8* data, size_t size) const;
+  // Returns false if the delta is corrupted or belongs to a different encoder.
+  bool Decode(const std::vector<u8>& delta, std::vector<u8>* data) const;
+
+private:
+  static constexpr size_t PAGE_SIZE = 4096;
+
+  bool MayContain(u32 checksum) const;
+  // Returns the offset of a page in the base which equals data, or -1.
+  s64 FindPage(u32 checksum, const u8* data) const;
+
+  std::vector<u8> m_base;
+  u64 m_id;
+
+  // Rolling checksum of a page -> offset of the first base page with that checksum.
+  std::unordered_map<u32, u32> m_pages;
+  // A bit for every checksum in m_pages, so that most misses don't have to hash.
+  std::vector<u64> m_filter;
+};
+}  // namespace Common
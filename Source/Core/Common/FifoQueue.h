@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <memory>
 
 #include "Common/CommonTypes.h"
 
@@ -107,4 +108,157 @@ private:
   ElementPtr* m_read_ptr;
   std::atomic<u32> m_size;
 };
+
+// Same interface and threading rules as FifoQueue, but elements are stored in a ring buffer
+// instead of one heap node each, so Push and Pop don't allocate in the common case.
+//
+// When the ring is full, the writer links in a new ring of twice the size and continues
+// there. The reader frees the old ring once it has drained it. Allocation therefore only
+// happens on overflow, and a queue which once overflowed stays large enough afterwards.
+//
+// Unlike FifoQueue, Empty/Front/Pop must only be called by the reader.
+template <typename T, bool NeedSize = true, size_t Capacity = 64>
+class RingFifoQueue
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+public:
+  RingFifoQueue() : m_size(0) { m_write_segment = m_read_segment = new Segment(Capacity); }
+  ~RingFifoQueue() { DeleteSegments(); }
+  RingFifoQueue(const RingFifoQueue&) = delete;
+  RingFifoQueue& operator=(const RingFifoQueue&) = delete;
+
+  u32 Size() const
+  {
+    static_assert(NeedSize, "using Size() on RingFifoQueue without NeedSize");
+    return m_size.load();
+  }
+
+  bool Empty() const { return !FrontSegment(); }
+  T& Front() const
+  {
+    Segment* segment = FrontSegment();
+    return segment->slots[segment->read_index.load(std::memory_order_relaxed) & segment->mask];
+  }
+
+  template <typename Arg>
+  void Push(Arg&& t)
+  {
+    Segment* segment = m_write_segment;
+    size_t write_index = segment->write_index.load(std::memory_order_relaxed);
+    if (write_index - segment->read_index.load(std::memory_order_acquire) > segment->mask)
+    {
+      // Full. The reader moves on to the new ring after draining this one.
+      Segment* new_segment = new Segment((segment->mask + 1) * 2);
+      segment->next.store(new_segment, std::memory_order_release);
+      m_write_segment = segment = new_segment;
+      write_index = 0;
+    }
+
+    segment->slots[write_index & segment->mask] = std::forward<Arg>(t);
+    segment->write_index.store(write_index + 1, std::memory_order_release);
+    if (NeedSize)
+      m_size++;
+  }
+
+  void Pop()
+  {
+    T& slot = AdvanceToFront();
+    if (NeedSize)
+      m_size--;
+    // Release whatever the element owns now instead of when the slot gets reused.
+    slot = T();
+    m_read_segment->read_index.fetch_add(1, std::memory_order_release);
+  }
+
+  bool Pop(T& t)
+  {
+    if (Empty())
+      return false;
+
+    T& slot = AdvanceToFront();
+    if (NeedSize)
+      m_size--;
+    t = std::move(slot);
+    m_read_segment->read_index.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  // not thread-safe
+  void Clear()
+  {
+    m_size.store(0);
+    DeleteSegments();
+    m_write_segment = m_read_segment = new Segment(Capacity);
+  }
+
+private:
+  struct Segment
+  {
+    explicit Segment(size_t capacity) : slots(new T[capacity]), mask(capacity - 1) {}
+    std::unique_ptr<T[]> slots;
+    const size_t mask;
+    std::atomic<Segment*> next{nullptr};
+
+    // The indices are written by different threads, keep them on separate cache lines.
+    // Padding instead of alignas, since over-aligned new needs C++17.
+    std::atomic<size_t> write_index{0};
+    u8 padding[64];
+    std::atomic<size_t> read_index{0};
+  };
+
+  static bool IsSegmentEmpty(const Segment* segment)
+  {
+    return segment->read_index.load(std::memory_order_relaxed) ==
+           segment->write_index.load(std::memory_order_acquire);
+  }
+
+  // Returns the segment holding the front element, or nullptr if the queue is empty.
+  Segment* FrontSegment() const
+  {
+    Segment* segment = m_read_segment;
+    while (true)
+    {
+      // Once next is set, the writer won't touch this segment anymore, so loading next first
+      // makes sure that an empty segment with a successor really is drained.
+      Segment* next = segment->next.load(std::memory_order_acquire);
+      if (!IsSegmentEmpty(segment))
+        return segment;
+      if (!next)
+        return nullptr;
+      segment = next;
+    }
+  }
+
+  // Frees drained segments and returns the front element. The queue must not be empty.
+  T& AdvanceToFront()
+  {
+    while (true)
+    {
+      // See FrontSegment for why next has to be loaded first.
+      Segment* next = m_read_segment->next.load(std::memory_order_acquire);
+      if (!IsSegmentEmpty(m_read_segment))
+        break;
+      delete m_read_segment;
+      m_read_segment = next;
+    }
+    return m_read_segment->slots[m_read_segment->read_index.load(std::memory_order_relaxed) &
+                                 m_read_segment->mask];
+  }
+
+  void DeleteSegments()
+  {
+    while (m_read_segment)
+    {
+      Segment* next = m_read_segment->next.load();
+      delete m_read_segment;
+      m_read_segment = next;
+    }
+  }
+
+  Segment* m_write_segment;
+  Segment* m_read_segment;
+  std::atomic<u32> m_size;
+};
 }
@@ -0,0 +1,209 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+// Open-addressing hash multimap for integral keys and small, trivially copyable values.
+//
+// All entries live in a single power-of-two sized array and are found with linear probing,
+// so a lookup touches a few adjacent cache lines instead of chasing tree nodes. Erasure shifts
+// the following entries back, so there are no tombstones and the table never degrades.
+//
+// Like std::multimap, a key may be stored several times. The same (key, value) pair may also
+// be stored more than once; Erase removes a single occurrence of it.
+//
+// The callbacks passed to ForEach/ForEachEntry must not modify the map.
+template <typename K, typename V>
+class FlatHashMultiMap final
+{
+  static_assert(std::is_integral<K>::value, "K must be an integral type");
+
+public:
+  size_t Size() const { return m_size; }
+  bool Empty() const { return m_size == 0; }
+
+  void Clear()
+  {
+    m_slots.clear();
+    m_mask = 0;
+    m_shift = 64;
+    m_size = 0;
+  }
+
+  void Insert(K key, V value)
+  {
+    if ((m_size + 1) * 4 > m_slots.size() * 3)
+      Grow();
+
+    size_t i = IndexFor(key);
+    while (m_slots[i].used)
+      i = (i + 1) & m_mask;
+
+    m_slots[i] = {key, std::move(value), true};
+    m_size++;
+  }
+
+  // Inserts the pair only if it isn't already present. Returns whether it was inserted.
+  bool InsertUnique(K key, V value)
+  {
+    if (Contains(key, value))
+      return false;
+
+    Insert(key, std::move(value));
+    return true;
+  }
+
+  // Removes one occurrence of the pair. Returns whether it was found.
+  bool Erase(K key, const V& value)
+  {
+    const size_t i = FindSlot(key, value);
+    if (i == NOT_FOUND)
+      return false;
+
+    EraseSlot(i);
+    return true;
+  }
+
+  // Removes all occurrences of the pair. Returns the number of removed entries.
+  size_t EraseAll(K key, const V& value)
+  {
+    size_t count = 0;
+    while (Erase(key, value))
+      count++;
+    return count;
+  }
+
+  bool Contains(K key, const V& value) const { return FindSlot(key, value) != NOT_FOUND; }
+
+  // Returns the first value stored for key which satisfies pred, or nullptr.
+  template <typename Pred>
+  const V* FindIf(K key, Pred pred) const
+  {
+    if (m_size == 0)
+      return nullptr;
+
+    for (size_t i = IndexFor(key); m_slots[i].used; i = (i + 1) & m_mask)
+    {
+      if (m_slots[i].key == key && pred(m_slots[i].value))
+        return &m_slots[i].value;
+    }
+    return nullptr;
+  }
+
+  // Calls f(value) for every value stored for key.
+  template <typename F>
+  void ForEach(K key, F f) const
+  {
+    if (m_size == 0)
+      return;
+
+    for (size_t i = IndexFor(key); m_slots[i].used; i = (i + 1) & m_mask)
+    {
+      if (m_slots[i].key == key)
+        f(m_slots[i].value);
+    }
+  }
+
+  // Calls f(key, value) for every entry, in no particular order.
+  template <typename F>
+  void ForEachEntry(F f) const
+  {
+    for (const Slot& slot : m_slots)
+    {
+      if (slot.used)
+        f(slot.key, slot.value);
+    }
+  }
+
+private:
+  static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+  static constexpr size_t MIN_CAPACITY = 16;
+
+  struct Slot
+  {
+    K key;
+    V value;
+    bool used;
+  };
+
+  size_t IndexFor(K key) const
+  {
+    // Fibonacci hashing; aligned addresses would otherwise all end up in the same few buckets.
+    return static_cast<size_t>((static_cast<u64>(key) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+  }
+
+  size_t FindSlot(K key, const V& value) const
+  {
+    if (m_size == 0)
+      return NOT_FOUND;
+
+    for (size_t i = IndexFor(key); m_slots[i].used; i = (i + 1) & m_mask)
+    {
+      if (m_slots[i].key == key && m_slots[i].value == value)
+        return i;
+    }
+    return NOT_FOUND;
+  }
+
+  void EraseSlot(size_t i)
+  {
+    // Backward shift deletion: move later entries of the probe sequence into the hole as long
+    // as that doesn't place them before their home slot.
+    size_t j = i;
+    while (true)
+    {
+      j = (j + 1) & m_mask;
+      if (!m_slots[j].used)
+        break;
+
+      const size_t home = IndexFor(m_slots[j].key);
+      if (((j - home) & m_mask) >= ((j - i) & m_mask))
+      {
+        m_slots[i] = std::move(m_slots[j]);
+        i = j;
+      }
+    }
+
+    m_slots[i].used = false;
+    m_size--;
+  }
+
+  void Grow()
+  {
+    const size_t new_capacity = m_slots.empty() ? MIN_CAPACITY : m_slots.size() * 2;
+    std::vector<Slot> old_slots(new_capacity);
+    std::swap(old_slots, m_slots);
+
+    m_mask = new_capacity - 1;
+    m_shift = 64;
+    for (size_t capacity = new_capacity; capacity > 1; capacity >>= 1)
+      m_shift--;
+
+    for (Slot& slot : old_slots)
+    {
+      if (!slot.used)
+        continue;
+
+      size_t i = IndexFor(slot.key);
+      while (m_slots[i].used)
+        i = (i + 1) & m_mask;
+      m_slots[i] = std::move(slot);
+    }
+  }
+
+  std::vector<Slot> m_slots;
+  size_t m_mask = 0;
+  u32 m_shift = 64;
+  size_t m_size = 0;
+};
+}  // namespace Common
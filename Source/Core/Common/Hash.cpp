@@ -332,6 +332,204 @@ static u64 GetCRC32(const u8* src, u32 len, u32 samples)
 
 #endif
 
+
+// A hash in the style of XXH3: eight 64 bit lanes each take one word of a 64 byte stripe, and
+// multiply the low and high halves of it after mixing in a key. This maps well to wide SIMD
+// registers, so it is a lot faster than the CRC32 hash on CPUs with AVX2. The scalar and AVX2
+// versions give the same results.
+namespace WideHash
+{
+constexpr u32 STRIPE_SIZE = 64;
+constexpr u32 STRIPES_PER_BLOCK = 16;
+constexpr u64 PRIME32_1 = 0x9E3779B1;
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87;
+
+// Each stripe of a block uses the keys starting at its index. They are followed by the keys for
+// scrambling the lanes after each block, for the last stripe and for merging the lanes.
+constexpr u32 SCRAMBLE_KEYS = STRIPES_PER_BLOCK;
+constexpr u32 LAST_STRIPE_KEYS = SCRAMBLE_KEYS + 8;
+constexpr u32 MERGE_KEYS = LAST_STRIPE_KEYS + 8;
+constexpr u32 NUM_KEYS = MERGE_KEYS + 8;
+
+struct Keys
+{
+  constexpr Keys() : values()
+  {
+    u64 state = 0x5d1e3b9c7a2f4d8e;
+    for (u64& value : values)
+    {
+      // SplitMix64
+      state += 0x9E3779B97F4A7C15;
+      u64 z = state;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+      value = z ^ (z >> 31);
+    }
+  }
+  u64 values[NUM_KEYS];
+};
+constexpr Keys KEYS;
+
+constexpr u64 INITIAL_LANES[8] = {0xC2B2AE3D,         0x9E3779B185EBCA87, 0xC2B2AE3D27D4EB4F,
+                                  0x165667B19E3779F9, 0x85EBCA77C2B2AE63, 0x85EBCA77,
+                                  0x27D4EB2F165667C5, 0x9E3779B1};
+
+static u64 Multiply128Fold64(u64 a, u64 b)
+{
+#ifdef _MSC_VER
+  u64 high;
+  const u64 low = _umul128(a, b, &high);
+  return low ^ high;
+#else
+  const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#endif
+}
+
+static u64 Merge(const u64* lanes, u32 len)
+{
+  u64 h = len * PRIME64_1;
+  for (u32 i = 0; i < 8; i += 2)
+  {
+    h += Multiply128Fold64(lanes[i] ^ KEYS.values[MERGE_KEYS + i],
+                           lanes[i + 1] ^ KEYS.values[MERGE_KEYS + i + 1]);
+  }
+  h ^= h >> 37;
+  h *= 0x165667919E3779F9;
+  h ^= h >> 32;
+  return h;
+}
+
+// Inputs shorter than a stripe are zero padded, and the last stripe of longer inputs overlaps
+// the previous one.
+static const u8* GetLastStripe(const u8* src, u32 len, u8* padded)
+{
+  if (len >= STRIPE_SIZE)
+    return src + len - STRIPE_SIZE;
+  std::memset(padded, 0, STRIPE_SIZE);
+  std::memcpy(padded, src, len);
+  return padded;
+}
+
+static void AccumulateScalar(u64* lanes, const u8* stripe, const u64* keys)
+{
+  for (u32 i = 0; i < 8; ++i)
+  {
+    u64 value;
+    std::memcpy(&value, stripe + i * 8, sizeof(value));
+    const u64 keyed = value ^ keys[i];
+    lanes[i ^ 1] += value;
+    lanes[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+  }
+}
+
+static u64 HashScalar(const u8* src, u32 len)
+{
+  u64 lanes[8];
+  std::memcpy(lanes, INITIAL_LANES, sizeof(lanes));
+
+  const u32 num_stripes = len == 0 ? 0 : (len - 1) / STRIPE_SIZE;
+  for (u32 stripe = 0; stripe < num_stripes; ++stripe)
+  {
+    const u32 index = stripe % STRIPES_PER_BLOCK;
+    AccumulateScalar(lanes, src + stripe * STRIPE_SIZE, &KEYS.values[index]);
+    if (index == STRIPES_PER_BLOCK - 1)
+    {
+      for (u32 i = 0; i < 8; ++i)
+      {
+        lanes[i] ^= lanes[i] >> 47;
+        lanes[i] ^= KEYS.values[SCRAMBLE_KEYS + i];
+        lanes[i] *= PRIME32_1;
+      }
+    }
+  }
+
+  u8 padded[STRIPE_SIZE];
+  AccumulateScalar(lanes, GetLastStripe(src, len, padded), &KEYS.values[LAST_STRIPE_KEYS]);
+  return Merge(lanes, len);
+}
+
+#if defined(_M_X86_64)
+
+FUNCTION_TARGET_AVX2
+static inline __m256i AccumulateAVX2(__m256i lanes, const u8* data, const u64* keys)
+{
+  const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+  const __m256i keyed =
+      _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys)));
+  // Adding the swapped value to each lane is the same as adding each value to the other lane
+  const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+  const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+  return _mm256_add_epi64(lanes, _mm256_add_epi64(swapped, product));
+}
+
+FUNCTION_TARGET_AVX2
+static inline __m256i ScrambleAVX2(__m256i lanes, const u64* keys)
+{
+  const __m256i prime = _mm256_set1_epi32(static_cast<s32>(PRIME32_1));
+  lanes = _mm256_xor_si256(lanes, _mm256_srli_epi64(lanes, 47));
+  lanes = _mm256_xor_si256(lanes, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys)));
+  const __m256i low = _mm256_mul_epu32(lanes, prime);
+  const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(lanes, 32), prime);
+  return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+}
+
+FUNCTION_TARGET_AVX2
+static u64 HashAVX2(const u8* src, u32 len)
+{
+  __m256i lanes_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&INITIAL_LANES[0]));
+  __m256i lanes_high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&INITIAL_LANES[4]));
+
+  const u32 num_stripes = len == 0 ? 0 : (len - 1) / STRIPE_SIZE;
+  u32 stripe = 0;
+  for (; stripe + STRIPES_PER_BLOCK <= num_stripes; stripe += STRIPES_PER_BLOCK)
+  {
+    const u8* block = src + stripe * STRIPE_SIZE;
+    for (u32 i = 0; i < STRIPES_PER_BLOCK; ++i)
+    {
+      lanes_low = AccumulateAVX2(lanes_low, block + i * STRIPE_SIZE, &KEYS.values[i]);
+      lanes_high = AccumulateAVX2(lanes_high, block + i * STRIPE_SIZE + 32, &KEYS.values[i + 4]);
+    }
+    lanes_low = ScrambleAVX2(lanes_low, &KEYS.values[SCRAMBLE_KEYS]);
+    lanes_high = ScrambleAVX2(lanes_high, &KEYS.values[SCRAMBLE_KEYS + 4]);
+  }
+  for (u32 i = 0; stripe < num_stripes; ++stripe, ++i)
+  {
+    lanes_low = AccumulateAVX2(lanes_low, src + stripe * STRIPE_SIZE, &KEYS.values[i]);
+    lanes_high = AccumulateAVX2(lanes_high, src + stripe * STRIPE_SIZE + 32, &KEYS.values[i + 4]);
+  }
+
+  u8 padded[STRIPE_SIZE];
+  const u8* last = GetLastStripe(src, len, padded);
+  lanes_low = AccumulateAVX2(lanes_low, last, &KEYS.values[LAST_STRIPE_KEYS]);
+  lanes_high = AccumulateAVX2(lanes_high, last + 32, &KEYS.values[LAST_STRIPE_KEYS + 4]);
+
+  alignas(32) u64 lanes[8];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(&lanes[0]), lanes_low);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(&lanes[4]), lanes_high);
+  return Merge(lanes, len);
+}
+
+#endif
+}  // namespace WideHash
+
+// Sampled hashes only read a few words, so they gain nothing from the wide hash.
+static u64 GetWideHash(const u8* src, u32 len, u32 samples)
+{
+  if (samples != 0)
+    return GetMurmurHash3(src, len, samples);
+  return WideHash::HashScalar(src, len);
+}
+
+#if defined(_M_X86_64)
+static u64 GetWideHashAVX2(const u8* src, u32 len, u32 samples)
+{
+  if (samples != 0)
+    return GetCRC32(src, len, samples);
+  return WideHash::HashAVX2(src, len);
+}
+#endif
+
 /*
  * NOTE: This hash function is used for custom texture loading/dumping, so
  * it should not be changed, which would require all custom textures to be
@@ -620,7 +818,21 @@ u64 GetHash64(const u8* src, u32 len, u32 samples)
 // sets the hash function used for the texture cache
 void SetHash64Function()
 {
-#if defined(_M_X86_64) || defined(_M_X86)
+#if defined(_M_X86_64)
+  if (cpu_info.bAVX2)
+  {
+    ptrHashFunction = &GetWideHashAVX2;
+  }
+  else if (cpu_info.bSSE4_2)  // sse crc32 version
+  {
+    ptrHashFunction = &GetCRC32;
+  }
+  else
+  {
+    ptrHashFunction = &GetWideHash;
+  }
+#else
+#if defined(_M_X86)
   if (cpu_info.bSSE4_2)  // sse crc32 version
   {
     ptrHashFunction = &GetCRC32;
@@ -636,4 +848,5 @@ void SetHash64Function()
   {
     ptrHashFunction = &GetMurmurHash3;
   }
+#endif
 }
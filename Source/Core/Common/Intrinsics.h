@@ -40,6 +40,15 @@
 #ifndef __SSE3__
 #define FUNCTION_TARGET_SSE3 [[gnu::target("sse3")]]
 #endif
+#ifndef __AES__
+#define FUNCTION_TARGET_AES [[gnu::target("aes")]]
+#endif
+#ifndef __SHA__
+#define FUNCTION_TARGET_SHA [[gnu::target("sha,sse4.1")]]
+#endif
+#ifndef __AVX2__
+#define FUNCTION_TARGET_AVX2 [[gnu::target("avx2")]]
+#endif
 
 #elif defined(_MSC_VER) || defined(__INTEL_COMPILER)
 
@@ -70,3 +79,12 @@
 #ifndef FUNCTION_TARGET_SSE3
 #define FUNCTION_TARGET_SSE3
 #endif
+#ifndef FUNCTION_TARGET_AES
+#define FUNCTION_TARGET_AES
+#endif
+#ifndef FUNCTION_TARGET_SHA
+#define FUNCTION_TARGET_SHA
+#endif
+#ifndef FUNCTION_TARGET_AVX2
+#define FUNCTION_TARGET_AVX2
+#endif
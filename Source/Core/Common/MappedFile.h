@@ -0,0 +1,37 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+namespace File
+{
+// A read-only view of a whole file. Pages are only read from disk once they are touched, which
+// makes this suited to large files that are accessed sparsely.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Empty files can't be mapped, and fail to open.
+  bool Open(const std::string& filename);
+  void Close();
+
+  bool IsOpen() const { return m_data != nullptr; }
+  const u8* GetData() const { return m_data; }
+  u64 GetSize() const { return m_size; }
+
+private:
+  const u8* m_data = nullptr;
+  u64 m_size = 0;
+};
+}  // namespace File
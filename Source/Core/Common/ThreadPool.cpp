@@ -0,0 +1,83 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/ThreadPool.h"
+
+#include "Common/Thread.h"
+
+namespace Common
+{
+ThreadPool::ThreadPool(size_t num_threads, const std::string& name)
+{
+  for (size_t i = 1; i < num_threads; ++i)
+    m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i, name);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_quit = true;
+  }
+  m_start_cv.notify_all();
+
+  for (std::thread& worker : m_workers)
+    worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)>& function)
+{
+  if (m_workers.empty() || count <= 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+      function(i, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_function = &function;
+    m_count = count;
+    m_next_index = 0;
+    m_busy_workers = m_workers.size();
+    ++m_generation;
+  }
+  m_start_cv.notify_all();
+
+  RunTasks(0);
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_done_cv.wait(lk, [this] { return m_busy_workers == 0; });
+  m_function = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t thread_index, std::string name)
+{
+  Common::SetCurrentThreadName(name.c_str());
+
+  u64 generation = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_start_cv.wait(lk, [&] { return m_quit || m_generation != generation; });
+      if (m_quit)
+        return;
+      generation = m_generation;
+    }
+
+    RunTasks(thread_index);
+
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (--m_busy_workers == 0)
+      m_done_cv.notify_one();
+  }
+}
+
+void ThreadPool::RunTasks(size_t thread_index)
+{
+  for (size_t i = m_next_index++; i < m_count; i = m_next_index++)
+    (*m_function)(i, thread_index);
+}
+}  // namespace Common
@@ -0,0 +1,59 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+// A fixed set of worker threads which a loop can be spread across. The threads are kept alive
+// between calls, which makes it cheap enough for small batches.
+class ThreadPool final
+{
+public:
+  // num_threads includes the thread calling ParallelFor, so a pool of one thread runs
+  // everything inline without creating any workers.
+  ThreadPool(size_t num_threads, const std::string& name);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t GetNumThreads() const { return m_workers.size() + 1; }
+
+  // Calls function(i, thread_index) for every i in [0, count) and returns once all calls have
+  // returned. thread_index is in [0, GetNumThreads()) and is never used by two calls at the
+  // same time, so it can select per-thread state. The calling thread always uses index 0.
+  // Indices are handed out in increasing order, but may complete in any order.
+  // Must not be called from more than one thread at a time.
+  void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& function);
+
+private:
+  void WorkerLoop(size_t thread_index, std::string name);
+  void RunTasks(size_t thread_index);
+
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start_cv;
+  std::condition_variable m_done_cv;
+  u64 m_generation = 0;
+  size_t m_busy_workers = 0;
+  bool m_quit = false;
+
+  const std::function<void(size_t, size_t)>* m_function = nullptr;
+  size_t m_count = 0;
+  std::atomic<size_t> m_next_index{0};
+};
+}  // namespace Common
@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <thread>
+#include <utility>
 
 #include "Common/Event.h"
 #include "Common/Flag.h"
@@ -40,7 +43,7 @@ public:
     m_wakeup.Set();
   }
 
-private:
+  // Waits for all queued items to be processed, then stops the thread.
   void Shutdown()
   {
     if (m_thread.joinable())
@@ -51,6 +54,14 @@ private:
     }
   }
 
+  // Waits until every item queued so far has been processed.
+  void WaitForCompletion()
+  {
+    std::unique_lock<std::mutex> lg(m_lock);
+    m_idle.wait(lg, [this] { return m_items.empty() && !m_busy; });
+  }
+
+private:
   void ThreadLoop()
   {
     while (true)
@@ -64,10 +75,16 @@ private:
           std::unique_lock<std::mutex> lg(m_lock);
           if (m_items.empty())
             break;
-          item = m_items.front();
+          item = std::move(m_items.front());
           m_items.pop();
+          m_busy = true;
         }
         m_function(std::move(item));
+        {
+          std::lock_guard<std::mutex> lg(m_lock);
+          m_busy = false;
+        }
+        m_idle.notify_all();
       }
 
       if (m_shutdown.IsSet())
@@ -81,6 +98,8 @@ private:
   Common::Flag m_shutdown;
   std::mutex m_lock;
   std::queue<T> m_items;
+  bool m_busy = false;
+  std::condition_variable m_idle;
 };
 
 }  // namespace Common
@@ -157,6 +157,11 @@ void CPUInfo::Detect()
         bBMI1 = true;
       if ((cpu_id[1] >> 8) & 1)
         bBMI2 = true;
+      if ((cpu_id[1] >> 29) & 1)
+      {
+        bSHA1 = true;
+        bSHA2 = true;
+      }
     }
   }
 
@@ -255,6 +260,8 @@ std::string CPUInfo::Summarize()
     sum += ", FMA";
   if (bAES)
     sum += ", AES";
+  if (bSHA1)
+    sum += ", SHA";
   if (bMOVBE)
     sum += ", MOVBE";
   if (bLongMode)
@@ -1,7 +1,6 @@
 #include "Core/Analytics.h"
 
 #include <cinttypes>
-#include <mbedtls/sha1.h>
 #include <memory>
 #include <mutex>
 #include <random>
@@ -16,6 +15,7 @@
 #include "Common/Analytics.h"
 #include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/StringUtil.h"
 #include "Common/Version.h"
 #include "Core/ConfigManager.h"
@@ -85,9 +85,9 @@ void DolphinAnalytics::GenerateNewIdentity()
 
 std::string DolphinAnalytics::MakeUniqueId(const std::string& data)
 {
-  u8 digest[20];
   std::string input = m_unique_id + data;
-  mbedtls_sha1(reinterpret_cast<const u8*>(input.c_str()), input.size(), digest);
+  const Common::SHA1::Digest digest =
+      Common::SHA1::CalculateDigest(reinterpret_cast<const u8*>(input.c_str()), input.size());
 
   // Convert to hex string and truncate to 64 bits.
   std::string out;
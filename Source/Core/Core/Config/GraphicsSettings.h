@@ -32,6 +32,8 @@ extern const ConfigInfo<bool> GFX_CROP;
 extern const ConfigInfo<bool> GFX_USE_XFB;
 extern const ConfigInfo<bool> GFX_USE_REAL_XFB;
 extern const ConfigInfo<int> GFX_SAFE_TEXTURE_CACHE_COLOR_SAMPLES;
+extern const ConfigInfo<bool> GFX_INCREMENTAL_TEXTURE_HASH;
+extern const ConfigInfo<bool> GFX_TEXTURE_DISK_CACHE;
 extern const ConfigInfo<bool> GFX_SHOW_FPS;
 extern const ConfigInfo<bool> GFX_SHOW_NETPLAY_PING;
 extern const ConfigInfo<bool> GFX_SHOW_NETPLAY_MESSAGES;
@@ -52,6 +54,7 @@ extern const ConfigInfo<std::string> GFX_DUMP_PATH;
 extern const ConfigInfo<int> GFX_BITRATE_KBPS;
 extern const ConfigInfo<bool> GFX_INTERNAL_RESOLUTION_FRAME_DUMPS;
 extern const ConfigInfo<bool> GFX_ENABLE_GPU_TEXTURE_DECODING;
+extern const ConfigInfo<int> GFX_TEXTURE_DECODE_THREADS;
 extern const ConfigInfo<bool> GFX_ENABLE_PIXEL_LIGHTING;
 extern const ConfigInfo<bool> GFX_FAST_DEPTH_CALC;
 extern const ConfigInfo<u32> GFX_MSAA;
@@ -79,6 +82,8 @@ extern const ConfigInfo<bool> GFX_SW_DUMP_TEV_STAGES;
 extern const ConfigInfo<bool> GFX_SW_DUMP_TEV_TEX_FETCHES;
 extern const ConfigInfo<int> GFX_SW_DRAW_START;
 extern const ConfigInfo<int> GFX_SW_DRAW_END;
+extern const ConfigInfo<int> GFX_SW_RASTERIZER_THREADS;
+extern const ConfigInfo<bool> GFX_SW_HEADLESS;
 
 extern const ConfigInfo<bool> GFX_PREFER_GLES;
 
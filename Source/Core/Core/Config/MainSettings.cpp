@@ -21,6 +21,12 @@ const ConfigInfo<bool> MAIN_FASTMEM{{System::Main, "Core", "Fastmem"}, true};
 const ConfigInfo<bool> MAIN_DSP_HLE{{System::Main, "Core", "DSPHLE"}, true};
 const ConfigInfo<int> MAIN_TIMING_VARIANCE{{System::Main, "Core", "TimingVariance"}, 40};
 const ConfigInfo<bool> MAIN_CPU_THREAD{{System::Main, "Core", "CPUThread"}, true};
+const ConfigInfo<bool> MAIN_JIT_TRACE_COMPILATION{{System::Main, "Core", "JITTraceCompilation"},
+                                                  false};
+const ConfigInfo<int> MAIN_JIT_TIER_UP_THRESHOLD{{System::Main, "Core", "JITTierUpThreshold"}, 0};
+const ConfigInfo<int> MAIN_REWIND_INTERVAL{{System::Main, "Core", "RewindInterval"}, 0};
+const ConfigInfo<int> MAIN_REWIND_MEMORY_MB{{System::Main, "Core", "RewindMemoryMB"}, 256};
+const ConfigInfo<int> MAIN_GCZ_CACHE_MB{{System::Main, "Core", "GCZCacheMB"}, 32};
 const ConfigInfo<bool> MAIN_SYNC_ON_SKIP_IDLE{{System::Main, "Core", "SyncOnSkipIdle"}, true};
 const ConfigInfo<std::string> MAIN_DEFAULT_ISO{{System::Main, "Core", "DefaultISO"}, ""};
 const ConfigInfo<bool> MAIN_ENABLE_CHEATS{{System::Main, "Core", "EnableCheats"}, false};
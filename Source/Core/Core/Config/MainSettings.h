@@ -19,6 +19,11 @@ extern const ConfigInfo<bool> MAIN_FASTMEM;
 extern const ConfigInfo<bool> MAIN_DSP_HLE;
 extern const ConfigInfo<int> MAIN_TIMING_VARIANCE;
 extern const ConfigInfo<bool> MAIN_CPU_THREAD;
+extern const ConfigInfo<bool> MAIN_JIT_TRACE_COMPILATION;
+extern const ConfigInfo<int> MAIN_JIT_TIER_UP_THRESHOLD;
+extern const ConfigInfo<int> MAIN_REWIND_INTERVAL;
+extern const ConfigInfo<int> MAIN_REWIND_MEMORY_MB;
+extern const ConfigInfo<int> MAIN_GCZ_CACHE_MB;
 extern const ConfigInfo<bool> MAIN_SYNC_ON_SKIP_IDLE;
 extern const ConfigInfo<std::string> MAIN_DEFAULT_ISO;
 extern const ConfigInfo<bool> MAIN_ENABLE_CHEATS;
@@ -29,7 +29,8 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
 
       Config::GFX_WIDESCREEN_HACK.location, Config::GFX_ASPECT_RATIO.location,
       Config::GFX_CROP.location, Config::GFX_USE_XFB.location, Config::GFX_USE_REAL_XFB.location,
-      Config::GFX_SAFE_TEXTURE_CACHE_COLOR_SAMPLES.location, Config::GFX_SHOW_FPS.location,
+      Config::GFX_SAFE_TEXTURE_CACHE_COLOR_SAMPLES.location,
+      Config::GFX_INCREMENTAL_TEXTURE_HASH.location, Config::GFX_SHOW_FPS.location,
       Config::GFX_SHOW_NETPLAY_PING.location, Config::GFX_SHOW_NETPLAY_MESSAGES.location,
       Config::GFX_LOG_RENDER_TIME_TO_FILE.location, Config::GFX_OVERLAY_STATS.location,
       Config::GFX_OVERLAY_PROJ_STATS.location, Config::GFX_DUMP_TEXTURES.location,
@@ -49,12 +50,14 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
       Config::GFX_BACKGROUND_SHADER_COMPILING.location,
       Config::GFX_DISABLE_SPECIALIZED_SHADERS.location,
       Config::GFX_PRECOMPILE_UBER_SHADERS.location, Config::GFX_SHADER_COMPILER_THREADS.location,
-      Config::GFX_SHADER_PRECOMPILER_THREADS.location,
+      Config::GFX_SHADER_PRECOMPILER_THREADS.location, Config::GFX_TEXTURE_DECODE_THREADS.location,
+      Config::GFX_TEXTURE_DISK_CACHE.location,
 
       Config::GFX_SW_ZCOMPLOC.location, Config::GFX_SW_ZFREEZE.location,
       Config::GFX_SW_DUMP_OBJECTS.location, Config::GFX_SW_DUMP_TEV_STAGES.location,
       Config::GFX_SW_DUMP_TEV_TEX_FETCHES.location, Config::GFX_SW_DRAW_START.location,
-      Config::GFX_SW_DRAW_END.location,
+      Config::GFX_SW_DRAW_END.location, Config::GFX_SW_RASTERIZER_THREADS.location,
+      Config::GFX_SW_HEADLESS.location,
 
       // Graphics.Enhancements
 
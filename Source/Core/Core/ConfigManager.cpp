@@ -27,6 +27,7 @@
 #include "Core/Analytics.h"
 #include "Core/Boot/Boot.h"
 #include "Core/CommonTitles.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/Config/SYSCONFSettings.h"
 #include "Core/ConfigLoaders/GameConfigLoader.h"
 #include "Core/Core.h"
@@ -42,6 +43,7 @@
 #include "Core/TitleDatabase.h"
 #include "VideoCommon/HiresTextures.h"
 
+#include "DiscIO/CompressedBlob.h"
 #include "DiscIO/Enums.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/WiiWad.h"
@@ -581,6 +583,9 @@ void SConfig::LoadCoreSettings(IniFile& ini)
   // Default to seconds between 1.1.1970 and 1.1.2000
   core->Get("CustomRTCValue", &m_customRTCValue, 946684800);
   core->Get("EnableSignatureChecks", &m_enable_signature_checks, true);
+
+  DiscIO::SetGCZCacheSize(static_cast<u64>(std::max(Config::Get(Config::MAIN_GCZ_CACHE_MB), 0))
+                          << 20);
 }
 
 void SConfig::LoadMovieSettings(IniFile& ini)
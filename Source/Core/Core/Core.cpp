@@ -50,6 +50,7 @@
 #include "Core/HW/GCKeyboard.h"
 #include "Core/HW/GCPad.h"
 #include "Core/HW/HW.h"
+#include "Core/HW/Memmap.h"
 #include "Core/HW/SystemTimers.h"
 #include "Core/HW/VideoInterface.h"
 #include "Core/HW/Wiimote.h"
@@ -349,7 +350,10 @@ static void CpuThread()
   DolphinAnalytics::Instance()->ReportGameStart();
 
   if (_CoreParameter.bFastmem)
+  {
     EMM::InstallExceptionHandler();  // Let's run under memory watch
+    Memory::EnableWriteTracking();
+  }
 
   if (!s_state_filename.empty())
   {
@@ -396,7 +400,10 @@ static void CpuThread()
     g_video_backend->Video_Cleanup();
 
   if (_CoreParameter.bFastmem)
+  {
+    Memory::DisableWriteTracking();
     EMM::UninstallExceptionHandler();
+  }
 }
 
 static void FifoPlayerThread()
@@ -415,6 +422,13 @@ static void FifoPlayerThread()
     Common::SetCurrentThreadName("FIFO-GPU thread");
   }
 
+  // The fifo player doesn't use the JIT, but the texture cache can use write tracking.
+  if (_CoreParameter.bFastmem)
+  {
+    EMM::InstallExceptionHandler();
+    Memory::EnableWriteTracking();
+  }
+
   // Enter CPU run loop. When we leave it - we are done.
   if (auto cpu_core = FifoPlayer::GetInstance().GetCPUCore())
   {
@@ -446,6 +460,12 @@ static void FifoPlayerThread()
 
   if (!_CoreParameter.bCPUThread)
     g_video_backend->Video_Cleanup();
+
+  if (_CoreParameter.bFastmem)
+  {
+    Memory::DisableWriteTracking();
+    EMM::UninstallExceptionHandler();
+  }
 }
 
 // Initialize and create emulation thread
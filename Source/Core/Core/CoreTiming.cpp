@@ -31,6 +31,8 @@ struct EventType
 {
   TimedCallback callback;
   const std::string* name;
+  // Positions in s_event_queue of all pending events of this type.
+  std::vector<size_t> queue_positions;
 };
 
 struct Event
@@ -39,6 +41,8 @@ struct Event
   u64 fifo_order;
   u64 userdata;
   EventType* type;
+  // Index of this event's entry in type->queue_positions. Not saved.
+  size_t type_slot;
 };
 
 // Sort by time, unless the times are the same, in which case sort by the order added to the queue
@@ -56,14 +60,14 @@ static bool operator<(const Event& left, const Event& right)
 static std::unordered_map<std::string, EventType> s_event_types;
 
 // STATE_TO_SAVE
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
+// The queue is an indexed binary min-heap. Every event type knows where its pending events are
+// in the heap, so RemoveEvent() costs O(log n) per removed event instead of a scan of the whole
+// queue followed by a rebuild. (time, fifo_order) is unique, so events are always run in the same
+// order regardless of the layout of the heap.
 static std::vector<Event> s_event_queue;
 static u64 s_event_fifo_id;
 static std::mutex s_ts_write_lock;
-static Common::FifoQueue<Event, false> s_ts_queue;
+static Common::RingFifoQueue<Event, false> s_ts_queue;
 
 static float s_last_OC_factor;
 static constexpr int MAX_SLICE_LENGTH = 20000;
@@ -83,6 +87,103 @@ static void EmptyTimedCallback(u64 userdata, s64 cyclesLate)
 {
 }
 
+static void SetQueuePosition(size_t pos)
+{
+  const Event& ev = s_event_queue[pos];
+  ev.type->queue_positions[ev.type_slot] = pos;
+}
+
+static void SwapEvents(size_t a, size_t b)
+{
+  std::swap(s_event_queue[a], s_event_queue[b]);
+  SetQueuePosition(a);
+  SetQueuePosition(b);
+}
+
+static void SiftUp(size_t pos)
+{
+  while (pos > 0)
+  {
+    const size_t parent = (pos - 1) / 2;
+    if (!(s_event_queue[pos] < s_event_queue[parent]))
+      break;
+    SwapEvents(pos, parent);
+    pos = parent;
+  }
+}
+
+static void SiftDown(size_t pos)
+{
+  const size_t size = s_event_queue.size();
+  while (true)
+  {
+    size_t smallest = pos;
+    const size_t left = pos * 2 + 1;
+    const size_t right = left + 1;
+    if (left < size && s_event_queue[left] < s_event_queue[smallest])
+      smallest = left;
+    if (right < size && s_event_queue[right] < s_event_queue[smallest])
+      smallest = right;
+    if (smallest == pos)
+      break;
+    SwapEvents(pos, smallest);
+    pos = smallest;
+  }
+}
+
+static void PushEvent(Event ev)
+{
+  const size_t pos = s_event_queue.size();
+  ev.type_slot = ev.type->queue_positions.size();
+  ev.type->queue_positions.push_back(pos);
+  s_event_queue.push_back(std::move(ev));
+  SiftUp(pos);
+}
+
+static Event RemoveEventAt(size_t pos)
+{
+  Event ev = std::move(s_event_queue[pos]);
+
+  // Unlink from the type's position list by moving its last entry into the gap.
+  std::vector<size_t>& positions = ev.type->queue_positions;
+  const size_t last_of_type = positions.back();
+  positions.pop_back();
+  if (ev.type_slot != positions.size())
+  {
+    positions[ev.type_slot] = last_of_type;
+    s_event_queue[last_of_type].type_slot = ev.type_slot;
+  }
+
+  const size_t last = s_event_queue.size() - 1;
+  if (pos != last)
+  {
+    s_event_queue[pos] = std::move(s_event_queue[last]);
+    SetQueuePosition(pos);
+  }
+  s_event_queue.pop_back();
+
+  if (pos < s_event_queue.size())
+  {
+    SiftUp(pos);
+    SiftDown(pos);
+  }
+  return ev;
+}
+
+// Re-establishes the heap and the per-type positions after s_event_queue was replaced.
+static void RebuildEventQueue()
+{
+  std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+  for (auto& entry : s_event_types)
+    entry.second.queue_positions.clear();
+  for (size_t pos = 0; pos < s_event_queue.size(); ++pos)
+  {
+    Event& ev = s_event_queue[pos];
+    ev.type_slot = ev.type->queue_positions.size();
+    ev.type->queue_positions.push_back(pos);
+  }
+}
+
 // Changing the CPU speed in Dolphin isn't actually done by changing the physical clock rate,
 // but by changing the amount of work done in a particular amount of time. This tends to be more
 // compatible because it stops the games from actually knowing directly that the clock rate has
@@ -109,7 +210,7 @@ EventType* RegisterEvent(const std::string& name, TimedCallback callback)
                "during Init to avoid breaking save states.",
                name.c_str());
 
-  auto info = s_event_types.emplace(name, EventType{callback, nullptr});
+  auto info = s_event_types.emplace(name, EventType{callback, nullptr, {}});
   EventType* event_type = &info.first->second;
   event_type->name = &info.first->first;
   return event_type;
@@ -202,7 +303,7 @@ void DoState(PointerWrap& p)
   // The exact layout of the heap in memory is implementation defined, therefore it is platform
   // and library version specific.
   if (p.GetMode() == PointerWrap::MODE_READ)
-    std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    RebuildEventQueue();
 }
 
 // This should only be called from the CPU thread. If you are calling
@@ -226,6 +327,8 @@ u64 GetIdleTicks()
 void ClearPendingEvents()
 {
   s_event_queue.clear();
+  for (auto& entry : s_event_types)
+    entry.second.queue_positions.clear();
 }
 
 void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata, FromThread from)
@@ -253,8 +356,7 @@ void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata,
     if (!s_is_global_timer_sane)
       ForceExceptionCheck(cycles_into_future);
 
-    s_event_queue.emplace_back(Event{timeout, s_event_fifo_id++, userdata, event_type});
-    std::push_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    PushEvent(Event{timeout, s_event_fifo_id++, userdata, event_type});
   }
   else
   {
@@ -272,15 +374,12 @@ void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata,
 
 void RemoveEvent(EventType* event_type)
 {
-  auto itr = std::remove_if(s_event_queue.begin(), s_event_queue.end(),
-                            [&](const Event& e) { return e.type == event_type; });
+  // This gets called during PowerPC::Reset, before the events are registered.
+  if (!event_type)
+    return;
 
-  // Removing random items breaks the invariant so we have to re-establish it.
-  if (itr != s_event_queue.end())
-  {
-    s_event_queue.erase(itr, s_event_queue.end());
-    std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
-  }
+  while (!event_type->queue_positions.empty())
+    RemoveEventAt(event_type->queue_positions.back());
 }
 
 void RemoveAllEvents(EventType* event_type)
@@ -306,8 +405,7 @@ void MoveEvents()
   for (Event ev; s_ts_queue.Pop(ev);)
   {
     ev.fifo_order = s_event_fifo_id++;
-    s_event_queue.emplace_back(std::move(ev));
-    std::push_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    PushEvent(std::move(ev));
   }
 }
 
@@ -325,9 +423,7 @@ void Advance()
 
   while (!s_event_queue.empty() && s_event_queue.front().time <= g.global_timer)
   {
-    Event evt = std::move(s_event_queue.front());
-    std::pop_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
-    s_event_queue.pop_back();
+    Event evt = RemoveEventAt(0);
     // NOTICE_LOG(POWERPC, "[Scheduler] %-20s (%lld, %lld)", evt.type->name->c_str(),
     //            g.global_timer, evt.time);
     evt.type->callback(evt.userdata, g.global_timer - evt.time);
@@ -370,6 +466,9 @@ void AdjustEventQueueTimes(u32 new_ppc_clock, u32 old_ppc_clock)
     const s64 ticks = (ev.time - g.global_timer) * new_ppc_clock / old_ppc_clock;
     ev.time = g.global_timer + ticks;
   }
+
+  // Rounding can make distinct times equal, after which fifo_order decides.
+  RebuildEventQueue();
 }
 
 void Idle()
@@ -10,13 +10,18 @@
 #include <string>
 #include <vector>
 
+#include <zlib.h>
+
 #include "Common/File.h"
+#include "Common/Logging/Log.h"
+#include "Common/MappedFile.h"
 
 enum
 {
   FILE_ID = 0x0d01f1f0,
-  VERSION_NUMBER = 4,
-  MIN_LOADER_VERSION = 1,
+  VERSION_NUMBER = 5,
+  // Frames are compressed since version 5
+  MIN_LOADER_VERSION = 5,
 };
 
 #pragma pack(push, 1)
@@ -51,7 +56,12 @@ struct FileFrameInfo
   u32 fifoEnd;
   u64 memoryUpdatesOffset;
   u32 numMemoryUpdates;
-  u8 reserved[32];
+  // Since version 5, the fifo data and memory updates of a frame are stored together in a chunk
+  // compressed with zlib, and the offsets above are relative to the decompressed chunk.
+  u64 compressedOffset;
+  u32 compressedSize;
+  u32 uncompressedSize;
+  u8 reserved[16];
 };
 static_assert(sizeof(FileFrameInfo) == 64, "FileFrameInfo should be 64 bytes");
 
@@ -89,7 +99,75 @@ bool FifoDataFile::GetIsWii() const
 
 void FifoDataFile::AddFrame(const FifoFrameInfo& frameInfo)
 {
-  m_Frames.push_back(frameInfo);
+  m_Frames.push_back(std::make_shared<const FifoFrameInfo>(frameInfo));
+}
+
+std::shared_ptr<const FifoFrameInfo> FifoDataFile::GetFrame(u32 frame) const
+{
+  if (!m_MappedFile)
+    return m_Frames[frame];
+
+  std::lock_guard<std::mutex> lk(m_FrameCacheLock);
+  auto iter = std::find_if(m_FrameCache.begin(), m_FrameCache.end(),
+                           [frame](const auto& entry) { return entry.first == frame; });
+  if (iter != m_FrameCache.end())
+  {
+    // Keep the most recently used frames at the front
+    std::rotate(m_FrameCache.begin(), iter, iter + 1);
+    return m_FrameCache.front().second;
+  }
+
+  auto loaded = std::make_shared<FifoFrameInfo>();
+  if (!ReadFrame(m_FrameIndex[frame], loaded.get()))
+  {
+    // Play the frame as empty rather than stopping the whole file
+    ERROR_LOG(VIDEO, "Fifo log frame %u is corrupt", frame);
+    *loaded = FifoFrameInfo{};
+  }
+
+  if (m_FrameCache.size() >= FRAME_CACHE_SIZE)
+    m_FrameCache.pop_back();
+  m_FrameCache.emplace(m_FrameCache.begin(), frame, loaded);
+  return loaded;
+}
+
+u32 FifoDataFile::GetFrameCount() const
+{
+  if (m_MappedFile)
+    return static_cast<u32>(m_FrameIndex.size());
+  return static_cast<u32>(m_Frames.size());
+}
+
+// Lays out the fifo data and memory updates of a frame the way they are stored in version 4
+// files, with offsets relative to the start of the chunk.
+static std::vector<u8> SerializeFrame(const FifoFrameInfo& frame, FileFrameInfo* frameInfo)
+{
+  std::vector<u8> chunk(frame.fifoData);
+  frameInfo->fifoDataOffset = 0;
+  frameInfo->fifoDataSize = static_cast<u32>(frame.fifoData.size());
+  frameInfo->fifoStart = frame.fifoStart;
+  frameInfo->fifoEnd = frame.fifoEnd;
+  frameInfo->memoryUpdatesOffset = chunk.size();
+  frameInfo->numMemoryUpdates = static_cast<u32>(frame.memoryUpdates.size());
+
+  chunk.resize(chunk.size() + frame.memoryUpdates.size() * sizeof(FileMemoryUpdate));
+  for (size_t i = 0; i < frame.memoryUpdates.size(); ++i)
+  {
+    const MemoryUpdate& srcUpdate = frame.memoryUpdates[i];
+
+    FileMemoryUpdate dstUpdate = {};
+    dstUpdate.address = srcUpdate.address;
+    dstUpdate.dataOffset = chunk.size();
+    dstUpdate.dataSize = static_cast<u32>(srcUpdate.data.size());
+    dstUpdate.fifoPosition = srcUpdate.fifoPosition;
+    dstUpdate.type = srcUpdate.type;
+    std::memcpy(&chunk[frameInfo->memoryUpdatesOffset + i * sizeof(FileMemoryUpdate)], &dstUpdate,
+                sizeof(FileMemoryUpdate));
+
+    chunk.insert(chunk.end(), srcUpdate.data.begin(), srcUpdate.data.end());
+  }
+
+  return chunk;
 }
 
 bool FifoDataFile::Save(const std::string& filename)
@@ -103,7 +181,7 @@ bool FifoDataFile::Save(const std::string& filename)
 
   // Add space for frame list
   u64 frameListOffset = file.Tell();
-  PadFile(m_Frames.size() * sizeof(FileFrameInfo), file);
+  PadFile(GetFrameCount() * sizeof(FileFrameInfo), file);
 
   u64 bpMemOffset = file.Tell();
   file.WriteArray(m_BPMem, BP_MEM_SIZE);
@@ -121,7 +199,7 @@ bool FifoDataFile::Save(const std::string& filename)
   file.WriteArray(m_TexMem, TEX_MEM_SIZE);
 
   // Write header
-  FileHeader header;
+  FileHeader header = {};
   header.fileId = FILE_ID;
   header.file_version = VERSION_NUMBER;
   header.min_loader_version = MIN_LOADER_VERSION;
@@ -142,7 +220,7 @@ bool FifoDataFile::Save(const std::string& filename)
   header.texMemSize = TEX_MEM_SIZE;
 
   header.frameListOffset = frameListOffset;
-  header.frameCount = (u32)m_Frames.size();
+  header.frameCount = GetFrameCount();
 
   header.flags = m_Flags;
 
@@ -150,24 +228,26 @@ bool FifoDataFile::Save(const std::string& filename)
   file.WriteBytes(&header, sizeof(FileHeader));
 
   // Write frames list
-  for (unsigned int i = 0; i < m_Frames.size(); ++i)
+  std::vector<u8> compressed;
+  for (u32 i = 0; i < GetFrameCount(); ++i)
   {
-    const FifoFrameInfo& srcFrame = m_Frames[i];
-
-    // Write FIFO data
+    FileFrameInfo dstFrame = {};
+    const std::vector<u8> chunk = SerializeFrame(*GetFrame(i), &dstFrame);
+
+    uLongf compressed_size = compressBound(static_cast<uLong>(chunk.size()));
+    compressed.resize(compressed_size);
+    if (compress(compressed.data(), &compressed_size, chunk.data(),
+                 static_cast<uLong>(chunk.size())) != Z_OK)
+    {
+      return false;
+    }
+
+    // Write the compressed fifo data and memory updates
     file.Seek(0, SEEK_END);
-    u64 dataOffset = file.Tell();
-    file.WriteBytes(srcFrame.fifoData.data(), srcFrame.fifoData.size());
-
-    u64 memoryUpdatesOffset = WriteMemoryUpdates(srcFrame.memoryUpdates, file);
-
-    FileFrameInfo dstFrame;
-    dstFrame.fifoDataSize = static_cast<u32>(srcFrame.fifoData.size());
-    dstFrame.fifoDataOffset = dataOffset;
-    dstFrame.fifoStart = srcFrame.fifoStart;
-    dstFrame.fifoEnd = srcFrame.fifoEnd;
-    dstFrame.memoryUpdatesOffset = memoryUpdatesOffset;
-    dstFrame.numMemoryUpdates = static_cast<u32>(srcFrame.memoryUpdates.size());
+    dstFrame.compressedOffset = file.Tell();
+    dstFrame.compressedSize = static_cast<u32>(compressed_size);
+    dstFrame.uncompressedSize = static_cast<u32>(chunk.size());
+    file.WriteBytes(compressed.data(), compressed_size);
 
     // Write frame info
     u64 frameOffset = frameListOffset + (i * sizeof(FileFrameInfo));
@@ -181,21 +261,25 @@ bool FifoDataFile::Save(const std::string& filename)
   return true;
 }
 
+static bool IsInRange(u64 offset, u64 size, u64 end)
+{
+  return offset <= end && size <= end - offset;
+}
+
 std::unique_ptr<FifoDataFile> FifoDataFile::Load(const std::string& filename, bool flagsOnly)
 {
-  File::IOFile file;
-  file.Open(filename, "rb");
-  if (!file)
+  auto mappedFile = std::make_unique<File::MappedFile>(filename);
+  if (!mappedFile->IsOpen() || mappedFile->GetSize() < sizeof(FileHeader))
     return nullptr;
 
+  const u8* const data = mappedFile->GetData();
+  const u64 fileSize = mappedFile->GetSize();
+
   FileHeader header;
-  file.ReadBytes(&header, sizeof(header));
+  std::memcpy(&header, data, sizeof(header));
 
   if (header.fileId != FILE_ID || header.min_loader_version > VERSION_NUMBER)
-  {
-    file.Close();
     return nullptr;
-  }
 
   auto dataFile = std::make_unique<FifoDataFile>();
 
@@ -203,61 +287,100 @@ std::unique_ptr<FifoDataFile> FifoDataFile::Load(const std::string& filename, bo
   dataFile->m_Version = header.file_version;
 
   if (flagsOnly)
-  {
-    file.Close();
     return dataFile;
+
+  const auto read_array = [&](auto* dst, u32 count, u64 offset, u32 fileCount) {
+    count = std::min(count, fileCount);
+    if (!IsInRange(offset, count * sizeof(*dst), fileSize))
+      return false;
+    std::memcpy(dst, data + offset, count * sizeof(*dst));
+    return true;
+  };
+
+  if (!read_array(dataFile->m_BPMem, BP_MEM_SIZE, header.bpMemOffset, header.bpMemSize) ||
+      !read_array(dataFile->m_CPMem, CP_MEM_SIZE, header.cpMemOffset, header.cpMemSize) ||
+      !read_array(dataFile->m_XFMem, XF_MEM_SIZE, header.xfMemOffset, header.xfMemSize) ||
+      !read_array(dataFile->m_XFRegs, XF_REGS_SIZE, header.xfRegsOffset, header.xfRegsSize))
+  {
+    return nullptr;
+  }
+
+  // Texture memory saving was added in version 4.
+  std::memset(dataFile->m_TexMem, 0, TEX_MEM_SIZE);
+  if (dataFile->m_Version >= 4 &&
+      !read_array(dataFile->m_TexMem, TEX_MEM_SIZE, header.texMemOffset, header.texMemSize))
+  {
+    return nullptr;
   }
 
-  u32 size = std::min<u32>(BP_MEM_SIZE, header.bpMemSize);
-  file.Seek(header.bpMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_BPMem, size);
+  // Only the frame list is read here, the frames themselves are read on demand.
+  if (!IsInRange(header.frameListOffset, u64{header.frameCount} * sizeof(FileFrameInfo), fileSize))
+    return nullptr;
 
-  size = std::min<u32>(CP_MEM_SIZE, header.cpMemSize);
-  file.Seek(header.cpMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_CPMem, size);
+  dataFile->m_FrameIndex.resize(header.frameCount);
+  std::memcpy(dataFile->m_FrameIndex.data(), data + header.frameListOffset,
+              header.frameCount * sizeof(FileFrameInfo));
 
-  size = std::min<u32>(XF_MEM_SIZE, header.xfMemSize);
-  file.Seek(header.xfMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_XFMem, size);
+  dataFile->m_MappedFile = std::move(mappedFile);
+  return dataFile;
+}
 
-  size = std::min<u32>(XF_REGS_SIZE, header.xfRegsSize);
-  file.Seek(header.xfRegsOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_XFRegs, size);
+bool FifoDataFile::ReadFrame(const FileFrameInfo& srcFrame, FifoFrameInfo* dstFrame) const
+{
+  // Before version 5, the offsets in the frame info are relative to the start of the file. Since
+  // then, they are relative to the decompressed chunk holding the frame.
+  const u8* data = m_MappedFile->GetData();
+  u64 size = m_MappedFile->GetSize();
 
-  // Texture memory saving was added in version 4.
-  std::memset(dataFile->m_TexMem, 0, TEX_MEM_SIZE);
-  if (dataFile->m_Version >= 4)
+  std::vector<u8> chunk;
+  if (m_Version >= 5)
   {
-    size = std::min<u32>(TEX_MEM_SIZE, header.texMemSize);
-    file.Seek(header.texMemOffset, SEEK_SET);
-    file.ReadArray(dataFile->m_TexMem, size);
+    if (!IsInRange(srcFrame.compressedOffset, srcFrame.compressedSize, size))
+      return false;
+
+    chunk.resize(srcFrame.uncompressedSize);
+    uLongf chunk_size = srcFrame.uncompressedSize;
+    if (uncompress(chunk.data(), &chunk_size, data + srcFrame.compressedOffset,
+                   srcFrame.compressedSize) != Z_OK ||
+        chunk_size != srcFrame.uncompressedSize)
+    {
+      return false;
+    }
+
+    data = chunk.data();
+    size = chunk.size();
   }
 
-  // Read frames
-  for (u32 i = 0; i < header.frameCount; ++i)
+  if (!IsInRange(srcFrame.fifoDataOffset, srcFrame.fifoDataSize, size) ||
+      !IsInRange(srcFrame.memoryUpdatesOffset,
+                 u64{srcFrame.numMemoryUpdates} * sizeof(FileMemoryUpdate), size))
   {
-    u64 frameOffset = header.frameListOffset + (i * sizeof(FileFrameInfo));
-    file.Seek(frameOffset, SEEK_SET);
-    FileFrameInfo srcFrame;
-    file.ReadBytes(&srcFrame, sizeof(FileFrameInfo));
-
-    FifoFrameInfo dstFrame;
-    dstFrame.fifoData.resize(srcFrame.fifoDataSize);
-    dstFrame.fifoStart = srcFrame.fifoStart;
-    dstFrame.fifoEnd = srcFrame.fifoEnd;
+    return false;
+  }
 
-    file.Seek(srcFrame.fifoDataOffset, SEEK_SET);
-    file.ReadBytes(dstFrame.fifoData.data(), srcFrame.fifoDataSize);
+  const u8* fifoData = data + srcFrame.fifoDataOffset;
+  dstFrame->fifoData.assign(fifoData, fifoData + srcFrame.fifoDataSize);
+  dstFrame->fifoStart = srcFrame.fifoStart;
+  dstFrame->fifoEnd = srcFrame.fifoEnd;
 
-    ReadMemoryUpdates(srcFrame.memoryUpdatesOffset, srcFrame.numMemoryUpdates,
-                      dstFrame.memoryUpdates, file);
+  dstFrame->memoryUpdates.resize(srcFrame.numMemoryUpdates);
+  for (u32 i = 0; i < srcFrame.numMemoryUpdates; ++i)
+  {
+    FileMemoryUpdate srcUpdate;
+    std::memcpy(&srcUpdate, data + srcFrame.memoryUpdatesOffset + i * sizeof(FileMemoryUpdate),
+                sizeof(FileMemoryUpdate));
+    if (!IsInRange(srcUpdate.dataOffset, srcUpdate.dataSize, size))
+      return false;
 
-    dataFile->AddFrame(dstFrame);
+    MemoryUpdate& dstUpdate = dstFrame->memoryUpdates[i];
+    dstUpdate.address = srcUpdate.address;
+    dstUpdate.fifoPosition = srcUpdate.fifoPosition;
+    dstUpdate.data.assign(data + srcUpdate.dataOffset,
+                          data + srcUpdate.dataOffset + srcUpdate.dataSize);
+    dstUpdate.type = static_cast<MemoryUpdate::Type>(srcUpdate.type);
   }
 
-  file.Close();
-
-  return dataFile;
+  return true;
 }
 
 void FifoDataFile::PadFile(size_t numBytes, File::IOFile& file)
@@ -278,57 +401,3 @@ bool FifoDataFile::GetFlag(u32 flag) const
 {
   return !!(m_Flags & flag);
 }
-
-u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates,
-                                     File::IOFile& file)
-{
-  // Add space for memory update list
-  u64 updateListOffset = file.Tell();
-  PadFile(memUpdates.size() * sizeof(FileMemoryUpdate), file);
-
-  for (unsigned int i = 0; i < memUpdates.size(); ++i)
-  {
-    const MemoryUpdate& srcUpdate = memUpdates[i];
-
-    // Write memory
-    file.Seek(0, SEEK_END);
-    u64 dataOffset = file.Tell();
-    file.WriteBytes(srcUpdate.data.data(), srcUpdate.data.size());
-
-    FileMemoryUpdate dstUpdate;
-    dstUpdate.address = srcUpdate.address;
-    dstUpdate.dataOffset = dataOffset;
-    dstUpdate.dataSize = static_cast<u32>(srcUpdate.data.size());
-    dstUpdate.fifoPosition = srcUpdate.fifoPosition;
-    dstUpdate.type = srcUpdate.type;
-
-    u64 updateOffset = updateListOffset + (i * sizeof(FileMemoryUpdate));
-    file.Seek(updateOffset, SEEK_SET);
-    file.WriteBytes(&dstUpdate, sizeof(FileMemoryUpdate));
-  }
-
-  return updateListOffset;
-}
-
-void FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates,
-                                     std::vector<MemoryUpdate>& memUpdates, File::IOFile& file)
-{
-  memUpdates.resize(numUpdates);
-
-  for (u32 i = 0; i < numUpdates; ++i)
-  {
-    u64 updateOffset = fileOffset + (i * sizeof(FileMemoryUpdate));
-    file.Seek(updateOffset, SEEK_SET);
-    FileMemoryUpdate srcUpdate;
-    file.ReadBytes(&srcUpdate, sizeof(FileMemoryUpdate));
-
-    MemoryUpdate& dstUpdate = memUpdates[i];
-    dstUpdate.address = srcUpdate.address;
-    dstUpdate.fifoPosition = srcUpdate.fifoPosition;
-    dstUpdate.data.resize(srcUpdate.dataSize);
-    dstUpdate.type = static_cast<MemoryUpdate::Type>(srcUpdate.type);
-
-    file.Seek(srcUpdate.dataOffset, SEEK_SET);
-    file.ReadBytes(dstUpdate.data.data(), srcUpdate.dataSize);
-  }
-}
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -13,8 +15,11 @@
 namespace File
 {
 class IOFile;
+class MappedFile;
 }
 
+struct FileFrameInfo;
+
 struct MemoryUpdate
 {
   enum Type
@@ -67,10 +72,13 @@ public:
   u32* GetXFRegs() { return m_XFRegs; }
   u8* GetTexMem() { return m_TexMem; }
   void AddFrame(const FifoFrameInfo& frameInfo);
-  const FifoFrameInfo& GetFrame(u32 frame) const { return m_Frames[frame]; }
-  u32 GetFrameCount() const { return static_cast<u32>(m_Frames.size()); }
+  // The frames of a loaded file are only read (and decompressed) when asked for, and only the most
+  // recently used ones are kept around, so callers should hold on to the frame they are using.
+  std::shared_ptr<const FifoFrameInfo> GetFrame(u32 frame) const;
+  u32 GetFrameCount() const;
   bool Save(const std::string& filename);
 
+  // The file stays mapped into memory for as long as the returned object exists.
   static std::unique_ptr<FifoDataFile> Load(const std::string& filename, bool flagsOnly);
 
 private:
@@ -79,14 +87,17 @@ private:
     FLAG_IS_WII = 1
   };
 
+  enum
+  {
+    FRAME_CACHE_SIZE = 4
+  };
+
   void PadFile(size_t numBytes, File::IOFile& file);
 
   void SetFlag(u32 flag, bool set);
   bool GetFlag(u32 flag) const;
 
-  u64 WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates, File::IOFile& file);
-  static void ReadMemoryUpdates(u64 fileOffset, u32 numUpdates,
-                                std::vector<MemoryUpdate>& memUpdates, File::IOFile& file);
+  bool ReadFrame(const FileFrameInfo& srcFrame, FifoFrameInfo* dstFrame) const;
 
   u32 m_BPMem[BP_MEM_SIZE];
   u32 m_CPMem[CP_MEM_SIZE];
@@ -97,5 +108,12 @@ private:
   u32 m_Flags = 0;
   u32 m_Version = 0;
 
-  std::vector<FifoFrameInfo> m_Frames;
+  // Frames added while recording
+  std::vector<std::shared_ptr<const FifoFrameInfo>> m_Frames;
+
+  // Frames of a loaded file
+  std::unique_ptr<File::MappedFile> m_MappedFile;
+  std::vector<FileFrameInfo> m_FrameIndex;
+  mutable std::mutex m_FrameCacheLock;
+  mutable std::vector<std::pair<u32, std::shared_ptr<const FifoFrameInfo>>> m_FrameCache;
 };
@@ -7,16 +7,23 @@
 #include <string>
 #include <vector>
 
+#include "Core/FifoPlayer/FifoAnalyzer.h"
 #include "Core/FifoPlayer/FifoDataFile.h"
 
 struct AnalyzedFrameInfo
 {
   std::vector<u32> objectStarts;
   std::vector<u32> objectEnds;
-  std::vector<MemoryUpdate> memoryUpdates;
 };
 
 namespace FifoPlaybackAnalyzer
 {
-void AnalyzeFrames(FifoDataFile* file, std::vector<AnalyzedFrameInfo>& frameInfo);
+// Returns the CP state at the start of the first frame.
+FifoAnalyzer::CPMemory GetInitialCPMemory(FifoDataFile* file);
+
+// Finds the objects drawn by a frame. The vertex formats used by a frame depend on the frames
+// before it, so cpMem has to hold the CP state at the start of the frame, and is updated to the
+// state at its end. Returns false if a command couldn't be decoded.
+bool AnalyzeFrame(const FifoFrameInfo& frame, FifoAnalyzer::CPMemory* cpMem,
+                  AnalyzedFrameInfo* analyzed);
 }  // namespace FifoPlaybackAnalyzer
@@ -48,7 +48,9 @@ bool FifoPlayer::Open(const std::string& filename)
   if (m_File)
   {
     FifoAnalyzer::Init();
-    FifoPlaybackAnalyzer::AnalyzeFrames(m_File.get(), m_FrameInfo);
+    m_FrameInfo.resize(m_File->GetFrameCount());
+    m_NumAnalyzedFrames = 0;
+    m_AnalysisCPMem = FifoPlaybackAnalyzer::GetInitialCPMemory(m_File.get());
 
     m_FrameRangeEnd = m_File->GetFrameCount();
   }
@@ -62,6 +64,8 @@ bool FifoPlayer::Open(const std::string& filename)
 void FifoPlayer::Close()
 {
   m_File.reset();
+  m_FrameInfo.clear();
+  m_NumAnalyzedFrames = 0;
 
   m_FrameRangeStart = 0;
   m_FrameRangeEnd = 0;
@@ -148,7 +152,7 @@ CPU::State FifoPlayer::AdvanceFrame()
   if (m_EarlyMemoryUpdates && m_CurrentFrame == m_FrameRangeStart)
     WriteAllMemoryUpdates();
 
-  WriteFrame(m_File->GetFrame(m_CurrentFrame), m_FrameInfo[m_CurrentFrame]);
+  WriteFrame(*m_File->GetFrame(m_CurrentFrame), GetAnalyzedFrameInfo(m_CurrentFrame));
 
   ++m_CurrentFrame;
   return CPU::State::Running;
@@ -162,16 +166,38 @@ std::unique_ptr<CPUCoreBase> FifoPlayer::GetCPUCore()
   return std::make_unique<CPUCore>(this);
 }
 
-u32 FifoPlayer::GetFrameObjectCount() const
+u32 FifoPlayer::GetFrameObjectCount()
 {
   if (m_CurrentFrame < m_FrameInfo.size())
   {
-    return (u32)(m_FrameInfo[m_CurrentFrame].objectStarts.size());
+    return (u32)(GetAnalyzedFrameInfo(m_CurrentFrame).objectStarts.size());
   }
 
   return 0;
 }
 
+const AnalyzedFrameInfo& FifoPlayer::GetAnalyzedFrameInfo(u32 frame)
+{
+  AnalyzeFrames(frame + 1);
+  return m_FrameInfo[frame];
+}
+
+void FifoPlayer::AnalyzeFrames(u32 end)
+{
+  std::lock_guard<std::mutex> lk(m_AnalysisLock);
+  for (; m_NumAnalyzedFrames < end; ++m_NumAnalyzedFrames)
+  {
+    AnalyzedFrameInfo& info = m_FrameInfo[m_NumAnalyzedFrames];
+    if (!FifoPlaybackAnalyzer::AnalyzeFrame(*m_File->GetFrame(m_NumAnalyzedFrames),
+                                            &m_AnalysisCPMem, &info))
+    {
+      // The commands after a bad one can't be decoded, so leave the remaining frames empty.
+      m_NumAnalyzedFrames = static_cast<u32>(m_FrameInfo.size());
+      break;
+    }
+  }
+}
+
 void FifoPlayer::SetFrameRangeStart(u32 start)
 {
   if (m_File)
@@ -285,7 +311,7 @@ void FifoPlayer::WriteFramePart(u32 dataStart, u32 dataEnd, u32& nextMemUpdate,
 
   while (nextMemUpdate < frame.memoryUpdates.size() && dataStart < dataEnd)
   {
-    const MemoryUpdate& memUpdate = info.memoryUpdates[nextMemUpdate];
+    const MemoryUpdate& memUpdate = frame.memoryUpdates[nextMemUpdate];
 
     if (memUpdate.fifoPosition < dataEnd)
     {
@@ -316,8 +342,8 @@ void FifoPlayer::WriteAllMemoryUpdates()
 
   for (u32 frameNum = 0; frameNum < m_File->GetFrameCount(); ++frameNum)
   {
-    const FifoFrameInfo& frame = m_File->GetFrame(frameNum);
-    for (auto& update : frame.memoryUpdates)
+    const auto frame = m_File->GetFrame(frameNum);
+    for (auto& update : frame->memoryUpdates)
     {
       WriteMemory(update);
     }
@@ -372,16 +398,16 @@ void FifoPlayer::SetupFifo()
   WriteCP(CommandProcessor::CTRL_REGISTER, 0);   // disable read, BP, interrupts
   WriteCP(CommandProcessor::CLEAR_REGISTER, 7);  // clear overflow, underflow, metrics
 
-  const FifoFrameInfo& frame = m_File->GetFrame(m_CurrentFrame);
+  const auto frame = m_File->GetFrame(m_CurrentFrame);
 
   // Set fifo bounds
-  WriteCP(CommandProcessor::FIFO_BASE_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_BASE_HI, frame.fifoStart >> 16);
-  WriteCP(CommandProcessor::FIFO_END_LO, frame.fifoEnd);
-  WriteCP(CommandProcessor::FIFO_END_HI, frame.fifoEnd >> 16);
+  WriteCP(CommandProcessor::FIFO_BASE_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_BASE_HI, frame->fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_END_LO, frame->fifoEnd);
+  WriteCP(CommandProcessor::FIFO_END_HI, frame->fifoEnd >> 16);
 
   // Set watermarks, high at 75%, low at 0%
-  u32 hi_watermark = (frame.fifoEnd - frame.fifoStart) * 3 / 4;
+  u32 hi_watermark = (frame->fifoEnd - frame->fifoStart) * 3 / 4;
   WriteCP(CommandProcessor::FIFO_HI_WATERMARK_LO, hi_watermark);
   WriteCP(CommandProcessor::FIFO_HI_WATERMARK_HI, hi_watermark >> 16);
   WriteCP(CommandProcessor::FIFO_LO_WATERMARK_LO, 0);
@@ -390,19 +416,19 @@ void FifoPlayer::SetupFifo()
   // Set R/W pointers to fifo start
   WriteCP(CommandProcessor::FIFO_RW_DISTANCE_LO, 0);
   WriteCP(CommandProcessor::FIFO_RW_DISTANCE_HI, 0);
-  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_HI, frame.fifoStart >> 16);
-  WriteCP(CommandProcessor::FIFO_READ_POINTER_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_READ_POINTER_HI, frame.fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_HI, frame->fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_READ_POINTER_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_READ_POINTER_HI, frame->fifoStart >> 16);
 
   // Set fifo bounds
-  WritePI(ProcessorInterface::PI_FIFO_BASE, frame.fifoStart);
-  WritePI(ProcessorInterface::PI_FIFO_END, frame.fifoEnd);
+  WritePI(ProcessorInterface::PI_FIFO_BASE, frame->fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_END, frame->fifoEnd);
 
   // Set write pointer
-  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame.fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame->fifoStart);
   FlushWGP();
-  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame.fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame->fifoStart);
 
   WriteCP(CommandProcessor::CTRL_REGISTER, 17);  // enable read & GP link
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -71,9 +72,10 @@ public:
   std::unique_ptr<CPUCoreBase> GetCPUCore();
 
   FifoDataFile* GetFile() const { return m_File.get(); }
-  u32 GetFrameObjectCount() const;
+  u32 GetFrameObjectCount();
   u32 GetCurrentFrameNum() const { return m_CurrentFrame; }
-  const AnalyzedFrameInfo& GetAnalyzedFrameInfo(u32 frame) const { return m_FrameInfo[frame]; }
+  // Frames are analyzed the first time they're needed, along with all frames before them.
+  const AnalyzedFrameInfo& GetAnalyzedFrameInfo(u32 frame);
   // Frame range
   u32 GetFrameRangeStart() const { return m_FrameRangeStart; }
   void SetFrameRangeStart(u32 start);
@@ -86,6 +88,9 @@ public:
   void SetObjectRangeStart(u32 start) { m_ObjectRangeStart = start; }
   u32 GetObjectRangeEnd() const { return m_ObjectRangeEnd; }
   void SetObjectRangeEnd(u32 end) { m_ObjectRangeEnd = end; }
+  // Whether playback restarts from the start of the frame range once it reaches the end
+  bool GetLoop() const { return m_Loop; }
+  void SetLoop(bool loop) { m_Loop = loop; }
   // If enabled then all memory updates happen at once before the first frame
   // Default is disabled
   void SetEarlyMemoryUpdates(bool enabled) { m_EarlyMemoryUpdates = enabled; }
@@ -101,6 +106,8 @@ private:
 
   CPU::State AdvanceFrame();
 
+  void AnalyzeFrames(u32 end);
+
   void WriteFrame(const FifoFrameInfo& frame, const AnalyzedFrameInfo& info);
   void WriteFramePart(u32 dataStart, u32 dataEnd, u32& nextMemUpdate, const FifoFrameInfo& frame,
                       const AnalyzedFrameInfo& info);
@@ -153,5 +160,12 @@ private:
 
   std::unique_ptr<FifoDataFile> m_File;
 
+  // Sized for all frames when opening a file, so that references to them stay valid. Only the
+  // first m_NumAnalyzedFrames are filled in.
   std::vector<AnalyzedFrameInfo> m_FrameInfo;
+  u32 m_NumAnalyzedFrames = 0;
+  // CP state at the end of the last analyzed frame
+  FifoAnalyzer::CPMemory m_AnalysisCPMem;
+  // Held while analyzing, since both the UI and playback ask for frames
+  std::mutex m_AnalysisLock;
 };
@@ -4,7 +4,10 @@
 
 #include "Core/HW/DVD/DVDThread.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -84,11 +87,38 @@ static Common::Event s_result_queue_expanded;     // Is set by DVD thread
 static Common::Flag s_dvd_thread_exiting(false);  // Is set by CPU thread
 
 static Common::FifoQueue<ReadRequest, false> s_request_queue;
-static Common::FifoQueue<ReadResult, false> s_result_queue;
+static Common::RingFifoQueue<ReadResult, false> s_result_queue;
 static std::map<u64, ReadResult> s_result_map;
 
 static std::unique_ptr<DiscIO::Volume> s_disc;
 
+// While the emulated software reads the disc sequentially, the DVD thread keeps reading ahead
+// when it has nothing else to do, so that the following requests can be answered from memory.
+// This only affects how fast the host gets the data, the emulated timing stays the same.
+struct PrefetchBlock
+{
+  u64 offset;
+  std::vector<u8> data;
+};
+
+constexpr u64 PREFETCH_BLOCK_SIZE = 0x8000;
+constexpr size_t MAX_PREFETCH_BLOCKS = 64;
+
+// Only used by the DVD thread, or while it is idle.
+static std::deque<PrefetchBlock> s_prefetch_blocks;  // Consecutive blocks in ascending order
+static DiscIO::Partition s_prefetch_partition;
+static bool s_prefetch_active = false;
+static u64 s_last_read_end = 0;
+static DiscIO::Partition s_last_read_partition;
+
+static void ResetPrefetch()
+{
+  s_prefetch_blocks.clear();
+  s_prefetch_active = false;
+  s_last_read_end = 0;
+  s_last_read_partition = DiscIO::Partition();
+}
+
 void Start()
 {
   s_finish_read = CoreTiming::RegisterEvent("FinishReadDVDThread", FinishRead);
@@ -116,6 +146,7 @@ void Stop()
 {
   StopDVDThread();
   s_disc.reset();
+  ResetPrefetch();
 }
 
 static void StopDVDThread()
@@ -179,6 +210,7 @@ void SetDisc(std::unique_ptr<DiscIO::Volume> disc)
 {
   WaitUntilIdle();
   s_disc = std::move(disc);
+  ResetPrefetch();
 }
 
 bool HasDisc()
@@ -335,6 +367,70 @@ static void FinishRead(u64 id, s64 cycles_late)
                                        buffer);
 }
 
+static bool ReadDisc(u64 offset, u32 length, u8* buffer, const DiscIO::Partition& partition)
+{
+  const bool sequential = partition == s_last_read_partition && offset == s_last_read_end;
+  s_last_read_partition = partition;
+  s_last_read_end = offset + length;
+
+  // Drop the blocks we've read past. If the read starts outside of the prefetched blocks,
+  // all of them are useless now.
+  while (!s_prefetch_blocks.empty() &&
+         s_prefetch_blocks.front().offset + s_prefetch_blocks.front().data.size() <= offset)
+  {
+    s_prefetch_blocks.pop_front();
+  }
+  if (partition != s_prefetch_partition ||
+      (!s_prefetch_blocks.empty() && s_prefetch_blocks.front().offset > offset))
+  {
+    s_prefetch_blocks.clear();
+  }
+
+  u64 position = offset;
+  const u64 end = offset + length;
+  for (const PrefetchBlock& block : s_prefetch_blocks)
+  {
+    if (position == end)
+      break;
+    const u64 block_end = block.offset + block.data.size();
+    const u64 copy_end = std::min(end, block_end);
+    std::memcpy(buffer + (position - offset), &block.data[position - block.offset],
+                copy_end - position);
+    position = copy_end;
+  }
+
+  s_prefetch_active = sequential;
+  s_prefetch_partition = partition;
+  if (!sequential)
+    s_prefetch_blocks.clear();
+
+  if (position == end)
+    return true;
+  return s_disc->Read(position, end - position, buffer + (position - offset), partition);
+}
+
+// Reads blocks following the last read until there are enough of them or a request arrives.
+static void Prefetch()
+{
+  while (s_prefetch_active && s_prefetch_blocks.size() < MAX_PREFETCH_BLOCKS &&
+         s_request_queue.Empty() && !s_dvd_thread_exiting.IsSet())
+  {
+    const u64 offset = s_prefetch_blocks.empty() ?
+                           s_last_read_end & ~(PREFETCH_BLOCK_SIZE - 1) :
+                           s_prefetch_blocks.back().offset + PREFETCH_BLOCK_SIZE;
+
+    std::vector<u8> data(PREFETCH_BLOCK_SIZE);
+    if (!s_disc->Read(offset, PREFETCH_BLOCK_SIZE, data.data(), s_prefetch_partition))
+    {
+      // Most likely the end of the disc or partition.
+      s_prefetch_active = false;
+      return;
+    }
+
+    s_prefetch_blocks.push_back({offset, std::move(data)});
+  }
+}
+
 static void DVDThread()
 {
   Common::SetCurrentThreadName("DVD thread");
@@ -352,7 +448,7 @@ static void DVDThread()
       FileMonitor::Log(*s_disc, request.partition, request.dvd_offset);
 
       std::vector<u8> buffer(request.length);
-      if (!s_disc->Read(request.dvd_offset, request.length, buffer.data(), request.partition))
+      if (!ReadDisc(request.dvd_offset, request.length, buffer.data(), request.partition))
         buffer.resize(0);
 
       request.realtime_done_us = Common::Timer::GetTimeUs();
@@ -363,6 +459,8 @@ static void DVDThread()
       if (s_dvd_thread_exiting.IsSet())
         return;
     }
+
+    Prefetch();
   }
 }
 }
@@ -10,6 +10,8 @@
 #include "Core/HW/Memmap.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <memory>
 
@@ -17,6 +19,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemArena.h"
+#include "Common/MemoryUtil.h"
 #include "Common/Swap.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/AudioInterface.h"
@@ -113,6 +116,7 @@ struct LogicalMemoryView
 {
   void* mapped_pointer;
   u32 mapped_size;
+  u32 physical_address;
 };
 
 // Dolphin allocates memory to represent four regions:
@@ -164,6 +168,80 @@ static PhysicalMemoryRegion physical_regions[] = {
 
 static std::vector<LogicalMemoryView> logical_mapped_entries;
 
+// The Mach exception handler only catches faults on the CPU thread, but the GPU thread writes to
+// RAM as well (EFB copies).
+#if defined(_M_X86_64) && (!defined(__APPLE__) || defined(USE_SIGACTION_ON_APPLE))
+#define SUPPORTS_WRITE_TRACKING
+#endif
+
+constexpr u32 NUM_TRACKED_PAGES = RAM_SIZE / WRITE_TRACKING_PAGE_SIZE;
+
+// Guards the write tracking state and the logical views. It is taken by the fault handler, so it
+// is a spinlock, and nothing may write to RAM while holding it.
+static std::atomic_flag s_write_tracking_lock = ATOMIC_FLAG_INIT;
+static std::atomic<bool> s_write_tracking_enabled{false};
+static std::array<bool, NUM_TRACKED_PAGES> s_page_protected;
+static std::array<u32, NUM_TRACKED_PAGES> s_page_write_counts;
+
+class WriteTrackingLock final
+{
+public:
+  WriteTrackingLock()
+  {
+    while (s_write_tracking_lock.test_and_set(std::memory_order_acquire))
+    {
+    }
+  }
+  ~WriteTrackingLock() { s_write_tracking_lock.clear(std::memory_order_release); }
+  WriteTrackingLock(const WriteTrackingLock&) = delete;
+  WriteTrackingLock& operator=(const WriteTrackingLock&) = delete;
+};
+
+// Changes the protection of a range of RAM pages in every view which maps them.
+static void SetPagesWritable(u32 first_page, u32 num_pages, bool writable)
+{
+  const u32 address = first_page * WRITE_TRACKING_PAGE_SIZE;
+  const u32 size = num_pages * WRITE_TRACKING_PAGE_SIZE;
+  auto set_protection = [writable](u8* ptr, u32 length) {
+    if (writable)
+      Common::UnWriteProtectMemory(ptr, length);
+    else
+      Common::WriteProtectMemory(ptr, length);
+  };
+
+  set_protection(m_pRAM + address, size);
+  for (const LogicalMemoryView& view : logical_mapped_entries)
+  {
+    const u32 start = std::max(address, view.physical_address);
+    const u32 end = std::min(address + size, view.physical_address + view.mapped_size);
+    if (start < end)
+      set_protection(static_cast<u8*>(view.mapped_pointer) + start - view.physical_address,
+                     end - start);
+  }
+}
+
+// Makes all tracked pages writable again and counts them as written, for when their contents
+// change without going through the fault handler, or their views are about to be replaced.
+static void ReleaseTrackedPages()
+{
+  for (u32 page = 0; page < NUM_TRACKED_PAGES;)
+  {
+    if (!s_page_protected[page])
+    {
+      ++page;
+      continue;
+    }
+
+    const u32 first_page = page;
+    for (; page < NUM_TRACKED_PAGES && s_page_protected[page]; ++page)
+    {
+      s_page_protected[page] = false;
+      ++s_page_write_counts[page];
+    }
+    SetPagesWritable(first_page, page - first_page, true);
+  }
+}
+
 void Init()
 {
   bool wii = SConfig::GetInstance().bWii;
@@ -224,6 +302,9 @@ void Init()
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
 {
+  WriteTrackingLock lock;
+  ReleaseTrackedPages();
+
   for (auto& entry : logical_mapped_entries)
   {
     g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
@@ -256,7 +337,7 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
             PanicAlert("MemoryMap_Setup: Failed finding a memory base.");
             exit(0);
           }
-          logical_mapped_entries.push_back({mapped_pointer, mapped_size});
+          logical_mapped_entries.push_back({mapped_pointer, mapped_size, intersection_start});
         }
       }
     }
@@ -266,6 +347,11 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
 void DoState(PointerWrap& p)
 {
   bool wii = SConfig::GetInstance().bWii;
+  if (p.GetMode() == PointerWrap::MODE_READ)
+  {
+    WriteTrackingLock lock;
+    ReleaseTrackedPages();
+  }
   p.DoArray(m_pRAM, RAM_SIZE);
   p.DoArray(m_pL1Cache, L1_CACHE_SIZE);
   p.DoMarker("Memory RAM");
@@ -279,6 +365,7 @@ void DoState(PointerWrap& p)
 
 void Shutdown()
 {
+  DisableWriteTracking();
   m_IsInitialized = false;
   u32 flags = 0;
   if (SConfig::GetInstance().bWii)
@@ -306,6 +393,11 @@ void Shutdown()
 
 void Clear()
 {
+  {
+    WriteTrackingLock lock;
+    ReleaseTrackedPages();
+  }
+
   if (m_pRAM)
     memset(m_pRAM, 0, RAM_SIZE);
   if (m_pL1Cache)
@@ -316,6 +408,98 @@ void Clear()
     memset(m_pEXRAM, 0, EXRAM_SIZE);
 }
 
+void EnableWriteTracking()
+{
+#ifdef SUPPORTS_WRITE_TRACKING
+  if (SConfig::GetInstance().bWii)
+    return;
+
+  WriteTrackingLock lock;
+  s_write_tracking_enabled = true;
+#endif
+}
+
+void DisableWriteTracking()
+{
+  WriteTrackingLock lock;
+  ReleaseTrackedPages();
+  s_write_tracking_enabled = false;
+}
+
+bool TrackWrites(u32 address, u32 size, u32* write_counts)
+{
+  address &= 0x3FFFFFFF;
+  if (size == 0 || address >= REALRAM_SIZE || size > REALRAM_SIZE - address)
+    return false;
+
+  WriteTrackingLock lock;
+  if (!s_write_tracking_enabled)
+    return false;
+
+  // The pages have to be protected before reading their counts, so that a write in between is
+  // either counted or happens before the caller reads the memory.
+  const u32 first_page = address / WRITE_TRACKING_PAGE_SIZE;
+  const u32 end_page = (address + size - 1) / WRITE_TRACKING_PAGE_SIZE + 1;
+  for (u32 page = first_page; page < end_page;)
+  {
+    if (s_page_protected[page])
+    {
+      ++page;
+      continue;
+    }
+
+    const u32 run_start = page;
+    for (; page < end_page && !s_page_protected[page]; ++page)
+      s_page_protected[page] = true;
+    SetPagesWritable(run_start, page - run_start, false);
+  }
+
+  std::copy(&s_page_write_counts[first_page], &s_page_write_counts[end_page], write_counts);
+  return true;
+}
+
+bool HandleWriteFault(uintptr_t host_address)
+{
+  // Most faults are fastmem accesses to MMIO, which the JIT handles
+  if (!s_write_tracking_enabled)
+    return false;
+
+  WriteTrackingLock lock;
+  if (!s_write_tracking_enabled)
+    return false;
+
+  u32 address = RAM_SIZE;
+  const uintptr_t ram = reinterpret_cast<uintptr_t>(m_pRAM);
+  if (host_address >= ram && host_address - ram < RAM_SIZE)
+  {
+    address = static_cast<u32>(host_address - ram);
+  }
+  else
+  {
+    for (const LogicalMemoryView& view : logical_mapped_entries)
+    {
+      const uintptr_t base = reinterpret_cast<uintptr_t>(view.mapped_pointer);
+      if (host_address >= base && host_address - base < view.mapped_size)
+      {
+        address = view.physical_address + static_cast<u32>(host_address - base);
+        break;
+      }
+    }
+  }
+  if (address >= RAM_SIZE)
+    return false;
+
+  // If the page isn't protected, another thread got here first, and retrying the write works.
+  const u32 page = address / WRITE_TRACKING_PAGE_SIZE;
+  if (s_page_protected[page])
+  {
+    s_page_protected[page] = false;
+    ++s_page_write_counts[page];
+    SetPagesWritable(page, 1, true);
+  }
+  return true;
+}
+
 static inline u8* GetPointerForRange(u32 address, size_t size)
 {
   // Make sure we don't have a range spanning 2 separate banks
@@ -68,6 +68,21 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table);
 
 void Clear();
 
+// Write tracking for RAM, used to skip rehashing memory which hasn't changed. Tracked pages are
+// write-protected, and the first write to each of them is counted by the fault handler. This
+// only works when every write to RAM comes from inside the process, so it is limited to
+// GameCube mode (Wii mode has IOS, which passes emulated memory to the host OS).
+constexpr u32 WRITE_TRACKING_PAGE_SIZE = 0x1000;
+// Must be called after installing the fault handler, and disabled before removing it.
+void EnableWriteTracking();
+void DisableWriteTracking();
+// Starts tracking the pages overlapping [address, address + size), and stores how often each of
+// them was written to since tracking was enabled into write_counts. A changed count means the
+// page has to be read again. Returns false if the range can't be tracked.
+bool TrackWrites(u32 address, u32 size, u32* write_counts);
+// Called by the fault handler. Returns true if the fault was a write to a tracked page.
+bool HandleWriteFault(uintptr_t host_address);
+
 // Routines to access physically addressed memory, designed for use by
 // emulated hardware outside the CPU. Use "Device_" prefix.
 std::string GetString(u32 em_address, size_t size = 0);
@@ -22,6 +22,7 @@
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/HW/SI/SI.h"
 #include "Core/HW/SystemTimers.h"
+#include "Core/Rewind.h"
 
 #include "DiscIO/Enums.h"
 
@@ -718,6 +719,7 @@ static void BeginField(FieldType field, u64 ticks)
 static void EndField()
 {
   Core::VideoThrottle();
+  Rewind::FrameAdvanced();
 }
 
 // Purpose: Send VI interrupt when triggered
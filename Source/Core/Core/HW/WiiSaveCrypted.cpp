@@ -13,15 +13,15 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
-#include <mbedtls/aes.h>
 #include <mbedtls/md5.h>
-#include <mbedtls/sha1.h>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "Common/Align.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Crypto/ec.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
@@ -104,7 +104,7 @@ CWiiSaveCrypted::CWiiSaveCrypted(const std::string& filename, u64 title_id)
 
   if (!title_id)  // Import
   {
-    mbedtls_aes_setkey_dec(&m_aes_ctx, s_sd_key, 128);
+    m_aes_ctx = Common::AES::CreateContext(s_sd_key, Common::AES::Mode::Decrypt);
     m_valid = true;
     ReadHDR();
     ReadBKHDR();
@@ -121,7 +121,7 @@ CWiiSaveCrypted::CWiiSaveCrypted(const std::string& filename, u64 title_id)
   }
   else
   {
-    mbedtls_aes_setkey_enc(&m_aes_ctx, s_sd_key, 128);
+    m_aes_ctx = Common::AES::CreateContext(s_sd_key, Common::AES::Mode::Encrypt);
 
     if (getPaths(true))
     {
@@ -151,8 +151,7 @@ void CWiiSaveCrypted::ReadHDR()
   }
   data_file.Close();
 
-  mbedtls_aes_crypt_cbc(&m_aes_ctx, MBEDTLS_AES_DECRYPT, HEADER_SZ, m_sd_iv,
-                        (const u8*)&m_encrypted_header, (u8*)&m_header);
+  m_aes_ctx->Crypt(m_sd_iv, (const u8*)&m_encrypted_header, (u8*)&m_header, HEADER_SZ);
   u32 banner_size = Common::swap32(m_header.hdr.BannerSize);
   if ((banner_size < FULL_BNR_MIN) || (banner_size > FULL_BNR_MAX) ||
       (((banner_size - BNR_SZ) % ICON_SZ) != 0))
@@ -225,8 +224,7 @@ void CWiiSaveCrypted::WriteHDR()
   mbedtls_md5((u8*)&m_header, HEADER_SZ, md5_calc);
   memcpy(m_header.hdr.Md5, md5_calc, 0x10);
 
-  mbedtls_aes_crypt_cbc(&m_aes_ctx, MBEDTLS_AES_ENCRYPT, HEADER_SZ, m_sd_iv, (const u8*)&m_header,
-                        (u8*)&m_encrypted_header);
+  m_aes_ctx->Crypt(m_sd_iv, (const u8*)&m_header, (u8*)&m_encrypted_header, HEADER_SZ);
 
   File::IOFile data_file(m_encrypted_save_path, "wb");
   if (!data_file.WriteBytes(&m_encrypted_header, HEADER_SZ))
@@ -365,8 +363,7 @@ void CWiiSaveCrypted::ImportWiiSaveFiles()
         }
 
         memcpy(m_iv, file_hdr_tmp.IV, 0x10);
-        mbedtls_aes_crypt_cbc(&m_aes_ctx, MBEDTLS_AES_DECRYPT, file_size_rounded, m_iv,
-                              static_cast<const u8*>(file_data_enc.data()), file_data.data());
+        m_aes_ctx->Crypt(m_iv, file_data_enc.data(), file_data.data(), file_size_rounded);
 
         INFO_LOG(CONSOLE, "Creating file %s", file_path_full.c_str());
 
@@ -459,8 +456,7 @@ void CWiiSaveCrypted::ExportWiiSaveFiles()
         m_valid = false;
       }
 
-      mbedtls_aes_crypt_cbc(&m_aes_ctx, MBEDTLS_AES_ENCRYPT, file_size_rounded, file_hdr_tmp.IV,
-                            static_cast<const u8*>(file_data.data()), file_data_enc.data());
+      m_aes_ctx->Crypt(file_hdr_tmp.IV, file_data.data(), file_data_enc.data(), file_size_rounded);
 
       File::IOFile fpData_bin(m_encrypted_save_path, "ab");
       if (!fpData_bin.WriteBytes(file_data_enc.data(), file_size_rounded))
@@ -478,7 +474,7 @@ void CWiiSaveCrypted::do_sig()
   u8 sig[0x40];
   u8 ng_cert[0x180];
   u8 ap_cert[0x180];
-  u8 hash[0x14];
+  Common::SHA1::Digest hash;
   u8 ap_priv[30];
   u8 ap_sig[60];
   char signer[64];
@@ -510,8 +506,8 @@ void CWiiSaveCrypted::do_sig()
   sprintf(name, "AP%08x%08x", 1, 2);
   make_ec_cert(ap_cert, ap_sig, signer, name, ap_priv, 0);
 
-  mbedtls_sha1(ap_cert + 0x80, 0x100, hash);
-  generate_ecdsa(ap_sig, ap_sig + 30, ng_priv, hash);
+  hash = Common::SHA1::CalculateDigest(ap_cert + 0x80, 0x100);
+  generate_ecdsa(ap_sig, ap_sig + 30, ng_priv, hash.data());
   make_ec_cert(ap_cert, ap_sig, signer, name, ap_priv, 0);
 
   data_size = Common::swap32(m_bk_hdr.sizeOfFiles) + 0x80;
@@ -531,8 +527,8 @@ void CWiiSaveCrypted::do_sig()
     return;
   }
 
-  mbedtls_sha1(data.get(), data_size, hash);
-  mbedtls_sha1(hash, 20, hash);
+  hash = Common::SHA1::CalculateDigest(data.get(), data_size);
+  hash = Common::SHA1::CalculateDigest(hash.data(), hash.size());
 
   data_file.Open(m_encrypted_save_path, "ab");
   if (!data_file)
@@ -540,7 +536,7 @@ void CWiiSaveCrypted::do_sig()
     m_valid = false;
     return;
   }
-  generate_ecdsa(sig, sig + 30, ap_priv, hash);
+  generate_ecdsa(sig, sig + 30, ap_priv, hash.data());
   *(u32*)(sig + 60) = Common::swap32(0x2f536969);
 
   data_file.WriteArray(sig, sizeof(sig));
@@ -10,9 +10,8 @@
 #include <utility>
 #include <vector>
 
-#include <mbedtls/sha1.h>
-
 #include "Common/Align.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
 #include "Common/Logging/Log.h"
@@ -335,9 +334,7 @@ IPCCommandResult ES::ImportContentData(Context& context, const IOCtlVRequest& re
 
 static bool CheckIfContentHashMatches(const std::vector<u8>& content, const IOS::ES::Content& info)
 {
-  std::array<u8, 20> sha1;
-  mbedtls_sha1(content.data(), info.size, sha1.data());
-  return sha1 == info.sha1;
+  return Common::SHA1::CalculateDigest(content.data(), info.size) == info.sha1;
 }
 
 static std::string GetImportContentPath(u64 title_id, u32 content_id)
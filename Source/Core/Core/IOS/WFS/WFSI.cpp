@@ -5,7 +5,6 @@
 #include "Core/IOS/WFS/WFSI.h"
 
 #include <cinttypes>
-#include <mbedtls/aes.h>
 #include <stack>
 #include <string>
 #include <utility>
@@ -164,7 +163,7 @@ IPCCommandResult WFSI::IOCtl(const IOCtlRequest& request)
     }
 
     memcpy(m_aes_key, ticket.GetTitleKey(m_ios.GetIOSC()).data(), sizeof(m_aes_key));
-    mbedtls_aes_setkey_dec(&m_aes_ctx, m_aes_key, 128);
+    m_aes_ctx = Common::AES::CreateContext(m_aes_key, Common::AES::Mode::Decrypt);
 
     SetImportTitleIdAndGroupId(m_tmd.GetTitleId(), m_tmd.GetGroupId());
 
@@ -219,9 +218,15 @@ IPCCommandResult WFSI::IOCtl(const IOCtlRequest& request)
     INFO_LOG(IOS_WFS, "%s: %08x bytes of data at %08x from content id %d", ioctl_name, input_size,
              input_ptr, content_id);
 
+    if (!m_aes_ctx)
+    {
+      ERROR_LOG(IOS_WFS, "%s: no title import in progress", ioctl_name);
+      return_error_code = IPC_EINVAL;
+      break;
+    }
+
     std::vector<u8> decrypted(input_size);
-    mbedtls_aes_crypt_cbc(&m_aes_ctx, MBEDTLS_AES_DECRYPT, input_size, m_aes_iv,
-                          Memory::GetPointer(input_ptr), decrypted.data());
+    m_aes_ctx->Crypt(m_aes_iv, Memory::GetPointer(input_ptr), decrypted.data(), input_size);
 
     m_arc_unpacker.AddBytes(decrypted);
     break;
@@ -14,6 +14,7 @@
 #include "Common/MsgHandler.h"
 #include "Common/Thread.h"
 
+#include "Core/HW/Memmap.h"
 #include "Core/MachineContext.h"
 #include "Core/PowerPC/JitInterface.h"
 
@@ -44,7 +45,7 @@ LONG NTAPI Handler(PEXCEPTION_POINTERS pPtrs)
     uintptr_t badAddress = (uintptr_t)pPtrs->ExceptionRecord->ExceptionInformation[1];
     CONTEXT* ctx = pPtrs->ContextRecord;
 
-    if (JitInterface::HandleFault(badAddress, ctx))
+    if (Memory::HandleWriteFault(badAddress) || JitInterface::HandleFault(badAddress, ctx))
     {
       return (DWORD)EXCEPTION_CONTINUE_EXECUTION;
     }
@@ -254,6 +255,9 @@ static void sigsegv_handler(int sig, siginfo_t* info, void* raw_context)
 #else
   mcontext_t* ctx = &context->uc_mcontext;
 #endif
+  if (Memory::HandleWriteFault(bad_address))
+    return;
+
   // assume it's not a write
   if (!JitInterface::HandleFault(bad_address,
 #ifdef __APPLE__
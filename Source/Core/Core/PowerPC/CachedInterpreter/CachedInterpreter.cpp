@@ -80,8 +80,12 @@ void CachedInterpreter::ExecuteOneBlock()
   const u8* normal_entry = m_block_cache.Dispatch();
   if (!normal_entry)
   {
-    Jit(PC);
-    return;
+    // Jit raises an ISI instead if the block can't be read, which moves PC to the handler.
+    const u32 start_pc = PC;
+    Jit(start_pc);
+    if (PC != start_pc)
+      return;
+    normal_entry = m_block_cache.Dispatch();
   }
 
   const Instruction* code = reinterpret_cast<const Instruction*>(normal_entry);
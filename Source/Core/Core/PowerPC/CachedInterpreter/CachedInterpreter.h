@@ -28,6 +28,9 @@ public:
 
   void Jit(u32 address) override;
 
+  // Runs the block at PC, compiling it first if necessary.
+  void ExecuteOneBlock();
+
   JitBaseBlockCache* GetBlockCache() override { return &m_block_cache; }
   const char* GetName() override { return "Cached Interpreter"; }
   const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
@@ -35,7 +38,6 @@ private:
   struct Instruction;
 
   const u8* GetCodePtr() const;
-  void ExecuteOneBlock();
 
   BlockCache m_block_cache{*this};
   std::vector<Instruction> m_code;
@@ -4,8 +4,14 @@
 
 #include "Core/PowerPC/Jit64/Jit.h"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
 // for the PROFILER stuff
 #ifdef _WIN32
@@ -13,12 +19,14 @@
 #endif
 
 #include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
 #include "Common/File.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemoryUtil.h"
 #include "Common/PerformanceCounter.h"
 #include "Common/StringUtil.h"
 #include "Common/x64ABI.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
@@ -205,6 +213,12 @@ bool Jit64::HandleFault(uintptr_t access_address, SContext* ctx)
   if (m_enable_blr_optimization && diff >= GUARD_OFFSET && diff < GUARD_OFFSET + GUARD_SIZE)
     return HandleStackFault();
 
+  // Backpatching needs the emitter and the backpatch info, which the compile thread may be using.
+  // Faults outside of the JIT code aren't ours to handle anyway.
+  if (!IsInSpace(reinterpret_cast<u8*>(ctx->CTX_PC)))
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_compile_lock);
   return Jitx86Base::HandleFault(access_address, ctx);
 }
 
@@ -242,8 +256,20 @@ void Jit64::Init()
   if (m_enable_blr_optimization)
     AllocStack();
 
+  const int tier_up_threshold = Config::Get(Config::MAIN_JIT_TIER_UP_THRESHOLD);
+  m_tier_up_threshold =
+      SConfig::GetInstance().bEnableDebugging || SConfig::GetInstance().bJITNoBlockCache ?
+          0 :
+          static_cast<u32>(std::max(tier_up_threshold, 0));
+  if (m_tier_up_threshold != 0)
+  {
+    // Before our own block cache, since that restarts JitRegister.
+    m_cold_tier = std::make_unique<CachedInterpreter>();
+    m_cold_tier->Init();
+  }
+
   blocks.Init();
-  asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr);
+  asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr, m_tier_up_threshold != 0);
 
   // important: do this *after* generating the global asm routines, because we can't use farcode in
   // them.
@@ -255,9 +281,24 @@ void Jit64::Init()
   code_block.m_gpa = &js.gpa;
   code_block.m_fpa = &js.fpa;
   EnableOptimization();
+
+  m_compile_in_background = m_tier_up_threshold != 0;
+  if (m_compile_in_background)
+  {
+    m_code_space_full.Clear();
+    m_cancel_compile_jobs.Clear();
+    m_compile_thread.Reset(
+        [this](std::shared_ptr<CompileJob> job) { CompileJobOnThread(std::move(job)); });
+  }
 }
 
 void Jit64::ClearCache()
+{
+  std::lock_guard<std::mutex> lock(m_compile_lock);
+  ClearCacheLocked();
+}
+
+void Jit64::ClearCacheLocked()
 {
   blocks.Clear();
   trampolines.ClearCodeSpace();
@@ -266,14 +307,59 @@ void Jit64::ClearCache()
   ClearCodeSpace();
   Clear();
   UpdateMemoryOptions();
+  m_cold_block_counts.clear();
+  if (m_cold_tier)
+    m_cold_tier->ClearCache();
+  InvalidateCompileJobs();
+}
+
+bool Jit64::IsCodeSpaceAlmostFull()
+{
+  return IsAlmostFull() || m_far_code.IsAlmostFull() || trampolines.IsAlmostFull();
+}
+
+void Jit64::ClearSafe()
+{
+  JitBase::ClearSafe();
+  if (m_cold_tier)
+    m_cold_tier->ClearSafe();
+  InvalidateCompileJobs();
+}
+
+void Jit64::InvalidateICache(u32 address, u32 length, bool forced)
+{
+  JitBase::InvalidateICache(address, length, forced);
+  if (!m_cold_tier)
+    return;
+
+  m_cold_tier->InvalidateICache(address, length, forced);
+
+  const auto translated = PowerPC::JitCache_TranslateAddress(address);
+  if (!translated.valid)
+    return;
+  for (const auto& job : m_compile_jobs)
+  {
+    const std::set<u32>& addresses = job->code_block.m_physical_addresses;
+    const auto it = addresses.lower_bound(translated.address & ~3);
+    if (it != addresses.end() && *it - (translated.address & ~3) < length)
+      job->invalidated = true;
+  }
 }
 
 void Jit64::Shutdown()
 {
+  m_cancel_compile_jobs.Set();
+  m_compile_thread.Shutdown();
+  m_compile_jobs.clear();
+  m_finished_jobs.clear();
+  // Its Shutdown would only shut down JitRegister, which our block cache takes care of.
+  m_cold_tier.reset();
+
   FreeStack();
   FreeCodeSpace();
 
   blocks.Shutdown();
+  m_cold_block_counts.clear();
   m_far_code.Shutdown();
   m_const_pool.Shutdown();
 }
@@ -361,8 +447,7 @@ bool Jit64::Cleanup()
     did_something = true;
   }
 
-  // SPEED HACK: MMCR0/MMCR1 should be checked at run-time, not at compile time.
-  if (MMCR0.Hex || MMCR1.Hex)
+  if (m_block_snapshot.update_performance_monitor)
   {
     ABI_PushRegistersAndAdjustStack({}, 0);
     ABI_CallFunctionCCC(PowerPC::UpdatePerformanceMonitor, js.downcountAmount, js.numLoadStoreInst,
@@ -576,12 +661,19 @@ void Jit64::Jit(u32 em_address)
 #endif
   }
 
-  if (IsAlmostFull() || m_far_code.IsAlmostFull() || trampolines.IsAlmostFull() ||
-      SConfig::GetInstance().bJITNoBlockCache)
+  if (m_tier_up_threshold != 0)
   {
-    ClearCache();
+    // The block may just have been compiled on the compile thread.
+    PublishCompiledBlocks();
+    if (blocks.GetBlockFromStartAddress(em_address, MSR) || RunColdBlock(em_address))
+      return;
   }
 
+  std::lock_guard<std::mutex> lock(m_compile_lock);
+
+  if (IsCodeSpaceAlmostFull() || SConfig::GetInstance().bJITNoBlockCache)
+    ClearCacheLocked();
+
   int blockSize = code_buffer.GetSize();
 
   if (SConfig::GetInstance().bEnableDebugging)
@@ -604,6 +696,7 @@ void Jit64::Jit(u32 em_address)
         analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CROR_MERGE);
         analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE);
         analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+        analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
       }
       Trace();
     }
@@ -624,11 +717,187 @@ void Jit64::Jit(u32 em_address)
     return;
   }
 
+  CaptureBlockSnapshot(&m_block_snapshot, code_block, code_buffer.codebuffer);
   JitBlock* b = blocks.AllocateBlock(em_address);
   DoJit(em_address, &code_buffer, b, nextPC);
   blocks.FinalizeBlock(*b, jo.enableBlocklink, code_block.m_physical_addresses);
 }
 
+void Jit64::CaptureBlockSnapshot(BlockSnapshot* snapshot, const PPCAnalyst::CodeBlock& block,
+                                 const PPCAnalyst::CodeOp* ops) const
+{
+  std::copy(std::begin(PowerPC::ppcState.gpr), std::end(PowerPC::ppcState.gpr),
+            snapshot->gpr.begin());
+  for (size_t i = 0; i < snapshot->gqr.size(); i++)
+    snapshot->gqr[i] = GQR(i);
+
+  snapshot->constant_gqrs =
+      js.pairedQuantizeAddresses.find(block.m_address) == js.pairedQuantizeAddresses.end();
+  snapshot->speculative_constants = js.noSpeculativeConstantsAddresses.find(block.m_address) ==
+                                    js.noSpeculativeConstantsAddresses.end();
+
+  // SPEED HACK: MMCR0/MMCR1 should be checked at run-time, not at compile time.
+  snapshot->update_performance_monitor = MMCR0.Hex || MMCR1.Hex;
+
+  // Gather pipe writes using a non-immediate address are discovered by profiling.
+  snapshot->fifo_write_checks.resize(block.m_num_instructions);
+  for (u32 i = 0; i < block.m_num_instructions; i++)
+    snapshot->fifo_write_checks[i] = js.fifoWriteAddresses.count(ops[i].address) != 0;
+}
+
+bool Jit64::RunColdBlock(u32 em_address)
+{
+  // Stop counting after a while, so that a game which runs a lot of code only once can't make
+  // this grow without bound. Blocks which are still hot will simply be counted again.
+  constexpr size_t MAX_COLD_BLOCKS = 0x10000;
+  if (m_cold_block_counts.size() >= MAX_COLD_BLOCKS)
+    m_cold_block_counts.clear();
+
+  const u32 msr_bits = MSR & JitBaseBlockCache::JIT_CACHE_MSR_MASK;
+  const u64 key = (static_cast<u64>(msr_bits) << 32) | em_address;
+  // The count keeps going up while the block is being compiled, so it is only queued once.
+  u32& count = m_cold_block_counts[key];
+  if (++count == m_tier_up_threshold)
+  {
+    if (!CanCompileInBackground(msr_bits) || !QueueCompileJob(em_address))
+    {
+      m_cold_block_counts.erase(key);
+      return false;
+    }
+  }
+
+  // The dispatcher checks the downcount again afterwards, since running the block may have
+  // used up the rest of the timeslice.
+  m_cold_tier->ExecuteOneBlock();
+  return true;
+}
+
+bool Jit64::CanCompileInBackground(u32 msr_bits) const
+{
+  // Loads and stores are compiled based on the current MSR.DR. If the CPU thread has switched
+  // data translation off in the meantime, that only makes the code slower, but the other way
+  // around it would be wrong. So blocks which run without data translation are compiled on the
+  // CPU thread. The profiling code points into the block cache, so it has to be there first.
+  return m_compile_in_background && UReg_MSR(msr_bits).DR && !Profiler::g_ProfileBlocks;
+}
+
+bool Jit64::QueueCompileJob(u32 em_address)
+{
+  auto job = std::make_shared<CompileJob>();
+  job->em_address = em_address;
+  job->msr_bits = MSR & JitBaseBlockCache::JIT_CACHE_MSR_MASK;
+  job->physical_address = PowerPC::JitCache_TranslateAddress(em_address).address;
+  job->code_block.m_stats = &job->st;
+  job->code_block.m_gpa = &job->gpa;
+  job->code_block.m_fpa = &job->fpa;
+
+  // code_buffer is only used on the CPU thread, so the job gets a copy of the instructions.
+  job->next_pc =
+      analyzer.Analyze(em_address, &job->code_block, &code_buffer, code_buffer.GetSize());
+  if (job->code_block.m_memory_exception)
+    return false;
+
+  const u32 num_instructions = job->code_block.m_num_instructions;
+  job->code_buffer = std::make_unique<PPCAnalyst::CodeBuffer>(static_cast<int>(num_instructions));
+  std::copy_n(code_buffer.codebuffer, num_instructions, job->code_buffer->codebuffer);
+  CaptureBlockSnapshot(&job->snapshot, job->code_block, job->code_buffer->codebuffer);
+
+  m_compile_jobs.push_back(job);
+  m_compile_thread.EmplaceItem(std::move(job));
+  return true;
+}
+
+void Jit64::CompileJobOnThread(std::shared_ptr<CompileJob> job)
+{
+  if (!m_cancel_compile_jobs.IsSet())
+  {
+    std::lock_guard<std::mutex> lock(m_compile_lock);
+    if (IsCodeSpaceAlmostFull())
+    {
+      // Only the CPU thread can clear the cache.
+      m_code_space_full.Set();
+    }
+    else
+    {
+      code_block = job->code_block;
+      code_block.m_stats = &js.st;
+      code_block.m_gpa = &js.gpa;
+      code_block.m_fpa = &js.fpa;
+      js.st = job->st;
+      js.gpa = job->gpa;
+      js.fpa = job->fpa;
+      m_block_snapshot = job->snapshot;
+
+      DoJit(job->em_address, job->code_buffer.get(), &job->block, job->next_pc);
+      job->compiled = true;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_finished_jobs_lock);
+  m_finished_jobs.push_back(std::move(job));
+}
+
+void Jit64::PublishCompiledBlocks()
+{
+  if (m_code_space_full.IsSet())
+  {
+    ClearCache();
+    m_code_space_full.Clear();
+  }
+
+  std::vector<std::shared_ptr<CompileJob>> finished_jobs;
+  {
+    std::lock_guard<std::mutex> lock(m_finished_jobs_lock);
+    if (m_finished_jobs.empty())
+      return;
+    finished_jobs.swap(m_finished_jobs);
+  }
+
+  const u32 msr_bits = MSR & JitBaseBlockCache::JIT_CACHE_MSR_MASK;
+  std::vector<std::shared_ptr<CompileJob>> deferred_jobs;
+  for (auto& job : finished_jobs)
+  {
+    // The block cache files blocks under the current address translation.
+    if (job->compiled && !job->invalidated && job->msr_bits != msr_bits)
+    {
+      deferred_jobs.push_back(std::move(job));
+      continue;
+    }
+
+    m_compile_jobs.erase(std::find(m_compile_jobs.begin(), m_compile_jobs.end(), job));
+    m_cold_block_counts.erase((static_cast<u64>(job->msr_bits) << 32) | job->em_address);
+    if (!job->compiled || job->invalidated)
+      continue;
+
+    const auto translated = PowerPC::JitCache_TranslateAddress(job->em_address);
+    if (!translated.valid || translated.address != job->physical_address ||
+        blocks.GetBlockFromStartAddress(job->em_address, job->msr_bits))
+    {
+      continue;
+    }
+
+    JitBlock* b = blocks.AllocateBlock(job->em_address);
+    b->checkedEntry = job->block.checkedEntry;
+    b->normalEntry = job->block.normalEntry;
+    b->codeSize = job->block.codeSize;
+    b->originalSize = job->block.originalSize;
+    b->linkData = std::move(job->block.linkData);
+    blocks.FinalizeBlock(*b, jo.enableBlocklink, job->code_block.m_physical_addresses);
+  }
+
+  if (!deferred_jobs.empty())
+  {
+    std::lock_guard<std::mutex> lock(m_finished_jobs_lock);
+    std::move(deferred_jobs.begin(), deferred_jobs.end(), std::back_inserter(m_finished_jobs));
+  }
+}
+
+void Jit64::InvalidateCompileJobs()
+{
+  for (const auto& job : m_compile_jobs)
+    job->invalidated = true;
+}
+
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock* b, u32 nextPC)
 {
   js.firstFPInstructionFound = false;
@@ -694,7 +963,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
   // loads and stores,
   // which are significantly faster when inlined (especially in MMU mode, where this lets them use
   // fastmem).
-  if (js.pairedQuantizeAddresses.find(js.blockStart) == js.pairedQuantizeAddresses.end())
+  if (m_block_snapshot.constant_gqrs)
   {
     // If there are GQRs used but not set, we'll treat those as constant and optimize them
     BitSet8 gqr_static = ComputeStaticGQRs(code_block);
@@ -714,7 +983,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
       // the start of the block in case our guess turns out wrong.
       for (int gqr : gqr_static)
       {
-        u32 value = GQR(gqr);
+        u32 value = m_block_snapshot.gqr[gqr];
         js.constantGqr[gqr] = value;
         CMP_or_TEST(32, PPCSTATE(spr[SPR_GQR0 + gqr]), Imm32(value));
         J_CC(CC_NZ, target);
@@ -722,8 +991,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     }
   }
 
-  if (js.noSpeculativeConstantsAddresses.find(js.blockStart) ==
-      js.noSpeculativeConstantsAddresses.end())
+  if (m_block_snapshot.speculative_constants)
   {
     IntializeSpeculativeConstants();
   }
@@ -751,8 +1019,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     }
 
     // Gather pipe writes using a non-immediate address are discovered by profiling.
-    bool gatherPipeIntCheck =
-        js.fifoWriteAddresses.find(ops[i].address) != js.fifoWriteAddresses.end();
+    bool gatherPipeIntCheck = m_block_snapshot.fifo_write_checks[i];
 
     // Gather pipe writes using an immediate address are explicitly tracked.
     if (jo.optimizeGatherPipe && (js.fifoBytesSinceCheck >= 32 || js.mustCheckFifo))
@@ -999,6 +1266,8 @@ void Jit64::EnableOptimization()
   analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CROR_MERGE);
   analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE);
   analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+  if (Config::Get(Config::MAIN_JIT_TRACE_COMPILATION))
+    analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
 }
 
 void Jit64::IntializeSpeculativeConstants()
@@ -1012,7 +1281,7 @@ void Jit64::IntializeSpeculativeConstants()
   const u8* target = nullptr;
   for (auto i : code_block.m_gpr_inputs)
   {
-    u32 compileTimeValue = PowerPC::ppcState.gpr[i];
+    u32 compileTimeValue = m_block_snapshot.gpr[i];
     if (PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue) ||
         PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue - 0x8000) ||
         compileTimeValue == 0xCC000000)
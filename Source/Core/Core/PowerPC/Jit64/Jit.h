@@ -18,9 +18,18 @@
 // ----------
 #pragma once
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "Common/CommonTypes.h"
+#include "Common/Flag.h"
+#include "Common/WorkQueueThread.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
+#include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
 #include "Core/PowerPC/Jit64/FPURegCache.h"
 #include "Core/PowerPC/Jit64/GPRRegCache.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
@@ -40,6 +49,9 @@ public:
   bool HandleFault(uintptr_t access_address, SContext* ctx) override;
   bool HandleStackFault() override;
 
+  void ClearSafe() override;
+  void InvalidateICache(u32 address, u32 length, bool forced) override;
+
   void EnableOptimization();
   void EnableBlockLink();
 
@@ -231,12 +243,68 @@ public:
   void eieio(UGeckoInstruction inst);
 
 private:
+  // The parts of the emulated CPU state which DoJit bases its guesses on, captured on the CPU
+  // thread when the block is requested. The live state keeps changing while a block is compiled
+  // on the compile thread.
+  struct BlockSnapshot
+  {
+    std::array<u32, 32> gpr;
+    std::array<u32, 8> gqr;
+    bool constant_gqrs;
+    bool speculative_constants;
+    bool update_performance_monitor;
+    // Indexed like the block's instructions.
+    std::vector<bool> fifo_write_checks;
+  };
+
+  // A hot block which is compiled on the compile thread. It is analyzed on the CPU thread, since
+  // that reads emulated memory, and published into the block cache on the CPU thread again.
+  struct CompileJob
+  {
+    u32 em_address;
+    u32 msr_bits;
+    u32 physical_address;
+    u32 next_pc;
+    PPCAnalyst::CodeBlock code_block;
+    PPCAnalyst::BlockStats st;
+    PPCAnalyst::BlockRegStats gpa;
+    PPCAnalyst::BlockRegStats fpa;
+    std::unique_ptr<PPCAnalyst::CodeBuffer> code_buffer;
+    BlockSnapshot snapshot;
+
+    // Written by the compile thread.
+    JitBlock block{};
+    bool compiled = false;
+
+    // Only used by the CPU thread. Set when the code or the address translation changed after
+    // the block was analyzed.
+    bool invalidated = false;
+  };
+
   static void InitializeInstructionTables();
   void CompileInstruction(PPCAnalyst::CodeOp& op);
 
   void AllocStack();
   void FreeStack();
 
+  // Expects m_compile_lock to be held.
+  void ClearCacheLocked();
+  bool IsCodeSpaceAlmostFull();
+
+  void CaptureBlockSnapshot(BlockSnapshot* snapshot, const PPCAnalyst::CodeBlock& block,
+                            const PPCAnalyst::CodeOp* ops) const;
+
+  // Runs the block at PC in the cold tier instead of compiling it, as long as it hasn't been
+  // requested often enough to be worth the compile time. Once it has, the block is handed to the
+  // compile thread if possible, and keeps running in the cold tier until it is compiled.
+  // Returns false if the block has to be compiled right away.
+  bool RunColdBlock(u32 em_address);
+  bool CanCompileInBackground(u32 msr_bits) const;
+  bool QueueCompileJob(u32 em_address);
+  void CompileJobOnThread(std::shared_ptr<CompileJob> job);
+  void PublishCompiledBlocks();
+  void InvalidateCompileJobs();
+
   GPRRegCache gpr{*this};
   FPURegCache fpr{*this};
 
@@ -245,7 +313,28 @@ private:
   PPCAnalyst::CodeBuffer code_buffer;
   Jit64AsmRoutineManager asm_routines;
 
+  BlockSnapshot m_block_snapshot;
+
+  // Number of times each not yet compiled block was requested, keyed by MSR bits and address.
+  std::unordered_map<u64, u32> m_cold_block_counts;
+  u32 m_tier_up_threshold = 0;
+  std::unique_ptr<CachedInterpreter> m_cold_tier;
+
+  // Held while the emitter, the register caches and the compiler state in js, code_block and the
+  // backpatch info are in use, by the compile thread as well as the CPU thread.
+  std::mutex m_compile_lock;
+  bool m_compile_in_background = false;
+  // Queued or compiled jobs which the CPU thread hasn't published or thrown away yet.
+  std::vector<std::shared_ptr<CompileJob>> m_compile_jobs;
+  std::mutex m_finished_jobs_lock;
+  std::vector<std::shared_ptr<CompileJob>> m_finished_jobs;
+  Common::Flag m_code_space_full;
+  Common::Flag m_cancel_compile_jobs;
+
   bool m_enable_blr_optimization;
   bool m_cleanup_after_stackfault;
   u8* m_stack;
+
+  // Declared last, so that the thread is stopped before anything it uses is destroyed.
+  Common::WorkQueueThread<std::shared_ptr<CompileJob>> m_compile_thread;
 };
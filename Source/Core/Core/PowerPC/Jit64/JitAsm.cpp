@@ -18,10 +18,11 @@
 
 using namespace Gen;
 
-void Jit64AsmRoutineManager::Init(u8* stack_top)
+void Jit64AsmRoutineManager::Init(u8* stack_top, bool tiering)
 {
   m_const_pool.Init(AllocChildCodeSpace(4096), 4096);
   m_stack_top = stack_top;
+  m_tiering = tiering;
   Generate();
   WriteProtect();
 }
@@ -179,9 +180,20 @@ void Jit64AsmRoutineManager::Generate()
   ABI_CallFunction(JitTrampoline);
   ABI_PopRegistersAndAdjustStack({}, 0);
 
+  // With tiering, JitTrampoline may have run a cold block instead of compiling it,
+  // so the timeslice could be over.
+  FixupBranch out_of_cycles;
+  if (m_tiering)
+  {
+    CMP(32, PPCSTATE(downcount), Imm8(0));
+    out_of_cycles = J_CC(CC_LE, true);
+  }
+
   JMP(dispatcherNoCheck, true);
 
   SetJumpTarget(bail);
+  if (m_tiering)
+    SetJumpTarget(out_of_cycles);
   doTiming = GetCodePtr();
 
   // make sure npc contains the next pc (needed for exception checking in CoreTiming::Advance)
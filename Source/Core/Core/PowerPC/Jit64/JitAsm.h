@@ -32,13 +32,15 @@ private:
   void Generate();
   void GenerateCommon();
   u8* m_stack_top;
+  bool m_tiering;
 
 public:
   // NOTE: When making large additions to the AsmCommon code, you might
   // want to ensure this number is big enough.
   static constexpr size_t CODE_SIZE = 16384;
 
-  void Init(u8* stack_top);
+  // With tiering, the JIT may run a block in its cold tier instead of compiling it.
+  void Init(u8* stack_top, bool tiering);
 
   void ResetStack(Gen::X64CodeBlock& emitter);
 };
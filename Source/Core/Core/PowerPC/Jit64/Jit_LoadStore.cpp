@@ -281,8 +281,12 @@ void Jit64::dcbx(UGeckoInstruction inst)
 
   // Check whether a JIT cache line needs to be invalidated.
   LEA(32, value, MScaled(addr, SCALE_8, 0));  // addr << 3 (masks the first 3 bits)
-  SHR(32, R(value), Imm8(3 + 5 + 5));         // >> 5 for cache line size, >> 5 for width of bitset
+  SHR(32, R(value), Imm8(3 + ValidBlockBitSet::REGION_SHIFT));  // index of the bitset chunk
   MOV(64, R(tmp), ImmPtr(GetBlockCache()->GetBlockBitSet()));
+  MOV(64, R(tmp), MComplex(tmp, value, SCALE_8, 0));
+  MOV(32, R(value), R(addr));
+  SHR(32, R(value), Imm8(5 + 5));  // >> 5 for cache line size, >> 5 for width of bitset
+  AND(32, R(value), Imm32(ValidBlockBitSet::WORDS_PER_CHUNK - 1));
   MOV(32, R(value), MComplex(tmp, value, SCALE_4, 0));
   SHR(32, R(addr), Imm8(5));
   BT(32, R(value), R(addr));
@@ -342,7 +346,9 @@ void Jit64::dcbz(UGeckoInstruction inst)
     ADD(32, R(RSCRATCH), gpr.R(a));
   AND(32, R(RSCRATCH), Imm32(~31));
 
-  if (UReg_MSR(MSR).DR)
+  // Read MSR.DR only once, blocks may be compiled while the CPU thread keeps running.
+  const bool dr_set = UReg_MSR(MSR).DR;
+  if (dr_set)
   {
     // Perform lookup to see if we can use fast path.
     MOV(64, R(RSCRATCH2), ImmPtr(&PowerPC::dbat_table[0]));
@@ -367,7 +373,7 @@ void Jit64::dcbz(UGeckoInstruction inst)
   ABI_CallFunctionR(PowerPC::ClearCacheLine, RSCRATCH);
   ABI_PopRegistersAndAdjustStack(registersInUse, 0);
 
-  if (UReg_MSR(MSR).DR)
+  if (dr_set)
   {
     FixupBranch end = J(true);
     SwitchToNearCode();
@@ -577,10 +577,12 @@ void JitArm64::dcbx(UGeckoInstruction inst)
     MOV(addr, gpr.R(b));
 
   // Check whether a JIT cache line needs to be invalidated.
-  AND(value, addr, 32 - 10, 28 - 10);  // upper three bits and last 10 bit are masked for the bitset
-                                       // of cachelines, 0x1ffffc00
-  LSR(value, value, 5 + 5);            // >> 5 for cache line size, >> 5 for width of bitset
+  // The upper three bits are masked, the next 9 bits select the chunk of the bitset.
+  UBFX(value, addr, ValidBlockBitSet::REGION_SHIFT, 29 - ValidBlockBitSet::REGION_SHIFT);
   MOVP2R(EncodeRegTo64(WA), GetBlockCache()->GetBlockBitSet());
+  LDR(EncodeRegTo64(WA), EncodeRegTo64(WA), ArithOption(EncodeRegTo64(value), true));
+  // >> 5 for cache line size, >> 5 for width of bitset, masked to the words of one chunk
+  UBFX(value, addr, 5 + 5, ValidBlockBitSet::REGION_SHIFT - 5 - 5);
   LDR(value, EncodeRegTo64(WA), ArithOption(EncodeRegTo64(value), true));
 
   LSR(addr, addr, 5);  // mask sizeof cacheline, & 0x1f is the position within the bitset
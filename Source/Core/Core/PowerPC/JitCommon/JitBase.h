@@ -121,6 +121,14 @@ public:
 
   virtual void Jit(u32 em_address) = 0;
 
+  // Forgets all blocks, or the blocks overlapping the given range, without freeing the code.
+  // JITs which keep blocks outside of their block cache have to forget those too.
+  virtual void ClearSafe() { GetBlockCache()->Clear(); }
+  virtual void InvalidateICache(u32 address, u32 length, bool forced)
+  {
+    GetBlockCache()->InvalidateICache(address, length, forced);
+  }
+
   virtual const CommonAsmRoutinesBase* GetAsmRoutines() = 0;
 
   virtual bool HandleFault(uintptr_t access_address, SContext* ctx) = 0;
@@ -13,9 +13,9 @@
 #include <array>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/JitRegister.h"
@@ -33,8 +33,30 @@ using namespace Gen;
 
 bool JitBlock::OverlapsPhysicalRange(u32 address, u32 length) const
 {
-  return physical_addresses.lower_bound(address) !=
-         physical_addresses.lower_bound(address + length);
+  auto first = std::lower_bound(physical_addresses.begin(), physical_addresses.end(), address);
+  return first != physical_addresses.end() && *first < address + length;
+}
+
+u32 ValidBlockBitSet::s_empty_chunk[ValidBlockBitSet::WORDS_PER_CHUNK];
+
+ValidBlockBitSet::ValidBlockBitSet() : m_chunks(new u32*[NUM_REGIONS])
+{
+  std::fill_n(m_chunks.get(), NUM_REGIONS, s_empty_chunk);
+}
+
+ValidBlockBitSet::~ValidBlockBitSet() = default;
+
+void ValidBlockBitSet::ClearAll()
+{
+  // Keep the chunks around, regions which contained code once are likely to again.
+  for (const auto& chunk : m_allocated_chunks)
+    std::memset(chunk.get(), 0, sizeof(u32) * WORDS_PER_CHUNK);
+}
+
+u32* ValidBlockBitSet::AllocateChunk()
+{
+  m_allocated_chunks.emplace_back(new u32[WORDS_PER_CHUNK]());
+  return m_allocated_chunks.back().get();
 }
 
 JitBaseBlockCache::JitBaseBlockCache(JitBase& jit) : m_jit{jit}
@@ -64,13 +86,11 @@ void JitBaseBlockCache::Clear()
 #endif
   m_jit.js.fifoWriteAddresses.clear();
   m_jit.js.pairedQuantizeAddresses.clear();
-  for (auto& e : block_map)
-  {
-    DestroyBlock(e.second);
-  }
-  block_map.clear();
-  links_to.clear();
-  block_range_map.clear();
+  block_map.ForEachEntry([this](u32, JitBlock* block) { DestroyBlock(*block); });
+  block_map.Clear();
+  links_to.Clear();
+  block_range_map.Clear();
+  FreeAllBlocks();
 
   valid_block.ClearAll();
 
@@ -90,18 +110,20 @@ JitBlock** JitBaseBlockCache::GetFastBlockMap()
 
 void JitBaseBlockCache::RunOnBlocks(std::function<void(const JitBlock&)> f)
 {
-  for (const auto& e : block_map)
-    f(e.second);
+  block_map.ForEachEntry([&f](u32, const JitBlock* block) { f(*block); });
 }
 
 JitBlock* JitBaseBlockCache::AllocateBlock(u32 em_address)
 {
   u32 physicalAddress = PowerPC::JitCache_TranslateAddress(em_address).address;
-  JitBlock& b = block_map.emplace(physicalAddress, JitBlock())->second;
+  JitBlock& b = *NewBlock();
+  block_map.Insert(physicalAddress, &b);
   b.effectiveAddress = em_address;
   b.physicalAddress = physicalAddress;
   b.msrBits = MSR & JIT_CACHE_MSR_MASK;
   b.linkData.clear();
+  b.physical_addresses.clear();
+  b.profile_data = {};
   b.fast_block_map_index = 0;
   return &b;
 }
@@ -113,20 +135,23 @@ void JitBaseBlockCache::FinalizeBlock(JitBlock& block, bool block_link,
   fast_block_map[index] = &block;
   block.fast_block_map_index = index;
 
-  block.physical_addresses = physical_addresses;
+  block.physical_addresses.assign(physical_addresses.begin(), physical_addresses.end());
 
+  // The addresses are sorted, so all addresses of a macro block are adjacent.
   u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
-  for (u32 addr : physical_addresses)
+  for (size_t i = 0; i < block.physical_addresses.size(); i++)
   {
+    u32 addr = block.physical_addresses[i];
     valid_block.Set(addr / 32);
-    block_range_map[addr & range_mask].insert(&block);
+    if (i == 0 || (addr & range_mask) != (block.physical_addresses[i - 1] & range_mask))
+      block_range_map.Insert(addr & range_mask, &block);
   }
 
   if (block_link)
   {
     for (const auto& e : block.linkData)
     {
-      links_to.emplace(e.exitAddress, &block);
+      links_to.Insert(e.exitAddress, &block);
     }
 
     LinkBlock(block);
@@ -159,15 +184,11 @@ JitBlock* JitBaseBlockCache::GetBlockFromStartAddress(u32 addr, u32 msr)
     translated_addr = translated.address;
   }
 
-  auto iter = block_map.equal_range(translated_addr);
-  for (; iter.first != iter.second; iter.first++)
-  {
-    JitBlock& b = iter.first->second;
-    if (b.effectiveAddress == addr && b.msrBits == (msr & JIT_CACHE_MSR_MASK))
-      return &b;
-  }
+  JitBlock* const* block = block_map.FindIf(translated_addr, [addr, msr](const JitBlock* b) {
+    return b->effectiveAddress == addr && b->msrBits == (msr & JIT_CACHE_MSR_MASK);
+  });
 
-  return nullptr;
+  return block ? *block : nullptr;
 }
 
 const u8* JitBaseBlockCache::Dispatch()
@@ -222,56 +243,95 @@ void JitBaseBlockCache::InvalidateICache(u32 address, u32 length, bool forced)
 
 void JitBaseBlockCache::ErasePhysicalRange(u32 address, u32 length)
 {
-  // Iterate over all macro blocks which overlap the given range.
-  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
-  auto start = block_range_map.lower_bound(address & range_mask);
-  auto end = block_range_map.lower_bound(address + length);
-  while (start != end)
+  if (block_map.Empty() || length == 0)
+    return;
+
+  // Gather the overlapping blocks first, as erasing them modifies block_range_map.
+  blocks_to_erase.clear();
+  const u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
+  const u64 first_macro_block = address & range_mask;
+  const u64 end = static_cast<u64>(address) + length;
+  const u64 num_macro_blocks = (end - first_macro_block + BLOCK_RANGE_MAP_ELEMENTS - 1) /
+                               BLOCK_RANGE_MAP_ELEMENTS;
+  if (num_macro_blocks > block_map.Size())
   {
-    // Iterate over all blocks in the macro block.
-    auto iter = start->second.begin();
-    while (iter != start->second.end())
-    {
-      JitBlock* block = *iter;
+    // For huge ranges, it's cheaper to look at every block once than to probe every
+    // macro block of the range.
+    block_map.ForEachEntry([&](u32, JitBlock* block) {
       if (block->OverlapsPhysicalRange(address, length))
-      {
-        // If the block overlaps, also remove all other occupied slots in the other macro blocks.
-        // This will leak empty macro blocks, but they may be reused or cleared later on.
-        for (u32 addr : block->physical_addresses)
-          if ((addr & range_mask) != start->first)
-            block_range_map[addr & range_mask].erase(block);
-
-        // And remove the block.
-        DestroyBlock(*block);
-        auto block_map_iter = block_map.equal_range(block->physicalAddress);
-        while (block_map_iter.first != block_map_iter.second)
-        {
-          if (&block_map_iter.first->second == block)
-          {
-            block_map.erase(block_map_iter.first);
-            break;
-          }
-          block_map_iter.first++;
-        }
-        iter = start->second.erase(iter);
-      }
-      else
-      {
-        iter++;
-      }
+        blocks_to_erase.push_back(block);
+    });
+  }
+  else
+  {
+    // Iterate over all macro blocks which overlap the given range. A block can only be
+    // listed once per macro block, but may span several of them.
+    for (u64 macro_block = first_macro_block; macro_block < end;
+         macro_block += BLOCK_RANGE_MAP_ELEMENTS)
+    {
+      block_range_map.ForEach(static_cast<u32>(macro_block), [&](JitBlock* block) {
+        if (block->OverlapsPhysicalRange(address, length))
+          blocks_to_erase.push_back(block);
+      });
     }
 
-    // If the macro block is empty, drop it.
-    if (start->second.empty())
-      start = block_range_map.erase(start);
-    else
-      start++;
+    // Blocks spanning several macro blocks were found once per macro block
+    std::sort(blocks_to_erase.begin(), blocks_to_erase.end());
+    blocks_to_erase.erase(std::unique(blocks_to_erase.begin(), blocks_to_erase.end()),
+                          blocks_to_erase.end());
+  }
+
+  for (JitBlock* block : blocks_to_erase)
+    EraseBlock(*block);
+}
+
+void JitBaseBlockCache::EraseBlock(JitBlock& block)
+{
+  // Remove the block from every macro block it occupies.
+  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
+  for (size_t i = 0; i < block.physical_addresses.size(); i++)
+  {
+    u32 addr = block.physical_addresses[i];
+    if (i == 0 || (addr & range_mask) != (block.physical_addresses[i - 1] & range_mask))
+      block_range_map.Erase(addr & range_mask, &block);
+  }
+
+  // And remove the block.
+  DestroyBlock(block);
+  block_map.Erase(block.physicalAddress, &block);
+  free_blocks.push_back(&block);
+}
+
+JitBlock* JitBaseBlockCache::NewBlock()
+{
+  if (free_blocks.empty())
+  {
+    block_slabs.emplace_back(new JitBlock[BLOCK_SLAB_SIZE]);
+    JitBlock* slab = block_slabs.back().get();
+
+    // Hand out the blocks of a new slab in ascending order.
+    for (size_t i = BLOCK_SLAB_SIZE; i > 0; i--)
+      free_blocks.push_back(&slab[i - 1]);
+  }
+
+  JitBlock* block = free_blocks.back();
+  free_blocks.pop_back();
+  return block;
+}
+
+void JitBaseBlockCache::FreeAllBlocks()
+{
+  free_blocks.clear();
+  for (auto slab = block_slabs.rbegin(); slab != block_slabs.rend(); ++slab)
+  {
+    for (size_t i = BLOCK_SLAB_SIZE; i > 0; i--)
+      free_blocks.push_back(&(*slab)[i - 1]);
   }
 }
 
-u32* JitBaseBlockCache::GetBlockBitSet() const
+u32* const* JitBaseBlockCache::GetBlockBitSet() const
 {
-  return valid_block.m_valid_block.get();
+  return valid_block.m_chunks.get();
 }
 
 void JitBaseBlockCache::WriteDestroyBlock(const JitBlock& block)
@@ -303,14 +363,10 @@ void JitBaseBlockCache::LinkBlockExits(JitBlock& block)
 void JitBaseBlockCache::LinkBlock(JitBlock& block)
 {
   LinkBlockExits(block);
-  auto ppp = links_to.equal_range(block.effectiveAddress);
-
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
-  {
-    JitBlock& b2 = *iter->second;
-    if (block.msrBits == b2.msrBits)
-      LinkBlockExits(b2);
-  }
+  links_to.ForEach(block.effectiveAddress, [this, &block](JitBlock* b2) {
+    if (block.msrBits == b2->msrBits)
+      LinkBlockExits(*b2);
+  });
 }
 
 void JitBaseBlockCache::UnlinkBlock(const JitBlock& block)
@@ -322,14 +378,11 @@ void JitBaseBlockCache::UnlinkBlock(const JitBlock& block)
   }
 
   // Unlink all exits of other blocks which points to this block
-  auto ppp = links_to.equal_range(block.effectiveAddress);
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
-  {
-    JitBlock& sourceBlock = *iter->second;
-    if (sourceBlock.msrBits != block.msrBits)
-      continue;
+  links_to.ForEach(block.effectiveAddress, [this, &block](JitBlock* sourceBlock) {
+    if (sourceBlock->msrBits != block.msrBits)
+      return;
 
-    for (auto& e : sourceBlock.linkData)
+    for (auto& e : sourceBlock->linkData)
     {
       if (e.exitAddress == block.effectiveAddress)
       {
@@ -337,7 +390,7 @@ void JitBaseBlockCache::UnlinkBlock(const JitBlock& block)
         e.linkStatus = false;
       }
     }
-  }
+  });
 }
 
 void JitBaseBlockCache::DestroyBlock(JitBlock& block)
@@ -350,14 +403,7 @@ void JitBaseBlockCache::DestroyBlock(JitBlock& block)
   // Delete linking addresses
   for (const auto& e : block.linkData)
   {
-    auto it = links_to.equal_range(e.exitAddress);
-    while (it.first != it.second)
-    {
-      if (it.first->second == &block)
-        it.first = links_to.erase(it.first);
-      else
-        it.first++;
-    }
+    links_to.EraseAll(e.exitAddress, &block);
   }
 
   // Raise an signal if we are going to call this block again
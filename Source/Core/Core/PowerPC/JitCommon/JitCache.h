@@ -8,12 +8,12 @@
 #include <bitset>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <memory>
 #include <set>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/FlatHashMultiMap.h"
 
 class JitBase;
 
@@ -61,8 +61,8 @@ struct JitBlock
   };
   std::vector<LinkData> linkData;
 
-  // This set stores all physical addresses of all occupied instructions.
-  std::set<u32> physical_addresses;
+  // The sorted physical addresses of all occupied instructions.
+  std::vector<u32> physical_addresses;
 
   // Block profiling data, structure is inlined in Jit.cpp
   struct ProfileData
@@ -81,34 +81,58 @@ struct JitBlock
 
 typedef void (*CompiledCode)();
 
-// This is essentially just an std::bitset, but Visual Studia 2013's
-// implementation of std::bitset is slow.
+// A bitset over the whole 32-bit address space with one bit per 32-byte cache line.
+//
+// Only a few small parts of the address space ever contain code (MEM1, MEM2 and the locked
+// L1 cache), so the bits are stored in chunks of one per 1 MiB region, which are only
+// allocated once a bit inside them is set. All other regions share one read-only chunk of
+// zeroes. Lookups stay O(1) with one extra indirection.
 class ValidBlockBitSet final
 {
 public:
   enum
   {
-    // ValidBlockBitSet covers the whole 32-bit address-space in 32-byte
-    // chunks.
-    // FIXME: Maybe we can get away with less? There isn't any actual
-    // RAM in most of this space.
+    // ValidBlockBitSet covers the whole 32-bit address-space in 32-byte chunks.
     VALID_BLOCK_MASK_SIZE = (1ULL << 32) / 32,
-    // The number of elements in the allocated array. Each u32 contains 32 bits.
-    VALID_BLOCK_ALLOC_ELEMENTS = VALID_BLOCK_MASK_SIZE / 32
+    // Each chunk covers 1 MiB of address space.
+    REGION_SHIFT = 20,
+    NUM_REGIONS = (1ULL << 32) >> REGION_SHIFT,
+    BITS_PER_CHUNK = VALID_BLOCK_MASK_SIZE / NUM_REGIONS,
+    // The number of elements in each chunk. Each u32 contains 32 bits.
+    WORDS_PER_CHUNK = BITS_PER_CHUNK / 32,
   };
-  // Directly accessed by Jit64.
-  std::unique_ptr<u32[]> m_valid_block;
+  // Directly accessed by the JITs: region (address >> REGION_SHIFT) -> chunk of the region.
+  std::unique_ptr<u32*[]> m_chunks;
+
+  ValidBlockBitSet();
+  ~ValidBlockBitSet();
 
-  ValidBlockBitSet()
+  void Set(u32 bit)
+  {
+    u32*& chunk = m_chunks[bit / BITS_PER_CHUNK];
+    if (chunk == s_empty_chunk)
+      chunk = AllocateChunk();
+    chunk[(bit % BITS_PER_CHUNK) / 32] |= 1u << (bit % 32);
+  }
+  void Clear(u32 bit)
+  {
+    u32* chunk = m_chunks[bit / BITS_PER_CHUNK];
+    if (chunk != s_empty_chunk)
+      chunk[(bit % BITS_PER_CHUNK) / 32] &= ~(1u << (bit % 32));
+  }
+  void ClearAll();
+  bool Test(u32 bit) const
   {
-    m_valid_block.reset(new u32[VALID_BLOCK_ALLOC_ELEMENTS]);
-    ClearAll();
+    return (m_chunks[bit / BITS_PER_CHUNK][(bit % BITS_PER_CHUNK) / 32] & (1u << (bit % 32))) != 0;
   }
 
-  void Set(u32 bit) { m_valid_block[bit / 32] |= 1u << (bit % 32); }
-  void Clear(u32 bit) { m_valid_block[bit / 32] &= ~(1u << (bit % 32)); }
-  void ClearAll() { memset(m_valid_block.get(), 0, sizeof(u32) * VALID_BLOCK_ALLOC_ELEMENTS); }
-  bool Test(u32 bit) { return (m_valid_block[bit / 32] & (1u << (bit % 32))) != 0; }
+private:
+  u32* AllocateChunk();
+
+  // Never written to; shared by all regions without a valid block.
+  static u32 s_empty_chunk[WORDS_PER_CHUNK];
+
+  std::vector<std::unique_ptr<u32[]>> m_allocated_chunks;
 };
 
 class JitBaseBlockCache
@@ -150,7 +174,7 @@ public:
   void InvalidateICache(u32 address, u32 length, bool forced);
   void ErasePhysicalRange(u32 address, u32 length);
 
-  u32* GetBlockBitSet() const;
+  u32* const* GetBlockBitSet() const;
 
 protected:
   JitBase& m_jit;
@@ -163,6 +187,10 @@ private:
   void LinkBlock(JitBlock& block);
   void UnlinkBlock(const JitBlock& block);
   void DestroyBlock(JitBlock& block);
+  void EraseBlock(JitBlock& block);
+
+  JitBlock* NewBlock();
+  void FreeAllBlocks();
 
   JitBlock* MoveBlockIntoFastCache(u32 em_address, u32 msr);
 
@@ -171,17 +199,26 @@ private:
 
   // links_to hold all exit points of all valid blocks in a reverse way.
   // It is used to query all blocks which links to an address.
-  std::multimap<u32, JitBlock*> links_to;  // destination_PC -> number
+  Common::FlatHashMultiMap<u32, JitBlock*> links_to;  // destination_PC -> block
 
   // Map indexed by the physical address of the entry point.
   // This is used to query the block based on the current PC in a slow way.
-  std::multimap<u32, JitBlock> block_map;  // start_addr -> block
+  Common::FlatHashMultiMap<u32, JitBlock*> block_map;  // start_addr -> block
 
   // Range of overlapping code indexed by a masked physical address.
   // This is used for invalidation of memory regions. The range is grouped
-  // in macro blocks of each 0x100 bytes.
+  // in macro blocks of each 0x100 bytes. Each block is listed once per macro block.
   static constexpr u32 BLOCK_RANGE_MAP_ELEMENTS = 0x100;
-  std::map<u32, std::set<JitBlock*>> block_range_map;
+  Common::FlatHashMultiMap<u32, JitBlock*> block_range_map;  // masked addr -> block
+
+  // The blocks themselves are allocated in slabs, so that pointers to them stay valid
+  // and neighbouring blocks are close in memory. Destroyed blocks go to the free list.
+  static constexpr size_t BLOCK_SLAB_SIZE = 1024;
+  std::vector<std::unique_ptr<JitBlock[]>> block_slabs;
+  std::vector<JitBlock*> free_blocks;
+
+  // Scratch space for ErasePhysicalRange, kept around to avoid reallocations.
+  std::vector<JitBlock*> blocks_to_erase;
 
   // This bitsets shows which cachelines overlap with any blocks.
   // It is used to provide a fast way to query if no icache invalidation is needed.
@@ -207,13 +207,13 @@ void ClearSafe()
   // the JIT'ed code.
   // TODO: There's probably a better way to handle this situation.
   if (g_jit)
-    g_jit->GetBlockCache()->Clear();
+    g_jit->ClearSafe();
 }
 
 void InvalidateICache(u32 address, u32 size, bool forced)
 {
   if (g_jit)
-    g_jit->GetBlockCache()->InvalidateICache(address, size, forced);
+    g_jit->InvalidateICache(address, size, forced);
 }
 
 void CompileExceptionCheck(ExceptionType type)
@@ -249,7 +249,7 @@ void CompileExceptionCheck(ExceptionType type)
 
     // Invalidate the JIT block so that it gets recompiled with the external exception check
     // included.
-    g_jit->GetBlockCache()->InvalidateICache(PC, 4, true);
+    g_jit->InvalidateICache(PC, 4, true);
   }
 }
 
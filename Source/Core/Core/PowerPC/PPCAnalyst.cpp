@@ -39,6 +39,9 @@ constexpr int CODEBUFFER_SIZE = 32000;
 // 0 does not perform block merging
 constexpr u32 BRANCH_FOLLOWING_THRESHOLD = 2;
 
+// Maximum number of branches inside a function followed by OPTION_TRACE.
+constexpr u32 TRACE_FOLLOWING_THRESHOLD = 8;
+
 constexpr u32 INVALID_BRANCH_TARGET = 0xFFFFFFFF;
 
 CodeBuffer::CodeBuffer(int size)
@@ -710,8 +713,21 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
   bool found_call = false;
   size_t caller = 0;
   u32 numFollows = 0;
+  u32 numTraceFollows = 0;
   u32 num_inst = 0;
 
+  u32 trace_start = 0;
+  u32 trace_size = 0;
+  if (HasOption(OPTION_TRACE))
+  {
+    const Symbol* function = g_symbolDB.GetSymbolFromAddr(address);
+    if (function && function->size > 0)
+    {
+      trace_start = function->address;
+      trace_size = static_cast<u32>(function->size);
+    }
+  }
+
   for (u32 i = 0; i < blockSize; ++i)
   {
     auto result = PowerPC::TryReadInstruction(address);
@@ -739,6 +755,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     SetInstructionStats(block, &code[i], opinfo, i);
 
     bool follow = false;
+    bool trace_follow = false;
     u32 destination = 0;
 
     bool conditional_continue = false;
@@ -804,6 +821,19 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
       }
     }
 
+    // Once the follow limit is reached, keep following plain jumps within the function,
+    // e.g. over an else clause or to a loop condition.
+    if (!follow && trace_size != 0 && numTraceFollows < TRACE_FOLLOWING_THRESHOLD &&
+        inst.OPCD == 18 && !inst.LK && blockSize > 1)
+    {
+      const u32 target = SignExt26(inst.LI << 2) + (inst.AA ? 0 : address);
+      if (target != block->m_address && target - trace_start < trace_size)
+      {
+        trace_follow = true;
+        destination = target;
+      }
+    }
+
     if (HasOption(OPTION_CONDITIONAL_CONTINUE))
     {
       if (inst.OPCD == 16 &&
@@ -831,7 +861,12 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
       }
     }
 
-    if (follow)
+    if (trace_follow)
+    {
+      numTraceFollows++;
+      address = destination;
+    }
+    else if (follow)
     {
       // Follow the unconditional branch.
       numFollows++;
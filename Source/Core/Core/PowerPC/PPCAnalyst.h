@@ -218,6 +218,14 @@ public:
 
     // Reorder cror instructions next to their associated fcmp.
     OPTION_CROR_MERGE = (1 << 6),
+
+    // Trace compilation: beyond the OPTION_BRANCH_FOLLOW limit, keep following unconditional
+    // branches as long as they stay inside the function (from the symbol DB) the block
+    // starts in. Together with OPTION_CONDITIONAL_CONTINUE, this turns the straight-line
+    // path through a function into one superblock, where conditional branches become side
+    // exits and registers stay allocated across the followed branches.
+    // Does nothing for code without a symbol.
+    OPTION_TRACE = (1 << 7),
   };
 
   PPCAnalyzer() : m_options(0) {}
@@ -0,0 +1,331 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/Rewind.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/DeltaEncoder.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "Common/WorkQueueThread.h"
+
+#include "Core/Config/MainSettings.h"
+#include "Core/Core.h"
+#include "Core/NetPlayProto.h"
+#include "Core/State.h"
+
+// Snapshots are taken on the host thread, which pauses the CPU thread just long enough to
+// serialize the state. Encoding them as deltas to a recent full state (a keyframe) happens on
+// a separate thread afterwards.
+
+namespace Rewind
+{
+namespace
+{
+// Starting a new keyframe every now and then keeps the deltas small, and allows freeing old
+// keyframes once their snapshots fall out of the memory budget.
+constexpr u32 MAX_DELTAS_PER_KEYFRAME = 60;
+
+struct Snapshot
+{
+  u64 frame = 0;
+  u64 generation = 0;
+  std::vector<u8> state;
+};
+
+struct Entry
+{
+  u64 frame;
+  std::shared_ptr<const Common::DeltaEncoder> keyframe;
+  std::vector<u8> delta;
+};
+}  // Anonymous namespace
+
+static std::mutex s_lock;
+// Protected by s_lock. Oldest snapshot first, snapshots using the same keyframe are adjacent.
+static std::deque<Entry> s_entries;
+static Stats s_stats;
+static size_t s_memory_budget;
+// Snapshots taken before the last time s_entries was cut short are dropped.
+static u64 s_generation = 0;
+
+// Only used on the CPU thread, or while it is paused.
+static std::atomic<bool> s_enabled{false};
+static u32 s_interval;
+static u64 s_frame;
+static u32 s_frames_since_snapshot;
+static std::atomic<bool> s_capture_pending{false};
+static Hooks s_hooks;
+
+// Only used on the encode thread.
+static std::shared_ptr<const Common::DeltaEncoder> s_keyframe;
+static u32 s_deltas_since_keyframe;
+static Common::WorkQueueThread<Snapshot> s_encode_thread;
+
+static size_t KeyframeSize(const Entry& entry)
+{
+  return entry.keyframe->GetBase().size();
+}
+
+// The following need s_lock to be held.
+static void PopFront()
+{
+  const Entry entry = std::move(s_entries.front());
+  s_entries.pop_front();
+  s_stats.resident_bytes -= entry.delta.size();
+  if (s_entries.empty() || s_entries.front().keyframe != entry.keyframe)
+  {
+    s_stats.resident_bytes -= KeyframeSize(entry);
+    s_stats.num_keyframes--;
+  }
+}
+
+static void PopBack()
+{
+  const Entry entry = std::move(s_entries.back());
+  s_entries.pop_back();
+  s_stats.resident_bytes -= entry.delta.size();
+  if (s_entries.empty() || s_entries.back().keyframe != entry.keyframe)
+  {
+    s_stats.resident_bytes -= KeyframeSize(entry);
+    s_stats.num_keyframes--;
+  }
+}
+
+static void PushBack(Entry entry)
+{
+  if (s_entries.empty() || s_entries.back().keyframe != entry.keyframe)
+  {
+    s_stats.resident_bytes += KeyframeSize(entry);
+    s_stats.num_keyframes++;
+  }
+  s_stats.resident_bytes += entry.delta.size();
+  s_entries.push_back(std::move(entry));
+
+  // Always keep the newest snapshot, even if it alone is over the budget.
+  while (s_stats.resident_bytes > s_memory_budget && s_entries.size() > 1)
+    PopFront();
+}
+
+static void Encode(Snapshot snapshot)
+{
+  {
+    std::lock_guard<std::mutex> lk(s_lock);
+    if (snapshot.generation != s_generation)
+      return;
+  }
+
+  const u64 start = Common::Timer::GetTimeUs();
+  std::vector<u8> delta;
+  if (s_keyframe && s_deltas_since_keyframe < MAX_DELTAS_PER_KEYFRAME)
+  {
+    delta = s_keyframe->Encode(snapshot.state.data(), snapshot.state.size());
+    s_deltas_since_keyframe++;
+  }
+
+  // Once too much has changed since the keyframe, storing deltas to it stops paying off.
+  if (delta.empty() || delta.size() > s_keyframe->GetBase().size() / 4)
+  {
+    s_keyframe = std::make_shared<const Common::DeltaEncoder>(std::move(snapshot.state));
+    s_deltas_since_keyframe = 0;
+    const std::vector<u8>& base = s_keyframe->GetBase();
+    delta = s_keyframe->Encode(base.data(), base.size());
+  }
+
+  std::lock_guard<std::mutex> lk(s_lock);
+  if (snapshot.generation != s_generation)
+    return;
+
+  PushBack({snapshot.frame, s_keyframe, std::move(delta)});
+  s_stats.last_encode_us = Common::Timer::GetTimeUs() - start;
+}
+
+static void Capture()
+{
+  Snapshot snapshot;
+  const u64 start = Common::Timer::GetTimeUs();
+  Core::RunAsCPUThread([&] {
+    if (!s_enabled)
+      return;
+
+    s_hooks.save_state(snapshot.state);
+    snapshot.frame = s_frame;
+    std::lock_guard<std::mutex> lk(s_lock);
+    snapshot.generation = s_generation;
+  });
+  const u64 capture_us = Common::Timer::GetTimeUs() - start;
+  s_capture_pending = false;
+
+  if (snapshot.state.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(s_lock);
+    s_stats.last_capture_us = capture_us;
+    s_stats.max_capture_us = std::max(s_stats.max_capture_us, capture_us);
+  }
+  s_encode_thread.EmplaceItem(std::move(snapshot));
+}
+
+void Init()
+{
+  Hooks hooks;
+  hooks.save_state = State::SaveToBuffer;
+  hooks.load_state = State::LoadFromDeltaBuffer;
+  hooks.queue_host_job = [](std::function<void()> job) { Core::QueueHostJob(std::move(job)); };
+
+  const int interval = Config::Get(Config::MAIN_REWIND_INTERVAL);
+  const int memory_mb = Config::Get(Config::MAIN_REWIND_MEMORY_MB);
+  Init(static_cast<u32>(std::max(interval, 0)), static_cast<size_t>(std::max(memory_mb, 0)) << 20,
+       std::move(hooks));
+}
+
+void Init(u32 interval, size_t memory_budget, Hooks hooks)
+{
+  s_interval = interval;
+  s_hooks = std::move(hooks);
+  s_frame = 0;
+  s_frames_since_snapshot = 0;
+  s_capture_pending = false;
+
+  {
+    std::lock_guard<std::mutex> lk(s_lock);
+    s_entries.clear();
+    s_stats = {};
+    s_memory_budget = memory_budget;
+    s_generation++;
+  }
+
+  // Savestates can't be loaded during netplay, so there is no point in taking any.
+  s_enabled = s_interval != 0 && !NetPlay::IsNetPlayRunning();
+  if (s_enabled)
+    s_encode_thread.Reset(Encode);
+}
+
+void Shutdown()
+{
+  s_enabled = false;
+
+  {
+    std::lock_guard<std::mutex> lk(s_lock);
+    s_entries.clear();
+    s_stats.resident_bytes = 0;
+    s_stats.num_keyframes = 0;
+    s_generation++;
+  }
+
+  s_encode_thread.Shutdown();
+  s_keyframe.reset();
+}
+
+bool IsEnabled()
+{
+  return s_enabled;
+}
+
+void FrameAdvanced()
+{
+  if (!s_enabled)
+    return;
+
+  s_frame++;
+  if (++s_frames_since_snapshot < s_interval)
+    return;
+  s_frames_since_snapshot = 0;
+
+  // Don't let requests pile up if the host thread can't keep up.
+  if (s_capture_pending.exchange(true))
+  {
+    std::lock_guard<std::mutex> lk(s_lock);
+    s_stats.num_skipped++;
+    return;
+  }
+
+  s_hooks.queue_host_job(Capture);
+}
+
+bool StepBack()
+{
+  if (!s_enabled)
+  {
+    Core::DisplayMessage("Rewinding is disabled", 2000);
+    return false;
+  }
+
+  bool loaded = false;
+  Core::RunAsCPUThread([&] {
+    Entry entry;
+    {
+      std::lock_guard<std::mutex> lk(s_lock);
+      while (!s_entries.empty() && s_entries.back().frame >= s_frame)
+        PopBack();
+      if (s_entries.empty())
+        return;
+
+      entry = s_entries.back();
+      // Snapshots which are still being encoded are newer than the one we're going back to.
+      s_generation++;
+    }
+
+    loaded = s_hooks.load_state(*entry.keyframe, entry.delta);
+    if (loaded)
+    {
+      s_frame = entry.frame;
+      s_frames_since_snapshot = 0;
+    }
+  });
+
+  if (!loaded)
+  {
+    Core::DisplayMessage("Nothing to rewind to", 2000);
+    return false;
+  }
+
+  const Stats stats = GetStats();
+  Core::DisplayMessage(StringFromFormat("Rewound, %zu snapshots (%zu MiB) left",
+                                        stats.num_snapshots, stats.resident_bytes >> 20),
+                       2000);
+  return true;
+}
+
+void Reset()
+{
+  if (!s_enabled)
+    return;
+
+  Core::RunAsCPUThread([] {
+    s_frame = 0;
+    s_frames_since_snapshot = 0;
+
+    std::lock_guard<std::mutex> lk(s_lock);
+    s_entries.clear();
+    s_stats.resident_bytes = 0;
+    s_stats.num_keyframes = 0;
+    // Snapshots which are still being encoded were taken before the load.
+    s_generation++;
+  });
+}
+
+void WaitForEncoding()
+{
+  s_encode_thread.WaitForCompletion();
+}
+
+Stats GetStats()
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+  Stats stats = s_stats;
+  stats.num_snapshots = s_entries.size();
+  return stats;
+}
+}  // namespace Rewind
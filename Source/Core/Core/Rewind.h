@@ -0,0 +1,71 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Keeps recent savestates in memory so that emulation can be stepped backwards.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+class DeltaEncoder;
+}
+
+namespace Rewind
+{
+struct Stats
+{
+  size_t num_snapshots;
+  size_t num_keyframes;
+  // Memory used by all kept snapshots, including the full states they are relative to.
+  size_t resident_bytes;
+  // How long the CPU was paused to take the last and the slowest snapshot.
+  u64 last_capture_us;
+  u64 max_capture_us;
+  // How long encoding the last snapshot took on the rewind thread.
+  u64 last_encode_us;
+  // Snapshots which were skipped because the previous one wasn't taken yet.
+  u64 num_skipped;
+};
+
+// How snapshots are taken and loaded, and how taking them is scheduled on the host thread.
+struct Hooks
+{
+  std::function<void(std::vector<u8>&)> save_state;
+  std::function<bool(const Common::DeltaEncoder&, const std::vector<u8>&)> load_state;
+  std::function<void(std::function<void()>)> queue_host_job;
+};
+
+// Starts taking snapshots every MAIN_REWIND_INTERVAL frames if rewinding is enabled.
+void Init();
+// Like Init, but with explicit settings and hooks, for tests which can't run the emulated system.
+void Init(u32 interval, size_t memory_budget, Hooks hooks);
+void Shutdown();
+
+bool IsEnabled();
+
+// Called on the CPU thread at the end of every field.
+void FrameAdvanced();
+
+// Loads the newest snapshot taken before the current frame, discarding everything after it.
+// Repeated calls go back one snapshot at a time, so with an interval of 1 this steps back frame
+// by frame. Every snapshot is loaded from a single full state plus one delta, so the time this
+// takes doesn't depend on how far back it goes.
+// Returns false if there is no such snapshot.
+bool StepBack();
+
+// Forgets all snapshots. Called after loading a savestate, since emulation then continues from
+// somewhere the snapshots taken so far don't lead to.
+void Reset();
+
+// Waits until the snapshots taken so far have been stored.
+void WaitForEncoding();
+
+Stats GetStats();
+}
@@ -4,23 +4,31 @@
 
 #include "Core/State.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <lzo/lzo1x.h>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#include "Common/CPUDetect.h"
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/DeltaEncoder.h"
 #include "Common/Event.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/ScopeGuard.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Common/ThreadPool.h"
 #include "Common/Timer.h"
 #include "Common/Version.h"
 
@@ -34,6 +42,7 @@
 #include "Core/Movie.h"
 #include "Core/NetPlayClient.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/Rewind.h"
 
 #include "VideoCommon/AVIDump.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -51,12 +60,15 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
+// Compressed states are a sequence of (u32 length, LZO data) chunks, each of which decompresses
+// to IN_LEN bytes except for the last one. The chunks are independent of each other, so they
+// are compressed and decompressed in parallel, this many at a time.
+static const size_t CHUNKS_PER_BATCH = 64;
 
-#define HEAP_ALLOC(var, size)                                                                      \
-  lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// Only used by one save or load at a time, since both of them Flush() the save thread first.
+static std::unique_ptr<Common::ThreadPool> s_compression_pool;
+// LZO's compression dictionary, one per thread of the pool
+static std::vector<std::vector<lzo_align_t>> s_compression_work_memory;
 
 static std::string g_last_filename;
 
@@ -231,6 +243,23 @@ void SaveToBuffer(std::vector<u8>& buffer)
   });
 }
 
+void SaveToDeltaBuffer(const Common::DeltaEncoder& base, std::vector<u8>& buffer)
+{
+  std::vector<u8> full_state;
+  SaveToBuffer(full_state);
+  buffer = base.Encode(full_state.data(), full_state.size());
+}
+
+bool LoadFromDeltaBuffer(const Common::DeltaEncoder& base, const std::vector<u8>& buffer)
+{
+  std::vector<u8> full_state;
+  if (!base.Decode(buffer, &full_state) || full_state.empty())
+    return false;
+
+  LoadFromBuffer(full_state);
+  return true;
+}
+
 void VerifyBuffer(std::vector<u8>& buffer)
 {
   Core::RunAsCPUThread([&] {
@@ -295,6 +324,80 @@ struct CompressAndDumpState_args
   bool wait;
 };
 
+static void CompressBuffer(File::IOFile& f, const u8* data, size_t size)
+{
+  const size_t num_chunks = (size + IN_LEN - 1) / IN_LEN;
+  std::vector<std::vector<u8>> compressed(std::min(num_chunks, CHUNKS_PER_BATCH));
+
+  for (size_t batch_start = 0; batch_start < num_chunks; batch_start += CHUNKS_PER_BATCH)
+  {
+    const size_t batch_size = std::min(num_chunks - batch_start, CHUNKS_PER_BATCH);
+    s_compression_pool->ParallelFor(batch_size, [&](size_t i, size_t thread_index) {
+      const size_t offset = (batch_start + i) * IN_LEN;
+      const lzo_uint in_len = static_cast<lzo_uint>(std::min<size_t>(size - offset, IN_LEN));
+      std::vector<lzo_align_t>& work_memory = s_compression_work_memory[thread_index];
+      work_memory.resize(LZO1X_1_MEM_COMPRESS / sizeof(lzo_align_t) + 1);
+
+      std::vector<u8>& out = compressed[i];
+      out.resize(OUT_LEN);
+      lzo_uint out_len = 0;
+      if (lzo1x_1_compress(data + offset, in_len, out.data(), &out_len, work_memory.data()) !=
+          LZO_E_OK)
+      {
+        PanicAlertT("Internal LZO Error - compression failed");
+      }
+      out.resize(out_len);
+    });
+
+    // Write the batch while it's still in cache, and so that memory use stays bounded.
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      const lzo_uint32 out_len = static_cast<lzo_uint32>(compressed[i].size());
+      f.WriteArray(&out_len, 1);
+      f.WriteBytes(compressed[i].data(), out_len);
+    }
+  }
+}
+
+static bool DecompressBuffer(File::IOFile& f, std::vector<u8>* buffer)
+{
+  const size_t num_chunks = (buffer->size() + IN_LEN - 1) / IN_LEN;
+  std::vector<std::vector<u8>> compressed(std::min(num_chunks, CHUNKS_PER_BATCH));
+
+  // Like saving, this only keeps one batch of compressed chunks in memory at a time.
+  for (size_t batch_start = 0; batch_start < num_chunks; batch_start += CHUNKS_PER_BATCH)
+  {
+    const size_t batch_size = std::min(num_chunks - batch_start, CHUNKS_PER_BATCH);
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      lzo_uint32 length;
+      if (!f.ReadArray(&length, 1) || length > OUT_LEN)
+        return false;
+      compressed[i].resize(length);
+      if (!f.ReadBytes(compressed[i].data(), length))
+        return false;
+    }
+
+    std::atomic<bool> success{true};
+    s_compression_pool->ParallelFor(batch_size, [&](size_t i, size_t) {
+      const size_t offset = (batch_start + i) * IN_LEN;
+      const lzo_uint expected_len = std::min<size_t>(buffer->size() - offset, IN_LEN);
+      lzo_uint new_len = expected_len;
+      const int res = lzo1x_decompress_safe(compressed[i].data(), compressed[i].size(),
+                                            buffer->data() + offset, &new_len, nullptr);
+      if (res != LZO_E_OK || new_len != expected_len)
+      {
+        ERROR_LOG(CORE, "LZO decompression of state chunk %zu failed (%d)", batch_start + i, res);
+        success = false;
+      }
+    });
+    if (!success)
+      return false;
+  }
+
+  return true;
+}
+
 static void CompressAndDumpState(CompressAndDumpState_args save_args)
 {
   std::lock_guard<std::mutex> lk(*save_args.buffer_mutex);
@@ -355,33 +458,7 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 
   if (header.size != 0)  // non-zero header size means the state is compressed
   {
-    lzo_uint i = 0;
-    while (true)
-    {
-      lzo_uint32 cur_len = 0;
-      lzo_uint out_len = 0;
-
-      if ((i + IN_LEN) >= buffer_size)
-      {
-        cur_len = (lzo_uint32)(buffer_size - i);
-      }
-      else
-      {
-        cur_len = IN_LEN;
-      }
-
-      if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-        PanicAlertT("Internal LZO Error - compression failed");
-
-      // The size of the data to write is 'out_len'
-      f.WriteArray((lzo_uint32*)&out_len, 1);
-      f.WriteBytes(out, out_len);
-
-      if (cur_len != IN_LEN)
-        break;
-
-      i += cur_len;
-    }
+    CompressBuffer(f, buffer_data, buffer_size);
   }
   else  // uncompressed
   {
@@ -489,27 +566,10 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 
     buffer.resize(header.size);
 
-    lzo_uint i = 0;
-    while (true)
+    if (!DecompressBuffer(f, &buffer))
     {
-      lzo_uint32 cur_len = 0;  // number of bytes to read
-      lzo_uint new_len = 0;    // number of bytes to write
-
-      if (!f.ReadArray(&cur_len, 1))
-        break;
-
-      f.ReadBytes(out, cur_len);
-      const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-      if (res != LZO_E_OK)
-      {
-        // This doesn't seem to happen anymore.
-        PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-                    "Try loading the state again",
-                    res, i, new_len);
-        return;
-      }
-
-      i += new_len;
+      Core::DisplayMessage("Unable to load: The state is corrupted", 4000);
+      return;
     }
   }
   else  // uncompressed
@@ -575,6 +635,8 @@ void LoadAs(const std::string& filename)
 
     if (loaded)
     {
+      Rewind::Reset();
+
       if (loadedSuccessfully)
       {
         Core::DisplayMessage(StringFromFormat("Loaded state from %s", filename.c_str()), 2000);
@@ -633,6 +695,10 @@ void Init()
 {
   if (lzo_init() != LZO_E_OK)
     PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+  s_compression_pool = std::make_unique<Common::ThreadPool>(std::max(cpu_info.num_cores, 1),
+                                                            "State Compression");
+  s_compression_work_memory.resize(s_compression_pool->GetNumThreads());
 }
 
 void Shutdown()
@@ -651,6 +717,9 @@ void Shutdown()
     std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
     std::vector<u8>().swap(g_undo_load_buffer);
   }
+
+  s_compression_pool.reset();
+  s_compression_work_memory.clear();
 }
 
 static std::string MakeStateFilename(int number)
@@ -721,6 +790,7 @@ void UndoLoadState()
     if (File::Exists(File::GetUserPath(D_STATESAVES_IDX) + "undo.dtm") || (!Movie::IsMovieActive()))
     {
       LoadFromBuffer(g_undo_load_buffer);
+      Rewind::Reset();
       if (Movie::IsMovieActive())
         Movie::LoadInput(File::GetUserPath(D_STATESAVES_IDX) + "undo.dtm");
     }
@@ -12,6 +12,11 @@
 
 #include "Common/CommonTypes.h"
 
+namespace Common
+{
+class DeltaEncoder;
+}
+
 namespace State
 {
 // number of states
@@ -53,6 +58,13 @@ void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 void VerifyBuffer(std::vector<u8>& buffer);
 
+// Delta states only contain what changed compared to a base state created with SaveToBuffer.
+// They are much smaller than full states as long as the base is recent, and are meant for
+// keeping many states in memory.
+void SaveToDeltaBuffer(const Common::DeltaEncoder& base, std::vector<u8>& buffer);
+// Returns false if the buffer isn't a delta state created from the given base.
+bool LoadFromDeltaBuffer(const Common::DeltaEncoder& base, const std::vector<u8>& buffer);
+
 void LoadLastSaved(int i = 1);
 void SaveFirstSaved();
 void UndoSaveState();
@@ -14,9 +14,8 @@
 #include <cstring>
 #include <string>
 
-#include <mbedtls/sha1.h>
-
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Crypto/ec.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
@@ -89,7 +88,7 @@ void MakeNGCert(u8* ng_cert_out, u32 NG_id, u32 NG_key_id, const u8* NG_priv, co
 void MakeAPSigAndCert(u8* sig_out, u8* ap_cert_out, u64 title_id, u8* data, u32 data_size,
                       const u8* NG_priv, u32 NG_id)
 {
-  u8 hash[20];
+  Common::SHA1::Digest hash;
   u8 ap_priv[30];
   char signer[64];
   char name[64];
@@ -112,11 +111,11 @@ void MakeAPSigAndCert(u8* sig_out, u8* ap_cert_out, u64 title_id, u8* data, u32
   sprintf(name, "AP%016" PRIx64, title_id);
   MakeBlankSigECCert(ap_cert_out, signer, name, ap_priv, 0);
 
-  mbedtls_sha1(ap_cert_out + 0x80, 0x100, hash);
-  generate_ecdsa(ap_cert_out + 4, ap_cert_out + 34, NG_priv, hash);
+  hash = Common::SHA1::CalculateDigest(ap_cert_out + 0x80, 0x100);
+  generate_ecdsa(ap_cert_out + 4, ap_cert_out + 34, NG_priv, hash.data());
 
-  mbedtls_sha1(data, data_size, hash);
-  generate_ecdsa(sig_out, sig_out + 30, ap_priv, hash);
+  hash = Common::SHA1::CalculateDigest(data, data_size);
+  generate_ecdsa(sig_out, sig_out + 30, ap_priv, hash.data());
 }
 
 EcWii::EcWii()
@@ -4,18 +4,23 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
 #include "Common/CDUtils.h"
+#include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/ThreadPool.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
 #include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DCZBlob.h"
 #include "DiscIO/DirectoryBlob.h"
 #include "DiscIO/DriveBlob.h"
 #include "DiscIO/FileBlob.h"
@@ -24,74 +29,76 @@
 
 namespace DiscIO
 {
+static std::mutex s_decompress_pool_mutex;
+static std::unique_ptr<Common::ThreadPool> s_decompress_pool;
+
 void SectorReader::SetSectorSize(int blocksize)
 {
   m_block_size = std::max(blocksize, 0);
-  for (auto& cache_entry : m_cache)
-  {
-    cache_entry.Reset();
-    cache_entry.data.resize(m_chunk_blocks * m_block_size);
-  }
+  ClearCache();
 }
 
 void SectorReader::SetChunkSize(int block_cnt)
 {
   m_chunk_blocks = std::max(block_cnt, 1);
-  // Clear cache and resize the data arrays
-  SetSectorSize(m_block_size);
+  ClearCache();
 }
 
-SectorReader::~SectorReader()
+void SectorReader::SetCacheLines(int lines)
 {
+  m_max_cache_lines = std::max(lines, 1);
+  ClearCache();
 }
 
-const SectorReader::Cache* SectorReader::FindCacheLine(u64 block_num)
+SectorReader::~SectorReader()
 {
-  auto itr = std::find_if(m_cache.begin(), m_cache.end(),
-                          [&](const Cache& entry) { return entry.Contains(block_num); });
-  if (itr == m_cache.end())
-    return nullptr;
-
-  itr->MarkUsed();
-  return &*itr;
 }
 
-SectorReader::Cache* SectorReader::GetEmptyCacheLine()
+void SectorReader::ClearCache()
 {
-  Cache* oldest = &m_cache[0];
-  // Find the Least Recently Used cache line to replace.
-  std::for_each(m_cache.begin() + 1, m_cache.end(), [&](Cache& line) {
-    if (line.IsLessRecentlyUsedThan(*oldest))
-    {
-      oldest->ShiftLRU();
-      oldest = &line;
-      return;
-    }
-    line.ShiftLRU();
-  });
-  oldest->Reset();
-  return oldest;
+  m_cache.clear();
+  m_cache_index.clear();
 }
 
 const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
 {
-  if (auto entry = FindCacheLine(block_num))
-    return entry;
-
-  // Cache miss. Fault in the missing entry.
-  Cache* cache = GetEmptyCacheLine();
   // We only read aligned chunks, this avoids duplicate overlapping entries.
-  u64 chunk_idx = block_num / m_chunk_blocks;
-  u32 blocks_read = ReadChunk(cache->data.data(), chunk_idx);
+  const u64 chunk_idx = block_num / m_chunk_blocks;
+  const auto found = m_cache_index.find(chunk_idx);
+  if (found != m_cache_index.end())
+  {
+    m_cache.splice(m_cache.begin(), m_cache, found->second);
+    return found->second->Contains(block_num) ? &*found->second : nullptr;
+  }
+
+  // Cache miss. Fault in the missing entry, in a new line until there are enough of them.
+  if (m_cache.size() < m_max_cache_lines)
+  {
+    m_cache.emplace_front();
+  }
+  else
+  {
+    m_cache_index.erase(m_cache.back().block_idx / m_chunk_blocks);
+    m_cache.splice(m_cache.begin(), m_cache, std::prev(m_cache.end()));
+  }
+
+  Cache& cache = m_cache.front();
+  cache.data.resize(m_chunk_blocks * m_block_size);
+  const u32 blocks_read = ReadChunk(cache.data.data(), chunk_idx);
   if (!blocks_read)
+  {
+    m_cache.pop_front();
     return nullptr;
-  cache->Fill(chunk_idx * m_chunk_blocks, blocks_read);
+  }
+  cache.block_idx = chunk_idx * m_chunk_blocks;
+  cache.num_blocks = blocks_read;
+  m_cache_index.emplace(chunk_idx, m_cache.begin());
 
   // Secondary check for out-of-bounds read.
   // If we got less than m_chunk_blocks, we may still have missed.
   // We do this after the cache fill since the cache line itself is
   // fine, the problem is being asked to read past the end of the disk.
-  return cache->Contains(block_num) ? cache : nullptr;
+  return cache.Contains(block_num) ? &cache : nullptr;
 }
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
@@ -136,6 +143,31 @@ bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 cnt_blocks, u8*
   return true;
 }
 
+void SectorReader::DecompressBlocks(size_t num_blocks,
+                                    const std::function<void(size_t)>& decompress)
+{
+  // Readers decompress at most this many blocks at once.
+  constexpr int MAX_DECOMPRESS_THREADS = 8;
+
+  std::unique_lock<std::mutex> pool_lock(s_decompress_pool_mutex, std::try_to_lock);
+  if (num_blocks > 1 && pool_lock.owns_lock())
+  {
+    if (!s_decompress_pool)
+    {
+      const int num_threads = std::min(std::max(cpu_info.num_cores, 1), MAX_DECOMPRESS_THREADS);
+      s_decompress_pool = std::make_unique<Common::ThreadPool>(num_threads, "Disc Decompression");
+    }
+    s_decompress_pool->ParallelFor(num_blocks, [&](size_t i, size_t) { decompress(i); });
+  }
+  else
+  {
+    if (pool_lock.owns_lock())
+      pool_lock.unlock();
+    for (size_t i = 0; i < num_blocks; ++i)
+      decompress(i);
+  }
+}
+
 u32 SectorReader::ReadChunk(u8* buffer, u64 chunk_num)
 {
   u64 block_num = chunk_num * m_chunk_blocks;
@@ -198,6 +230,8 @@ std::unique_ptr<BlobReader> CreateBlobReader(const std::string& filename)
     return CISOFileReader::Create(std::move(file));
   case GCZ_MAGIC:
     return CompressedBlobReader::Create(std::move(file), filename);
+  case DCZ_MAGIC:
+    return DCZFileReader::Create(std::move(file), filename);
   case TGC_MAGIC:
     return TGCFileReader::Create(std::move(file));
   case WBFS_MAGIC:
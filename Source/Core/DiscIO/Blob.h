@@ -14,10 +14,12 @@
 // detect whether the file is a compressed blob, or just a big hunk of data, or a drive, and
 // automatically do the right thing.
 
-#include <array>
+#include <functional>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -34,7 +36,8 @@ enum class BlobType
   GCZ,
   CISO,
   WBFS,
-  TGC
+  TGC,
+  DCZ
 };
 
 class BlobReader
@@ -86,6 +89,8 @@ protected:
   // as large reads are slow and will take too long to resolve.
   void SetChunkSize(int blocks);
   int GetChunkSize() const { return m_chunk_blocks; }
+  // Set the number of chunks to keep in memory. Their memory is only allocated once they're used.
+  void SetCacheLines(int lines);
   // Read a single block/sector.
   virtual bool GetBlock(u64 block_num, u8* out) = 0;
 
@@ -94,6 +99,11 @@ protected:
   // overridden in derived classes where possible.
   virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
 
+  // Calls decompress(i) for every i < num_blocks, spread across a thread pool which is shared by
+  // all readers, so that opening many images doesn't start threads for each of them. A reader
+  // which finds the pool in use decompresses on its own thread instead of waiting.
+  static void DecompressBlocks(size_t num_blocks, const std::function<void(size_t)>& decompress);
+
 private:
   struct Cache
   {
@@ -101,45 +111,17 @@ private:
     u64 block_idx = 0;
     u32 num_blocks = 0;
 
-    // [Pseudo-] Least Recently Used Shift Register
-    // When an empty cache line is needed, the line with the lowest value
-    // is taken and reset; the LRU register is then shifted down 1 place
-    // on all lines (low bit discarded). When a line is used, the high bit
-    // is set marking it as most recently used.
-    u32 lru_sreg = 0;
-
-    void Reset()
-    {
-      block_idx = 0;
-      num_blocks = 0;
-      lru_sreg = 0;
-    }
-    void Fill(u64 block, u32 count)
-    {
-      block_idx = block;
-      num_blocks = count;
-      // NOTE: Setting only the high bit means the newest line will
-      //   be selected for eviction if every line in the cache was
-      //   touched. This gives MRU behavior which is probably
-      //   desirable in that case.
-      MarkUsed();
-    }
     bool Contains(u64 block) const { return block >= block_idx && block - block_idx < num_blocks; }
-    void MarkUsed() { lru_sreg |= 0x80000000; }
-    void ShiftLRU() { lru_sreg >>= 1; }
-    bool IsLessRecentlyUsedThan(const Cache& other) const { return lru_sreg < other.lru_sreg; }
   };
+  using CacheList = std::list<Cache>;
 
-  // Gets the cache line that contains the given block, or nullptr.
-  // NOTE: The cache record only lasts until it expires (next GetEmptyCacheLine)
-  const Cache* FindCacheLine(u64 block_num);
-
-  // Finds the least recently used cache line, resets and returns it.
-  Cache* GetEmptyCacheLine();
+  // Drops all cache lines, for when their size changes.
+  void ClearCache();
 
-  // Combines FindCacheLine with GetEmptyCacheLine and ReadChunk.
-  // Always returns a valid cache line (loading the data if needed).
-  // May return nullptr only if the cache missed and the read failed.
+  // Gets the cache line that contains the given block, loading the data if needed, and marks it
+  // as the most recently used one. Once all lines are in use, the least recently used one is
+  // replaced. Returns nullptr if the read failed.
+  // NOTE: The cache record only lasts until it expires (next GetCacheLine)
   const Cache* GetCacheLine(u64 block_num);
 
   // Read all bytes from a chunk of blocks into a buffer.
@@ -148,10 +130,14 @@ private:
   // evenly divisible into chunks). Returns zero if it fails.
   u32 ReadChunk(u8* buffer, u64 chunk_num);
 
-  static constexpr int CACHE_LINES = 32;
+  static constexpr int DEFAULT_CACHE_LINES = 32;
   u32 m_block_size = 0;    // Bytes in a sector/block
   u32 m_chunk_blocks = 1;  // Number of sectors/blocks in a chunk
-  std::array<Cache, CACHE_LINES> m_cache;
+  size_t m_max_cache_lines = DEFAULT_CACHE_LINES;
+  // Most recently used first
+  CacheList m_cache;
+  // Chunk number -> the cache line holding it
+  std::unordered_map<u64, CacheList::iterator> m_cache_index;
 };
 
 // Factory function - examines the path to choose the right type of BlobReader, and returns one.
@@ -8,6 +8,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
@@ -17,21 +18,32 @@
 #include <vector>
 #include <zlib.h>
 
+#include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
+#include "Common/Event.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
+#include "Common/ThreadPool.h"
+#include "Common/WorkQueueThread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
 
 namespace DiscIO
 {
+static std::atomic<u64> s_cache_size{32 << 20};
+
 bool IsGCZBlob(File::IOFile& file);
 
+void SetGCZCacheSize(u64 bytes)
+{
+  s_cache_size = bytes;
+}
+
 CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string& filename)
     : m_file(std::move(file)), m_file_name(filename)
 {
@@ -51,11 +63,11 @@ CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string&
                   (sizeof(u64)) * m_header.num_blocks     // skip block pointers
                   + (sizeof(u32)) * m_header.num_blocks;  // skip hashes
 
-  // A compressed block is never ever longer than a decompressed block, so just header.block_size
-  // should be fine.
-  // I still add some safety margin.
-  const u32 zlib_buffer_size = m_header.block_size + 64;
-  m_zlib_buffer.resize(zlib_buffer_size);
+  // Decompressing a few neighbouring blocks at a time lets us spread them across threads.
+  SetChunkSize(DECOMPRESS_CHUNK_BLOCKS);
+  const u64 chunk_size = u64(DECOMPRESS_CHUNK_BLOCKS) * m_header.block_size;
+  if (chunk_size != 0)
+    SetCacheLines(static_cast<int>(std::min<u64>(s_cache_size / chunk_size, MAX_CACHE_LINES)));
 }
 
 std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile file,
@@ -87,23 +99,24 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 
 bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
 {
-  bool uncompressed = false;
-  u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
-  u64 offset = m_block_pointers[block_num] + m_data_offset;
-
-  if (offset & (1ULL << 63))
-  {
-    if (comp_block_size != m_header.block_size)
-      PanicAlert("Uncompressed block with wrong size");
-    uncompressed = true;
-    offset &= ~(1ULL << 63);
-  }
-
-  // clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-  memset(&m_zlib_buffer[comp_block_size], 0, m_zlib_buffer.size() - comp_block_size);
+  return ReadMultipleAlignedBlocks(block_num, 1, out_ptr);
+}
 
-  m_file.Seek(offset, SEEK_SET);
-  if (!m_file.ReadBytes(m_zlib_buffer.data(), comp_block_size))
+bool CompressedBlobReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+  constexpr u64 UNCOMPRESSED_FLAG = 1ULL << 63;
+  if (num_blocks == 0)
+    return true;
+
+  // Consecutive blocks are stored back to back, so they can all be read at once.
+  const u64 last_block = block_num + num_blocks - 1;
+  const u64 start = m_block_pointers[block_num] & ~UNCOMPRESSED_FLAG;
+  const u64 end = (m_block_pointers[last_block] & ~UNCOMPRESSED_FLAG) +
+                  static_cast<u32>(GetBlockCompressedSize(last_block));
+  m_zlib_buffer.resize(end - start);
+
+  m_file.Seek(start + m_data_offset, SEEK_SET);
+  if (!m_file.ReadBytes(m_zlib_buffer.data(), m_zlib_buffer.size()))
   {
     PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
                 m_file_name.c_str());
@@ -111,8 +124,28 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
     return false;
   }
 
+  std::vector<u8> results(num_blocks);
+  DecompressBlocks(num_blocks, [&](size_t i) {
+    const u64 block = block_num + i;
+    const u64 pointer = m_block_pointers[block];
+    const u8* data = &m_zlib_buffer[(pointer & ~UNCOMPRESSED_FLAG) - start];
+    // The size is truncated to 32 bits, which also gets rid of the flag of either block.
+    const u32 comp_block_size = static_cast<u32>(GetBlockCompressedSize(block));
+    results[i] = DecompressBlock(block, data, comp_block_size, (pointer & UNCOMPRESSED_FLAG) != 0,
+                                 out_ptr + i * m_header.block_size);
+  });
+
+  return std::all_of(results.begin(), results.end(), [](u8 result) { return result != 0; });
+}
+
+bool CompressedBlobReader::DecompressBlock(u64 block_num, const u8* data, u32 comp_block_size,
+                                           bool uncompressed, u8* out_ptr) const
+{
+  if (uncompressed && comp_block_size != m_header.block_size)
+    PanicAlert("Uncompressed block with wrong size");
+
   // First, check hash.
-  u32 block_hash = HashAdler32(m_zlib_buffer.data(), comp_block_size);
+  u32 block_hash = HashAdler32(data, comp_block_size);
   if (block_hash != m_hashes[block_num])
     PanicAlertT("The disc image \"%s\" is corrupt.\n"
                 "Hash of block %" PRIu64 " is %08x instead of %08x.",
@@ -120,12 +153,12 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
 
   if (uncompressed)
   {
-    std::copy(m_zlib_buffer.begin(), m_zlib_buffer.begin() + comp_block_size, out_ptr);
+    std::copy(data, data + std::min(comp_block_size, m_header.block_size), out_ptr);
   }
   else
   {
     z_stream z = {};
-    z.next_in = m_zlib_buffer.data();
+    z.next_in = const_cast<u8*>(data);
     z.avail_in = comp_block_size;
     if (z.avail_in > m_header.block_size)
     {
@@ -152,6 +185,41 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
   return true;
 }
 
+namespace
+{
+// A block on its way from the input file to the output file.
+struct CompressionBlock
+{
+  std::vector<u8> in_buf;
+  std::vector<u8> out_buf;
+  // 0 if the block should be stored uncompressed.
+  int comp_size = 0;
+  bool failed = false;
+  Common::Event done;
+};
+}  // Anonymous namespace
+
+static void CompressBlock(z_stream* z, CompressionBlock* block)
+{
+  const int block_size = static_cast<int>(block->in_buf.size());
+  block->failed = deflateReset(z) != Z_OK;
+  if (!block->failed)
+  {
+    z->next_in = block->in_buf.data();
+    z->avail_in = block_size;
+    z->next_out = block->out_buf.data();
+    z->avail_out = block_size;
+
+    const int status = deflate(z, Z_FINISH);
+    if ((status != Z_STREAM_END) || (z->avail_out < 10))
+      block->comp_size = 0;
+    else
+      block->comp_size = block_size - z->avail_out;
+  }
+
+  block->done.Set();
+}
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type, int block_size, CompressCB callback, void* arg)
 {
@@ -193,9 +261,23 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     scrubbing = true;
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
+  // Blocks are read and written on this thread, and compressed on one thread per core.
+  // Every compression thread gets two blocks, so that it can start on the next one while we
+  // write out the previous one.
+  const size_t num_threads = std::max(cpu_info.num_cores, 1);
+  const size_t num_slots = num_threads * 2;
+
+  std::vector<z_stream> streams(num_threads);
+  for (size_t i = 0; i < num_threads; ++i)
+  {
+    streams[i] = {};
+    if (deflateInit(&streams[i], 9) != Z_OK)
+    {
+      for (size_t j = 0; j < i; ++j)
+        deflateEnd(&streams[j]);
+      return false;
+    }
+  }
 
   callback(GetStringT("Files opened, ready to compress."), 0, arg);
 
@@ -210,8 +292,20 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
+  std::vector<CompressionBlock> blocks(num_slots);
+  for (CompressionBlock& block : blocks)
+  {
+    block.in_buf.resize(block_size);
+    block.out_buf.resize(block_size);
+  }
+
+  // Slot i is always compressed by thread i % num_threads.
+  std::vector<std::unique_ptr<Common::WorkQueueThread<size_t>>> threads;
+  for (size_t i = 0; i < num_threads; ++i)
+  {
+    threads.push_back(std::make_unique<Common::WorkQueueThread<size_t>>(
+        [&streams, &blocks, i](size_t slot) { CompressBlock(&streams[i], &blocks[slot]); }));
+  }
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -222,6 +316,7 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   // Now we are ready to write compressed data!
   u64 position = 0;
+  u32 num_read = 0;
   int num_compressed = 0;
   int num_stored = 0;
   int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
@@ -231,7 +326,7 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   {
     if (i % progress_monitor == 0)
     {
-      const u64 inpos = infile.Tell();
+      const u64 inpos = static_cast<u64>(i) * block_size;
       int ratio = 0;
       if (inpos != 0)
         ratio = (int)(100 * position / inpos);
@@ -247,39 +342,41 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
       }
     }
 
-    offsets[i] = position;
-
-    size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+    // Read ahead as far as there are free slots, to keep all threads busy.
+    for (; num_read < header.num_blocks && num_read < i + num_slots; num_read++)
+    {
+      const size_t slot = num_read % num_slots;
+      std::vector<u8>& in_buf = blocks[slot].in_buf;
+
+      size_t read_bytes;
+      if (scrubbing)
+        read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
+      else
+        infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
+      if (read_bytes < header.block_size)
+        std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+
+      threads[slot % num_threads]->EmplaceItem(slot);
+    }
 
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
+    CompressionBlock& block = blocks[i % num_slots];
+    block.done.Wait();
 
-    if (retval != Z_OK)
+    if (block.failed)
     {
       ERROR_LOG(DISCIO, "Deflate failed");
       success = false;
       break;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
+    offsets[i] = position;
 
     u8* write_buf;
     int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
+    if (block.comp_size == 0)
     {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
       // let's store uncompressed
-      write_buf = in_buf.data();
+      write_buf = block.in_buf.data();
       offsets[i] |= 0x8000000000000000ULL;
       write_size = block_size;
       num_stored++;
@@ -287,9 +384,8 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     else
     {
       // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
+      write_buf = block.out_buf.data();
+      write_size = block.comp_size;
       num_compressed++;
     }
 
@@ -307,6 +403,9 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     hashes[i] = HashAdler32(write_buf, write_size);
   }
 
+  // Let the threads finish the blocks we've already handed out before cleaning up.
+  threads.clear();
+
   header.compressed_data_size = position;
 
   if (!success)
@@ -325,7 +424,8 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   }
 
   // Cleanup
-  deflateEnd(&z);
+  for (z_stream& z : streams)
+    deflateEnd(&z);
 
   if (success)
   {
@@ -41,6 +41,9 @@ struct CompressedBlobHeader  // 32 bytes
   u32 num_blocks;
 };
 
+// Sets how much decompressed data CompressedBlobReaders created afterwards keep in memory.
+void SetGCZCacheSize(u64 bytes);
+
 class CompressedBlobReader : public SectorReader
 {
 public:
@@ -54,8 +57,17 @@ public:
   u64 GetBlockCompressedSize(u64 block_num) const;
   bool GetBlock(u64 block_num, u8* out_ptr) override;
 
+protected:
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
+
 private:
+  static constexpr int DECOMPRESS_CHUNK_BLOCKS = 8;
+  static constexpr u64 MAX_CACHE_LINES = 4096;
+
   CompressedBlobReader(File::IOFile file, const std::string& filename);
+  // Checks the hash of a block and decompresses it. Can be called from any thread.
+  bool DecompressBlock(u64 block_num, const u8* data, u32 comp_block_size, bool uncompressed,
+                       u8* out_ptr) const;
 
   CompressedBlobHeader m_header;
   std::vector<u64> m_block_pointers;
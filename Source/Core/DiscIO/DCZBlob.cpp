@@ -0,0 +1,547 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/DCZBlob.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/Logging/Log.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Common/ThreadPool.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeWii.h"
+
+namespace DiscIO
+{
+static constexpr u64 UNCOMPRESSED_FLAG = 1ULL << 63;
+static constexpr u32 CLUSTER_SIZE = VolumeWii::BLOCK_TOTAL_SIZE;
+static constexpr u32 CLUSTER_HEADER_SIZE = VolumeWii::BLOCK_HEADER_SIZE;
+static constexpr u32 CLUSTER_DATA_SIZE = VolumeWii::BLOCK_DATA_SIZE;
+// The IV for the data of a cluster is stored at this offset in its encrypted header.
+static constexpr u32 CLUSTER_IV_OFFSET = 0x3D0;
+
+// zlib can't make use of dictionaries bigger than its window.
+static constexpr u32 DICTIONARY_SLICES = 32;
+static constexpr u32 DICTIONARY_SLICE_SIZE = 1024;
+
+// Both work in place.
+static void EncryptCluster(const Common::AES::Context* key, u8* cluster)
+{
+  u8 iv[16] = {};
+  key->Crypt(iv, cluster, cluster, CLUSTER_HEADER_SIZE);
+  std::memcpy(iv, cluster + CLUSTER_IV_OFFSET, sizeof(iv));
+  key->Crypt(iv, cluster + CLUSTER_HEADER_SIZE, cluster + CLUSTER_HEADER_SIZE, CLUSTER_DATA_SIZE);
+}
+
+static void DecryptCluster(const Common::AES::Context* key, u8* cluster)
+{
+  u8 iv[16];
+  std::memcpy(iv, cluster + CLUSTER_IV_OFFSET, sizeof(iv));
+  key->Crypt(iv, cluster + CLUSTER_HEADER_SIZE, cluster + CLUSTER_HEADER_SIZE, CLUSTER_DATA_SIZE);
+  std::memset(iv, 0, sizeof(iv));
+  key->Crypt(iv, cluster, cluster, CLUSTER_HEADER_SIZE);
+}
+
+// Applies crypt to every partition cluster in data, which holds the disc from offset on.
+// Clusters which are only partially in data are read whole with read_cluster first.
+template <typename CryptFunction, typename ReadFunction>
+static bool CryptClusters(const DCZPartition& partition, const Common::AES::Context* key,
+                          u64 offset, u64 size, u8* data, u8* cluster_buffer, CryptFunction crypt,
+                          ReadFunction read_cluster)
+{
+  const u64 end = offset + size;
+  const u64 data_end = partition.data_offset + partition.data_size;
+  if (end <= partition.data_offset || offset >= data_end)
+    return true;
+
+  const u64 first = std::max(offset, partition.data_offset);
+  const u64 last = std::min(end, data_end);
+  u64 cluster = first - (first - partition.data_offset) % CLUSTER_SIZE;
+  for (; cluster < last; cluster += CLUSTER_SIZE)
+  {
+    if (cluster >= offset && cluster + CLUSTER_SIZE <= end)
+    {
+      crypt(key, data + (cluster - offset));
+      continue;
+    }
+
+    if (!read_cluster(cluster, cluster_buffer))
+      return false;
+    crypt(key, cluster_buffer);
+
+    const u64 copy_start = std::max(cluster, offset);
+    const u64 copy_end = std::min(cluster + CLUSTER_SIZE, end);
+    std::memcpy(data + (copy_start - offset), cluster_buffer + (copy_start - cluster),
+                copy_end - copy_start);
+  }
+
+  return true;
+}
+
+DCZFileReader::DCZFileReader(File::IOFile file, const std::string& filename)
+    : m_file(std::move(file)), m_file_name(filename), m_cluster_buffer(CLUSTER_SIZE)
+{
+  m_file_size = m_file.GetSize();
+}
+
+DCZFileReader::~DCZFileReader()
+{
+}
+
+std::unique_ptr<DCZFileReader> DCZFileReader::Create(File::IOFile file,
+                                                     const std::string& filename)
+{
+  std::unique_ptr<DCZFileReader> reader(new DCZFileReader(std::move(file), filename));
+  if (!reader->Initialize())
+    return nullptr;
+
+  return reader;
+}
+
+bool DCZFileReader::Initialize()
+{
+  m_file.Seek(0, SEEK_SET);
+  if (!m_file.ReadArray(&m_header, 1) || m_header.magic != DCZ_MAGIC)
+    return false;
+
+  if (m_header.version != DCZ_VERSION || m_header.block_size == 0 ||
+      m_header.block_size % CLUSTER_SIZE != 0)
+  {
+    ERROR_LOG(DISCIO, "DCZ file %s has an unsupported version or block size",
+              m_file_name.c_str());
+    return false;
+  }
+
+  std::vector<DCZPartition> partitions(m_header.num_partitions);
+  m_dictionary.resize(m_header.dictionary_size);
+  m_blocks.resize(m_header.num_blocks);
+  if (!m_file.ReadArray(partitions.data(), partitions.size()) ||
+      !m_file.ReadArray(m_dictionary.data(), m_dictionary.size()) ||
+      !m_file.ReadArray(m_blocks.data(), m_blocks.size()))
+  {
+    return false;
+  }
+  m_data_offset = m_file.Tell();
+
+  for (const DCZPartition& partition : partitions)
+  {
+    auto key = Common::AES::CreateContext(partition.title_key.data(), Common::AES::Mode::Encrypt);
+    m_partitions.push_back({partition, std::move(key)});
+  }
+
+  SetSectorSize(m_header.block_size);
+  // Decompressing a few neighbouring blocks at a time lets us spread them across threads.
+  SetChunkSize(CHUNK_BLOCKS);
+  return true;
+}
+
+bool DCZFileReader::Read(u64 offset, u64 size, u8* out_ptr)
+{
+  if (!SectorReader::Read(offset, size, out_ptr))
+    return false;
+
+  const auto read_cluster = [this](u64 cluster_offset, u8* buffer) {
+    return SectorReader::Read(cluster_offset, CLUSTER_SIZE, buffer);
+  };
+  for (const PartitionData& partition : m_partitions)
+  {
+    if (!CryptClusters(partition.info, partition.key.get(), offset, size, out_ptr,
+                       m_cluster_buffer.data(), EncryptCluster, read_cluster))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool DCZFileReader::ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset)
+{
+  const auto it =
+      std::find_if(m_partitions.begin(), m_partitions.end(), [&](const PartitionData& partition) {
+        return partition.info.partition_offset == partition_offset;
+      });
+  if (it == m_partitions.end())
+    return false;
+
+  while (size > 0)
+  {
+    const u64 cluster = offset / CLUSTER_DATA_SIZE;
+    const u64 offset_in_cluster = offset % CLUSTER_DATA_SIZE;
+    const u64 read_size = std::min(size, CLUSTER_DATA_SIZE - offset_in_cluster);
+    if (cluster * CLUSTER_SIZE >= it->info.data_size)
+      return false;
+    const u64 disc_offset =
+        it->info.data_offset + cluster * CLUSTER_SIZE + CLUSTER_HEADER_SIZE + offset_in_cluster;
+
+    if (!SectorReader::Read(disc_offset, read_size, out_ptr))
+      return false;
+
+    offset += read_size;
+    size -= read_size;
+    out_ptr += read_size;
+  }
+
+  return true;
+}
+
+bool DCZFileReader::GetBlock(u64 block_num, u8* out_ptr)
+{
+  return ReadMultipleAlignedBlocks(block_num, 1, out_ptr);
+}
+
+bool DCZFileReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+  if (num_blocks == 0)
+    return true;
+
+  // Consecutive blocks are stored back to back, so they can all be read at once.
+  const DCZBlock& first = m_blocks[block_num];
+  const DCZBlock& last = m_blocks[block_num + num_blocks - 1];
+  const u64 start = first.offset & ~UNCOMPRESSED_FLAG;
+  const u64 end = (last.offset & ~UNCOMPRESSED_FLAG) + last.size;
+  m_compressed_buffer.resize(end - start);
+
+  m_file.Seek(m_data_offset + start, SEEK_SET);
+  if (!m_file.ReadBytes(m_compressed_buffer.data(), m_compressed_buffer.size()))
+  {
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_file_name.c_str());
+    m_file.Clear();
+    return false;
+  }
+
+  std::vector<u8> results(num_blocks);
+  DecompressBlocks(num_blocks, [&](size_t i) {
+    const u64 block = block_num + i;
+    const u8* data = &m_compressed_buffer[(m_blocks[block].offset & ~UNCOMPRESSED_FLAG) - start];
+    results[i] = DecompressBlock(block, data, out_ptr + i * m_header.block_size);
+  });
+
+  return std::all_of(results.begin(), results.end(), [](u8 result) { return result != 0; });
+}
+
+bool DCZFileReader::DecompressBlock(u64 block_num, const u8* data, u8* out_ptr) const
+{
+  const DCZBlock& block = m_blocks[block_num];
+
+  const u32 hash = HashAdler32(data, block.size);
+  if (hash != block.hash)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.\n"
+                "Hash of block %" PRIu64 " is %08x instead of %08x.",
+                m_file_name.c_str(), block_num, hash, block.hash);
+    return false;
+  }
+
+  if (block.offset & UNCOMPRESSED_FLAG)
+  {
+    if (block.size != m_header.block_size)
+      return false;
+    std::memcpy(out_ptr, data, block.size);
+    return true;
+  }
+
+  z_stream z = {};
+  z.next_in = const_cast<u8*>(data);
+  z.avail_in = block.size;
+  z.next_out = out_ptr;
+  z.avail_out = m_header.block_size;
+  if (inflateInit(&z) != Z_OK)
+    return false;
+
+  int status = inflate(&z, Z_FINISH);
+  if (status == Z_NEED_DICT &&
+      inflateSetDictionary(&z, m_dictionary.data(), static_cast<uInt>(m_dictionary.size())) ==
+          Z_OK)
+  {
+    status = inflate(&z, Z_FINISH);
+  }
+  inflateEnd(&z);
+
+  if (status != Z_STREAM_END || z.avail_out != 0)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.\nBlock %" PRIu64 " could not be decompressed.",
+                m_file_name.c_str(), block_num);
+    return false;
+  }
+
+  return true;
+}
+
+namespace
+{
+struct ConversionPartition
+{
+  DCZPartition info;
+  std::unique_ptr<Common::AES::Context> key;
+};
+
+// A block being compressed, together with its result.
+struct ConversionBlock
+{
+  std::vector<u8> data;
+  std::vector<u8> compressed;
+  bool stored_uncompressed;
+};
+}  // Anonymous namespace
+
+// Returns the partitions whose data areas can be stored decrypted. If that isn't possible for
+// all of them, none are, since the reader has to be able to read all of them decrypted.
+static std::vector<ConversionPartition> GetConversionPartitions(BlobReader* reader,
+                                                                const Volume* volume)
+{
+  std::vector<ConversionPartition> result;
+  if (!volume)
+    return result;
+
+  for (const Partition& partition : volume->GetPartitions())
+  {
+    const IOS::ES::TicketReader& ticket = volume->GetTicket(partition);
+    const std::optional<u32> data_offset = reader->ReadSwapped<u32>(partition.offset + 0x2b8);
+    const std::optional<u32> data_size = reader->ReadSwapped<u32>(partition.offset + 0x2bc);
+    if (!ticket.IsValid() || !data_offset || !data_size)
+      return {};
+
+    DCZPartition info;
+    info.partition_offset = partition.offset;
+    info.data_offset = partition.offset + (static_cast<u64>(*data_offset) << 2);
+    // Scrubbed or truncated images may end before the partition does.
+    const u64 available = reader->GetDataSize() > info.data_offset ?
+                              reader->GetDataSize() - info.data_offset :
+                              0;
+    info.data_size = std::min(static_cast<u64>(*data_size) << 2, available);
+    info.data_size -= info.data_size % CLUSTER_SIZE;
+    info.title_key = ticket.GetTitleKey();
+
+    result.push_back(
+        {info, Common::AES::CreateContext(info.title_key.data(), Common::AES::Mode::Decrypt)});
+  }
+
+  return result;
+}
+
+// Reads from the disc like the DCZ reader returns it before encrypting partitions again.
+static bool ReadForConversion(BlobReader* reader,
+                              const std::vector<ConversionPartition>& partitions, u64 offset,
+                              u64 size, u8* out_ptr, u8* cluster_buffer)
+{
+  // The last block goes past the end of the disc, that part is filled with zeroes.
+  const u64 available = offset < reader->GetDataSize() ? reader->GetDataSize() - offset : 0;
+  const u64 to_read = std::min(size, available);
+  if (!reader->Read(offset, to_read, out_ptr))
+    return false;
+  std::fill(out_ptr + to_read, out_ptr + size, 0);
+
+  const auto read_cluster = [reader](u64 cluster_offset, u8* buffer) {
+    return reader->Read(cluster_offset, CLUSTER_SIZE, buffer);
+  };
+  for (const ConversionPartition& partition : partitions)
+  {
+    if (!CryptClusters(partition.info, partition.key.get(), offset, size, out_ptr, cluster_buffer,
+                       DecryptCluster, read_cluster))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void CompressBlock(const std::vector<u8>& dictionary, ConversionBlock* block)
+{
+  block->stored_uncompressed = true;
+
+  z_stream z = {};
+  if (deflateInit(&z, 9) != Z_OK)
+    return;
+
+  block->compressed.resize(deflateBound(&z, static_cast<uLong>(block->data.size())));
+  z.next_in = block->data.data();
+  z.avail_in = static_cast<uInt>(block->data.size());
+  z.next_out = block->compressed.data();
+  z.avail_out = static_cast<uInt>(block->compressed.size());
+
+  if (deflateSetDictionary(&z, dictionary.data(), static_cast<uInt>(dictionary.size())) == Z_OK &&
+      deflate(&z, Z_FINISH) == Z_STREAM_END)
+  {
+    block->compressed.resize(block->compressed.size() - z.avail_out);
+    block->stored_uncompressed = block->compressed.size() >= block->data.size();
+  }
+  deflateEnd(&z);
+}
+
+bool ConvertToDCZ(const std::string& infile_path, const std::string& outfile_path, int block_size,
+                  CompressCB callback, void* arg)
+{
+  if (block_size <= 0 || block_size % CLUSTER_SIZE != 0)
+  {
+    PanicAlert("Invalid DCZ block size %i", block_size);
+    return false;
+  }
+
+  std::unique_ptr<BlobReader> reader = CreateBlobReader(infile_path);
+  if (!reader)
+  {
+    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    return false;
+  }
+
+  if (reader->GetBlobType() == BlobType::DCZ)
+  {
+    PanicAlertT("\"%s\" is already compressed! Cannot compress it further.", infile_path.c_str());
+    return false;
+  }
+
+  const std::vector<ConversionPartition> partitions =
+      GetConversionPartitions(reader.get(), CreateVolumeFromFilename(infile_path).get());
+
+  File::IOFile outfile(outfile_path, "wb");
+  if (!outfile)
+  {
+    PanicAlertT("Failed to open the output file \"%s\".\n"
+                "Check that you have permissions to write the target folder and that the media can "
+                "be written.",
+                outfile_path.c_str());
+    return false;
+  }
+
+  if (callback)
+    callback(GetStringT("Files opened, ready to compress."), 0, arg);
+
+  DCZHeader header;
+  header.magic = DCZ_MAGIC;
+  header.version = DCZ_VERSION;
+  header.data_size = reader->GetDataSize();
+  header.block_size = block_size;
+  header.num_blocks = static_cast<u32>((header.data_size + block_size - 1) / block_size);
+  header.num_partitions = static_cast<u32>(partitions.size());
+
+  std::vector<u8> cluster_buffer(CLUSTER_SIZE);
+
+  // Build the dictionary from small pieces of data spread across the whole disc.
+  std::vector<u8> dictionary;
+  std::vector<u8> slice(DICTIONARY_SLICE_SIZE);
+  const u64 num_candidates = DICTIONARY_SLICES * 4;
+  for (u64 i = 0; i < num_candidates && dictionary.size() < DICTIONARY_SLICES * slice.size(); ++i)
+  {
+    const u64 offset = header.data_size / num_candidates * i;
+    if (!ReadForConversion(reader.get(), partitions, offset, slice.size(), slice.data(),
+                           cluster_buffer.data()))
+    {
+      break;
+    }
+    if (std::any_of(slice.begin(), slice.end(), [](u8 byte) { return byte != 0; }))
+      dictionary.insert(dictionary.end(), slice.begin(), slice.end());
+  }
+  header.dictionary_size = static_cast<u32>(dictionary.size());
+
+  outfile.WriteArray(&header, 1);
+  for (const ConversionPartition& partition : partitions)
+    outfile.WriteArray(&partition.info, 1);
+  outfile.WriteBytes(dictionary.data(), dictionary.size());
+  // Seek past the block table, it's written at the end.
+  const u64 block_table_offset = outfile.Tell();
+  outfile.Seek(sizeof(DCZBlock) * header.num_blocks, SEEK_CUR);
+
+  std::vector<DCZBlock> blocks(header.num_blocks);
+  Common::ThreadPool pool(std::max(cpu_info.num_cores, 1), "DCZ Compression");
+  const size_t batch_size = pool.GetNumThreads() * 2;
+  std::vector<ConversionBlock> batch(batch_size);
+  for (ConversionBlock& block : batch)
+    block.data.resize(block_size);
+
+  u64 position = 0;
+  bool success = true;
+  for (u32 batch_start = 0; batch_start < header.num_blocks && success; batch_start += batch_size)
+  {
+    const u32 num_blocks =
+        static_cast<u32>(std::min<u64>(batch_size, header.num_blocks - batch_start));
+
+    if (callback)
+    {
+      const u64 in_position = static_cast<u64>(batch_start) * block_size;
+      const int ratio = in_position == 0 ? 0 : static_cast<int>(100 * position / in_position);
+      const std::string text =
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                           batch_start, header.num_blocks, ratio);
+      if (!callback(text, static_cast<float>(batch_start) / header.num_blocks, arg))
+      {
+        success = false;
+        break;
+      }
+    }
+
+    for (u32 i = 0; i < num_blocks; ++i)
+    {
+      const u64 offset = static_cast<u64>(batch_start + i) * block_size;
+      if (!ReadForConversion(reader.get(), partitions, offset, block_size, batch[i].data.data(),
+                             cluster_buffer.data()))
+      {
+        PanicAlertT("The disc could not be read (at 0x%" PRIx64 " - 0x%" PRIx64 ").", offset,
+                    offset + block_size);
+        success = false;
+        break;
+      }
+    }
+    if (!success)
+      break;
+
+    pool.ParallelFor(num_blocks, [&](size_t i, size_t) { CompressBlock(dictionary, &batch[i]); });
+
+    for (u32 i = 0; i < num_blocks; ++i)
+    {
+      const ConversionBlock& block = batch[i];
+      const std::vector<u8>& stored = block.stored_uncompressed ? block.data : block.compressed;
+
+      DCZBlock& entry = blocks[batch_start + i];
+      entry.offset = position | (block.stored_uncompressed ? UNCOMPRESSED_FLAG : 0);
+      entry.size = static_cast<u32>(stored.size());
+      entry.hash = HashAdler32(stored.data(), stored.size());
+
+      if (!outfile.WriteBytes(stored.data(), stored.size()))
+      {
+        PanicAlertT("Failed to write the output file \"%s\".\n"
+                    "Check that you have enough space available on the target drive.",
+                    outfile_path.c_str());
+        success = false;
+        break;
+      }
+      position += stored.size();
+    }
+  }
+
+  if (!success)
+  {
+    // Remove the incomplete output file.
+    outfile.Close();
+    File::Delete(outfile_path);
+    return false;
+  }
+
+  outfile.Seek(block_table_offset, SEEK_SET);
+  outfile.WriteArray(blocks.data(), blocks.size());
+
+  if (callback)
+    callback(GetStringT("Done compressing disc image."), 1.0f, arg);
+  return true;
+}
+
+}  // namespace DiscIO
@@ -0,0 +1,121 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// WARNING Code not big-endian safe.
+
+// To create DCZ files, use ConvertToDCZ.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/File.h"
+#include "DiscIO/Blob.h"
+
+namespace DiscIO
+{
+static constexpr u32 DCZ_MAGIC = 0x015A4344;  // "DCZ\x01"
+static constexpr u32 DCZ_VERSION = 1;
+
+// DCZ file structure:
+// DCZHeader
+// DCZPartition[num_partitions]
+// u8 dictionary[dictionary_size]
+// DCZBlock[num_blocks]
+// compressed data
+//
+// Like GCZ, the disc is split into blocks which are compressed separately, so that any of them
+// can be read without the others. Every block is compressed with the same preset dictionary,
+// which makes up for most of what is lost by not compressing the disc as one stream.
+//
+// The encrypted data areas of Wii partitions are stored decrypted, because encrypted data
+// doesn't compress at all. Since all the hashes are kept, encrypting the data again on reads
+// restores the original disc exactly.
+struct DCZHeader  // 32 bytes
+{
+  u32 magic;
+  u32 version;
+  u64 data_size;
+  u32 block_size;  // A multiple of the Wii cluster size
+  u32 num_blocks;
+  u32 num_partitions;
+  u32 dictionary_size;
+};
+
+struct DCZPartition  // 40 bytes
+{
+  u64 partition_offset;
+  // Where the encrypted clusters of the partition start on the disc, and how many bytes of them
+  // are stored decrypted.
+  u64 data_offset;
+  u64 data_size;
+  std::array<u8, 16> title_key;
+};
+
+struct DCZBlock  // 16 bytes
+{
+  // Relative to the start of the compressed data. The top bit is set if the block is stored
+  // uncompressed.
+  u64 offset;
+  u32 size;
+  u32 hash;  // Adler-32 of the stored data
+};
+
+class DCZFileReader final : public SectorReader
+{
+public:
+  static std::unique_ptr<DCZFileReader> Create(File::IOFile file, const std::string& filename);
+  ~DCZFileReader();
+
+  BlobType GetBlobType() const override { return BlobType::DCZ; }
+  u64 GetDataSize() const override { return m_header.data_size; }
+  u64 GetRawSize() const override { return m_file_size; }
+  bool Read(u64 offset, u64 size, u8* out_ptr) override;
+
+  bool SupportsReadWiiDecrypted() const override { return !m_partitions.empty(); }
+  bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset) override;
+
+  bool GetBlock(u64 block_num, u8* out_ptr) override;
+
+protected:
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
+
+private:
+  struct PartitionData
+  {
+    DCZPartition info;
+    std::unique_ptr<Common::AES::Context> key;
+  };
+
+  static constexpr int CHUNK_BLOCKS = 4;
+
+  DCZFileReader(File::IOFile file, const std::string& filename);
+  bool Initialize();
+  // Checks the hash of a block and decompresses it. Can be called from any thread.
+  bool DecompressBlock(u64 block_num, const u8* data, u8* out_ptr) const;
+
+  File::IOFile m_file;
+  std::string m_file_name;
+  u64 m_file_size;
+  u64 m_data_offset;
+
+  DCZHeader m_header;
+  std::vector<PartitionData> m_partitions;
+  std::vector<u8> m_dictionary;
+  std::vector<DCZBlock> m_blocks;
+
+  std::vector<u8> m_compressed_buffer;
+  std::vector<u8> m_cluster_buffer;
+};
+
+// The block size must be a multiple of the Wii cluster size (32 KiB).
+bool ConvertToDCZ(const std::string& infile_path, const std::string& outfile_path,
+                  int block_size = 0x20000, CompressCB callback = nullptr, void* arg = nullptr);
+
+}  // namespace DiscIO
@@ -9,8 +9,6 @@
 #include <cstddef>
 #include <cstring>
 #include <map>
-#include <mbedtls/aes.h>
-#include <mbedtls/sha1.h>
 #include <memory>
 #include <optional>
 #include <string>
@@ -19,6 +17,8 @@
 
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/Swap.h"
@@ -35,8 +35,7 @@ namespace DiscIO
 constexpr u64 PARTITION_DATA_OFFSET = 0x20000;
 
 VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
-    : m_pReader(std::move(reader)), m_game_partition(PARTITION_NONE),
-      m_last_decrypted_block(UINT64_MAX)
+    : m_pReader(std::move(reader)), m_game_partition(PARTITION_NONE)
 {
   _assert_(m_pReader);
 
@@ -102,14 +101,12 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
         return IOS::ES::TMDReader{std::move(tmd_buffer)};
       };
 
-      auto get_key = [this, partition]() -> std::unique_ptr<mbedtls_aes_context> {
+      auto get_key = [this, partition]() -> std::unique_ptr<Common::AES::Context> {
         const IOS::ES::TicketReader& ticket = *m_partitions[partition].ticket;
         if (!ticket.IsValid())
           return nullptr;
         const std::array<u8, 16> key = ticket.GetTitleKey();
-        std::unique_ptr<mbedtls_aes_context> aes_context = std::make_unique<mbedtls_aes_context>();
-        mbedtls_aes_setkey_dec(aes_context.get(), key.data(), 128);
-        return aes_context;
+        return Common::AES::CreateContext(key.data(), Common::AES::Mode::Decrypt);
       };
 
       auto get_file_system = [this, partition]() -> std::unique_ptr<FileSystem> {
@@ -118,7 +115,7 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
       };
 
       m_partitions.emplace(
-          partition, PartitionDetails{Common::Lazy<std::unique_ptr<mbedtls_aes_context>>(get_key),
+          partition, PartitionDetails{Common::Lazy<std::unique_ptr<Common::AES::Context>>(get_key),
                                       Common::Lazy<IOS::ES::TicketReader>(get_ticket),
                                       Common::Lazy<IOS::ES::TMDReader>(get_tmd),
                                       Common::Lazy<std::unique_ptr<FileSystem>>(get_file_system),
@@ -143,42 +140,36 @@ bool VolumeWii::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, const Partition
   auto it = m_partitions.find(partition);
   if (it == m_partitions.end())
     return false;
-  mbedtls_aes_context* aes_context = it->second.key->get();
+  const Common::AES::Context* aes_context = it->second.key->get();
   if (!aes_context)
     return false;
 
-  std::vector<u8> read_buffer(BLOCK_TOTAL_SIZE);
   while (_Length > 0)
   {
-    // Calculate offsets
-    u64 block_offset_on_disc =
-        partition.offset + PARTITION_DATA_OFFSET + _ReadOffset / BLOCK_DATA_SIZE * BLOCK_TOTAL_SIZE;
-    u64 data_offset_in_block = _ReadOffset % BLOCK_DATA_SIZE;
+    const u64 block_index = _ReadOffset / BLOCK_DATA_SIZE;
+    const u64 data_offset_in_block = _ReadOffset % BLOCK_DATA_SIZE;
 
-    if (m_last_decrypted_block != block_offset_on_disc)
+    const CachedBlock* block = FindCachedBlock(partition, block_index);
+    if (!block)
     {
-      // Read the current block
-      if (!m_pReader->Read(block_offset_on_disc, BLOCK_TOTAL_SIZE, read_buffer.data()))
-        return false;
+      // Decrypt all of the following blocks which are needed for this read at once, so that
+      // large reads don't turn into many small reads from the blob.
+      const u64 last_block = (_ReadOffset + _Length - 1) / BLOCK_DATA_SIZE;
+      u64 num_blocks = 1;
+      while (num_blocks < MAX_BLOCKS_PER_READ && block_index + num_blocks <= last_block &&
+             !FindCachedBlock(partition, block_index + num_blocks))
+      {
+        ++num_blocks;
+      }
 
-      // Decrypt the block's data.
-      // 0x3D0 - 0x3DF in read_buffer will be overwritten,
-      // but that won't affect anything, because we won't
-      // use the content of read_buffer anymore after this
-      mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_DATA_SIZE, &read_buffer[0x3D0],
-                            &read_buffer[BLOCK_HEADER_SIZE], m_last_decrypted_block_data);
-      m_last_decrypted_block = block_offset_on_disc;
-
-      // The only thing we currently use from the 0x000 - 0x3FF part
-      // of the block is the IV (at 0x3D0), but it also contains SHA-1
-      // hashes that IOS uses to check that discs aren't tampered with.
-      // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+      if (!DecryptBlocks(partition, aes_context, block_index, num_blocks))
+        return false;
+      block = FindCachedBlock(partition, block_index);
     }
 
     // Copy the decrypted data
     u64 copy_size = std::min(_Length, BLOCK_DATA_SIZE - data_offset_in_block);
-    memcpy(_pBuffer, &m_last_decrypted_block_data[data_offset_in_block],
-           static_cast<size_t>(copy_size));
+    memcpy(_pBuffer, &block->data[data_offset_in_block], static_cast<size_t>(copy_size));
 
     // Update offsets
     _Length -= copy_size;
@@ -189,6 +180,61 @@ bool VolumeWii::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, const Partition
   return true;
 }
 
+const VolumeWii::CachedBlock* VolumeWii::FindCachedBlock(const Partition& partition,
+                                                         u64 block_index) const
+{
+  for (CachedBlock& block : m_block_cache)
+  {
+    if (block.partition_offset == partition.offset && block.block_index == block_index)
+    {
+      block.last_used = ++m_block_cache_clock;
+      return &block;
+    }
+  }
+
+  return nullptr;
+}
+
+bool VolumeWii::DecryptBlocks(const Partition& partition, const Common::AES::Context* aes_context,
+                              u64 first_block, u64 num_blocks) const
+{
+  const u64 blocks_offset_on_disc =
+      partition.offset + PARTITION_DATA_OFFSET + first_block * BLOCK_TOTAL_SIZE;
+  m_read_buffer.resize(num_blocks * BLOCK_TOTAL_SIZE);
+  if (!m_pReader->Read(blocks_offset_on_disc, m_read_buffer.size(), m_read_buffer.data()))
+    return false;
+
+  if (m_block_cache.empty())
+    m_block_cache.resize(BLOCK_CACHE_SIZE);
+
+  for (u64 i = 0; i < num_blocks; ++i)
+  {
+    // Evict the least recently used block. Since the cache is bigger than MAX_BLOCKS_PER_READ,
+    // this never evicts a block decrypted earlier in this loop.
+    CachedBlock& block = *std::min_element(
+        m_block_cache.begin(), m_block_cache.end(),
+        [](const CachedBlock& a, const CachedBlock& b) { return a.last_used < b.last_used; });
+
+    // Decrypt the block's data.
+    // 0x3D0 - 0x3DF in the read buffer will be overwritten,
+    // but that won't affect anything, because we won't
+    // use the content of the read buffer anymore after this
+    u8* encrypted_block = &m_read_buffer[i * BLOCK_TOTAL_SIZE];
+    aes_context->Crypt(&encrypted_block[0x3D0], &encrypted_block[BLOCK_HEADER_SIZE],
+                       block.data.data(), BLOCK_DATA_SIZE);
+    block.partition_offset = partition.offset;
+    block.block_index = first_block + i;
+    block.last_used = ++m_block_cache_clock;
+
+    // The only thing we currently use from the 0x000 - 0x3FF part
+    // of the block is the IV (at 0x3D0), but it also contains SHA-1
+    // hashes that IOS uses to check that discs aren't tampered with.
+    // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+  }
+
+  return true;
+}
+
 std::vector<Partition> VolumeWii::GetPartitions() const
 {
   std::vector<Partition> partitions;
@@ -360,7 +406,7 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
   auto it = m_partitions.find(partition);
   if (it == m_partitions.end())
     return false;
-  mbedtls_aes_context* aes_context = it->second.key->get();
+  const Common::AES::Context* aes_context = it->second.key->get();
   if (!aes_context)
     return false;
 
@@ -383,7 +429,7 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
       WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", clusterID);
       return false;
     }
-    mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, 0x400, IV, clusterMDCrypted, clusterMD);
+    aes_context->Crypt(IV, clusterMDCrypted, clusterMD, 0x400);
 
     // Some clusters have invalid data and metadata because they aren't
     // meant to be read by the game (for example, holes between files). To
@@ -410,12 +456,11 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
 
     for (u32 hashID = 0; hashID < 31; ++hashID)
     {
-      u8 hash[20];
-
-      mbedtls_sha1(clusterData + hashID * 0x400, 0x400, hash);
+      const Common::SHA1::Digest hash =
+          Common::SHA1::CalculateDigest(clusterData + hashID * 0x400, 0x400);
 
       // Note that we do not use strncmp here
-      if (memcmp(hash, clusterMD + hashID * 20, 20))
+      if (memcmp(hash.data(), clusterMD + hashID * 20, 20))
       {
         WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", clusterID,
                  hashID);
@@ -4,14 +4,15 @@
 
 #pragma once
 
+#include <array>
 #include <map>
-#include <mbedtls/aes.h>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "Common/Lazy.h"
 #include "Core/IOS/ES/Formats.h"
 #include "DiscIO/Filesystem.h"
@@ -70,19 +71,39 @@ protected:
 private:
   struct PartitionDetails
   {
-    Common::Lazy<std::unique_ptr<mbedtls_aes_context>> key;
+    Common::Lazy<std::unique_ptr<Common::AES::Context>> key;
     Common::Lazy<IOS::ES::TicketReader> ticket;
     Common::Lazy<IOS::ES::TMDReader> tmd;
     Common::Lazy<std::unique_ptr<FileSystem>> file_system;
     u32 type;
   };
 
+  struct CachedBlock
+  {
+    u64 partition_offset = UINT64_MAX;
+    u64 block_index = 0;
+    // When the block was last read, for finding the least recently used one.
+    u64 last_used = 0;
+    std::array<u8, BLOCK_DATA_SIZE> data;
+  };
+
+  // How many decrypted blocks are kept, and how many blocks are read with one call.
+  static constexpr size_t BLOCK_CACHE_SIZE = 64;
+  static constexpr size_t MAX_BLOCKS_PER_READ = 16;
+  static_assert(BLOCK_CACHE_SIZE > MAX_BLOCKS_PER_READ,
+                "Reading blocks must not evict blocks decrypted by the same read");
+
+  const CachedBlock* FindCachedBlock(const Partition& partition, u64 block_index) const;
+  bool DecryptBlocks(const Partition& partition, const Common::AES::Context* aes_context,
+                     u64 first_block, u64 num_blocks) const;
+
   std::unique_ptr<BlobReader> m_pReader;
   std::map<Partition, PartitionDetails> m_partitions;
   Partition m_game_partition;
 
-  mutable u64 m_last_decrypted_block;
-  mutable u8 m_last_decrypted_block_data[BLOCK_DATA_SIZE];
+  mutable std::vector<CachedBlock> m_block_cache;
+  mutable u64 m_block_cache_clock = 0;
+  mutable std::vector<u8> m_read_buffer;
 };
 
 }  // namespace
@@ -0,0 +1,135 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DolphinNoGUI/FifoBenchmark.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/StringUtil.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
+#include "VideoCommon/Statistics.h"
+
+namespace FifoBenchmark
+{
+struct FrameRecord
+{
+  u32 loop;
+  Statistics::ThisFrame stats;
+};
+
+static u32 s_loops;
+static u32 s_current_loop;
+static bool s_playback_started;
+static std::mutex s_frames_lock;
+static std::vector<FrameRecord> s_frames;
+
+// Called on the CPU thread before the fifo player writes a frame
+static void OnFrameWritten()
+{
+  FifoPlayer& player = FifoPlayer::GetInstance();
+  if (player.GetCurrentFrameNum() != player.GetFrameRangeStart())
+    return;
+
+  std::lock_guard<std::mutex> lk(s_frames_lock);
+  if (s_playback_started)
+    ++s_current_loop;
+  s_playback_started = true;
+  if (s_current_loop + 1 >= s_loops)
+    player.SetLoop(false);
+}
+
+// Called on the GPU thread when a frame is swapped
+static void OnFrameEnded(const Statistics::ThisFrame& frame)
+{
+  std::lock_guard<std::mutex> lk(s_frames_lock);
+  s_frames.push_back({s_current_loop, frame});
+}
+
+void Start(u32 loops)
+{
+  s_loops = loops;
+  s_current_loop = 0;
+  s_playback_started = false;
+  s_frames.clear();
+
+  FifoPlayer::GetInstance().SetLoop(loops > 1);
+  FifoPlayer::GetInstance().SetFrameWrittenCallback(OnFrameWritten);
+  Statistics::SetFrameCallback(OnFrameEnded);
+  Statistics::EnableTimings(true);
+}
+
+void Stop()
+{
+  Statistics::EnableTimings(false);
+  Statistics::SetFrameCallback(nullptr);
+  FifoPlayer::GetInstance().SetFrameWrittenCallback(nullptr);
+}
+
+static std::string EscapeJSON(const std::string& str)
+{
+  std::string escaped;
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    if (static_cast<unsigned char>(c) < 0x20)
+      escaped += StringFromFormat("\\u%04x", c);
+    else
+      escaped += c;
+  }
+  return escaped;
+}
+
+// The first key identifies the frame, or counts the frames for the totals
+static std::string FrameToJSON(const char* key, u32 value, const Statistics::ThisFrame& frame)
+{
+  return StringFromFormat("{\"%s\": %u, \"gpu_ms\": %.3f, \"vertex_loader_ms\": %.3f, "
+                          "\"texture_decode_ms\": %.3f, \"vertex_shaders_generated\": %i, "
+                          "\"pixel_shaders_generated\": %i, \"geometry_shaders_generated\": %i, "
+                          "\"draw_calls\": %i, \"primitives\": %i}",
+                          key, value, frame.gpuTimeNs / 1e6, frame.vertexLoaderTimeNs / 1e6,
+                          frame.textureDecodeTimeNs / 1e6, frame.numVertexShadersGenerated,
+                          frame.numPixelShadersGenerated, frame.numGeometryShadersGenerated,
+                          frame.numDrawCalls, frame.numPrims + frame.numDLPrims);
+}
+
+bool WriteJSON(const std::string& path, const std::string& fifolog, const std::string& backend)
+{
+  std::lock_guard<std::mutex> lk(s_frames_lock);
+
+  Statistics::ThisFrame total = {};
+  std::string json = StringFromFormat("{\n  \"fifolog\": \"%s\",\n  \"backend\": \"%s\",\n"
+                                      "  \"loops\": %u,\n  \"frames\": [\n",
+                                      EscapeJSON(fifolog).c_str(), EscapeJSON(backend).c_str(),
+                                      s_loops);
+  for (size_t i = 0; i < s_frames.size(); ++i)
+  {
+    const Statistics::ThisFrame& frame = s_frames[i].stats;
+    json += "    " + FrameToJSON("loop", s_frames[i].loop, frame);
+    json += i + 1 < s_frames.size() ? ",\n" : "\n";
+
+    total.gpuTimeNs += frame.gpuTimeNs;
+    total.vertexLoaderTimeNs += frame.vertexLoaderTimeNs;
+    total.textureDecodeTimeNs += frame.textureDecodeTimeNs;
+    total.numVertexShadersGenerated += frame.numVertexShadersGenerated;
+    total.numPixelShadersGenerated += frame.numPixelShadersGenerated;
+    total.numGeometryShadersGenerated += frame.numGeometryShadersGenerated;
+    total.numDrawCalls += frame.numDrawCalls;
+    total.numPrims += frame.numPrims + frame.numDLPrims;
+  }
+  json += "  ],\n  \"total\": ";
+  json += FrameToJSON("frames", static_cast<u32>(s_frames.size()), total) + "\n}\n";
+
+  if (path == "-")
+    return std::fwrite(json.data(), 1, json.size(), stdout) == json.size();
+
+  File::IOFile file(path, "wb");
+  return file.WriteBytes(json.data(), json.size());
+}
+}
@@ -0,0 +1,20 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// Replays a fifolog a fixed number of times and records how long the GPU spent on each frame.
+namespace FifoBenchmark
+{
+// Must be called before booting the fifolog. Playback stops by itself after the last loop.
+void Start(u32 loops);
+void Stop();
+
+// Writes the frames recorded since Start() as JSON. A path of "-" writes to stdout.
+bool WriteJSON(const std::string& path, const std::string& fifolog, const std::string& backend);
+}
@@ -10,8 +10,10 @@
 #include <string>
 #include <thread>
 #include <unistd.h>
+#include <variant>
 
 #include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
 #include "Common/Event.h"
 #include "Common/Flag.h"
 #include "Common/Logging/LogManager.h"
@@ -20,6 +22,7 @@
 #include "Core/Analytics.h"
 #include "Core/Boot/Boot.h"
 #include "Core/BootManager.h"
+#include "Core/Config/GraphicsSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/Host.h"
@@ -27,6 +30,8 @@
 #include "Core/IOS/STM/STM.h"
 #include "Core/State.h"
 
+#include "DolphinNoGUI/FifoBenchmark.h"
+
 #include "UICommon/CommandLineParse.h"
 #include "UICommon/UICommon.h"
 
@@ -53,6 +58,27 @@ namespace ProcessorInterface
 void PowerButton_Tap();
 }
 
+// Asks the game to shut down the first time a signal arrives, and stops emulation the second time
+// or if the game can't be asked.
+static void HandleShutdownRequest()
+{
+  if (!s_shutdown_requested.TestAndClear())
+    return;
+
+  const auto ios = IOS::HLE::GetIOS();
+  const auto stm = ios ? ios->GetDeviceByName("/dev/stm/eventhook") : nullptr;
+  if (!s_tried_graceful_shutdown.IsSet() && stm &&
+      std::static_pointer_cast<IOS::HLE::Device::STMEventHook>(stm)->HasHookInstalled())
+  {
+    ProcessorInterface::PowerButton_Tap();
+    s_tried_graceful_shutdown.Set();
+  }
+  else
+  {
+    s_running.Clear();
+  }
+}
+
 class Platform
 {
 public:
@@ -62,6 +88,7 @@ public:
   {
     while (s_running.IsSet())
     {
+      HandleShutdownRequest();
       Core::HostDispatchJobs();
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
@@ -214,21 +241,7 @@ class PlatformX11 : public Platform
     // The actual loop
     while (s_running.IsSet())
     {
-      if (s_shutdown_requested.TestAndClear())
-      {
-        const auto ios = IOS::HLE::GetIOS();
-        const auto stm = ios ? ios->GetDeviceByName("/dev/stm/eventhook") : nullptr;
-        if (!s_tried_graceful_shutdown.IsSet() && stm &&
-            std::static_pointer_cast<IOS::HLE::Device::STMEventHook>(stm)->HasHookInstalled())
-        {
-          ProcessorInterface::PowerButton_Tap();
-          s_tried_graceful_shutdown.Set();
-        }
-        else
-        {
-          s_running.Clear();
-        }
-      }
+      HandleShutdownRequest();
 
       XEvent event;
       KeySym key;
@@ -357,6 +370,21 @@ static Platform* GetPlatform()
 int main(int argc, char* argv[])
 {
   auto parser = CommandLineParse::CreateParser(CommandLineParse::ParserOptions::OmitGUIOptions);
+  parser->set_defaults("output", "window");
+  parser->add_option("-o", "--output")
+      .choices({"window", "memory", "images", "avi"})
+      .help("Choose where frames are shown or written to from [%choices]. "
+            "Anything but window renders without a display, with the software renderer unless "
+            "the video backend is Null");
+  parser->add_option("--benchmark")
+      .metavar("<file>")
+      .help("Replay the fifolog given as FILE as fast as possible and write the time spent on "
+            "each frame to <file> as JSON, or to stdout if it is -");
+  parser->set_defaults("loops", "1");
+  parser->add_option("--loops")
+      .type("int")
+      .metavar("<count>")
+      .help("Number of times the benchmark replays the fifolog");
   optparse::Values& options = CommandLineParse::ParseArguments(parser.get(), argc, argv);
   std::vector<std::string> args = parser->args();
 
@@ -388,13 +416,33 @@ int main(int argc, char* argv[])
     return 0;
   }
 
+  const bool benchmark = options.is_set("benchmark");
+  const int benchmark_loops = options.get("loops");
+  std::string fifolog_path;
+  if (benchmark)
+  {
+    if (!boot || !std::holds_alternative<BootParameters::DFF>(boot->parameters) ||
+        benchmark_loops < 1)
+    {
+      fprintf(stderr, "The benchmark needs a fifolog and at least one loop\n");
+      return 1;
+    }
+    fifolog_path = std::get<BootParameters::DFF>(boot->parameters).dff_path;
+  }
+
   std::string user_directory;
   if (options.is_set("user"))
   {
     user_directory = static_cast<const char*>(options.get("user"));
   }
 
-  platform = GetPlatform();
+  // Benchmarks don't need to show anything unless asked to
+  const std::string output = benchmark && !options.is_set_by_user("output") ?
+                                 "memory" :
+                                 static_cast<const char*>(options.get("output"));
+  const bool headless = output != "window";
+
+  platform = headless ? new Platform() : GetPlatform();
   if (!platform)
   {
     fprintf(stderr, "No platform found\n");
@@ -404,6 +452,22 @@ int main(int argc, char* argv[])
   UICommon::SetUserDirectory(user_directory);
   UICommon::Init();
 
+  if (headless)
+  {
+    // Only backends that can run without a window may be picked here
+    const std::string video_backend = static_cast<const char*>(options.get("video_backend"));
+    SConfig::GetInstance().m_strVideoBackend =
+        video_backend == "Null" ? video_backend : "Software Renderer";
+    Config::SetCurrent(Config::GFX_SW_HEADLESS, true);
+
+    // Frames are written out through frame dumping
+    if (output == "images" || output == "avi")
+    {
+      SConfig::GetInstance().m_DumpFrames = true;
+      Config::SetCurrent(Config::GFX_DUMP_FRAMES_AS_IMAGES, output == "images");
+    }
+  }
+
   Core::SetOnStateChangedCallback([](Core::State state) {
     if (state == Core::State::Uninitialized)
       s_running.Clear();
@@ -420,6 +484,12 @@ int main(int argc, char* argv[])
 
   DolphinAnalytics::Instance()->ReportDolphinStart("nogui");
 
+  if (benchmark)
+  {
+    FifoBenchmark::Start(benchmark_loops);
+    Core::SetIsThrottlerTempDisabled(true);
+  }
+
   if (!BootManager::BootCore(std::move(boot)))
   {
     fprintf(stderr, "Could not boot the specified file\n");
@@ -437,10 +507,24 @@ int main(int argc, char* argv[])
   Core::Stop();
 
   Core::Shutdown();
+
+  int result = 0;
+  if (benchmark)
+  {
+    FifoBenchmark::Stop();
+    const std::string json_path = static_cast<const char*>(options.get("benchmark"));
+    const std::string& backend = SConfig::GetInstance().m_strVideoBackend;
+    if (!FifoBenchmark::WriteJSON(json_path, fifolog_path, backend))
+    {
+      fprintf(stderr, "Could not write the benchmark results to %s\n", json_path.c_str());
+      result = 1;
+    }
+  }
+
   platform->Shutdown();
   UICommon::Shutdown();
 
   delete platform;
 
-  return 0;
+  return result;
 }
@@ -16,6 +16,7 @@
 #include "Core/HotkeyManager.h"
 #include "Core/IOS/IOS.h"
 #include "Core/IOS/USB/Bluetooth/BTBase.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "DolphinQt2/MainWindow.h"
 #include "DolphinQt2/Settings.h"
@@ -370,5 +371,8 @@ void HotkeyScheduler::Run()
 
     if (IsHotkey(HK_UNDO_SAVE_STATE))
       State::UndoSaveState();
+
+    if (IsHotkey(HK_REWIND))
+      Rewind::StepBack();
   }
 }
@@ -56,6 +56,7 @@
 #include "Core/IOS/IOS.h"
 #include "Core/IOS/USB/Bluetooth/BTBase.h"
 #include "Core/Movie.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 
 #include "DolphinWX/Config/ConfigMain.h"
@@ -972,6 +973,8 @@ static int GetMenuIDFromHotkey(unsigned int key)
     return IDM_RESET;
   case HK_FRAME_ADVANCE:
     return IDM_FRAMESTEP;
+  case HK_REWIND:
+    return IDM_REWIND;
   case HK_START_RECORDING:
     return IDM_RECORD;
   case HK_PLAY_RECORDING:
@@ -1665,6 +1668,8 @@ void CFrame::ParseHotkeys()
     State::UndoLoadState();
   if (IsHotkey(HK_UNDO_SAVE_STATE))
     State::UndoSaveState();
+  if (IsHotkey(HK_REWIND))
+    Rewind::StepBack();
 }
 
 void CFrame::HandleFrameSkipHotkeys()
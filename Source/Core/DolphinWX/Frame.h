@@ -310,6 +310,7 @@ private:
   void OnUndoSaveState(wxCommandEvent& event);
 
   void OnFrameStep(wxCommandEvent& event);
+  void OnRewind(wxCommandEvent& event);
 
   void OnConfigMain(wxCommandEvent& event);  // Options
   void OnConfigGFX(wxCommandEvent& event);
@@ -56,6 +56,7 @@
 #include "Core/Movie.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/WiiUtils.h"
 
@@ -137,6 +138,7 @@ void CFrame::BindMenuBarEvents()
   Bind(wxEVT_MENU, &CFrame::OnReset, this, IDM_RESET);
   Bind(wxEVT_MENU, &CFrame::OnToggleFullscreen, this, IDM_TOGGLE_FULLSCREEN);
   Bind(wxEVT_MENU, &CFrame::OnFrameStep, this, IDM_FRAMESTEP);
+  Bind(wxEVT_MENU, &CFrame::OnRewind, this, IDM_REWIND);
   Bind(wxEVT_MENU, &CFrame::OnScreenshot, this, IDM_SCREENSHOT);
   Bind(wxEVT_MENU, &CFrame::OnLoadStateFromFile, this, IDM_LOAD_STATE_FILE);
   Bind(wxEVT_MENU, &CFrame::OnLoadCurrentSlot, this, IDM_LOAD_SELECTED_SLOT);
@@ -346,9 +348,10 @@ void CFrame::DoOpen(bool Boot)
 
   wxString path = wxFileSelector(
       _("Select the file to load"), wxEmptyString, wxEmptyString, wxEmptyString,
-      _("All GC/Wii files (elf, dol, gcm, iso, tgc, wbfs, ciso, gcz, wad, dff)") +
-          wxString::Format("|*.elf;*.dol;*.gcm;*.iso;*.tgc;*.wbfs;*.ciso;*.gcz;*.wad;*.dff|%s",
-                           wxGetTranslation(wxALL_FILES)),
+      _("All GC/Wii files (elf, dol, gcm, iso, tgc, wbfs, ciso, gcz, dcz, wad, dff)") +
+          wxString::Format(
+              "|*.elf;*.dol;*.gcm;*.iso;*.tgc;*.wbfs;*.ciso;*.gcz;*.dcz;*.wad;*.dff|%s",
+              wxGetTranslation(wxALL_FILES)),
       wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
 
   if (path.IsEmpty())
@@ -1560,6 +1563,12 @@ void CFrame::OnUndoSaveState(wxCommandEvent& WXUNUSED(event))
     State::UndoSaveState();
 }
 
+void CFrame::OnRewind(wxCommandEvent& WXUNUSED(event))
+{
+  if (Core::IsRunningAndStarted())
+    Rewind::StepBack();
+}
+
 void CFrame::OnLoadState(wxCommandEvent& event)
 {
   if (Core::IsRunningAndStarted())
@@ -1632,6 +1641,7 @@ void CFrame::UpdateGUI()
   GetMenuBar()->FindItem(IDM_STOP_RECORD)->Enable(Movie::IsMovieActive());
   GetMenuBar()->FindItem(IDM_RECORD_EXPORT)->Enable(Movie::IsMovieActive());
   GetMenuBar()->FindItem(IDM_FRAMESTEP)->Enable(Running || Paused);
+  GetMenuBar()->FindItem(IDM_REWIND)->Enable((Running || Paused) && Rewind::IsEnabled());
   GetMenuBar()->FindItem(IDM_SCREENSHOT)->Enable(Running || Paused);
   GetMenuBar()->FindItem(IDM_TOGGLE_FULLSCREEN)->Enable(Running || Paused);
   GetMenuBar()->FindItem(IDM_LOAD_STATE)->Enable(Initialized);
@@ -54,6 +54,7 @@
 #include "Core/Movie.h"
 #include "Core/TitleDatabase.h"
 #include "DiscIO/Blob.h"
+#include "DiscIO/DCZBlob.h"
 #include "DiscIO/DirectoryBlob.h"
 #include "DiscIO/Enums.h"
 #include "DiscIO/Volume.h"
@@ -82,7 +83,7 @@ public:
   wxProgressDialog* dialog;
 };
 
-static constexpr u32 CACHE_REVISION = 5;  // Last changed in PR 6102
+static constexpr u32 CACHE_REVISION = 6;  // Last changed when adding DCZ
 
 static bool sorted = false;
 
@@ -757,8 +758,9 @@ void GameListCtrl::RescanList()
 
   post_status(_("Scanning..."));
 
-  const std::vector<std::string> search_extensions = {".gcm",  ".tgc", ".iso", ".ciso", ".gcz",
-                                                      ".wbfs", ".wad", ".dol", ".elf"};
+  const std::vector<std::string> search_extensions = {".gcm", ".tgc", ".iso", ".ciso",
+                                                      ".gcz", ".dcz", ".wbfs", ".wad",
+                                                      ".dol", ".elf"};
   // TODO This could process paths iteratively as they are found
   auto search_results = Common::DoFileSearch(SConfig::GetInstance().m_ISOFolder, search_extensions,
                                              SConfig::GetInstance().m_RecursiveISOFolder);
@@ -1512,13 +1514,11 @@ void GameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
     }
     else
     {
-      if (iso->GetPlatform() == DiscIO::Platform::WII_DISC && !WiiCompressWarning())
-        return;
-
       path = wxFileSelector(_("Save compressed GCM/ISO"), StrToWxStr(FilePath),
                             StrToWxStr(FileName) + ".gcz", wxEmptyString,
-                            _("All compressed GC/Wii ISO files (gcz)") +
-                                wxString::Format("|*.gcz|%s", wxGetTranslation(wxALL_FILES)),
+                            _("All compressed GC/Wii ISO files (gcz)") + "|*.gcz|" +
+                                _("Losslessly compressed GC/Wii ISO files (dcz)") +
+                                wxString::Format("|*.dcz|%s", wxGetTranslation(wxALL_FILES)),
                             wxFD_SAVE, this);
     }
     if (!path)
@@ -1529,6 +1529,14 @@ void GameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
                                     path.c_str()),
                    _("Confirm File Overwrite"), wxYES_NO) == wxNO);
 
+  // DCZ keeps everything on the disc, so only GCZ needs the warning
+  const bool dcz = !is_compressed && wxFileName(path).GetExt().IsSameAs("dcz", false);
+  if (!is_compressed && !dcz && iso->GetPlatform() == DiscIO::Platform::WII_DISC &&
+      !WiiCompressWarning())
+  {
+    return;
+  }
+
   bool all_good = false;
 
   {
@@ -1540,6 +1548,9 @@ void GameListCtrl::OnCompressISO(wxCommandEvent& WXUNUSED(event))
     if (is_compressed)
       all_good =
           DiscIO::DecompressBlobToFile(iso->GetFileName(), WxStrToStr(path), &CompressCB, &dialog);
+    else if (dcz)
+      all_good = DiscIO::ConvertToDCZ(iso->GetFileName(), WxStrToStr(path), 0x20000, &CompressCB,
+                                      &dialog);
     else
       all_good = DiscIO::CompressFileToBlob(
           iso->GetFileName(), WxStrToStr(path),
@@ -80,6 +80,7 @@ enum
   IDM_SHOW_INPUT_DISPLAY,
   IDM_SHOW_RTC_DISPLAY,
   IDM_FRAMESTEP,
+  IDM_REWIND,
   IDM_SCREENSHOT,
   IDM_TOGGLE_DUMP_FRAMES,
   IDM_TOGGLE_DUMP_AUDIO,
@@ -128,6 +128,7 @@ wxMenu* MainMenuBar::CreateEmulationMenu() const
   emulation_menu->AppendSeparator();
   emulation_menu->Append(IDM_TOGGLE_FULLSCREEN, _("Toggle &Fullscreen"));
   emulation_menu->Append(IDM_FRAMESTEP, _("&Frame Advance"));
+  emulation_menu->Append(IDM_REWIND, _("Re&wind"));
   emulation_menu->AppendSeparator();
   emulation_menu->Append(IDM_SCREENSHOT, _("Take Screenshot"));
   emulation_menu->AppendSeparator();
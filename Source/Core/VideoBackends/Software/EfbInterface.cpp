@@ -8,7 +8,9 @@
 #include <cstddef>
 #include <cstring>
 
+#include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "Common/Swap.h"
 
@@ -21,6 +23,18 @@ static u8 efb[EFB_WIDTH * EFB_HEIGHT * 6];
 namespace EfbInterface
 {
 u32 perf_values[PQ_NUM_MEMBERS];
+static u32 perf_quad_pixels[PQ_NUM_MEMBERS];
+
+void IncPerfCounterQuadCount(PerfQueryType type, u32 num_pixels)
+{
+  // NOTE: hardware doesn't process individual pixels but quads instead.
+  // Current software renderer architecture works on pixels though, so
+  // we have this "quad" hack here to only increment the registers on
+  // every third rendered pixel
+  const u32 pixels = perf_quad_pixels[type] + num_pixels;
+  perf_values[type] += pixels / 3;
+  perf_quad_pixels[type] = pixels % 3;
+}
 
 static inline u32 GetColorOffset(u16 x, u16 y)
 {
@@ -32,6 +46,20 @@ static inline u32 GetDepthOffset(u16 x, u16 y)
   return (x + y * EFB_WIDTH) * 3 + DEPTH_BUFFER_START;
 }
 
+// Pixels are only accessed through their own three bytes, so that threads drawing to
+// neighbouring pixels don't race with each other.
+static inline u32 LoadPixel(u32 offset)
+{
+  u32 value = 0;
+  std::memcpy(&value, &efb[offset], 3);
+  return value;
+}
+
+static inline void StorePixel(u32 offset, u32 value)
+{
+  std::memcpy(&efb[offset], &value, 3);
+}
+
 static void SetPixelAlphaOnly(u32 offset, u8 a)
 {
   switch (bpmem.zcontrol.pixel_format)
@@ -44,10 +72,9 @@ static void SetPixelAlphaOnly(u32 offset, u8 a)
   case PEControl::RGBA6_Z24:
   {
     u32 a32 = a;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xffffffc0;
+    u32 val = LoadPixel(offset) & 0x00ffffc0;
     val |= (a32 >> 2) & 0x0000003f;
-    *dst = val;
+    StorePixel(offset, val);
   }
   break;
   default:
@@ -63,31 +90,24 @@ static void SetPixelColorOnly(u32 offset, u8* rgb)
   case PEControl::Z24:
   {
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    StorePixel(offset, src >> 8);
   }
   break;
   case PEControl::RGBA6_Z24:
   {
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff00003f;
+    u32 val = LoadPixel(offset) & 0x0000003f;
     val |= (src >> 4) & 0x00000fc0;  // blue
     val |= (src >> 6) & 0x0003f000;  // green
     val |= (src >> 8) & 0x00fc0000;  // red
-    *dst = val;
+    StorePixel(offset, val);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    StorePixel(offset, src >> 8);
   }
   break;
   default:
@@ -103,32 +123,24 @@ static void SetPixelAlphaColor(u32 offset, u8* color)
   case PEControl::Z24:
   {
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    StorePixel(offset, src >> 8);
   }
   break;
   case PEControl::RGBA6_Z24:
   {
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= (src >> 2) & 0x0000003f;  // alpha
+    u32 val = (src >> 2) & 0x0000003f;  // alpha
     val |= (src >> 4) & 0x00000fc0;  // blue
     val |= (src >> 6) & 0x0003f000;  // green
     val |= (src >> 8) & 0x00fc0000;  // red
-    *dst = val;
+    StorePixel(offset, val);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    StorePixel(offset, src >> 8);
   }
   break;
   default:
@@ -138,8 +150,7 @@ static void SetPixelAlphaColor(u32 offset, u8* color)
 
 static u32 GetPixelColor(u32 offset)
 {
-  u32 src;
-  std::memcpy(&src, &efb[offset], sizeof(u32));
+  const u32 src = LoadPixel(offset);
 
   switch (bpmem.zcontrol.pixel_format)
   {
@@ -171,19 +182,13 @@ static void SetPixelDepth(u32 offset, u32 depth)
   case PEControl::RGBA6_Z24:
   case PEControl::Z24:
   {
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= depth & 0x00ffffff;
-    *dst = val;
+    StorePixel(offset, depth & 0x00ffffff);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= depth & 0x00ffffff;
-    *dst = val;
+    StorePixel(offset, depth & 0x00ffffff);
   }
   break;
   default:
@@ -201,13 +206,13 @@ static u32 GetPixelDepth(u32 offset)
   case PEControl::RGBA6_Z24:
   case PEControl::Z24:
   {
-    depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+    depth = LoadPixel(offset);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-    depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+    depth = LoadPixel(offset);
   }
   break;
   default:
@@ -629,4 +634,341 @@ bool ZCompare(u16 x, u16 y, u32 z)
 
   return pass;
 }
+
+#ifdef _M_X86
+// The block functions keep a 32 bit lane per pixel. Pixels are still loaded and stored through
+// their own three bytes, and unpacked in the lanes.
+static bool IsBlockFormat(PEControl::PixelFormat format)
+{
+  return format == PEControl::RGB8_Z24 || format == PEControl::RGBA6_Z24 ||
+         format == PEControl::Z24;
+}
+
+FUNCTION_TARGET_SSR41
+static u32 ZCompareBlockSSE41(const PixelBlock& block)
+{
+  u32 offsets[PixelBlock::MAX_PIXELS];
+  alignas(16) u32 depths[PixelBlock::MAX_PIXELS] = {};
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+  {
+    if (block.mask & (1 << i))
+    {
+      offsets[i] = GetDepthOffset(block.x[i], block.y[i]);
+      depths[i] = LoadPixel(offsets[i]);
+    }
+  }
+
+  // Both are 24 bit, so the signed comparisons work
+  const __m128i depth = _mm_load_si128(reinterpret_cast<const __m128i*>(depths));
+  const __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.z));
+  const __m128i all = _mm_set1_epi32(-1);
+  __m128i pass;
+  switch (bpmem.zmode.func)
+  {
+  case ZMode::LESS:
+    pass = _mm_cmplt_epi32(z, depth);
+    break;
+  case ZMode::EQUAL:
+    pass = _mm_cmpeq_epi32(z, depth);
+    break;
+  case ZMode::LEQUAL:
+    pass = _mm_xor_si128(_mm_cmpgt_epi32(z, depth), all);
+    break;
+  case ZMode::GREATER:
+    pass = _mm_cmpgt_epi32(z, depth);
+    break;
+  case ZMode::NEQUAL:
+    pass = _mm_xor_si128(_mm_cmpeq_epi32(z, depth), all);
+    break;
+  case ZMode::GEQUAL:
+    pass = _mm_xor_si128(_mm_cmplt_epi32(z, depth), all);
+    break;
+  case ZMode::ALWAYS:
+    pass = all;
+    break;
+  case ZMode::NEVER:
+  default:
+    pass = _mm_setzero_si128();
+    break;
+  }
+
+  const u32 passed = _mm_movemask_ps(_mm_castsi128_ps(pass)) & block.mask;
+  if (bpmem.zmode.updateenable)
+  {
+    for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+    {
+      if (passed & (1 << i))
+        StorePixel(offsets[i], block.z[i] & 0x00ffffff);
+    }
+  }
+
+  return passed;
+}
+
+// GetPixelColor for every lane
+FUNCTION_TARGET_SSR41
+static inline __m128i UnpackColors(__m128i src)
+{
+  if (bpmem.zcontrol.pixel_format != PEControl::RGBA6_Z24)
+    return _mm_or_si128(_mm_slli_epi32(src, 8), _mm_set1_epi32(0xff));
+
+  // Move each 6 bit component into its own byte, then widen all of them like Convert6To8
+  __m128i v = _mm_and_si128(src, _mm_set1_epi32(0x3f));
+  v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(src, 2), _mm_set1_epi32(0x3f00)));
+  v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(src, 4), _mm_set1_epi32(0x3f0000)));
+  v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(src, 6), _mm_set1_epi32(0x3f000000)));
+  return _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 2), _mm_set1_epi32(0xfcfcfcfc)),
+                      _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi32(0x03030303)));
+}
+
+// GetSourceFactor and GetDestinationFactor for every lane. color is the other color of the
+// factor, which the *CLR modes use.
+FUNCTION_TARGET_SSR41
+static inline __m128i BlendFactorLanes(BlendMode::BlendFactor mode, __m128i color, __m128i src,
+                                       __m128i dst)
+{
+  // Repeats the alpha byte of each lane in the other three
+  const __m128i broadcast_alpha = _mm_set_epi8(12, 12, 12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0);
+  const __m128i all = _mm_set1_epi32(-1);
+  switch (mode)
+  {
+  case BlendMode::ZERO:
+    return _mm_setzero_si128();
+  case BlendMode::ONE:
+    return all;
+  case BlendMode::SRCCLR:
+    return color;
+  case BlendMode::INVSRCCLR:
+    return _mm_xor_si128(color, all);
+  case BlendMode::SRCALPHA:
+    return _mm_shuffle_epi8(src, broadcast_alpha);
+  case BlendMode::INVSRCALPHA:
+    return _mm_xor_si128(_mm_shuffle_epi8(src, broadcast_alpha), all);
+  case BlendMode::DSTALPHA:
+    return _mm_shuffle_epi8(dst, broadcast_alpha);
+  case BlendMode::INVDSTALPHA:
+    return _mm_xor_si128(_mm_shuffle_epi8(dst, broadcast_alpha), all);
+  }
+
+  return _mm_setzero_si128();
+}
+
+// BlendColor for two lanes, with 16 bit components
+FUNCTION_TARGET_SSR41
+static inline __m128i BlendHalf(__m128i src, __m128i dst, __m128i src_factor, __m128i dst_factor)
+{
+  // Add the MSB of the factors to make their range 0 -> 256
+  src_factor = _mm_add_epi16(src_factor, _mm_srli_epi16(src_factor, 7));
+  dst_factor = _mm_add_epi16(dst_factor, _mm_srli_epi16(dst_factor, 7));
+
+  // Pair each source component with its destination component, so that a single multiply-add
+  // gives src * sf + dst * df
+  const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(src, dst),
+                                    _mm_unpacklo_epi16(src_factor, dst_factor));
+  const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(src, dst),
+                                    _mm_unpackhi_epi16(src_factor, dst_factor));
+  return _mm_packs_epi32(_mm_srli_epi32(lo, 8), _mm_srli_epi32(hi, 8));
+}
+
+FUNCTION_TARGET_SSR41
+static inline __m128i BlendColorLanes(__m128i src, __m128i dst)
+{
+  const __m128i src_factor = BlendFactorLanes(bpmem.blendmode.srcfactor, dst, src, dst);
+  const __m128i dst_factor = BlendFactorLanes(bpmem.blendmode.dstfactor, src, src, dst);
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo =
+      BlendHalf(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero),
+                _mm_unpacklo_epi8(src_factor, zero), _mm_unpacklo_epi8(dst_factor, zero));
+  const __m128i hi =
+      BlendHalf(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero),
+                _mm_unpackhi_epi8(src_factor, zero), _mm_unpackhi_epi8(dst_factor, zero));
+  // Saturates at 255
+  return _mm_packus_epi16(lo, hi);
+}
+
+FUNCTION_TARGET_SSR41
+static inline __m128i LogicBlendLanes(__m128i src, __m128i dst, BlendMode::LogicOp op)
+{
+  const __m128i all = _mm_set1_epi32(-1);
+  switch (op)
+  {
+  case BlendMode::CLEAR:
+    return _mm_setzero_si128();
+  case BlendMode::AND:
+    return _mm_and_si128(src, dst);
+  case BlendMode::AND_REVERSE:
+    return _mm_andnot_si128(dst, src);
+  case BlendMode::COPY:
+    return src;
+  case BlendMode::AND_INVERTED:
+    return _mm_andnot_si128(src, dst);
+  case BlendMode::NOOP:
+    return dst;
+  case BlendMode::XOR:
+    return _mm_xor_si128(src, dst);
+  case BlendMode::OR:
+    return _mm_or_si128(src, dst);
+  case BlendMode::NOR:
+    return _mm_xor_si128(_mm_or_si128(src, dst), all);
+  case BlendMode::EQUIV:
+    return _mm_xor_si128(_mm_xor_si128(src, dst), all);
+  case BlendMode::INVERT:
+    return _mm_xor_si128(dst, all);
+  case BlendMode::OR_REVERSE:
+    return _mm_or_si128(src, _mm_xor_si128(dst, all));
+  case BlendMode::COPY_INVERTED:
+    return _mm_xor_si128(src, all);
+  case BlendMode::OR_INVERTED:
+    return _mm_or_si128(_mm_xor_si128(src, all), dst);
+  case BlendMode::NAND:
+    return _mm_xor_si128(_mm_and_si128(src, dst), all);
+  case BlendMode::SET:
+    return all;
+  }
+
+  return dst;
+}
+
+FUNCTION_TARGET_SSR41
+static inline __m128i DitherLanes(const PixelBlock& block, __m128i color)
+{
+  static const u8 dither[2][2] = {{0, 2}, {3, 1}};
+
+  alignas(16) u32 offsets[PixelBlock::MAX_PIXELS];
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+    offsets[i] = dither[block.y[i] & 1][block.x[i] & 1] * 0x01010100;
+
+  // ((c - (c >> 6)) + offset) & 0xfc for the color bytes, which can't overflow
+  const __m128i high_bits = _mm_and_si128(_mm_srli_epi32(color, 6), _mm_set1_epi32(0x03030303));
+  __m128i dithered = _mm_sub_epi8(color, high_bits);
+  dithered = _mm_add_epi8(dithered, _mm_load_si128(reinterpret_cast<const __m128i*>(offsets)));
+  return _mm_or_si128(_mm_and_si128(dithered, _mm_set1_epi32(0xfcfcfc00)),
+                      _mm_and_si128(color, _mm_set1_epi32(0xff)));
+}
+
+// The color and alpha bits of an RGBA6 pixel
+FUNCTION_TARGET_SSR41
+static inline __m128i PackRGBA6Color(__m128i color)
+{
+  __m128i packed = _mm_and_si128(_mm_srli_epi32(color, 4), _mm_set1_epi32(0x00000fc0));
+  packed = _mm_or_si128(packed, _mm_and_si128(_mm_srli_epi32(color, 6), _mm_set1_epi32(0x3f000)));
+  return _mm_or_si128(packed, _mm_and_si128(_mm_srli_epi32(color, 8), _mm_set1_epi32(0xfc0000)));
+}
+
+FUNCTION_TARGET_SSR41
+static inline __m128i PackRGBA6Alpha(__m128i color)
+{
+  return _mm_and_si128(_mm_srli_epi32(color, 2), _mm_set1_epi32(0x3f));
+}
+
+FUNCTION_TARGET_SSR41
+static void BlendTevBlockSSE41(const PixelBlock& block)
+{
+  const PEControl::PixelFormat format = bpmem.zcontrol.pixel_format;
+  u32 offsets[PixelBlock::MAX_PIXELS];
+  alignas(16) u32 pixels[PixelBlock::MAX_PIXELS] = {};
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+  {
+    if (block.mask & (1 << i))
+    {
+      offsets[i] = GetColorOffset(block.x[i], block.y[i]);
+      pixels[i] = LoadPixel(offsets[i]);
+    }
+  }
+
+  const __m128i stored = _mm_load_si128(reinterpret_cast<const __m128i*>(pixels));
+  const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.color));
+  const __m128i dst = UnpackColors(stored);
+
+  __m128i color;
+  if (bpmem.blendmode.blendenable)
+  {
+    if (bpmem.blendmode.subtract)
+      color = _mm_subs_epu8(dst, src);
+    else
+      color = BlendColorLanes(src, dst);
+  }
+  else if (bpmem.blendmode.logicopenable)
+  {
+    color = LogicBlendLanes(src, dst, bpmem.blendmode.logicmode);
+  }
+  else
+  {
+    color = src;
+  }
+
+  if (bpmem.dstalpha.enable)
+  {
+    color = _mm_or_si128(_mm_andnot_si128(_mm_set1_epi32(0xff), color),
+                         _mm_set1_epi32(bpmem.dstalpha.alpha));
+  }
+
+  __m128i packed;
+  if (bpmem.blendmode.colorupdate)
+  {
+    if (bpmem.blendmode.dither && format == PEControl::RGBA6_Z24)
+      color = DitherLanes(block, color);
+
+    if (format != PEControl::RGBA6_Z24)
+      packed = _mm_srli_epi32(color, 8);
+    else if (bpmem.blendmode.alphaupdate)
+      packed = _mm_or_si128(PackRGBA6Color(color), PackRGBA6Alpha(color));
+    else
+      packed = _mm_or_si128(PackRGBA6Color(color), _mm_and_si128(stored, _mm_set1_epi32(0x3f)));
+  }
+  else if (bpmem.blendmode.alphaupdate && format == PEControl::RGBA6_Z24)
+  {
+    packed = _mm_or_si128(_mm_and_si128(stored, _mm_set1_epi32(0x00ffffc0)), PackRGBA6Alpha(color));
+  }
+  else
+  {
+    return;
+  }
+
+  alignas(16) u32 results[PixelBlock::MAX_PIXELS];
+  _mm_store_si128(reinterpret_cast<__m128i*>(results), packed);
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+  {
+    if (block.mask & (1 << i))
+      StorePixel(offsets[i], results[i]);
+  }
+}
+#endif
+
+u32 ZCompareBlock(const PixelBlock& block)
+{
+#ifdef _M_X86
+  if (cpu_info.bSSE4_1 && IsBlockFormat(bpmem.zcontrol.pixel_format))
+    return ZCompareBlockSSE41(block);
+#endif
+
+  u32 passed = 0;
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+  {
+    if ((block.mask & (1 << i)) && ZCompare(block.x[i], block.y[i], block.z[i]))
+      passed |= 1 << i;
+  }
+  return passed;
+}
+
+void BlendTevBlock(const PixelBlock& block)
+{
+#ifdef _M_X86
+  if (cpu_info.bSSE4_1 && IsBlockFormat(bpmem.zcontrol.pixel_format))
+  {
+    BlendTevBlockSSE41(block);
+    return;
+  }
+#endif
+
+  for (int i = 0; i < PixelBlock::MAX_PIXELS; i++)
+  {
+    if (block.mask & (1 << i))
+    {
+      u32 color = block.color[i];
+      BlendTev(block.x[i], block.y[i], reinterpret_cast<u8*>(&color));
+    }
+  }
+}
 }
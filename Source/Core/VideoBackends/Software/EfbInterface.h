@@ -47,6 +47,24 @@ void BlendTev(u16 x, u16 y, u8* color);
 // returns result of compare.
 bool ZCompare(u16 x, u16 y, u32 z);
 
+// Pixels which are depth tested or blended together. They must all be at different positions.
+struct PixelBlock
+{
+  static constexpr int MAX_PIXELS = 4;
+
+  u16 x[MAX_PIXELS];
+  u16 y[MAX_PIXELS];
+  u32 z[MAX_PIXELS];
+  u32 color[MAX_PIXELS];  // ABGR, like the color of BlendTev
+  // Bit i is set if pixel i is part of the block
+  u32 mask;
+};
+
+// Like ZCompare and BlendTev, for all pixels of a block at once. ZCompareBlock returns the mask
+// of the pixels which passed.
+u32 ZCompareBlock(const PixelBlock& block);
+void BlendTevBlock(const PixelBlock& block);
+
 // sets the color and alpha
 void SetColor(u16 x, u16 y, u8* color);
 void SetDepth(u16 x, u16 y, u32 depth);
@@ -62,16 +80,6 @@ void CopyToXFB(yuv422_packed* xfb_in_ram, u32 fbWidth, u32 fbHeight, const EFBRe
 void BypassXFB(u8* texture, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma);
 
 extern u32 perf_values[PQ_NUM_MEMBERS];
-inline void IncPerfCounterQuadCount(PerfQueryType type)
-{
-  // NOTE: hardware doesn't process individual pixels but quads instead.
-  // Current software renderer architecture works on pixels though, so
-  // we have this "quad" hack here to only increment the registers on
-  // every fourth rendered pixel
-  static u32 quad[PQ_NUM_MEMBERS];
-  if (++quad[type] != 3)
-    return;
-  quad[type] = 0;
-  ++perf_values[type];
-}
+// Counts num_pixels pixels towards the given perf counter.
+void IncPerfCounterQuadCount(PerfQueryType type, u32 num_pixels);
 }
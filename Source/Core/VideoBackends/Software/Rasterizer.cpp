@@ -3,13 +3,19 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cstring>
+#include <memory>
+#include <vector>
 
+#include "Common/BitSet.h"
 #include "Common/CommonTypes.h"
+#include "Common/ThreadPool.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
@@ -19,22 +25,100 @@ namespace Rasterizer
 {
 static constexpr int BLOCK_SIZE = 2;
 
+// With more than one thread, triangles are binned into tiles of the EFB which are then drawn in
+// parallel. Each tile is drawn by a single thread, in the order the triangles were submitted,
+// and no pixel belongs to more than one tile, so the result is the same as drawing each triangle
+// completely before the next one.
+static constexpr int TILE_SIZE = 32;
+static constexpr int NUM_TILES_X = (EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
+static constexpr int NUM_TILES_Y = (EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+static_assert(TILE_SIZE % BLOCK_SIZE == 0, "Blocks must not cross tile boundaries");
+static_assert(BLOCK_SIZE * BLOCK_SIZE * Tev::MAX_BLOCKS <= Tev::MAX_PIXELS,
+              "A span of blocks must fit into the Tev");
+static_assert(BLOCK_SIZE * BLOCK_SIZE == EfbInterface::PixelBlock::MAX_PIXELS,
+              "Blocks are depth tested together");
+
+// Batches with bounding boxes covering fewer pixels than this are drawn on the calling thread,
+// since waking up the workers would take longer than drawing them.
+static constexpr u32 MIN_PARALLEL_PIXELS = 64 * 64;
+
+namespace
+{
+// Everything needed to draw a triangle, so that drawing can be deferred until the end of the
+// batch. The BP/XF state the triangle is drawn with can't change within a batch.
+struct TriangleSetup
+{
+  Slope ZSlope;
+  Slope WSlope;
+  Slope ColorSlopes[2][4];
+  Slope TexSlopes[8][3];
+
+  s32 vertex0X;
+  s32 vertex0Y;
+  float vertexOffsetX;
+  float vertexOffsetY;
+
+  // Deltas and half-edge constants in 28.4 fixed-point
+  s32 DX12, DX23, DX31;
+  s32 DY12, DY23, DY31;
+  s32 C1, C2, C3;
+
+  // Bounding rectangle in pixels, starting in the corner of a block
+  s32 minx, maxx, miny, maxy;
+};
+
+// State of one thread drawing pixels.
+struct RasterContext
+{
+  Tev tev;
+  RasterBlock rasterBlock;
+};
+}  // Anonymous namespace
+
+// Kept across triangles for zfreeze.
 static Slope ZSlope;
-static Slope WSlope;
-static Slope ColorSlopes[2][4];
-static Slope TexSlopes[8][3];
 
-static s32 vertex0X;
-static s32 vertex0Y;
-static float vertexOffsetX;
-static float vertexOffsetY;
+static std::vector<std::unique_ptr<RasterContext>> s_contexts;
+// Konstant colors, for contexts which are created later on
+static s16 s_tev_regs[4][4];
+static std::unique_ptr<Common::ThreadPool> s_thread_pool;
+
+static std::vector<TriangleSetup> s_triangles;
+static std::array<std::vector<u32>, NUM_TILES_X * NUM_TILES_Y> s_tile_bins;
+static std::vector<u32> s_used_tiles;
+static u32 s_batch_pixels;
+
+static void UpdateThreads()
+{
+  // Tev dumps go through shared buffers, so pixels have to be drawn one at a time in order.
+  const bool dump_tev = g_ActiveConfig.bDumpTevStages || g_ActiveConfig.bDumpTevTextureFetches;
+  const size_t num_threads = dump_tev ? 1 : std::max(g_ActiveConfig.GetSWRasterizerThreads(), 1u);
+  if (s_contexts.size() == num_threads)
+    return;
+
+  s_thread_pool.reset();
+  if (num_threads > 1)
+    s_thread_pool = std::make_unique<Common::ThreadPool>(num_threads, "Software Rasterizer");
 
-static Tev tev;
-static RasterBlock rasterBlock;
+  while (s_contexts.size() < num_threads)
+  {
+    s_contexts.push_back(std::make_unique<RasterContext>());
+    Tev& tev = s_contexts.back()->tev;
+    tev.Init();
+    for (int reg = 0; reg < 4; ++reg)
+    {
+      for (int comp = 0; comp < 4; ++comp)
+        tev.SetRegColor(reg, comp, s_tev_regs[reg][comp]);
+    }
+  }
+  s_contexts.resize(num_threads);
+}
 
 void Init()
 {
-  tev.Init();
+  s_contexts.clear();
+  std::memset(s_tev_regs, 0, sizeof(s_tev_regs));
+  UpdateThreads();
 
   // Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the
   // first primitive.
@@ -43,6 +127,15 @@ void Init()
   ZSlope.f0 = 1.f;
 }
 
+void Shutdown()
+{
+  s_thread_pool.reset();
+  s_contexts.clear();
+  s_triangles.clear();
+  for (std::vector<u32>& bin : s_tile_bins)
+    bin.clear();
+}
+
 // Returns approximation of log2(f) in s28.4
 // results are close enough to use for LOD
 static s32 FixedLog2(float f)
@@ -67,84 +160,121 @@ static inline int iround(float x)
 
 void SetTevReg(int reg, int comp, s16 color)
 {
-  tev.SetRegColor(reg, comp, color);
+  s_tev_regs[reg][comp] = color;
+  for (auto& context : s_contexts)
+    context->tev.SetRegColor(reg, comp, color);
 }
 
-static void Draw(s32 x, s32 y, s32 xi, s32 yi)
+// Queues the pixels of the block at x, y whose bits are set in coverage, unless they fail the
+// early depth test. Bit iy * BLOCK_SIZE + ix stands for the pixel at x + ix, y + iy.
+static void AddPixels(const TriangleSetup& triangle, RasterContext& context, int* num_pixels,
+                      s32 x, s32 y, u32 coverage, int block_index)
 {
-  INCSTAT(stats.thisFrame.rasterizedPixels);
+  Tev& tev = context.tev;
+  const RasterBlock& rasterBlock = context.rasterBlock;
 
-  float dx = vertexOffsetX + (float)(x - vertex0X);
-  float dy = vertexOffsetY + (float)(y - vertex0Y);
+  tev.counters.rasterized_pixels += CountSetBits(coverage);
 
-  s32 z = (s32)MathUtil::Clamp<float>(ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
+  EfbInterface::PixelBlock block;
+  block.mask = coverage;
+  float dx[EfbInterface::PixelBlock::MAX_PIXELS];
+  float dy[EfbInterface::PixelBlock::MAX_PIXELS];
+  for (int i = 0; i < EfbInterface::PixelBlock::MAX_PIXELS; i++)
+  {
+    if (!(coverage & (1 << i)))
+      continue;
+
+    const s32 px = x + i % BLOCK_SIZE;
+    const s32 py = y + i / BLOCK_SIZE;
+    dx[i] = triangle.vertexOffsetX + (float)(px - triangle.vertex0X);
+    dy[i] = triangle.vertexOffsetY + (float)(py - triangle.vertex0Y);
+
+    block.x[i] = px;
+    block.y[i] = py;
+    block.z[i] =
+        (s32)MathUtil::Clamp<float>(triangle.ZSlope.GetValue(dx[i], dy[i]), 0.0f, 16777215.0f);
+  }
 
+  u32 passed = coverage;
   if (bpmem.UseEarlyDepthTest() && g_ActiveConfig.bZComploc)
   {
     // TODO: Test if perf regs are incremented even if test is disabled
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
+    tev.counters.perf_pixels[PQ_ZCOMP_INPUT_ZCOMPLOC] += CountSetBits(coverage);
     if (bpmem.zmode.testenable)
     {
       // early z
-      if (!EfbInterface::ZCompare(x, y, z))
-        return;
+      passed = EfbInterface::ZCompareBlock(block);
     }
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
+    tev.counters.perf_pixels[PQ_ZCOMP_OUTPUT_ZCOMPLOC] += CountSetBits(passed);
   }
 
-  RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+  for (int i = 0; i < EfbInterface::PixelBlock::MAX_PIXELS; i++)
+  {
+    if (!(passed & (1 << i)))
+      continue;
+
+    const RasterBlockPixel& pixel = rasterBlock.Pixel[i % BLOCK_SIZE][i / BLOCK_SIZE];
+    Tev::PixelInput& input = tev.Pixels[(*num_pixels)++];
 
-  tev.Position[0] = x;
-  tev.Position[1] = y;
-  tev.Position[2] = z;
+    input.Position[0] = block.x[i];
+    input.Position[1] = block.y[i];
+    input.Position[2] = block.z[i];
+    input.Block = block_index;
 
-  //  colors
-  for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
-  {
-    for (int comp = 0; comp < 4; comp++)
+    //  colors
+    for (unsigned int j = 0; j < bpmem.genMode.numcolchans; j++)
     {
-      u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+      for (int comp = 0; comp < 4; comp++)
+      {
+        u16 color = (u16)triangle.ColorSlopes[j][comp].GetValue(dx[i], dy[i]);
 
-      // clamp color value to 0
-      u16 mask = ~(color >> 8);
+        // clamp color value to 0
+        u16 mask = ~(color >> 8);
 
-      tev.Color[i][comp] = color & mask;
+        input.Color[j][comp] = color & mask;
+      }
     }
-  }
 
-  // tex coords
-  for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
-  {
-    // multiply by 128 because TEV stores UVs as s17.7
-    tev.Uv[i].s = (s32)(pixel.Uv[i][0] * 128);
-    tev.Uv[i].t = (s32)(pixel.Uv[i][1] * 128);
+    // tex coords
+    for (unsigned int j = 0; j < bpmem.genMode.numtexgens; j++)
+    {
+      // multiply by 128 because TEV stores UVs as s17.7
+      input.Uv[j].s = (s32)(pixel.Uv[j][0] * 128);
+      input.Uv[j].t = (s32)(pixel.Uv[j][1] * 128);
+    }
   }
+}
+
+// Hands the level of detail of the current block to the Tev, for the pixels AddPixels queued
+// with block_index.
+static void SetBlockLods(RasterContext& context, int block_index)
+{
+  Tev& tev = context.tev;
+  const RasterBlock& rasterBlock = context.rasterBlock;
 
   for (unsigned int i = 0; i < bpmem.genMode.numindstages; i++)
   {
-    tev.IndirectLod[i] = rasterBlock.IndirectLod[i];
-    tev.IndirectLinear[i] = rasterBlock.IndirectLinear[i];
+    tev.IndirectLod[block_index][i] = rasterBlock.IndirectLod[i];
+    tev.IndirectLinear[block_index][i] = rasterBlock.IndirectLinear[i];
   }
 
   for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
   {
-    tev.TextureLod[i] = rasterBlock.TextureLod[i];
-    tev.TextureLinear[i] = rasterBlock.TextureLinear[i];
+    tev.TextureLod[block_index][i] = rasterBlock.TextureLod[i];
+    tev.TextureLinear[block_index][i] = rasterBlock.TextureLinear[i];
   }
-
-  tev.Draw();
 }
 
-static void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+static void InitTriangle(TriangleSetup* triangle, float X1, float Y1, s32 xi, s32 yi)
 {
-  vertex0X = xi;
-  vertex0Y = yi;
+  triangle->vertex0X = xi;
+  triangle->vertex0Y = yi;
 
   // adjust a little less than 0.5
   const float adjust = 0.495f;
 
-  vertexOffsetX = ((float)xi - X1) + adjust;
-  vertexOffsetY = ((float)yi - Y1) + adjust;
+  triangle->vertexOffsetX = ((float)xi - X1) + adjust;
+  triangle->vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 static void InitSlope(Slope* slope, float f1, float f2, float f3, float DX31, float DX12,
@@ -160,7 +290,8 @@ static void InitSlope(Slope* slope, float f1, float f2, float f3, float DX31, fl
   slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear,
+                                u32 texmap, u32 texcoord)
 {
   const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
   const u8 subTexmap = texmap & 3;
@@ -173,17 +304,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   float sDelta, tDelta;
   if (tm0.diag_lod)
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
     sDelta = fabsf(uv0[0] - uv1[0]);
     tDelta = fabsf(uv0[1] - uv1[1]);
   }
   else
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-    float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+    const float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
     sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
     tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -208,7 +339,8 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   *lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+static void BuildBlock(const TriangleSetup& triangle, RasterBlock& rasterBlock, s32 blockX,
+                       s32 blockY)
 {
   for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
   {
@@ -216,10 +348,10 @@ static void BuildBlock(s32 blockX, s32 blockY)
     {
       RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-      float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-      float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+      float dx = triangle.vertexOffsetX + (float)(xi + blockX - triangle.vertex0X);
+      float dy = triangle.vertexOffsetY + (float)(yi + blockY - triangle.vertex0Y);
 
-      float invW = 1.0f / WSlope.GetValue(dx, dy);
+      float invW = 1.0f / triangle.WSlope.GetValue(dx, dy);
       pixel.InvW = invW;
 
       // tex coords
@@ -228,13 +360,13 @@ static void BuildBlock(s32 blockX, s32 blockY)
         float projection = invW;
         if (xfmem.texMtxInfo[i].projection)
         {
-          float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+          float q = triangle.TexSlopes[i][2].GetValue(dx, dy) * invW;
           if (q != 0.0f)
             projection = invW / q;
         }
 
-        pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-        pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+        pixel.Uv[i][0] = triangle.TexSlopes[i][0].GetValue(dx, dy) * projection;
+        pixel.Uv[i][1] = triangle.TexSlopes[i][1].GetValue(dx, dy) * projection;
       }
     }
   }
@@ -247,7 +379,8 @@ static void BuildBlock(s32 blockX, s32 blockY)
     u32 texcoord = indref & 3;
     indref >>= 3;
 
-    CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+    CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap,
+                 texcoord);
   }
 
   for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -259,16 +392,15 @@ static void BuildBlock(s32 blockX, s32 blockY)
       u32 texmap = order.getTexMap(stageOdd);
       u32 texcoord = order.getTexCoord(stageOdd);
 
-      CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+      CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap,
+                   texcoord);
     }
   }
 }
 
-void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v1,
-                           const OutputVertexData* v2)
+static bool SetupTriangle(TriangleSetup* triangle, const OutputVertexData* v0,
+                          const OutputVertexData* v1, const OutputVertexData* v2)
 {
-  INCSTAT(stats.thisFrame.numTrianglesDrawn);
-
   // adapted from http://devmaster.net/posts/6145/advanced-rasterization
 
   // 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
@@ -290,15 +422,6 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   const s32 DY23 = Y2 - Y3;
   const s32 DY31 = Y3 - Y1;
 
-  // Fixed-pos32 deltas
-  const s32 FDX12 = DX12 * 16;
-  const s32 FDX23 = DX23 * 16;
-  const s32 FDX31 = DX31 * 16;
-
-  const s32 FDY12 = DY12 * 16;
-  const s32 FDY23 = DY23 * 16;
-  const s32 FDY31 = DY31 * 16;
-
   // Bounding rectangle
   s32 minx = (std::min(std::min(X1, X2), X3) + 0xF) >> 4;
   s32 maxx = (std::max(std::max(X1, X2), X3) + 0xF) >> 4;
@@ -331,7 +454,7 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   maxy = std::min(maxy, scissorBottom);
 
   if (minx >= maxx || miny >= maxy)
-    return;
+    return false;
 
   // Setup slopes
   float fltx1 = v0->screenPosition.x;
@@ -341,11 +464,11 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   float fltdy12 = flty1 - v1->screenPosition.y;
   float fltdy31 = v2->screenPosition.y - flty1;
 
-  InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+  InitTriangle(triangle, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
   float w[3] = {1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w,
                 1.0f / v2->projectedPosition.w};
-  InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+  InitSlope(&triangle->WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
   // TODO: The zfreeze emulation is not quite correct, yet!
   // Many things might prevent us from reaching this line (culling, clipping, scissoring).
@@ -356,19 +479,21 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   if (!bpmem.genMode.zfreeze || !g_ActiveConfig.bZFreeze)
     InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31,
               fltdx12, fltdy12, fltdy31);
+  triangle->ZSlope = ZSlope;
 
   for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
   {
     for (int comp = 0; comp < 4; comp++)
-      InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp],
-                fltdx31, fltdx12, fltdy12, fltdy31);
+      InitSlope(&triangle->ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp],
+                v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
   }
 
   for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
   {
     for (int comp = 0; comp < 3; comp++)
-      InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1],
-                v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+      InitSlope(&triangle->TexSlopes[i][comp], v0->texCoords[i][comp] * w[0],
+                v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12,
+                fltdy12, fltdy31);
   }
 
   // Half-edge constants
@@ -388,6 +513,58 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   minx &= ~(BLOCK_SIZE - 1);
   miny &= ~(BLOCK_SIZE - 1);
 
+  triangle->DX12 = DX12;
+  triangle->DX23 = DX23;
+  triangle->DX31 = DX31;
+  triangle->DY12 = DY12;
+  triangle->DY23 = DY23;
+  triangle->DY31 = DY31;
+  triangle->C1 = C1;
+  triangle->C2 = C2;
+  triangle->C3 = C3;
+  triangle->minx = minx;
+  triangle->maxx = maxx;
+  triangle->miny = miny;
+  triangle->maxy = maxy;
+
+  return true;
+}
+
+// Draws the part of the triangle within the given rectangle, which must start in the corner of a
+// block.
+static void RasterizeTriangle(const TriangleSetup& triangle, RasterContext& context, s32 left,
+                              s32 top, s32 right, s32 bottom)
+{
+  const s32 DX12 = triangle.DX12;
+  const s32 DX23 = triangle.DX23;
+  const s32 DX31 = triangle.DX31;
+
+  const s32 DY12 = triangle.DY12;
+  const s32 DY23 = triangle.DY23;
+  const s32 DY31 = triangle.DY31;
+
+  // Fixed-pos32 deltas
+  const s32 FDX12 = DX12 * 16;
+  const s32 FDX23 = DX23 * 16;
+  const s32 FDX31 = DX31 * 16;
+
+  const s32 FDY12 = DY12 * 16;
+  const s32 FDY23 = DY23 * 16;
+  const s32 FDY31 = DY31 * 16;
+
+  const s32 C1 = triangle.C1;
+  const s32 C2 = triangle.C2;
+  const s32 C3 = triangle.C3;
+
+  const s32 minx = std::max(triangle.minx, left);
+  const s32 maxx = std::min(triangle.maxx, right);
+  const s32 miny = std::max(triangle.miny, top);
+  const s32 maxy = std::min(triangle.maxy, bottom);
+
+  // Pixels queued for the Tev, and the number of blocks they come from
+  int num_pixels = 0;
+  int num_blocks = 0;
+
   // Loop through blocks
   for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
   {
@@ -422,18 +599,11 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
       if (a == 0x0 || b == 0x0 || c == 0x0)
         continue;
 
-      BuildBlock(x, y);
-
       // Accept whole block when totally covered
+      u32 coverage = 0;
       if (a == 0xF && b == 0xF && c == 0xF)
       {
-        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-        {
-          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-          {
-            Draw(x + ix, y + iy, ix, iy);
-          }
-        }
+        coverage = (1 << (BLOCK_SIZE * BLOCK_SIZE)) - 1;
       }
       else  // Partially covered block
       {
@@ -450,9 +620,7 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
           for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
           {
             if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-            {
-              Draw(x + ix, y + iy, ix, iy);
-            }
+              coverage |= 1 << (iy * BLOCK_SIZE + ix);
 
             CX1 -= FDY12;
             CX2 -= FDY23;
@@ -464,7 +632,137 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
           CY3 += FDX31;
         }
       }
+
+      if (coverage == 0)
+        continue;
+
+      BuildBlock(triangle, context.rasterBlock, x, y);
+
+      const int first_pixel = num_pixels;
+      AddPixels(triangle, context, &num_pixels, x, y, coverage, num_blocks);
+      if (num_pixels == first_pixel)
+        continue;
+
+      // Blocks are drawn together once the span is full, so that the Tev can combine all of their
+      // pixels at once
+      SetBlockLods(context, num_blocks);
+      if (++num_blocks == Tev::MAX_BLOCKS)
+      {
+        context.tev.Draw(num_pixels);
+        num_pixels = 0;
+        num_blocks = 0;
+      }
     }
   }
+
+  if (num_pixels != 0)
+    context.tev.Draw(num_pixels);
+}
+
+static void BinTriangle(const TriangleSetup& triangle)
+{
+  const u32 index = static_cast<u32>(s_triangles.size());
+  s_triangles.push_back(triangle);
+  s_batch_pixels += (triangle.maxx - triangle.minx) * (triangle.maxy - triangle.miny);
+
+  // Blocks are visited by their top left pixel, so the tiles touched by the last block row and
+  // column are the ones containing maxx - 1 and maxy - 1.
+  const int first_tile_x = triangle.minx / TILE_SIZE;
+  const int last_tile_x = (triangle.maxx - 1) / TILE_SIZE;
+  const int first_tile_y = triangle.miny / TILE_SIZE;
+  const int last_tile_y = (triangle.maxy - 1) / TILE_SIZE;
+
+  for (int tile_y = first_tile_y; tile_y <= last_tile_y; ++tile_y)
+  {
+    for (int tile_x = first_tile_x; tile_x <= last_tile_x; ++tile_x)
+      s_tile_bins[tile_y * NUM_TILES_X + tile_x].push_back(index);
+  }
+}
+
+void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v1,
+                           const OutputVertexData* v2)
+{
+  INCSTAT(stats.thisFrame.numTrianglesDrawn);
+
+  TriangleSetup triangle;
+  if (!SetupTriangle(&triangle, v0, v1, v2))
+    return;
+
+  if (s_thread_pool)
+    BinTriangle(triangle);
+  else
+    RasterizeTriangle(triangle, *s_contexts[0], 0, 0, EFB_WIDTH, EFB_HEIGHT);
+}
+
+static void DrawTile(size_t tile, RasterContext& context)
+{
+  const s32 left = static_cast<s32>(tile % NUM_TILES_X) * TILE_SIZE;
+  const s32 top = static_cast<s32>(tile / NUM_TILES_X) * TILE_SIZE;
+
+  for (u32 index : s_tile_bins[tile])
+    RasterizeTriangle(s_triangles[index], context, left, top, left + TILE_SIZE, top + TILE_SIZE);
+}
+
+static void DrawBinnedTriangles()
+{
+  s_used_tiles.clear();
+  for (u32 i = 0; i < s_tile_bins.size(); ++i)
+  {
+    if (!s_tile_bins[i].empty())
+      s_used_tiles.push_back(i);
+  }
+
+  if (s_batch_pixels < MIN_PARALLEL_PIXELS)
+  {
+    for (u32 tile : s_used_tiles)
+      DrawTile(tile, *s_contexts[0]);
+  }
+  else
+  {
+    s_thread_pool->ParallelFor(s_used_tiles.size(), [](size_t i, size_t thread_index) {
+      DrawTile(s_used_tiles[i], *s_contexts[thread_index]);
+    });
+  }
+
+  for (u32 tile : s_used_tiles)
+    s_tile_bins[tile].clear();
+  s_triangles.clear();
+  s_batch_pixels = 0;
+}
+
+void Flush()
+{
+  if (!s_triangles.empty())
+    DrawBinnedTriangles();
+
+  for (auto& context : s_contexts)
+  {
+    Tev::Counters& counters = context->tev.counters;
+
+    ADDSTAT(stats.thisFrame.rasterizedPixels, counters.rasterized_pixels);
+    ADDSTAT(stats.thisFrame.tevPixelsIn, counters.tev_pixels_in);
+    ADDSTAT(stats.thisFrame.tevPixelsOut, counters.tev_pixels_out);
+
+    for (int i = 0; i < PQ_NUM_MEMBERS; ++i)
+    {
+      if (counters.perf_pixels[i] != 0)
+        EfbInterface::IncPerfCounterQuadCount(static_cast<PerfQueryType>(i),
+                                              counters.perf_pixels[i]);
+    }
+
+    BoundingBox::coords[BoundingBox::LEFT] =
+        std::min(counters.bounding_box[BoundingBox::LEFT], BoundingBox::coords[BoundingBox::LEFT]);
+    BoundingBox::coords[BoundingBox::RIGHT] = std::max(counters.bounding_box[BoundingBox::RIGHT],
+                                                       BoundingBox::coords[BoundingBox::RIGHT]);
+    BoundingBox::coords[BoundingBox::TOP] =
+        std::min(counters.bounding_box[BoundingBox::TOP], BoundingBox::coords[BoundingBox::TOP]);
+    BoundingBox::coords[BoundingBox::BOTTOM] = std::max(counters.bounding_box[BoundingBox::BOTTOM],
+                                                        BoundingBox::coords[BoundingBox::BOTTOM]);
+
+    context->tev.ResetCounters();
+  }
+
+  // Thread settings only take effect between batches, as triangles may already be binned.
+  UpdateThreads();
 }
 }
@@ -11,10 +11,15 @@ struct OutputVertexData;
 namespace Rasterizer
 {
 void Init();
+void Shutdown();
 
 void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v1,
                            const OutputVertexData* v2);
 
+// Finishes drawing all triangles of the current batch. Must be called before anything that
+// depends on the EFB, statistics or BP state changes.
+void Flush();
+
 void SetTevReg(int reg, int comp, s16 color);
 
 struct Slope
@@ -0,0 +1,61 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoBackends/Software/SWHeadlessOutput.h"
+
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+static std::mutex s_frame_lock;
+static SWHeadlessOutput::FrameCallback s_frame_callback;
+static std::vector<u8> s_last_frame;
+static int s_last_frame_width = 0;
+static int s_last_frame_height = 0;
+static u64 s_frame_count = 0;
+
+void SWHeadlessOutput::SetFrameCallback(FrameCallback callback)
+{
+  std::lock_guard<std::mutex> lk(s_frame_lock);
+  s_frame_callback = std::move(callback);
+}
+
+bool SWHeadlessOutput::GetLastFrame(std::vector<u8>* data, int* width, int* height)
+{
+  std::lock_guard<std::mutex> lk(s_frame_lock);
+  if (s_frame_count == 0)
+    return false;
+
+  *data = s_last_frame;
+  *width = s_last_frame_width;
+  *height = s_last_frame_height;
+  return true;
+}
+
+u64 SWHeadlessOutput::GetFrameCount()
+{
+  std::lock_guard<std::mutex> lk(s_frame_lock);
+  return s_frame_count;
+}
+
+void SWHeadlessOutput::ShowImage(const u8* data, int stride, int width, int height, float aspect)
+{
+  FrameCallback callback;
+  {
+    std::lock_guard<std::mutex> lk(s_frame_lock);
+
+    const size_t row_size = width * 4;
+    s_last_frame.resize(row_size * height);
+    for (int y = 0; y < height; ++y)
+      std::memcpy(&s_last_frame[y * row_size], data + y * stride, row_size);
+    s_last_frame_width = width;
+    s_last_frame_height = height;
+    ++s_frame_count;
+
+    callback = s_frame_callback;
+  }
+
+  if (callback)
+    callback(data, stride, width, height);
+}
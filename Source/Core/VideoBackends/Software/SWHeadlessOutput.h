@@ -0,0 +1,29 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/SWOutput.h"
+
+// Keeps frames in memory instead of presenting them, so that the software renderer can run
+// without a window system. Frame dumping still works, to write the frames to images or AVI.
+class SWHeadlessOutput final : public SWOutput
+{
+public:
+  // Called on the GPU thread for every frame, with RGBA8 pixels.
+  using FrameCallback = std::function<void(const u8* data, int stride, int width, int height)>;
+
+  static void SetFrameCallback(FrameCallback callback);
+
+  // Copies the most recent frame as tightly packed RGBA8 pixels.
+  // Returns false if no frame has been shown yet.
+  static bool GetLastFrame(std::vector<u8>* data, int* width, int* height);
+  static u64 GetFrameCount();
+
+  void ShowImage(const u8* data, int stride, int width, int height, float aspect) override;
+};
@@ -10,9 +10,7 @@
 
 #include "VideoBackends/Software/SWOGLWindow.h"
 
-std::unique_ptr<SWOGLWindow> SWOGLWindow::s_instance;
-
-void SWOGLWindow::Init(void* window_handle)
+std::unique_ptr<SWOGLWindow> SWOGLWindow::Create(void* window_handle)
 {
   InitInterface();
   GLInterface->SetMode(GLInterfaceMode::MODE_DETECT);
@@ -21,15 +19,13 @@ void SWOGLWindow::Init(void* window_handle)
     ERROR_LOG(VIDEO, "GLInterface::Create failed.");
   }
 
-  s_instance.reset(new SWOGLWindow());
+  return std::unique_ptr<SWOGLWindow>(new SWOGLWindow());
 }
 
-void SWOGLWindow::Shutdown()
+SWOGLWindow::~SWOGLWindow()
 {
   GLInterface->Shutdown();
   GLInterface.reset();
-
-  s_instance.reset();
 }
 
 void SWOGLWindow::Prepare()
@@ -9,22 +9,18 @@
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "VideoBackends/Software/SWOutput.h"
 
-class SWOGLWindow
+// Presents frames in a window through OpenGL.
+class SWOGLWindow final : public SWOutput
 {
 public:
-  static void Init(void* window_handle);
-  static void Shutdown();
+  static std::unique_ptr<SWOGLWindow> Create(void* window_handle);
+  ~SWOGLWindow() override;
 
-  // Will be printed on the *next* image
-  void PrintText(const std::string& text, int x, int y, u32 color);
-
-  // Image to show, will be swapped immediately
-  void ShowImage(const u8* data, int stride, int width, int height, float aspect);
-
-  int PeekMessages();
-
-  static std::unique_ptr<SWOGLWindow> s_instance;
+  void PrintText(const std::string& text, int x, int y, u32 color) override;
+  void ShowImage(const u8* data, int stride, int width, int height, float aspect) override;
+  int PeekMessages() override;
 
 private:
   SWOGLWindow() {}
@@ -0,0 +1,25 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoBackends/Software/SWOutput.h"
+
+#include "VideoBackends/Software/SWHeadlessOutput.h"
+#include "VideoBackends/Software/SWOGLWindow.h"
+
+#include "VideoCommon/VideoConfig.h"
+
+std::unique_ptr<SWOutput> SWOutput::s_instance;
+
+void SWOutput::Init(void* window_handle)
+{
+  if (g_ActiveConfig.bSWHeadless)
+    s_instance = std::make_unique<SWHeadlessOutput>();
+  else
+    s_instance = SWOGLWindow::Create(window_handle);
+}
+
+void SWOutput::Shutdown()
+{
+  s_instance.reset();
+}
@@ -0,0 +1,31 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// Where the software renderer sends the frames it has finished.
+class SWOutput
+{
+public:
+  virtual ~SWOutput() = default;
+
+  // Creates s_instance, which is either a window or the headless output, depending on the config.
+  static void Init(void* window_handle);
+  static void Shutdown();
+
+  // Will be printed on the *next* image
+  virtual void PrintText(const std::string& text, int x, int y, u32 color) {}
+
+  // Image to show, will be swapped immediately
+  virtual void ShowImage(const u8* data, int stride, int width, int height, float aspect) = 0;
+
+  virtual int PeekMessages() { return 0; }
+
+  static std::unique_ptr<SWOutput> s_instance;
+};
@@ -16,7 +16,7 @@
 #include "Core/HW/Memmap.h"
 
 #include "VideoBackends/Software/EfbCopy.h"
-#include "VideoBackends/Software/SWOGLWindow.h"
+#include "VideoBackends/Software/SWOutput.h"
 
 #include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -52,7 +52,7 @@ void SWRenderer::Shutdown()
 
 void SWRenderer::RenderText(const std::string& pstr, int left, int top, u32 color)
 {
-  SWOGLWindow::s_instance->PrintText(pstr, left, top, color);
+  SWOutput::s_instance->PrintText(pstr, left, top, color);
 }
 
 u8* SWRenderer::GetNextColorTexture()
@@ -136,7 +136,7 @@ void SWRenderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbStride, u32 fbHeight,
 
   DrawDebugText();
 
-  SWOGLWindow::s_instance->ShowImage(GetCurrentColorTexture(), fbWidth * 4, fbWidth, fbHeight, 1.0);
+  SWOutput::s_instance->ShowImage(GetCurrentColorTexture(), fbWidth * 4, fbWidth, fbHeight, 1.0);
 
   UpdateActiveConfig();
 
@@ -117,6 +117,8 @@ void SWVertexLoader::vFlush()
     INCSTAT(stats.thisFrame.numVerticesLoaded)
   }
 
+  Rasterizer::Flush();
+
   DebugUtil::OnObjectEnd();
 }
 
@@ -14,7 +14,7 @@
 #include "VideoBackends/Software/EfbCopy.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Rasterizer.h"
-#include "VideoBackends/Software/SWOGLWindow.h"
+#include "VideoBackends/Software/SWOutput.h"
 #include "VideoBackends/Software/SWRenderer.h"
 #include "VideoBackends/Software/SWTexture.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
@@ -133,7 +133,7 @@ bool VideoSoftware::Initialize(void* window_handle)
   InitBackendInfo();
   InitializeShared();
 
-  SWOGLWindow::Init(window_handle);
+  SWOutput::Init(window_handle);
 
   Clipper::Init();
   Rasterizer::Init();
@@ -145,7 +145,8 @@ bool VideoSoftware::Initialize(void* window_handle)
 
 void VideoSoftware::Shutdown()
 {
-  SWOGLWindow::Shutdown();
+  Rasterizer::Shutdown();
+  SWOutput::Shutdown();
 
   ShutdownShared();
 }
@@ -179,6 +180,6 @@ void VideoSoftware::Video_Prepare()
 
 unsigned int VideoSoftware::PeekMessages()
 {
-  return SWOGLWindow::s_instance->PeekMessages();
+  return SWOutput::s_instance->PeekMessages();
 }
 }
@@ -2,10 +2,16 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 
+#include "Common/BitSet.h"
+#include "Common/CPUDetect.h"
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Tev.h"
@@ -14,7 +20,6 @@
 #include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
 #include "VideoCommon/PixelShaderManager.h"
-#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
 
@@ -26,6 +31,8 @@
 
 void Tev::Init()
 {
+  ResetCounters();
+
   FixedConstants[0] = 0;
   FixedConstants[1] = 32;
   FixedConstants[2] = 64;
@@ -169,28 +176,28 @@ static inline s16 Clamp1024(s16 in)
   return in > 1023 ? 1023 : (in < -1024 ? -1024 : in);
 }
 
-void Tev::SetRasColor(int colorChan, int swaptable)
+void Tev::SetRasColor(const u8 (&color)[2][4], int colorChan, int swaptable)
 {
   switch (colorChan)
   {
   case 0:  // Color0
   {
-    const u8* color = Color[0];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
+    const u8* color0 = color[0];
+    RasColor[RED_C] = color0[bpmem.tevksel[swaptable].swap1];
+    RasColor[GRN_C] = color0[bpmem.tevksel[swaptable].swap2];
     swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+    RasColor[BLU_C] = color0[bpmem.tevksel[swaptable].swap1];
+    RasColor[ALP_C] = color0[bpmem.tevksel[swaptable].swap2];
   }
   break;
   case 1:  // Color1
   {
-    const u8* color = Color[1];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
+    const u8* color1 = color[1];
+    RasColor[RED_C] = color1[bpmem.tevksel[swaptable].swap1];
+    RasColor[GRN_C] = color1[bpmem.tevksel[swaptable].swap2];
     swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+    RasColor[BLU_C] = color1[bpmem.tevksel[swaptable].swap1];
+    RasColor[ALP_C] = color1[bpmem.tevksel[swaptable].swap2];
   }
   break;
   case 5:  // alpha bump
@@ -562,21 +569,29 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
   }
 }
 
-void Tev::Draw()
+void Tev::SetStageKonst(unsigned int stageNum)
 {
-  _assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
-  _assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
-
-  INCSTAT(stats.thisFrame.tevPixelsIn);
+  const TevKSel& kSel = bpmem.tevksel[stageNum >> 1];
+  const int kc = kSel.getKC(stageNum & 1);
+  const int ka = kSel.getKA(stageNum & 1);
+  StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
+  StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
+  StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
+  StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
+}
 
-  // initial color values
-  for (int i = 0; i < 4; i++)
-  {
-    Reg[i][RED_C] = PixelShaderManager::constants.colors[i][0];
-    Reg[i][GRN_C] = PixelShaderManager::constants.colors[i][1];
-    Reg[i][BLU_C] = PixelShaderManager::constants.colors[i][2];
-    Reg[i][ALP_C] = PixelShaderManager::constants.colors[i][3];
-  }
+void Tev::SampleTextures(int pixel)
+{
+  const PixelInput& input = Pixels[pixel];
+  PixelState& state = m_PixelStates[pixel];
+
+  // Stages which don't sample a texture see the texture color of the previous stage, but nothing
+  // is carried over from the previous pixel. That one may have been drawn by another thread.
+  TexCoord.s = 0;
+  TexCoord.t = 0;
+  for (s16& comp : TexColor)
+    comp = 0;
+  AlphaBump = 0;
 
   for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
   {
@@ -590,8 +605,9 @@ void Tev::Draw()
     const s32 scaleS = stageOdd ? texscale.ss1 : texscale.ss0;
     const s32 scaleT = stageOdd ? texscale.ts1 : texscale.ts0;
 
-    TextureSampler::Sample(Uv[texcoordSel].s >> scaleS, Uv[texcoordSel].t >> scaleT,
-                           IndirectLod[stageNum], IndirectLinear[stageNum], texmap,
+    TextureSampler::Sample(input.Uv[texcoordSel].s >> scaleS, input.Uv[texcoordSel].t >> scaleT,
+                           IndirectLod[input.Block][stageNum],
+                           IndirectLinear[input.Block][stageNum], texmap,
                            IndirectTex[stageNum]);
 
 #if ALLOW_TEV_DUMPS
@@ -607,19 +623,14 @@ void Tev::Draw()
 
   for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
   {
-    const int stageNum2 = stageNum >> 1;
     const int stageOdd = stageNum & 1;
-    const TwoTevStageOrders& order = bpmem.tevorders[stageNum2];
-    const TevKSel& kSel = bpmem.tevksel[stageNum2];
-
-    // stage combiners
-    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+    const TwoTevStageOrders& order = bpmem.tevorders[stageNum >> 1];
     const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
 
     const int texcoordSel = order.getTexCoord(stageOdd);
     const int texmap = order.getTexMap(stageOdd);
 
-    Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
+    Indirect(stageNum, input.Uv[texcoordSel].s, input.Uv[texcoordSel].t);
 
     // sample texture
     if (order.getEnable(stageOdd))
@@ -627,8 +638,8 @@ void Tev::Draw()
       // RGBA
       u8 texel[4];
 
-      TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum],
-                             texmap, texel);
+      TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[input.Block][stageNum],
+                             TextureLinear[input.Block][stageNum], texmap, texel);
 
 #if ALLOW_TEV_DUMPS
       if (g_ActiveConfig.bDumpTevTextureFetches)
@@ -644,78 +655,1066 @@ void Tev::Draw()
       TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
     }
 
-    // set konst for this stage
-    const int kc = kSel.getKC(stageOdd);
-    const int ka = kSel.getKA(stageOdd);
-    StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
-    StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
-    StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
-    StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
+    std::copy(std::begin(TexColor), std::end(TexColor), state.TexColor[stageNum]);
+    state.AlphaBump[stageNum] = AlphaBump;
+  }
+}
+
+void Tev::DrawStage(unsigned int stageNum, const u8 (&color)[2][4])
+{
+  const int stageOdd = stageNum & 1;
+  const TwoTevStageOrders& order = bpmem.tevorders[stageNum >> 1];
+
+  // stage combiners
+  const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+  const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+  SetStageKonst(stageNum);
+
+  // set color
+  SetRasColor(color, order.getColorChan(stageOdd), ac.rswap * 2);
+
+  // combine inputs
+  InputRegType inputs[4];
+  for (int i = 0; i < 3; i++)
+  {
+    inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
+    inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
+    inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
+    inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+  }
+  inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
+  inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
+  inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
+  inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
+
+  if (cc.bias != 3)
+    DrawColorRegular(cc, inputs);
+  else
+    DrawColorCompare(cc, inputs);
+
+  if (cc.clamp)
+  {
+    Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
+    Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
+    Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+  }
+  else
+  {
+    Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
+    Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
+    Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+  }
+
+  if (ac.bias != 3)
+    DrawAlphaRegular(ac, inputs);
+  else
+    DrawAlphaCompare(ac, inputs);
+
+  if (ac.clamp)
+    Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
+  else
+    Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+
+#if ALLOW_TEV_DUMPS
+  if (g_ActiveConfig.bDumpTevStages)
+  {
+    u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
+    DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+  }
+#endif
+}
+
+void Tev::CombineScalar(int pixel)
+{
+  PixelState& state = m_PixelStates[pixel];
+
+  // initial color values
+  for (int i = 0; i < 4; i++)
+  {
+    Reg[i][RED_C] = PixelShaderManager::constants.colors[i][0];
+    Reg[i][GRN_C] = PixelShaderManager::constants.colors[i][1];
+    Reg[i][BLU_C] = PixelShaderManager::constants.colors[i][2];
+    Reg[i][ALP_C] = PixelShaderManager::constants.colors[i][3];
+  }
+
+  for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+  {
+    std::copy(std::begin(state.TexColor[stageNum]), std::end(state.TexColor[stageNum]),
+              TexColor);
+    AlphaBump = state.AlphaBump[stageNum];
+    DrawStage(stageNum, Pixels[pixel].Color);
+  }
+
+  std::memcpy(state.Reg, Reg, sizeof(Reg));
+}
+
+// Adjusts the fog depth by the distance of the pixel from the center of the viewport.
+static float GetFogRangeAdjustment(s32 x)
+{
+  // TODO: This is untested and should definitely be checked against real hw.
+  // - No idea if offset is really normalized against the viewport width or against the
+  // projection matrix or yet something else
+  // - scaling of the "k" coefficient isn't clear either.
+
+  // First, calculate the offset from the viewport center (normalized to 0..1)
+  const float offset = (x - (static_cast<s32>(bpmem.fogRange.Base.Center.Value()) - 342)) /
+                       static_cast<float>(xfmem.viewport.wd);
+
+  // Based on that, choose the index such that points which are far away from the z-axis use the
+  // 10th "k" value and such that central points use the first value.
+  float floatindex = 9.f - std::abs(offset) * 9.f;
+  floatindex = (floatindex < 0.f) ? 0.f : (floatindex > 9.f) ?
+                                    9.f :
+                                    floatindex;  // TODO: This shouldn't be necessary!
+
+  // Get the two closest integer indices, look up the corresponding samples
+  const int indexlower = (int)floor(floatindex);
+  const int indexupper = indexlower + 1;
+  // Look up coefficient... Seems like multiplying by 4 makes Fortune Street work properly (fog
+  // is too strong without the factor)
+  const float klower = bpmem.fogRange.K[indexlower / 2].GetValue(indexlower % 2) * 4.f;
+  const float kupper = bpmem.fogRange.K[indexupper / 2].GetValue(indexupper % 2) * 4.f;
+
+  // linearly interpolate the samples and multiple ze by the resulting adjustment factor
+  const float factor = indexupper - floatindex;
+  const float k = klower * factor + kupper * (1.f - factor);
+  // NOTE: This is basically dividing by a cosine (hidden behind GXInitFogAdjTable):
+  // 1/cos = c/b = sqrt(a^2+b^2)/b
+  const float x_adjust = sqrt(offset * offset + k * k) / k;
+  return x_adjust;
+}
+
+// Applies the exponential fog curves to the clamped fog value.
+static float ApplyFogFunction(float fog)
+{
+  switch (bpmem.fog.c_proj_fsel.fsel)
+  {
+  case 4:  // exp
+    fog = 1.0f - pow(2.0f, -8.0f * fog);
+    break;
+  case 5:  // exp2
+    fog = 1.0f - pow(2.0f, -8.0f * fog * fog);
+    break;
+  case 6:  // backward exp
+    fog = 1.0f - fog;
+    fog = pow(2.0f, -8.0f * fog);
+    break;
+  case 7:  // backward exp2
+    fog = 1.0f - fog;
+    fog = pow(2.0f, -8.0f * fog * fog);
+    break;
+  }
+  return fog;
+}
+
+#ifdef _M_X86
+// The SIMD combiners work on several pixels at once, with a 32 bit lane per pixel. Each
+// component of a register is a vector of its own, indexed in the same ABGR order as the scalar
+// code, so every stage runs the same combiner equation across all lanes. SSE4.1 combines four
+// pixels at a time, AVX2 a whole span. The output is drawn four pixels at a time either way.
+static constexpr int SSE_LANES = 4;
+static constexpr int AVX2_LANES = 8;
+static_assert(Tev::MAX_PIXELS == AVX2_LANES, "The AVX2 combiners use one lane per pixel");
+static_assert(EfbInterface::PixelBlock::MAX_PIXELS == SSE_LANES,
+              "The output is drawn one SSE vector at a time");
+
+enum
+{
+  SRC_TEX = 4,
+  SRC_RAS,
+  SRC_KONST,
+  SRC_ONE,
+  SRC_HALF,
+  SRC_ZERO,
+  NUM_SOURCES
+};
+
+// Source and whether it is alpha broadcast to all components, indexed by the color input
+// selector
+static constexpr u8 s_color_sources[16][2] = {
+    {0, 0},       {0, 1},        {1, 0},         {1, 1},       {2, 0},       {2, 1},
+    {3, 0},       {3, 1},        {SRC_TEX, 0},   {SRC_TEX, 1}, {SRC_RAS, 0}, {SRC_RAS, 1},
+    {SRC_ONE, 0}, {SRC_HALF, 0}, {SRC_KONST, 0}, {SRC_ZERO, 0}};
+static constexpr u8 s_alpha_sources[8] = {0, 1, 2, 3, SRC_TEX, SRC_RAS, SRC_KONST, SRC_ZERO};
+
+namespace
+{
+// Parameters of a color or alpha combiner, which are the same for every lane
+struct CombinerParams
+{
+  int lshift;
+  int rounding;
+  int bias;
+  int clamp_min;
+  int clamp_max;
+  bool negate;
+  bool negate_before_shift;
+  bool rshift;
+};
+}  // Anonymous namespace
+
+static CombinerParams GetCombinerParams(u32 shift, u32 op, u32 clamp, bool alpha, int lshift,
+                                        int bias, bool rshift)
+{
+  CombinerParams params;
+  params.lshift = lshift;
+  // The color combiner rounds unless it halves the result, the alpha combiner only then
+  params.rounding = ((shift == 3) != alpha) ? 0 : (op == 1) ? 127 : 128;
+  params.bias = bias;
+  params.clamp_min = clamp ? 0 : -1024;
+  params.clamp_max = clamp ? 255 : 1023;
+  params.negate = op != 0;
+  // The color combiner negates after shifting, the alpha combiner before
+  params.negate_before_shift = alpha;
+  params.rshift = rshift;
+  return params;
+}
+
+// Turns four vectors of four lanes each from pixels into components or the other way around.
+FUNCTION_TARGET_SSR41
+static inline void Transpose(__m128i (&v)[4])
+{
+  const __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+  const __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+  const __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+  const __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm_unpacklo_epi64(t0, t1);
+  v[1] = _mm_unpackhi_epi64(t0, t1);
+  v[2] = _mm_unpacklo_epi64(t2, t3);
+  v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+FUNCTION_TARGET_SSR41
+static inline void LoadColors(const s16* const (&colors)[SSE_LANES], __m128i (&out)[4])
+{
+  for (int lane = 0; lane < SSE_LANES; lane++)
+  {
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(colors[lane]));
+    out[lane] = _mm_cvtepi16_epi32(packed);
+  }
+  Transpose(out);
+}
+
+FUNCTION_TARGET_SSR41
+static inline void StoreColors(s16* const (&colors)[SSE_LANES], int num_pixels,
+                               const __m128i (&in)[4])
+{
+  __m128i pixels[4] = {in[0], in[1], in[2], in[3]};
+  Transpose(pixels);
+  for (int lane = 0; lane < num_pixels; lane++)
+  {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(colors[lane]),
+                     _mm_packs_epi32(pixels[lane], pixels[lane]));
+  }
+}
+
+// The regular combiner equation for one component of every pixel
+FUNCTION_TARGET_SSR41
+static inline __m128i CombineLanes(__m128i a, __m128i b, __m128i c, __m128i d,
+                                   const CombinerParams& params)
+{
+  const __m128i mask_ff = _mm_set1_epi32(0xff);
+  const __m128i lshift = _mm_cvtsi32_si128(params.lshift);
+  a = _mm_and_si128(a, mask_ff);
+  b = _mm_and_si128(b, mask_ff);
+  c = _mm_and_si128(c, mask_ff);
+  // d is an 11 bit signed value
+  d = _mm_srai_epi32(_mm_slli_epi32(d, 21), 21);
+
+  // a * (256 - c) + b * c, with a single multiplication
+  c = _mm_add_epi32(c, _mm_srli_epi32(c, 7));
+  __m128i temp = _mm_add_epi32(_mm_slli_epi32(a, 8), _mm_mullo_epi32(_mm_sub_epi32(b, a), c));
+  temp = _mm_add_epi32(_mm_sll_epi32(temp, lshift), _mm_set1_epi32(params.rounding));
+
+  if (!params.negate)
+    temp = _mm_srai_epi32(temp, 8);
+  else if (params.negate_before_shift)
+    temp = _mm_srai_epi32(_mm_sub_epi32(_mm_setzero_si128(), temp), 8);
+  else
+    temp = _mm_sub_epi32(_mm_setzero_si128(), _mm_srai_epi32(temp, 8));
+
+  const __m128i bias = _mm_set1_epi32(params.bias);
+  __m128i result = _mm_add_epi32(_mm_sll_epi32(_mm_add_epi32(d, bias), lshift), temp);
+  if (params.rshift)
+    result = _mm_srai_epi32(result, 1);
+
+  return _mm_min_epi32(_mm_max_epi32(result, _mm_set1_epi32(params.clamp_min)),
+                       _mm_set1_epi32(params.clamp_max));
+}
+
+// The value which a compare mode compares for component comp
+FUNCTION_TARGET_SSR41
+static inline __m128i CompareValue(const __m128i (&v)[4], int comp, u32 shift)
+{
+  const __m128i mask_ff = _mm_set1_epi32(0xff);
+  const __m128i red = _mm_and_si128(v[Tev::RED_C], mask_ff);
+  const __m128i green = _mm_slli_epi32(_mm_and_si128(v[Tev::GRN_C], mask_ff), 8);
+  switch (shift)
+  {
+  case 0:  // R8
+    return red;
+  case 1:  // GR16
+    return _mm_or_si128(green, red);
+  case 2:  // BGR24
+    return _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v[Tev::BLU_C], mask_ff), 16),
+                        _mm_or_si128(green, red));
+  default:  // RGB8 or A8
+    return _mm_and_si128(v[comp], mask_ff);
+  }
+}
+
+// The compare mode combiner equation for one component of every pixel. a and b hold all
+// components of the inputs, since the wider comparisons look at several of them.
+FUNCTION_TARGET_SSR41
+static inline __m128i CompareLanes(const __m128i (&a)[4], const __m128i (&b)[4], int comp,
+                                   __m128i c, __m128i d, u32 shift, u32 op, u32 clamp)
+{
+  const __m128i value_a = CompareValue(a, comp, shift);
+  const __m128i value_b = CompareValue(b, comp, shift);
+  // The values have at most 24 bits, so the signed comparison works
+  const __m128i pass =
+      op ? _mm_cmpeq_epi32(value_a, value_b) : _mm_cmpgt_epi32(value_a, value_b);
+
+  c = _mm_and_si128(c, _mm_set1_epi32(0xff));
+  d = _mm_srai_epi32(_mm_slli_epi32(d, 21), 21);
+  const __m128i result = _mm_add_epi32(d, _mm_and_si128(pass, c));
+
+  return _mm_min_epi32(_mm_max_epi32(result, _mm_set1_epi32(clamp ? 0 : -1024)),
+                       _mm_set1_epi32(clamp ? 255 : 1023));
+}
+
+// SetRasColor for every lane. colors holds the packed RGBA colors of both channels, bumps the
+// alpha bump of the stage.
+FUNCTION_TARGET_SSR41
+static inline void RasLanes(const __m128i (&colors)[2], __m128i bumps, int color_chan,
+                            int swaptable, __m128i (&ras)[4])
+{
+  const __m128i mask_ff = _mm_set1_epi32(0xff);
+  switch (color_chan)
+  {
+  case 0:  // Color0
+  case 1:  // Color1
+  {
+    const __m128i color = colors[color_chan];
+    const TevKSel& ksel0 = bpmem.tevksel[swaptable];
+    const TevKSel& ksel1 = bpmem.tevksel[swaptable + 1];
+    ras[Tev::RED_C] =
+        _mm_and_si128(_mm_srl_epi32(color, _mm_cvtsi32_si128(ksel0.swap1 * 8)), mask_ff);
+    ras[Tev::GRN_C] =
+        _mm_and_si128(_mm_srl_epi32(color, _mm_cvtsi32_si128(ksel0.swap2 * 8)), mask_ff);
+    ras[Tev::BLU_C] =
+        _mm_and_si128(_mm_srl_epi32(color, _mm_cvtsi32_si128(ksel1.swap1 * 8)), mask_ff);
+    ras[Tev::ALP_C] =
+        _mm_and_si128(_mm_srl_epi32(color, _mm_cvtsi32_si128(ksel1.swap2 * 8)), mask_ff);
+    break;
+  }
+  case 5:  // alpha bump
+    ras[0] = ras[1] = ras[2] = ras[3] = bumps;
+    break;
+  case 6:  // alpha bump normalized
+    ras[0] = ras[1] = ras[2] = ras[3] = _mm_or_si128(bumps, _mm_srli_epi32(bumps, 5));
+    break;
+  default:  // zero
+    ras[0] = ras[1] = ras[2] = ras[3] = _mm_setzero_si128();
+    break;
+  }
+}
+
+FUNCTION_TARGET_SSR41
+void Tev::CombineSIMD(int first_pixel, int num_pixels)
+{
+  // Lanes of missing pixels repeat the first one, and are never stored
+  s16* reg_ptrs[4][SSE_LANES];
+  const s16* tex_ptrs[16][SSE_LANES];
+  const u8* bump_ptrs[SSE_LANES];
+  alignas(16) u32 packed_colors[2][SSE_LANES];
+  for (int lane = 0; lane < SSE_LANES; lane++)
+  {
+    const int pixel = first_pixel + (lane < num_pixels ? lane : 0);
+    PixelState& state = m_PixelStates[pixel];
+    for (int i = 0; i < 4; i++)
+      reg_ptrs[i][lane] = state.Reg[i];
+    for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+      tex_ptrs[stageNum][lane] = state.TexColor[stageNum];
+    bump_ptrs[lane] = state.AlphaBump;
+    std::memcpy(&packed_colors[0][lane], Pixels[pixel].Color[0], sizeof(u32));
+    std::memcpy(&packed_colors[1][lane], Pixels[pixel].Color[1], sizeof(u32));
+  }
+  const __m128i colors[2] = {_mm_load_si128(reinterpret_cast<const __m128i*>(packed_colors[0])),
+                             _mm_load_si128(reinterpret_cast<const __m128i*>(packed_colors[1]))};
+
+  __m128i regs[4][4];
+  for (int i = 0; i < 4; i++)
+  {
+    // Registers are 16 bits wide, so truncate like the scalar path does
+    const auto& color = PixelShaderManager::constants.colors[i];
+    regs[i][RED_C] = _mm_set1_epi32(static_cast<s16>(color[0]));
+    regs[i][GRN_C] = _mm_set1_epi32(static_cast<s16>(color[1]));
+    regs[i][BLU_C] = _mm_set1_epi32(static_cast<s16>(color[2]));
+    regs[i][ALP_C] = _mm_set1_epi32(static_cast<s16>(color[3]));
+  }
+
+  __m128i tex[4];
+  __m128i ras[4];
+  __m128i konst[4];
+  const __m128i one[4] = {_mm_set1_epi32(255), _mm_set1_epi32(255), _mm_set1_epi32(255),
+                          _mm_set1_epi32(255)};
+  const __m128i half[4] = {_mm_set1_epi32(128), _mm_set1_epi32(128), _mm_set1_epi32(128),
+                           _mm_set1_epi32(128)};
+  const __m128i zero[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(),
+                           _mm_setzero_si128()};
+  const __m128i* const sources[NUM_SOURCES] = {regs[0], regs[1], regs[2], regs[3], tex,
+                                               ras,     konst,   one,     half,    zero};
 
-    // set color
-    SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
+  for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+  {
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
 
-    // combine inputs
-    InputRegType inputs[4];
-    for (int i = 0; i < 3; i++)
+    SetStageKonst(stageNum);
+    for (int comp = 0; comp < 4; comp++)
+      konst[comp] = _mm_set1_epi32(StageKonst[comp]);
+
+    LoadColors(tex_ptrs[stageNum], tex);
+
+    const int color_chan = bpmem.tevorders[stageNum >> 1].getColorChan(stageNum & 1);
+    alignas(16) s32 bumps[SSE_LANES] = {};
+    if (color_chan == 5 || color_chan == 6)
+    {
+      for (int lane = 0; lane < SSE_LANES; lane++)
+        bumps[lane] = bump_ptrs[lane][stageNum];
+    }
+    RasLanes(colors, _mm_load_si128(reinterpret_cast<const __m128i*>(bumps)), color_chan,
+             ac.rswap * 2, ras);
+
+    // All inputs are read before either destination is written
+    __m128i a[4];
+    __m128i b[4];
+    __m128i c[4];
+    __m128i d[4];
+    for (int comp = BLU_C; comp <= RED_C; comp++)
     {
-      inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
-      inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
-      inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
-      inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+      a[comp] = sources[s_color_sources[cc.a][0]][s_color_sources[cc.a][1] ? ALP_C : comp];
+      b[comp] = sources[s_color_sources[cc.b][0]][s_color_sources[cc.b][1] ? ALP_C : comp];
+      c[comp] = sources[s_color_sources[cc.c][0]][s_color_sources[cc.c][1] ? ALP_C : comp];
+      d[comp] = sources[s_color_sources[cc.d][0]][s_color_sources[cc.d][1] ? ALP_C : comp];
     }
-    inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
-    inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
-    inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
-    inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
+    a[ALP_C] = sources[s_alpha_sources[ac.a]][ALP_C];
+    b[ALP_C] = sources[s_alpha_sources[ac.b]][ALP_C];
+    c[ALP_C] = sources[s_alpha_sources[ac.c]][ALP_C];
+    d[ALP_C] = sources[s_alpha_sources[ac.d]][ALP_C];
 
+    __m128i color[4];
     if (cc.bias != 3)
-      DrawColorRegular(cc, inputs);
+    {
+      const CombinerParams params =
+          GetCombinerParams(cc.shift, cc.op, cc.clamp, false, m_ScaleLShiftLUT[cc.shift],
+                            m_BiasLUT[cc.bias], m_ScaleRShiftLUT[cc.shift] != 0);
+      for (int comp = BLU_C; comp <= RED_C; comp++)
+        color[comp] = CombineLanes(a[comp], b[comp], c[comp], d[comp], params);
+    }
     else
-      DrawColorCompare(cc, inputs);
+    {
+      for (int comp = BLU_C; comp <= RED_C; comp++)
+        color[comp] = CompareLanes(a, b, comp, c[comp], d[comp], cc.shift, cc.op, cc.clamp);
+    }
+
+    __m128i alpha;
+    if (ac.bias != 3)
+    {
+      const CombinerParams params =
+          GetCombinerParams(ac.shift, ac.op, ac.clamp, true, m_ScaleLShiftLUT[ac.shift],
+                            m_BiasLUT[ac.bias], m_ScaleRShiftLUT[ac.shift] != 0);
+      alpha = CombineLanes(a[ALP_C], b[ALP_C], c[ALP_C], d[ALP_C], params);
+    }
+    else
+    {
+      alpha = CompareLanes(a, b, ALP_C, c[ALP_C], d[ALP_C], ac.shift, ac.op, ac.clamp);
+    }
+
+    for (int comp = BLU_C; comp <= RED_C; comp++)
+      regs[cc.dest][comp] = color[comp];
+    regs[ac.dest][ALP_C] = alpha;
+  }
+
+  for (int i = 0; i < 4; i++)
+    StoreColors(reg_ptrs[i], num_pixels, regs[i]);
+}
+
+FUNCTION_TARGET_SSR41
+static inline __m128i AlphaCompareSIMD(__m128i alpha, int ref, AlphaTest::CompareMode comp)
+{
+  const __m128i ref_vec = _mm_set1_epi32(ref);
+  switch (comp)
+  {
+  case AlphaTest::NEVER:
+    return _mm_setzero_si128();
+  case AlphaTest::LEQUAL:
+    return _mm_cmpeq_epi32(_mm_min_epi32(alpha, ref_vec), alpha);
+  case AlphaTest::LESS:
+    return _mm_cmplt_epi32(alpha, ref_vec);
+  case AlphaTest::GEQUAL:
+    return _mm_cmpeq_epi32(_mm_max_epi32(alpha, ref_vec), alpha);
+  case AlphaTest::GREATER:
+    return _mm_cmpgt_epi32(alpha, ref_vec);
+  case AlphaTest::EQUAL:
+    return _mm_cmpeq_epi32(alpha, ref_vec);
+  case AlphaTest::NEQUAL:
+    return _mm_xor_si128(_mm_cmpeq_epi32(alpha, ref_vec), _mm_set1_epi32(-1));
+  case AlphaTest::ALWAYS:
+  default:
+    return _mm_set1_epi32(-1);
+  }
+}
+
+FUNCTION_TARGET_SSR41
+int Tev::AlphaTestSIMD(int first_pixel, int num_pixels) const
+{
+  const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+
+  alignas(16) s32 alphas[SSE_LANES] = {};
+  for (int lane = 0; lane < num_pixels; lane++)
+    alphas[lane] = static_cast<u8>(m_PixelStates[first_pixel + lane].Reg[alpha_index][ALP_C]);
+  const __m128i alpha = _mm_load_si128(reinterpret_cast<const __m128i*>(alphas));
+
+  const __m128i comp0 = AlphaCompareSIMD(alpha, bpmem.alpha_test.ref0, bpmem.alpha_test.comp0);
+  const __m128i comp1 = AlphaCompareSIMD(alpha, bpmem.alpha_test.ref1, bpmem.alpha_test.comp1);
+
+  __m128i pass;
+  switch (bpmem.alpha_test.logic)
+  {
+  case 0:
+    pass = _mm_and_si128(comp0, comp1);  // and
+    break;
+  case 1:
+    pass = _mm_or_si128(comp0, comp1);  // or
+    break;
+  case 2:
+    pass = _mm_xor_si128(comp0, comp1);  // xor
+    break;
+  case 3:
+    pass = _mm_xor_si128(_mm_xor_si128(comp0, comp1), _mm_set1_epi32(-1));  // xnor
+    break;
+  default:
+    pass = _mm_set1_epi32(-1);
+    break;
+  }
+
+  return _mm_movemask_ps(_mm_castsi128_ps(pass)) & ((1 << num_pixels) - 1);
+}
+
+// The AVX2 versions of the above, for all pixels of a span. The lower half of each vector holds
+// the first four pixels.
+FUNCTION_TARGET_AVX2
+static inline void LoadColors8(const s16* const (&colors)[AVX2_LANES], __m256i (&out)[4])
+{
+  const s16* const lo_colors[SSE_LANES] = {colors[0], colors[1], colors[2], colors[3]};
+  const s16* const hi_colors[SSE_LANES] = {colors[4], colors[5], colors[6], colors[7]};
+  __m128i lo[4];
+  __m128i hi[4];
+  LoadColors(lo_colors, lo);
+  LoadColors(hi_colors, hi);
+  for (int comp = 0; comp < 4; comp++)
+    out[comp] = _mm256_inserti128_si256(_mm256_castsi128_si256(lo[comp]), hi[comp], 1);
+}
+
+FUNCTION_TARGET_AVX2
+static inline void StoreColors8(s16* const (&colors)[AVX2_LANES], int num_pixels,
+                                const __m256i (&in)[4])
+{
+  s16* const lo_colors[SSE_LANES] = {colors[0], colors[1], colors[2], colors[3]};
+  s16* const hi_colors[SSE_LANES] = {colors[4], colors[5], colors[6], colors[7]};
+  __m128i lo[4];
+  __m128i hi[4];
+  for (int comp = 0; comp < 4; comp++)
+  {
+    lo[comp] = _mm256_castsi256_si128(in[comp]);
+    hi[comp] = _mm256_extracti128_si256(in[comp], 1);
+  }
+  StoreColors(lo_colors, std::min(num_pixels, SSE_LANES), lo);
+  if (num_pixels > SSE_LANES)
+    StoreColors(hi_colors, num_pixels - SSE_LANES, hi);
+}
+
+FUNCTION_TARGET_AVX2
+static inline __m256i CombineLanes8(__m256i a, __m256i b, __m256i c, __m256i d,
+                                    const CombinerParams& params)
+{
+  const __m256i mask_ff = _mm256_set1_epi32(0xff);
+  const __m128i lshift = _mm_cvtsi32_si128(params.lshift);
+  a = _mm256_and_si256(a, mask_ff);
+  b = _mm256_and_si256(b, mask_ff);
+  c = _mm256_and_si256(c, mask_ff);
+  d = _mm256_srai_epi32(_mm256_slli_epi32(d, 21), 21);
+
+  c = _mm256_add_epi32(c, _mm256_srli_epi32(c, 7));
+  __m256i temp =
+      _mm256_add_epi32(_mm256_slli_epi32(a, 8), _mm256_mullo_epi32(_mm256_sub_epi32(b, a), c));
+  temp = _mm256_add_epi32(_mm256_sll_epi32(temp, lshift), _mm256_set1_epi32(params.rounding));
+
+  if (!params.negate)
+    temp = _mm256_srai_epi32(temp, 8);
+  else if (params.negate_before_shift)
+    temp = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_setzero_si256(), temp), 8);
+  else
+    temp = _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_srai_epi32(temp, 8));
+
+  const __m256i bias = _mm256_set1_epi32(params.bias);
+  __m256i result = _mm256_add_epi32(_mm256_sll_epi32(_mm256_add_epi32(d, bias), lshift), temp);
+  if (params.rshift)
+    result = _mm256_srai_epi32(result, 1);
+
+  return _mm256_min_epi32(_mm256_max_epi32(result, _mm256_set1_epi32(params.clamp_min)),
+                          _mm256_set1_epi32(params.clamp_max));
+}
+
+FUNCTION_TARGET_AVX2
+static inline __m256i CompareValue8(const __m256i (&v)[4], int comp, u32 shift)
+{
+  const __m256i mask_ff = _mm256_set1_epi32(0xff);
+  const __m256i red = _mm256_and_si256(v[Tev::RED_C], mask_ff);
+  const __m256i green = _mm256_slli_epi32(_mm256_and_si256(v[Tev::GRN_C], mask_ff), 8);
+  switch (shift)
+  {
+  case 0:  // R8
+    return red;
+  case 1:  // GR16
+    return _mm256_or_si256(green, red);
+  case 2:  // BGR24
+    return _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(v[Tev::BLU_C], mask_ff), 16),
+                           _mm256_or_si256(green, red));
+  default:  // RGB8 or A8
+    return _mm256_and_si256(v[comp], mask_ff);
+  }
+}
+
+FUNCTION_TARGET_AVX2
+static inline __m256i CompareLanes8(const __m256i (&a)[4], const __m256i (&b)[4], int comp,
+                                    __m256i c, __m256i d, u32 shift, u32 op, u32 clamp)
+{
+  const __m256i value_a = CompareValue8(a, comp, shift);
+  const __m256i value_b = CompareValue8(b, comp, shift);
+  const __m256i pass =
+      op ? _mm256_cmpeq_epi32(value_a, value_b) : _mm256_cmpgt_epi32(value_a, value_b);
+
+  c = _mm256_and_si256(c, _mm256_set1_epi32(0xff));
+  d = _mm256_srai_epi32(_mm256_slli_epi32(d, 21), 21);
+  const __m256i result = _mm256_add_epi32(d, _mm256_and_si256(pass, c));
+
+  return _mm256_min_epi32(_mm256_max_epi32(result, _mm256_set1_epi32(clamp ? 0 : -1024)),
+                          _mm256_set1_epi32(clamp ? 255 : 1023));
+}
+
+FUNCTION_TARGET_AVX2
+static inline void RasLanes8(const __m256i (&colors)[2], __m256i bumps, int color_chan,
+                             int swaptable, __m256i (&ras)[4])
+{
+  const __m256i mask_ff = _mm256_set1_epi32(0xff);
+  switch (color_chan)
+  {
+  case 0:  // Color0
+  case 1:  // Color1
+  {
+    const __m256i color = colors[color_chan];
+    const TevKSel& ksel0 = bpmem.tevksel[swaptable];
+    const TevKSel& ksel1 = bpmem.tevksel[swaptable + 1];
+    ras[Tev::RED_C] =
+        _mm256_and_si256(_mm256_srl_epi32(color, _mm_cvtsi32_si128(ksel0.swap1 * 8)), mask_ff);
+    ras[Tev::GRN_C] =
+        _mm256_and_si256(_mm256_srl_epi32(color, _mm_cvtsi32_si128(ksel0.swap2 * 8)), mask_ff);
+    ras[Tev::BLU_C] =
+        _mm256_and_si256(_mm256_srl_epi32(color, _mm_cvtsi32_si128(ksel1.swap1 * 8)), mask_ff);
+    ras[Tev::ALP_C] =
+        _mm256_and_si256(_mm256_srl_epi32(color, _mm_cvtsi32_si128(ksel1.swap2 * 8)), mask_ff);
+    break;
+  }
+  case 5:  // alpha bump
+    ras[0] = ras[1] = ras[2] = ras[3] = bumps;
+    break;
+  case 6:  // alpha bump normalized
+    ras[0] = ras[1] = ras[2] = ras[3] = _mm256_or_si256(bumps, _mm256_srli_epi32(bumps, 5));
+    break;
+  default:  // zero
+    ras[0] = ras[1] = ras[2] = ras[3] = _mm256_setzero_si256();
+    break;
+  }
+}
+
+FUNCTION_TARGET_AVX2
+void Tev::CombineAVX2(int num_pixels)
+{
+  s16* reg_ptrs[4][AVX2_LANES];
+  const s16* tex_ptrs[16][AVX2_LANES];
+  const u8* bump_ptrs[AVX2_LANES];
+  alignas(32) u32 packed_colors[2][AVX2_LANES];
+  for (int lane = 0; lane < AVX2_LANES; lane++)
+  {
+    const int pixel = lane < num_pixels ? lane : 0;
+    PixelState& state = m_PixelStates[pixel];
+    for (int i = 0; i < 4; i++)
+      reg_ptrs[i][lane] = state.Reg[i];
+    for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+      tex_ptrs[stageNum][lane] = state.TexColor[stageNum];
+    bump_ptrs[lane] = state.AlphaBump;
+    std::memcpy(&packed_colors[0][lane], Pixels[pixel].Color[0], sizeof(u32));
+    std::memcpy(&packed_colors[1][lane], Pixels[pixel].Color[1], sizeof(u32));
+  }
+  const __m256i colors[2] = {
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(packed_colors[0])),
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(packed_colors[1]))};
+
+  __m256i regs[4][4];
+  for (int i = 0; i < 4; i++)
+  {
+    const auto& color = PixelShaderManager::constants.colors[i];
+    regs[i][RED_C] = _mm256_set1_epi32(static_cast<s16>(color[0]));
+    regs[i][GRN_C] = _mm256_set1_epi32(static_cast<s16>(color[1]));
+    regs[i][BLU_C] = _mm256_set1_epi32(static_cast<s16>(color[2]));
+    regs[i][ALP_C] = _mm256_set1_epi32(static_cast<s16>(color[3]));
+  }
+
+  __m256i tex[4];
+  __m256i ras[4];
+  __m256i konst[4];
+  const __m256i one[4] = {_mm256_set1_epi32(255), _mm256_set1_epi32(255),
+                          _mm256_set1_epi32(255), _mm256_set1_epi32(255)};
+  const __m256i half[4] = {_mm256_set1_epi32(128), _mm256_set1_epi32(128),
+                           _mm256_set1_epi32(128), _mm256_set1_epi32(128)};
+  const __m256i zero[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                           _mm256_setzero_si256(), _mm256_setzero_si256()};
+  const __m256i* const sources[NUM_SOURCES] = {regs[0], regs[1], regs[2], regs[3], tex,
+                                               ras,     konst,   one,     half,    zero};
+
+  for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+  {
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+    SetStageKonst(stageNum);
+    for (int comp = 0; comp < 4; comp++)
+      konst[comp] = _mm256_set1_epi32(StageKonst[comp]);
+
+    LoadColors8(tex_ptrs[stageNum], tex);
 
-    if (cc.clamp)
+    const int color_chan = bpmem.tevorders[stageNum >> 1].getColorChan(stageNum & 1);
+    alignas(32) s32 bumps[AVX2_LANES] = {};
+    if (color_chan == 5 || color_chan == 6)
     {
-      Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+      for (int lane = 0; lane < AVX2_LANES; lane++)
+        bumps[lane] = bump_ptrs[lane][stageNum];
+    }
+    RasLanes8(colors, _mm256_load_si256(reinterpret_cast<const __m256i*>(bumps)), color_chan,
+              ac.rswap * 2, ras);
+
+    __m256i a[4];
+    __m256i b[4];
+    __m256i c[4];
+    __m256i d[4];
+    for (int comp = BLU_C; comp <= RED_C; comp++)
+    {
+      a[comp] = sources[s_color_sources[cc.a][0]][s_color_sources[cc.a][1] ? ALP_C : comp];
+      b[comp] = sources[s_color_sources[cc.b][0]][s_color_sources[cc.b][1] ? ALP_C : comp];
+      c[comp] = sources[s_color_sources[cc.c][0]][s_color_sources[cc.c][1] ? ALP_C : comp];
+      d[comp] = sources[s_color_sources[cc.d][0]][s_color_sources[cc.d][1] ? ALP_C : comp];
+    }
+    a[ALP_C] = sources[s_alpha_sources[ac.a]][ALP_C];
+    b[ALP_C] = sources[s_alpha_sources[ac.b]][ALP_C];
+    c[ALP_C] = sources[s_alpha_sources[ac.c]][ALP_C];
+    d[ALP_C] = sources[s_alpha_sources[ac.d]][ALP_C];
+
+    __m256i color[4];
+    if (cc.bias != 3)
+    {
+      const CombinerParams params =
+          GetCombinerParams(cc.shift, cc.op, cc.clamp, false, m_ScaleLShiftLUT[cc.shift],
+                            m_BiasLUT[cc.bias], m_ScaleRShiftLUT[cc.shift] != 0);
+      for (int comp = BLU_C; comp <= RED_C; comp++)
+        color[comp] = CombineLanes8(a[comp], b[comp], c[comp], d[comp], params);
     }
     else
     {
-      Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+      for (int comp = BLU_C; comp <= RED_C; comp++)
+        color[comp] = CompareLanes8(a, b, comp, c[comp], d[comp], cc.shift, cc.op, cc.clamp);
     }
 
+    __m256i alpha;
     if (ac.bias != 3)
-      DrawAlphaRegular(ac, inputs);
+    {
+      const CombinerParams params =
+          GetCombinerParams(ac.shift, ac.op, ac.clamp, true, m_ScaleLShiftLUT[ac.shift],
+                            m_BiasLUT[ac.bias], m_ScaleRShiftLUT[ac.shift] != 0);
+      alpha = CombineLanes8(a[ALP_C], b[ALP_C], c[ALP_C], d[ALP_C], params);
+    }
     else
-      DrawAlphaCompare(ac, inputs);
+    {
+      alpha = CompareLanes8(a, b, ALP_C, c[ALP_C], d[ALP_C], ac.shift, ac.op, ac.clamp);
+    }
+
+    for (int comp = BLU_C; comp <= RED_C; comp++)
+      regs[cc.dest][comp] = color[comp];
+    regs[ac.dest][ALP_C] = alpha;
+  }
+
+  for (int i = 0; i < 4; i++)
+    StoreColors8(reg_ptrs[i], num_pixels, regs[i]);
+}
+
+FUNCTION_TARGET_AVX2
+static inline __m256i AlphaCompareAVX2(__m256i alpha, int ref, AlphaTest::CompareMode comp)
+{
+  const __m256i ref_vec = _mm256_set1_epi32(ref);
+  switch (comp)
+  {
+  case AlphaTest::NEVER:
+    return _mm256_setzero_si256();
+  case AlphaTest::LEQUAL:
+    return _mm256_cmpeq_epi32(_mm256_min_epi32(alpha, ref_vec), alpha);
+  case AlphaTest::LESS:
+    return _mm256_cmpgt_epi32(ref_vec, alpha);
+  case AlphaTest::GEQUAL:
+    return _mm256_cmpeq_epi32(_mm256_max_epi32(alpha, ref_vec), alpha);
+  case AlphaTest::GREATER:
+    return _mm256_cmpgt_epi32(alpha, ref_vec);
+  case AlphaTest::EQUAL:
+    return _mm256_cmpeq_epi32(alpha, ref_vec);
+  case AlphaTest::NEQUAL:
+    return _mm256_xor_si256(_mm256_cmpeq_epi32(alpha, ref_vec), _mm256_set1_epi32(-1));
+  case AlphaTest::ALWAYS:
+  default:
+    return _mm256_set1_epi32(-1);
+  }
+}
+
+FUNCTION_TARGET_AVX2
+int Tev::AlphaTestAVX2(int num_pixels) const
+{
+  const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+
+  alignas(32) s32 alphas[AVX2_LANES] = {};
+  for (int lane = 0; lane < num_pixels; lane++)
+    alphas[lane] = static_cast<u8>(m_PixelStates[lane].Reg[alpha_index][ALP_C]);
+  const __m256i alpha = _mm256_load_si256(reinterpret_cast<const __m256i*>(alphas));
+
+  const __m256i comp0 = AlphaCompareAVX2(alpha, bpmem.alpha_test.ref0, bpmem.alpha_test.comp0);
+  const __m256i comp1 = AlphaCompareAVX2(alpha, bpmem.alpha_test.ref1, bpmem.alpha_test.comp1);
+
+  __m256i pass;
+  switch (bpmem.alpha_test.logic)
+  {
+  case 0:
+    pass = _mm256_and_si256(comp0, comp1);  // and
+    break;
+  case 1:
+    pass = _mm256_or_si256(comp0, comp1);  // or
+    break;
+  case 2:
+    pass = _mm256_xor_si256(comp0, comp1);  // xor
+    break;
+  case 3:
+    pass = _mm256_xor_si256(_mm256_xor_si256(comp0, comp1), _mm256_set1_epi32(-1));  // xnor
+    break;
+  default:
+    pass = _mm256_set1_epi32(-1);
+    break;
+  }
+
+  return _mm256_movemask_ps(_mm256_castsi256_ps(pass)) & ((1 << num_pixels) - 1);
+}
+
+// The fog color blended into one component of every lane, which holds a byte at shift
+FUNCTION_TARGET_SSR41
+static inline __m128i FogComponent(__m128i color, int shift, __m128i fog_int, __m128i inv_fog,
+                                   u32 fog_color)
+{
+  const __m128i mask_ff = _mm_set1_epi32(0xff);
+  const __m128i comp = _mm_and_si128(_mm_srli_epi32(color, shift), mask_ff);
+  const __m128i blended = _mm_add_epi32(_mm_mullo_epi32(comp, inv_fog),
+                                        _mm_mullo_epi32(fog_int, _mm_set1_epi32(fog_color)));
+  return _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(blended, 8), mask_ff), shift);
+}
+
+// DrawOutput for up to four pixels starting at first_pixel. Bit i of mask is set if pixel
+// first_pixel + i passed the alpha test.
+FUNCTION_TARGET_SSR41
+void Tev::DrawOutputSIMD(int first_pixel, int num_pixels, int mask)
+{
+  const u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
+  const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+
+  // Lanes of missing pixels repeat the first one, and are masked out
+  EfbInterface::PixelBlock block;
+  block.mask = mask;
+  alignas(16) s32 x[SSE_LANES];
+  const s16* tex_ptrs[SSE_LANES];
+  for (int lane = 0; lane < SSE_LANES; lane++)
+  {
+    const int pixel = first_pixel + (lane < num_pixels ? lane : 0);
+    const PixelInput& input = Pixels[pixel];
+    const PixelState& state = m_PixelStates[pixel];
+
+    _assert_(input.Position[0] >= 0 && input.Position[0] < EFB_WIDTH);
+    _assert_(input.Position[1] >= 0 && input.Position[1] < EFB_HEIGHT);
+
+    x[lane] = input.Position[0];
+    block.x[lane] = input.Position[0];
+    block.y[lane] = input.Position[1];
+    block.z[lane] = input.Position[2];
+    block.color[lane] = static_cast<u8>(state.Reg[alpha_index][ALP_C]) |
+                        static_cast<u8>(state.Reg[color_index][BLU_C]) << 8 |
+                        static_cast<u8>(state.Reg[color_index][GRN_C]) << 16 |
+                        static_cast<u8>(state.Reg[color_index][RED_C]) << 24;
+    tex_ptrs[lane] = state.TexColor[bpmem.genMode.numtevstages];
+  }
 
-    if (ac.clamp)
-      Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
+  __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.z));
+
+  // z texture
+  if (bpmem.ztex2.op)
+  {
+    __m128i tex[4];
+    LoadColors(tex_ptrs, tex);
+
+    __m128i ztex;
+    switch (bpmem.ztex2.type)
+    {
+    case 0:  // 8 bit
+      ztex = tex[ALP_C];
+      break;
+    case 1:  // 16 bit
+      ztex = _mm_or_si128(_mm_slli_epi32(tex[ALP_C], 8), tex[RED_C]);
+      break;
+    case 2:  // 24 bit
+      ztex = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(tex[RED_C], 16),
+                                       _mm_slli_epi32(tex[GRN_C], 8)),
+                          tex[BLU_C]);
+      break;
+    default:
+      ztex = _mm_setzero_si128();
+      break;
+    }
+    ztex = _mm_add_epi32(ztex, _mm_set1_epi32(bpmem.ztex1.bias));
+
+    if (bpmem.ztex2.op == ZTEXTURE_ADD)
+      ztex = _mm_add_epi32(ztex, z);
+
+    z = _mm_and_si128(ztex, _mm_set1_epi32(0x00ffffff));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(block.z), z);
+  }
+
+  // fog
+  if (bpmem.fog.c_proj_fsel.fsel)
+  {
+    __m128 ze;
+
+    if (bpmem.fog.c_proj_fsel.proj == 0)
+    {
+      // perspective
+      // ze = A/(B - (Zs >> B_SHF))
+      const __m128i denom = _mm_sub_epi32(_mm_set1_epi32(bpmem.fog.b_magnitude),
+                                          _mm_srl_epi32(z, _mm_cvtsi32_si128(bpmem.fog.b_shift)));
+      // in addition downscale magnitude and zs to 0.24 bits
+      ze = _mm_div_ps(_mm_set1_ps(bpmem.fog.a.GetA() * 16777215.0f), _mm_cvtepi32_ps(denom));
+    }
     else
-      Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+    {
+      // orthographic
+      // ze = a*Zs
+      // in addition downscale zs to 0.24 bits
+      ze = _mm_mul_ps(_mm_set1_ps(bpmem.fog.a.GetA()),
+                      _mm_div_ps(_mm_cvtepi32_ps(z), _mm_set1_ps(16777215.0f)));
+    }
 
-#if ALLOW_TEV_DUMPS
-    if (g_ActiveConfig.bDumpTevStages)
+    // The range adjustment and the exponential curves need sqrt and pow, so they go lane by lane
+    alignas(16) float lanes[SSE_LANES];
+    if (bpmem.fogRange.Base.Enabled)
     {
-      u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
-      DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+      _mm_store_ps(lanes, ze);
+      for (int lane = 0; lane < SSE_LANES; lane++)
+        lanes[lane] *= GetFogRangeAdjustment(x[lane]);
+      ze = _mm_load_ps(lanes);
     }
-#endif
+
+    ze = _mm_sub_ps(ze, _mm_set1_ps(bpmem.fog.c_proj_fsel.GetC()));
+
+    // clamp 0 to 1, keeping NaNs like the scalar code
+    __m128 fog = _mm_blendv_ps(ze, _mm_set1_ps(1.0f), _mm_cmpgt_ps(ze, _mm_set1_ps(1.0f)));
+    fog = _mm_blendv_ps(fog, _mm_setzero_ps(), _mm_cmplt_ps(ze, _mm_setzero_ps()));
+
+    if (bpmem.fog.c_proj_fsel.fsel >= 4)
+    {
+      _mm_store_ps(lanes, fog);
+      for (float& lane : lanes)
+        lane = ApplyFogFunction(lane);
+      fog = _mm_load_ps(lanes);
+    }
+
+    // lerp from output to fog color. NaNs turn into 0, as they do for the scalar conversion.
+    const __m128 scaled = _mm_mul_ps(fog, _mm_set1_ps(256.0f));
+    const __m128i fog_int = _mm_and_si128(_mm_cvttps_epi32(scaled),
+                                          _mm_castps_si128(_mm_cmpord_ps(scaled, scaled)));
+    const __m128i inv_fog = _mm_sub_epi32(_mm_set1_epi32(256), fog_int);
+
+    __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.color));
+    __m128i fogged = _mm_and_si128(color, _mm_set1_epi32(0xff));
+    fogged = _mm_or_si128(fogged, FogComponent(color, 8, fog_int, inv_fog, bpmem.fog.color.b));
+    fogged = _mm_or_si128(fogged, FogComponent(color, 16, fog_int, inv_fog, bpmem.fog.color.g));
+    fogged = _mm_or_si128(fogged, FogComponent(color, 24, fog_int, inv_fog, bpmem.fog.color.r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(block.color), fogged);
+  }
+
+  const bool late_ztest = !bpmem.zcontrol.early_ztest || !g_ActiveConfig.bZComploc;
+  if (late_ztest && bpmem.zmode.testenable)
+  {
+    // TODO: Check against hw if these values get incremented even if depth testing is disabled
+    counters.perf_pixels[PQ_ZCOMP_INPUT] += CountSetBits(block.mask);
+
+    block.mask = EfbInterface::ZCompareBlock(block);
+    if (block.mask == 0)
+      return;
+
+    counters.perf_pixels[PQ_ZCOMP_OUTPUT] += CountSetBits(block.mask);
   }
 
+  for (int lane = 0; lane < SSE_LANES; lane++)
+  {
+    if (!(block.mask & (1 << lane)))
+      continue;
+
+    counters.bounding_box[BoundingBox::LEFT] =
+        std::min(block.x[lane], counters.bounding_box[BoundingBox::LEFT]);
+    counters.bounding_box[BoundingBox::RIGHT] =
+        std::max(block.x[lane], counters.bounding_box[BoundingBox::RIGHT]);
+    counters.bounding_box[BoundingBox::TOP] =
+        std::min(block.y[lane], counters.bounding_box[BoundingBox::TOP]);
+    counters.bounding_box[BoundingBox::BOTTOM] =
+        std::max(block.y[lane], counters.bounding_box[BoundingBox::BOTTOM]);
+  }
+
+  counters.tev_pixels_out += CountSetBits(block.mask);
+  counters.perf_pixels[PQ_BLEND_INPUT] += CountSetBits(block.mask);
+
+  EfbInterface::BlendTevBlock(block);
+}
+#endif
+
+void Tev::DrawOutput(int pixel)
+{
+  PixelInput& input = Pixels[pixel];
+  const PixelState& state = m_PixelStates[pixel];
+
+  _assert_(input.Position[0] >= 0 && input.Position[0] < EFB_WIDTH);
+  _assert_(input.Position[1] >= 0 && input.Position[1] < EFB_HEIGHT);
+
   // convert to 8 bits per component
   // the results of the last tev stage are put onto the screen,
   // regardless of the used destination register - TODO: Verify!
   const u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
   const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
-  u8 output[4] = {(u8)Reg[alpha_index][ALP_C], (u8)Reg[color_index][BLU_C],
-                  (u8)Reg[color_index][GRN_C], (u8)Reg[color_index][RED_C]};
+  u8 output[4] = {(u8)state.Reg[alpha_index][ALP_C], (u8)state.Reg[color_index][BLU_C],
+                  (u8)state.Reg[color_index][GRN_C], (u8)state.Reg[color_index][RED_C]};
 
-  if (!TevAlphaTest(output[ALP_C]))
-    return;
+  const s16* tex_color = state.TexColor[bpmem.genMode.numtevstages];
 
   // z texture
   if (bpmem.ztex2.op)
@@ -724,20 +1723,20 @@ void Tev::Draw()
     switch (bpmem.ztex2.type)
     {
     case 0:  // 8 bit
-      ztex += TexColor[ALP_C];
+      ztex += tex_color[ALP_C];
       break;
     case 1:  // 16 bit
-      ztex += TexColor[ALP_C] << 8 | TexColor[RED_C];
+      ztex += tex_color[ALP_C] << 8 | tex_color[RED_C];
       break;
     case 2:  // 24 bit
-      ztex += TexColor[RED_C] << 16 | TexColor[GRN_C] << 8 | TexColor[BLU_C];
+      ztex += tex_color[RED_C] << 16 | tex_color[GRN_C] << 8 | tex_color[BLU_C];
       break;
     }
 
     if (bpmem.ztex2.op == ZTEXTURE_ADD)
-      ztex += Position[2];
+      ztex += input.Position[2];
 
-    Position[2] = ztex & 0x00ffffff;
+    input.Position[2] = ztex & 0x00ffffff;
   }
 
   // fog
@@ -749,7 +1748,7 @@ void Tev::Draw()
     {
       // perspective
       // ze = A/(B - (Zs >> B_SHF))
-      const s32 denom = bpmem.fog.b_magnitude - (Position[2] >> bpmem.fog.b_shift);
+      const s32 denom = bpmem.fog.b_magnitude - (input.Position[2] >> bpmem.fog.b_shift);
       // in addition downscale magnitude and zs to 0.24 bits
       ze = (bpmem.fog.a.GetA() * 16777215.0f) / (float)denom;
     }
@@ -758,66 +1757,17 @@ void Tev::Draw()
       // orthographic
       // ze = a*Zs
       // in addition downscale zs to 0.24 bits
-      ze = bpmem.fog.a.GetA() * ((float)Position[2] / 16777215.0f);
+      ze = bpmem.fog.a.GetA() * ((float)input.Position[2] / 16777215.0f);
     }
 
     if (bpmem.fogRange.Base.Enabled)
-    {
-      // TODO: This is untested and should definitely be checked against real hw.
-      // - No idea if offset is really normalized against the viewport width or against the
-      // projection matrix or yet something else
-      // - scaling of the "k" coefficient isn't clear either.
-
-      // First, calculate the offset from the viewport center (normalized to 0..1)
-      const float offset =
-          (Position[0] - (static_cast<s32>(bpmem.fogRange.Base.Center.Value()) - 342)) /
-          static_cast<float>(xfmem.viewport.wd);
-
-      // Based on that, choose the index such that points which are far away from the z-axis use the
-      // 10th "k" value and such that central points use the first value.
-      float floatindex = 9.f - std::abs(offset) * 9.f;
-      floatindex = (floatindex < 0.f) ? 0.f : (floatindex > 9.f) ?
-                                        9.f :
-                                        floatindex;  // TODO: This shouldn't be necessary!
-
-      // Get the two closest integer indices, look up the corresponding samples
-      const int indexlower = (int)floor(floatindex);
-      const int indexupper = indexlower + 1;
-      // Look up coefficient... Seems like multiplying by 4 makes Fortune Street work properly (fog
-      // is too strong without the factor)
-      const float klower = bpmem.fogRange.K[indexlower / 2].GetValue(indexlower % 2) * 4.f;
-      const float kupper = bpmem.fogRange.K[indexupper / 2].GetValue(indexupper % 2) * 4.f;
-
-      // linearly interpolate the samples and multiple ze by the resulting adjustment factor
-      const float factor = indexupper - floatindex;
-      const float k = klower * factor + kupper * (1.f - factor);
-      const float x_adjust = sqrt(offset * offset + k * k) / k;
-      ze *= x_adjust;  // NOTE: This is basically dividing by a cosine (hidden behind
-                       // GXInitFogAdjTable): 1/cos = c/b = sqrt(a^2+b^2)/b
-    }
+      ze *= GetFogRangeAdjustment(input.Position[0]);
 
     ze -= bpmem.fog.c_proj_fsel.GetC();
 
     // clamp 0 to 1
     float fog = (ze < 0.0f) ? 0.0f : ((ze > 1.0f) ? 1.0f : ze);
-
-    switch (bpmem.fog.c_proj_fsel.fsel)
-    {
-    case 4:  // exp
-      fog = 1.0f - pow(2.0f, -8.0f * fog);
-      break;
-    case 5:  // exp2
-      fog = 1.0f - pow(2.0f, -8.0f * fog * fog);
-      break;
-    case 6:  // backward exp
-      fog = 1.0f - fog;
-      fog = pow(2.0f, -8.0f * fog);
-      break;
-    case 7:  // backward exp2
-      fog = 1.0f - fog;
-      fog = pow(2.0f, -8.0f * fog * fog);
-      break;
-    }
+    fog = ApplyFogFunction(fog);
 
     // lerp from output to fog color
     const u32 fogInt = (u32)(fog * 256);
@@ -832,31 +1782,31 @@ void Tev::Draw()
   if (late_ztest && bpmem.zmode.testenable)
   {
     // TODO: Check against hw if these values get incremented even if depth testing is disabled
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+    ++counters.perf_pixels[PQ_ZCOMP_INPUT];
 
-    if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
+    if (!EfbInterface::ZCompare(input.Position[0], input.Position[1], input.Position[2]))
       return;
 
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+    ++counters.perf_pixels[PQ_ZCOMP_OUTPUT];
   }
 
   // branchless bounding box update
-  BoundingBox::coords[BoundingBox::LEFT] =
-      std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-  BoundingBox::coords[BoundingBox::RIGHT] =
-      std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-  BoundingBox::coords[BoundingBox::TOP] =
-      std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-  BoundingBox::coords[BoundingBox::BOTTOM] =
-      std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+  counters.bounding_box[BoundingBox::LEFT] =
+      std::min((u16)input.Position[0], counters.bounding_box[BoundingBox::LEFT]);
+  counters.bounding_box[BoundingBox::RIGHT] =
+      std::max((u16)input.Position[0], counters.bounding_box[BoundingBox::RIGHT]);
+  counters.bounding_box[BoundingBox::TOP] =
+      std::min((u16)input.Position[1], counters.bounding_box[BoundingBox::TOP]);
+  counters.bounding_box[BoundingBox::BOTTOM] =
+      std::max((u16)input.Position[1], counters.bounding_box[BoundingBox::BOTTOM]);
 
 #if ALLOW_TEV_DUMPS
   if (g_ActiveConfig.bDumpTevStages)
   {
     for (u32 i = 0; i < bpmem.genMode.numindstages; ++i)
-      DebugUtil::CopyTempBuffer(Position[0], Position[1], INDIRECT, i, "Indirect");
+      DebugUtil::CopyTempBuffer(input.Position[0], input.Position[1], INDIRECT, i, "Indirect");
     for (u32 i = 0; i <= bpmem.genMode.numtevstages; ++i)
-      DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT, i, "Stage");
+      DebugUtil::CopyTempBuffer(input.Position[0], input.Position[1], DIRECT, i, "Stage");
   }
 
   if (g_ActiveConfig.bDumpTevTextureFetches)
@@ -865,15 +1815,79 @@ void Tev::Draw()
     {
       TwoTevStageOrders& order = bpmem.tevorders[i >> 1];
       if (order.getEnable(i & 1))
-        DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT_TFETCH, i, "TFetch");
+        DebugUtil::CopyTempBuffer(input.Position[0], input.Position[1], DIRECT_TFETCH, i, "TFetch");
     }
   }
 #endif
 
-  INCSTAT(stats.thisFrame.tevPixelsOut);
-  EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+  ++counters.tev_pixels_out;
+  ++counters.perf_pixels[PQ_BLEND_INPUT];
+
+  EfbInterface::BlendTev(input.Position[0], input.Position[1], output);
+}
+
+void Tev::Draw(int num_pixels)
+{
+  counters.tev_pixels_in += num_pixels;
+
+  bool use_simd = false;
+#ifdef _M_X86
+  use_simd = cpu_info.bSSE4_1;
+#endif
+#if ALLOW_TEV_DUMPS
+  // The dumps go through a single temporary buffer, so each pixel has to be drawn on its own
+  if (g_ActiveConfig.bDumpTevStages || g_ActiveConfig.bDumpTevTextureFetches)
+    use_simd = false;
+#endif
+
+  if (!use_simd)
+  {
+    const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+    for (int pixel = 0; pixel < num_pixels; pixel++)
+    {
+      SampleTextures(pixel);
+      CombineScalar(pixel);
+      if (TevAlphaTest((u8)m_PixelStates[pixel].Reg[alpha_index][ALP_C]))
+        DrawOutput(pixel);
+    }
+    return;
+  }
+
+#ifdef _M_X86
+  for (int pixel = 0; pixel < num_pixels; pixel++)
+    SampleTextures(pixel);
+
+  // A span with a single block fits into one SSE vector anyway
+  int passed = 0;
+  if (cpu_info.bAVX2 && num_pixels > SSE_LANES)
+  {
+    CombineAVX2(num_pixels);
+    passed = AlphaTestAVX2(num_pixels);
+  }
+  else
+  {
+    for (int first_pixel = 0; first_pixel < num_pixels; first_pixel += SSE_LANES)
+    {
+      const int count = std::min(num_pixels - first_pixel, SSE_LANES);
+      CombineSIMD(first_pixel, count);
+      passed |= AlphaTestSIMD(first_pixel, count) << first_pixel;
+    }
+  }
 
-  EfbInterface::BlendTev(Position[0], Position[1], output);
+  for (int first_pixel = 0; first_pixel < num_pixels; first_pixel += SSE_LANES)
+  {
+    const int mask = (passed >> first_pixel) & ((1 << SSE_LANES) - 1);
+    if (mask != 0)
+      DrawOutputSIMD(first_pixel, std::min(num_pixels - first_pixel, SSE_LANES), mask);
+  }
+#endif
+}
+
+void Tev::ResetCounters()
+{
+  counters = {};
+  counters.bounding_box[BoundingBox::LEFT] = 0xffff;
+  counters.bounding_box[BoundingBox::TOP] = 0xffff;
 }
 
 void Tev::SetRegColor(int reg, int comp, s16 color)
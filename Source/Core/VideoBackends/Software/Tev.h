@@ -5,9 +5,23 @@
 #pragma once
 
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/PerfQueryBase.h"
 
 class Tev
 {
+public:
+  struct TextureCoordinateType
+  {
+    signed s : 24;
+    signed t : 24;
+  };
+
+  // Pixels are drawn in spans of up to two 2x2 blocks, so that the combiners can work on all of
+  // them at once.
+  static constexpr int MAX_BLOCKS = 2;
+  static constexpr int MAX_PIXELS = 4 * MAX_BLOCKS;
+
+private:
   struct InputRegType
   {
     unsigned a : 8;
@@ -16,10 +30,13 @@ class Tev
     signed d : 11;
   };
 
-  struct TextureCoordinateType
+  // State of a pixel which is carried between the drawing steps.
+  struct PixelState
   {
-    signed s : 24;
-    signed t : 24;
+    s16 Reg[4][4];
+    // Texture color and alpha bump as seen by each stage
+    s16 TexColor[16][4];
+    u8 AlphaBump[16];
   };
 
   // color order: ABGR
@@ -57,7 +74,10 @@ class Tev
     INDIRECT = 32
   };
 
-  void SetRasColor(int colorChan, int swaptable);
+  PixelState m_PixelStates[MAX_PIXELS];
+
+  void SetRasColor(const u8 (&color)[2][4], int colorChan, int swaptable);
+  void SetStageKonst(unsigned int stageNum);
 
   void DrawColorRegular(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
   void DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
@@ -66,14 +86,34 @@ class Tev
 
   void Indirect(unsigned int stageNum, s32 s, s32 t);
 
+  void SampleTextures(int pixel);
+  void DrawStage(unsigned int stageNum, const u8 (&color)[2][4]);
+  void CombineScalar(int pixel);
+#ifdef _M_X86
+  void CombineSIMD(int first_pixel, int num_pixels);
+  int AlphaTestSIMD(int first_pixel, int num_pixels) const;
+  void CombineAVX2(int num_pixels);
+  int AlphaTestAVX2(int num_pixels) const;
+  void DrawOutputSIMD(int first_pixel, int num_pixels, int mask);
+#endif
+  void DrawOutput(int pixel);
+
 public:
-  s32 Position[3];
-  u8 Color[2][4];  // must be RGBA for correct swap table ordering
-  TextureCoordinateType Uv[8];
-  s32 IndirectLod[4];
-  bool IndirectLinear[4];
-  s32 TextureLod[16];
-  bool TextureLinear[16];
+  struct PixelInput
+  {
+    s32 Position[3];
+    u8 Color[2][4];  // must be RGBA for correct swap table ordering
+    TextureCoordinateType Uv[8];
+    // Which of the level of detail sets below the pixel uses
+    int Block;
+  };
+  PixelInput Pixels[MAX_PIXELS];
+
+  // Shared by all pixels of a block
+  s32 IndirectLod[MAX_BLOCKS][4];
+  bool IndirectLinear[MAX_BLOCKS][4];
+  s32 TextureLod[MAX_BLOCKS][16];
+  bool TextureLinear[MAX_BLOCKS][16];
 
   enum
   {
@@ -83,9 +123,24 @@ public:
     RED_C
   };
 
+  // Drawing also updates statistics, perf counters and the bounding box, which are shared
+  // between all rasterizer threads. Each Tev collects its changes here instead, and the
+  // rasterizer applies them once a batch of primitives is done.
+  struct Counters
+  {
+    u32 rasterized_pixels;
+    u32 tev_pixels_in;
+    u32 tev_pixels_out;
+    u32 perf_pixels[PQ_NUM_MEMBERS];
+    u16 bounding_box[4];
+  };
+  Counters counters;
+
   void Init();
+  void ResetCounters();
 
-  void Draw();
+  // Draws Pixels[0] to Pixels[num_pixels - 1].
+  void Draw(int num_pixels);
 
   void SetRegColor(int reg, int comp, s16 color);
 };
@@ -10,6 +10,7 @@
 #include "Common/CommonTypes.h"
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/LightingShaderGen.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
@@ -48,6 +49,8 @@ static void EndPrimitive(ShaderCode& out, const ShaderHostConfig& host_config,
 ShaderCode GenerateGeometryShaderCode(APIType ApiType, const ShaderHostConfig& host_config,
                                       const geometry_shader_uid_data* uid_data)
 {
+  INCSTAT(stats.thisFrame.numGeometryShadersGenerated);
+
   ShaderCode out;
   // Non-uid template parameters will write to the dummy data (=> gets optimized out)
 
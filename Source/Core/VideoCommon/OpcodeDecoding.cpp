@@ -83,6 +83,9 @@ void Init()
 template <bool is_preprocess>
 u8* Run(DataReader src, u32* cycles, bool in_display_list)
 {
+  if (!is_preprocess && !in_display_list)
+    stats.BeginGPUTime();
+
   u32 totalCycles = 0;
   u8* opcodeStart;
   while (true)
@@ -259,6 +262,8 @@ end:
   {
     *cycles = totalCycles;
   }
+  if (!is_preprocess && !in_display_list)
+    stats.EndGPUTime();
   return opcodeStart;
 }
 
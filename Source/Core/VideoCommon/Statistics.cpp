@@ -13,11 +13,51 @@
 
 Statistics stats;
 
+bool Statistics::s_timings_enabled = false;
+Statistics::FrameCallback Statistics::s_frame_callback;
+
+static u64 NanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              start)
+      .count();
+}
+
 void Statistics::ResetFrame()
 {
+  if (m_gpu_timer_running)
+  {
+    thisFrame.gpuTimeNs += NanosecondsSince(m_gpu_timer_start);
+    m_gpu_timer_start = std::chrono::steady_clock::now();
+  }
+
+  if (s_frame_callback)
+    s_frame_callback(thisFrame);
+
   memset(&thisFrame, 0, sizeof(ThisFrame));
 }
 
+void Statistics::SetFrameCallback(FrameCallback callback)
+{
+  s_frame_callback = std::move(callback);
+}
+
+void Statistics::BeginGPUTime()
+{
+  m_gpu_timer_running = s_timings_enabled;
+  if (m_gpu_timer_running)
+    m_gpu_timer_start = std::chrono::steady_clock::now();
+}
+
+void Statistics::EndGPUTime()
+{
+  if (!m_gpu_timer_running)
+    return;
+
+  thisFrame.gpuTimeNs += NanosecondsSince(m_gpu_timer_start);
+  m_gpu_timer_running = false;
+}
+
 void Statistics::SwapDL()
 {
   std::swap(stats.thisFrame.numDLPrims, stats.thisFrame.numPrims);
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <string>
 
+#include "Common/CommonTypes.h"
+
 struct Statistics
 {
   int numPixelShadersCreated;
@@ -61,13 +65,43 @@ struct Statistics
     int numVerticesLoaded;
     int tevPixelsIn;
     int tevPixelsOut;
+
+    int numVertexShadersGenerated;
+    int numPixelShadersGenerated;
+    int numGeometryShadersGenerated;
+
+    // Wall clock times in nanoseconds, only measured while timings are enabled. The GPU time
+    // covers all command processing, including vertex loading and texture decoding.
+    u64 gpuTimeNs;
+    u64 vertexLoaderTimeNs;
+    u64 textureDecodeTimeNs;
   };
   ThisFrame thisFrame;
   void ResetFrame();
   static void SwapDL();
 
+  // Timings need a clock read per draw, so they are only collected on request.
+  static void EnableTimings(bool enable) { s_timings_enabled = enable; }
+  static bool TimingsEnabled() { return s_timings_enabled; }
+
+  // Called from ResetFrame on the GPU thread, with the statistics of the frame that just ended.
+  using FrameCallback = std::function<void(const ThisFrame&)>;
+  static void SetFrameCallback(FrameCallback callback);
+
+  // Brackets a run of GPU commands. A swap happens in the middle of one, so the time spent before
+  // it is accounted to the frame that ended there.
+  void BeginGPUTime();
+  void EndGPUTime();
+
   static std::string ToString();
   static std::string ToStringProj();
+
+private:
+  static bool s_timings_enabled;
+  static FrameCallback s_frame_callback;
+
+  bool m_gpu_timer_running;
+  std::chrono::steady_clock::time_point m_gpu_timer_start;
 };
 
 extern Statistics stats;
@@ -86,3 +120,31 @@ extern Statistics stats;
 #define ADDSTAT(a, b) ;
 #define SETSTAT(a, x) ;
 #endif
+
+// Adds the time spent in its scope to one of the ThisFrame timings, if timings are enabled.
+class ScopedStatTimer
+{
+public:
+  explicit ScopedStatTimer(u64* counter)
+      : m_counter(Statistics::TimingsEnabled() ? counter : nullptr)
+  {
+    if (m_counter)
+      m_start = std::chrono::steady_clock::now();
+  }
+  ~ScopedStatTimer()
+  {
+    if (m_counter)
+    {
+      *m_counter += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - m_start)
+                        .count();
+    }
+  }
+
+  ScopedStatTimer(const ScopedStatTimer&) = delete;
+  ScopedStatTimer& operator=(const ScopedStatTimer&) = delete;
+
+private:
+  u64* m_counter;
+  std::chrono::steady_clock::time_point m_start;
+};
@@ -4,9 +4,12 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "Common/Align.h"
 #include "Common/Assert.h"
@@ -17,6 +20,7 @@
 #include "Common/MathUtil.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/ThreadPool.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/FifoPlayer/FifoPlayer.h"
@@ -39,20 +43,38 @@ static const u64 TEXHASH_INVALID = 0;
 // Sonic the Fighters (inside Sonic Gems Collection) loops a 64 frames animation
 static const int TEXTURE_KILL_THRESHOLD = 64;
 static const int TEXTURE_POOL_KILL_THRESHOLD = 3;
+// Approximate number of decoded bytes per band of rows. Textures smaller than this are decoded
+// without waking up the decoder threads.
+static const u32 TEXTURE_DECODE_BAND_SIZE = 64 * 1024;
 
 std::unique_ptr<TextureCacheBase> g_texture_cache;
 
 std::bitset<8> TextureCacheBase::valid_bind_points;
 
-TextureCacheBase::TCacheEntry::TCacheEntry(std::unique_ptr<AbstractTexture> tex)
-    : texture(std::move(tex))
+static std::string GetTextureDiskCacheFileName()
 {
+  const std::string cache_dir = File::GetUserPath(D_CACHE_IDX);
+  File::CreateFullPath(cache_dir);
+  return cache_dir + "Textures-" + SConfig::GetInstance().GetGameID() + ".cache";
 }
 
-TextureCacheBase::TCacheEntry::~TCacheEntry()
+// Matches the hashing done by HashMemory
+static TextureDiskCache::HashMode GetTextureDiskCacheHashMode(const VideoConfig& config)
 {
-  for (auto& reference : references)
-    reference->references.erase(this);
+  return config.bIncrementalTextureHash && config.iSafeTextureCache_ColorSamples == 0 ?
+             TextureDiskCache::HashMode::Incremental :
+             TextureDiskCache::HashMode::Full;
+}
+
+void TextureCacheBase::TCacheEntry::UnlinkReferences()
+{
+  for (TCacheEntry* reference : references)
+  {
+    std::vector<TCacheEntry*>& other_references = reference->references;
+    other_references.erase(std::remove(other_references.begin(), other_references.end(), this),
+                           other_references.end());
+  }
+  references.clear();
 }
 
 void TextureCacheBase::CheckTempSize(size_t required_size)
@@ -69,6 +91,9 @@ TextureCacheBase::TextureCacheBase()
 {
   SetBackupConfig(g_ActiveConfig);
 
+  decode_pool = std::make_unique<Common::ThreadPool>(g_ActiveConfig.GetTextureDecodeThreads(),
+                                                     "Texture Decoder");
+
   temp_size = 2048 * 2048 * 4;
   temp = static_cast<u8*>(Common::AllocateAlignedMemory(temp_size, 16));
 
@@ -79,6 +104,10 @@ TextureCacheBase::TextureCacheBase()
 
   SetHash64Function();
 
+  // Keys of the disk cache depend on the hash function
+  if (backup_config.disk_cache)
+    disk_cache.Open(GetTextureDiskCacheFileName(), GetTextureDiskCacheHashMode(g_ActiveConfig));
+
   InvalidateAllBindPoints();
 }
 
@@ -90,14 +119,15 @@ void TextureCacheBase::Invalidate()
     bound_textures[i] = nullptr;
   }
 
-  for (auto& tex : textures_by_address)
-  {
-    delete tex.second;
-  }
-  textures_by_address.clear();
-  textures_by_hash.clear();
+  textures_by_address.Clear();
+  textures_by_hash.Clear();
+  textures_by_range.Clear();
+  entry_slabs.clear();
+  free_entries.clear();
+  page_hashes.clear();
 
   texture_pool.clear();
+  texture_pool_by_config.Clear();
 }
 
 TextureCacheBase::~TextureCacheBase()
@@ -118,6 +148,7 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 
   // TODO: Invalidating texcache is really stupid in some of these cases
   if (config.iSafeTextureCache_ColorSamples != backup_config.color_samples ||
+      config.bIncrementalTextureHash != backup_config.incremental_hash ||
       config.bTexFmtOverlayEnable != backup_config.texfmt_overlay ||
       config.bTexFmtOverlayCenter != backup_config.texfmt_overlay_center ||
       config.bHiresTextures != backup_config.hires_textures ||
@@ -129,6 +160,25 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
                                        g_ActiveConfig.bTexFmtOverlayCenter);
   }
 
+  const bool hash_mode_changed =
+      config.bIncrementalTextureHash != backup_config.incremental_hash ||
+      config.iSafeTextureCache_ColorSamples != backup_config.color_samples;
+  if (config.bTextureDiskCache != backup_config.disk_cache ||
+      (config.bTextureDiskCache && hash_mode_changed))
+  {
+    if (config.bTextureDiskCache)
+      disk_cache.Open(GetTextureDiskCacheFileName(), GetTextureDiskCacheHashMode(config));
+    else
+      disk_cache.Close();
+  }
+
+  if (config.GetTextureDecodeThreads() != decode_pool->GetNumThreads())
+  {
+    decode_pool.reset();
+    decode_pool =
+        std::make_unique<Common::ThreadPool>(config.GetTextureDecodeThreads(), "Texture Decoder");
+  }
+
   if ((config.iStereoMode > 0) != backup_config.stereo_3d ||
       config.bStereoEFBMonoDepth != backup_config.efb_mono_depth)
   {
@@ -142,63 +192,63 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 
 void TextureCacheBase::Cleanup(int _frameCount)
 {
-  TexAddrCache::iterator iter = textures_by_address.begin();
-  TexAddrCache::iterator tcend = textures_by_address.end();
-  while (iter != tcend)
+  // Freeing entries doesn't move the others, so the slabs can be walked while invalidating.
+  for (const auto& slab : entry_slabs)
   {
-    if (iter->second->tmem_only)
+    for (size_t i = 0; i < ENTRY_SLAB_SIZE; ++i)
     {
-      iter = InvalidateTexture(iter);
-    }
-    else if (iter->second->frameCount == FRAMECOUNT_INVALID)
-    {
-      iter->second->frameCount = _frameCount;
-      ++iter;
-    }
-    else if (_frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount)
-    {
-      if (iter->second->IsEfbCopy())
+      TCacheEntry* entry = &slab[i];
+
+      // Skip the free entries, which don't own a texture
+      if (!entry->texture)
+        continue;
+
+      if (entry->tmem_only)
+      {
+        InvalidateTexture(entry);
+      }
+      else if (entry->frameCount == FRAMECOUNT_INVALID)
+      {
+        entry->frameCount = _frameCount;
+      }
+      else if (_frameCount > TEXTURE_KILL_THRESHOLD + entry->frameCount)
       {
-        // Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB
-        // copies living on the
-        // host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for
-        // performance reasons
-        if ((_frameCount - iter->second->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
-            iter->second->hash != iter->second->CalculateHash())
+        if (entry->IsEfbCopy())
         {
-          iter = InvalidateTexture(iter);
+          // Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB
+          // copies living on the
+          // host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for
+          // performance reasons
+          if ((_frameCount - entry->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
+              entry->hash != entry->CalculateHash())
+          {
+            InvalidateTexture(entry);
+          }
         }
         else
         {
-          ++iter;
+          InvalidateTexture(entry);
         }
       }
-      else
-      {
-        iter = InvalidateTexture(iter);
-      }
-    }
-    else
-    {
-      ++iter;
     }
   }
 
-  TexPool::iterator iter2 = texture_pool.begin();
-  TexPool::iterator tcend2 = texture_pool.end();
-  while (iter2 != tcend2)
+  size_t pool_index = 0;
+  while (pool_index < texture_pool.size())
   {
-    if (iter2->second.frameCount == FRAMECOUNT_INVALID)
+    TexPoolEntry& pool_entry = texture_pool[pool_index];
+    if (pool_entry.frameCount == FRAMECOUNT_INVALID)
     {
-      iter2->second.frameCount = _frameCount;
+      pool_entry.frameCount = _frameCount;
     }
-    if (_frameCount > TEXTURE_POOL_KILL_THRESHOLD + iter2->second.frameCount)
+    if (_frameCount > TEXTURE_POOL_KILL_THRESHOLD + pool_entry.frameCount)
     {
-      iter2 = texture_pool.erase(iter2);
+      // The last texture of the pool takes its place
+      TakeTextureFromPool(static_cast<u32>(pool_index));
     }
     else
     {
-      ++iter2;
+      ++pool_index;
     }
   }
 }
@@ -217,6 +267,8 @@ bool TextureCacheBase::TCacheEntry::OverlapsMemoryRange(u32 range_address, u32 r
 void TextureCacheBase::SetBackupConfig(const VideoConfig& config)
 {
   backup_config.color_samples = config.iSafeTextureCache_ColorSamples;
+  backup_config.incremental_hash = config.bIncrementalTextureHash;
+  backup_config.disk_cache = config.bTextureDiskCache;
   backup_config.texfmt_overlay = config.bTexFmtOverlayEnable;
   backup_config.texfmt_overlay_center = config.bTexFmtOverlayCenter;
   backup_config.hires_textures = config.bHiresTextures;
@@ -245,7 +297,7 @@ TextureCacheBase::ApplyPaletteToEntry(TCacheEntry* entry, u8* palette, TLUTForma
   decoded_entry->may_have_overlapping_textures = entry->may_have_overlapping_textures;
 
   ConvertTexture(decoded_entry, entry, palette, tlutfmt);
-  textures_by_address.emplace(entry->addr, decoded_entry);
+  AddTextureToCache(decoded_entry);
 
   return decoded_entry;
 }
@@ -279,10 +331,9 @@ void TextureCacheBase::ScaleTextureCacheEntryTo(TextureCacheBase::TCacheEntry* e
                                           new_texture->GetConfig().GetRect());
     entry->texture.swap(new_texture);
 
-    auto config = new_texture->GetConfig();
     // At this point new_texture has the old texture in it,
     // we can potentially reuse this, so let's move it back to the pool
-    texture_pool.emplace(config, TexPoolEntry(std::move(new_texture)));
+    AddTextureToPool(std::move(new_texture));
   }
   else
   {
@@ -315,14 +366,11 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
 
   u32 numBlocksX = (entry_to_update->native_width + block_width - 1) / block_width;
 
-  auto iter = FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
-  while (iter.first != iter.second)
+  FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
+  for (TCacheEntry* entry : overlapping_textures)
   {
-    TCacheEntry* entry = iter.first->second;
     if (entry != entry_to_update && entry->IsEfbCopy() && !entry->tmem_only &&
-        entry->references.count(entry_to_update) == 0 &&
-        entry->OverlapsMemoryRange(entry_to_update->addr, entry_to_update->size_in_bytes) &&
-        entry->memory_stride == numBlocksX * block_size)
+        !entry->HasReference(entry_to_update) && entry->memory_stride == numBlocksX * block_size)
     {
       if (entry->hash == entry->CalculateHash())
       {
@@ -340,7 +388,6 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
           }
           else
           {
-            ++iter.first;
             continue;
           }
         }
@@ -409,7 +456,7 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
         {
           // Remove the temporary converted texture, it won't be used anywhere else
           // TODO: It would be nice to convert and copy in one step, but this code path isn't common
-          InvalidateTexture(GetTexCacheIter(entry));
+          InvalidateTexture(entry);
         }
         else
         {
@@ -422,11 +469,9 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
       else
       {
         // If the hash does not match, this EFB copy will not be used for anything, so remove it
-        iter.first = InvalidateTexture(iter.first);
-        continue;
+        InvalidateTexture(entry);
       }
     }
-    ++iter.first;
   }
   return entry_to_update;
 }
@@ -454,6 +499,52 @@ static u32 CalculateLevelSize(u32 level_0_size, u32 level)
   return std::max(level_0_size >> level, 1u);
 }
 
+void TextureCacheBase::DecodeTextureLevels(const DecodeLevel* levels, size_t num_levels,
+                                           TextureFormat texformat, const u8* tlut,
+                                           TLUTFormat tlutfmt)
+{
+  struct Band
+  {
+    const DecodeLevel* level;
+    u32 first_row;
+    u32 num_rows;
+  };
+  std::vector<Band> bands;
+
+  // Split each level into bands of whole block rows. Bands of all levels are independent, so the
+  // mips are decoded at the same time as the base level.
+  const u32 block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+  size_t decoded_size = 0;
+  for (size_t i = 0; i < num_levels; ++i)
+  {
+    const DecodeLevel& level = levels[i];
+    const u32 block_row_size = level.expanded_width * block_height * sizeof(u32);
+    const u32 rows_per_band =
+        std::max(TEXTURE_DECODE_BAND_SIZE / block_row_size, 1u) * block_height;
+    for (u32 row = 0; row < level.expanded_height; row += rows_per_band)
+      bands.push_back({&level, row, std::min(rows_per_band, level.expanded_height - row)});
+    decoded_size += level.GetDecodedSize();
+  }
+
+  const auto decode_band = [&](size_t index, size_t) {
+    const Band& band = bands[index];
+    const DecodeLevel& level = *band.level;
+    TexDecoder_DecodeRows(temp + level.decoded_offset, level.src, level.expanded_width,
+                          level.expanded_height, band.first_row, band.num_rows, texformat, tlut,
+                          tlutfmt);
+  };
+
+  if (decoded_size < TEXTURE_DECODE_BAND_SIZE)
+  {
+    for (size_t i = 0; i < bands.size(); ++i)
+      decode_band(i, 0);
+  }
+  else
+  {
+    decode_pool->ParallelFor(bands.size(), decode_band);
+  }
+}
+
 // Used by TextureCacheBase::Load
 TextureCacheBase::TCacheEntry* TextureCacheBase::ReturnEntry(unsigned int stage, TCacheEntry* entry)
 {
@@ -561,7 +652,10 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
 
   // TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data
   // from the low tmem bank than it should)
-  base_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+  if (from_tmem)
+    base_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+  else
+    base_hash = HashMemory(address, texture_size);
   u32 palette_size = 0;
   if (isPaletteTexture)
   {
@@ -613,22 +707,24 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
   // For efb copies, the entry created in CopyRenderTargetToTexture always has to be used, or else
   // it was
   // done in vain.
-  auto iter_range = textures_by_address.equal_range(address);
-  TexAddrCache::iterator iter = iter_range.first;
-  TexAddrCache::iterator oldest_entry = iter;
+  //
+  // The entries are gathered first, as invalidating them modifies textures_by_address. They are
+  // looked at from the oldest to the newest one.
+  textures_at_address.clear();
+  textures_by_address.ForEach(
+      address, [this](TCacheEntry* entry) { textures_at_address.push_back(entry); });
+  std::sort(textures_at_address.begin(), textures_at_address.end(),
+            [](const TCacheEntry* a, const TCacheEntry* b) { return a->id < b->id; });
+
+  TCacheEntry* oldest_entry = nullptr;
   int temp_frameCount = 0x7fffffff;
-  TexAddrCache::iterator unconverted_copy = textures_by_address.end();
+  TCacheEntry* unconverted_copy = nullptr;
 
-  while (iter != iter_range.second)
+  for (TCacheEntry* entry : textures_at_address)
   {
-    TCacheEntry* entry = iter->second;
-
     // Skip entries that are only left in our texture cache for the tmem cache emulation
     if (entry->tmem_only)
-    {
-      ++iter;
       continue;
-    }
 
     // Do not load strided EFB copies, they are not meant to be used directly.
     // Also do not directly load EFB copies, which were partly overwritten.
@@ -652,7 +748,7 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
         // perform the conversion later.  Currently, we only convert EFB copies to
         // palette textures; we could do other conversions if it proved to be
         // beneficial.
-        unconverted_copy = iter;
+        unconverted_copy = entry;
       }
       else
       {
@@ -660,7 +756,7 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
         // never be useful again.  It's theoretically possible for a game to do
         // something weird where the copy could become useful in the future, but in
         // practice it doesn't happen.
-        iter = InvalidateTexture(iter);
+        InvalidateTexture(entry);
         continue;
       }
     }
@@ -671,7 +767,7 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
           entry->native_levels >= tex_levels && entry->native_width == nativeW &&
           entry->native_height == nativeH)
       {
-        entry = DoPartialTextureUpdates(iter->second, &texMem[tlutaddr], tlutfmt);
+        entry = DoPartialTextureUpdates(entry, &texMem[tlutaddr], tlutfmt);
 
         return ReturnEntry(stage, entry);
       }
@@ -686,15 +782,13 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
         !entry->IsEfbCopy() && !(isPaletteTexture && entry->base_hash == base_hash))
     {
       temp_frameCount = entry->frameCount;
-      oldest_entry = iter;
+      oldest_entry = entry;
     }
-    ++iter;
   }
 
-  if (unconverted_copy != textures_by_address.end())
+  if (unconverted_copy)
   {
-    TCacheEntry* decoded_entry =
-        ApplyPaletteToEntry(unconverted_copy->second, &texMem[tlutaddr], tlutfmt);
+    TCacheEntry* decoded_entry = ApplyPaletteToEntry(unconverted_copy, &texMem[tlutaddr], tlutfmt);
 
     if (decoded_entry)
     {
@@ -712,25 +806,22 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
       std::max(texture_size, palette_size) <=
           (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
   {
-    auto hash_range = textures_by_hash.equal_range(full_hash);
-    TexHashCache::iterator hash_iter = hash_range.first;
-    while (hash_iter != hash_range.second)
+    // All parameters, except the address, need to match here
+    TCacheEntry* const* hash_entry =
+        textures_by_hash.FindIf(full_hash, [&](const TCacheEntry* entry) {
+          return entry->format == full_format && entry->native_levels >= tex_levels &&
+                 entry->native_width == nativeW && entry->native_height == nativeH;
+        });
+    if (hash_entry)
     {
-      TCacheEntry* entry = hash_iter->second;
-      // All parameters, except the address, need to match here
-      if (entry->format == full_format && entry->native_levels >= tex_levels &&
-          entry->native_width == nativeW && entry->native_height == nativeH)
-      {
-        entry = DoPartialTextureUpdates(hash_iter->second, &texMem[tlutaddr], tlutfmt);
+      TCacheEntry* entry = DoPartialTextureUpdates(*hash_entry, &texMem[tlutaddr], tlutfmt);
 
-        return ReturnEntry(stage, entry);
-      }
-      ++hash_iter;
+      return ReturnEntry(stage, entry);
     }
   }
 
   // If at least one entry was not used for the same frame, overwrite the oldest one
-  if (temp_frameCount != 0x7fffffff)
+  if (oldest_entry)
   {
     // pool this texture and make a new one later
     InvalidateTexture(oldest_entry);
@@ -783,41 +874,112 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
   const u8* tlut = &texMem[tlutaddr];
   if (hires_tex)
   {
-    const auto& level = hires_tex->m_levels[0];
-    entry->texture->Load(0, level.width, level.height, level.row_length, level.data.get(),
-                         level.data_size);
+    for (u32 level_index = 0; level_index != texLevels; ++level_index)
+    {
+      const auto& level = hires_tex->m_levels[level_index];
+      entry->texture->Load(level_index, level.width, level.height, level.row_length,
+                           level.data.get(), level.data_size);
+    }
+  }
+
+  // Mips follow the base level, except for mips from TMEM, which alternate between the even and
+  // odd banks. TODO: Loading mipmaps from tmem is untested!
+  std::vector<DecodeLevel> levels;
+  if (!hires_tex)
+  {
+    const u8* ptr_even = src_data;
+    const u8* ptr_odd = nullptr;
+    if (from_tmem)
+      ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+
+    levels.resize(texLevels);
+    size_t decoded_offset = 0;
+    for (u32 level = 0; level != texLevels; ++level)
+    {
+      DecodeLevel& info = levels[level];
+      info.width = CalculateLevelSize(width, level);
+      info.height = CalculateLevelSize(height, level);
+      info.expanded_width = Common::AlignUp(info.width, bsw);
+      info.expanded_height = Common::AlignUp(info.height, bsh);
+      info.size =
+          TexDecoder_GetTextureSizeInBytes(info.expanded_width, info.expanded_height, texformat);
+      info.decoded_offset = decoded_offset;
+      decoded_offset += info.GetDecodedSize();
+
+      const u8*& level_src = (from_tmem && level % 2) ? ptr_odd : ptr_even;
+      info.src = level_src;
+      level_src += info.size;
+    }
   }
 
   if (!hires_tex && decode_on_gpu)
   {
-    u32 row_stride = bytes_per_block * (expandedWidth / bsw);
-    g_texture_cache->DecodeTextureOnGPU(entry, 0, src_data, texture_size, texformat, width, height,
-                                        expandedWidth, expandedHeight, row_stride, tlut, tlutfmt);
+    ScopedStatTimer timer(&stats.thisFrame.textureDecodeTimeNs);
+    for (u32 level = 0; level != texLevels; ++level)
+    {
+      const DecodeLevel& info = levels[level];
+      u32 row_stride = bytes_per_block * (info.expanded_width / bsw);
+      g_texture_cache->DecodeTextureOnGPU(entry, level, info.src, info.size, texformat, info.width,
+                                          info.height, info.expanded_width, info.expanded_height,
+                                          row_stride, tlut, tlutfmt);
+    }
   }
   else if (!hires_tex)
   {
-    size_t decoded_texture_size = expandedWidth * sizeof(u32) * expandedHeight;
-    CheckTempSize(decoded_texture_size);
-    if (!(texformat == TextureFormat::RGBA8 && from_tmem))
+    const DecodeLevel& last_level = levels.back();
+    const size_t decoded_size = last_level.decoded_offset + last_level.GetDecodedSize();
+    CheckTempSize(decoded_size);
+
+    // The format overlay is drawn into the decoded data, so those textures aren't stored.
+    // Textures from TMEM aren't either, as their hashes don't cover all of their data.
+    const bool use_disk_cache =
+        disk_cache.IsOpen() && !from_tmem && !g_ActiveConfig.bTexFmtOverlayEnable;
+    TextureDiskCache::Key disk_cache_key = {base_hash, full_hash, width, height, texLevels, 0};
+    disk_cache_key.format =
+        static_cast<u32>(texformat) | (isPaletteTexture ? static_cast<u32>(tlutfmt) << 8 : 0);
+
+    // The stored data must match all of the texture, but our hashes may be sampled, and don't
+    // include the mips.
+    if (use_disk_cache &&
+        (texLevels > 1 || (g_ActiveConfig.iSafeTextureCache_ColorSamples != 0 &&
+                           std::max(texture_size, palette_size) >
+                               (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)))
     {
-      TexDecoder_Decode(temp, src_data, expandedWidth, expandedHeight, texformat, tlut, tlutfmt);
+      disk_cache_key.base_hash = GetHash64(src_data, texture_size + additional_mips_size, 0);
+      disk_cache_key.full_hash = disk_cache_key.base_hash;
+      if (isPaletteTexture)
+        disk_cache_key.full_hash ^= GetHash64(&texMem[tlutaddr], palette_size, 0);
     }
-    else
+
     {
-      u8* src_data_gb =
-          &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
-      TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, expandedWidth, expandedHeight);
-    }
+      ScopedStatTimer timer(&stats.thisFrame.textureDecodeTimeNs);
+      if (!use_disk_cache || !disk_cache.Read(disk_cache_key, temp, decoded_size))
+      {
+        // RGBA8 textures from TMEM are split across both banks, so their base level is decoded
+        // separately.
+        size_t first_level = 0;
+        if (texformat == TextureFormat::RGBA8 && from_tmem)
+        {
+          u8* src_data_gb =
+              &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+          TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, expandedWidth,
+                                         expandedHeight);
+          first_level = 1;
+        }
+        DecodeTextureLevels(levels.data() + first_level, levels.size() - first_level, texformat,
+                            tlut, tlutfmt);
 
-    entry->texture->Load(0, width, height, expandedWidth, temp, decoded_texture_size);
-  }
+        if (use_disk_cache)
+          disk_cache.Append(disk_cache_key, temp, decoded_size);
+      }
+    }
 
-  iter = textures_by_address.emplace(address, entry);
-  if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
-      std::max(texture_size, palette_size) <=
-          (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
-  {
-    entry->textures_by_hash_iter = textures_by_hash.emplace(full_hash, entry);
+    for (u32 level = 0; level != texLevels; ++level)
+    {
+      const DecodeLevel& info = levels[level];
+      entry->texture->Load(level, info.width, info.height, info.expanded_width,
+                           temp + info.decoded_offset, info.GetDecodedSize());
+    }
   }
 
   entry->SetGeneralParameters(address, texture_size, full_format);
@@ -827,76 +989,28 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
   entry->is_custom_tex = hires_tex != nullptr;
   entry->memory_stride = entry->BytesPerRow();
 
-  std::string basename = "";
-  if (g_ActiveConfig.bDumpTextures && !hires_tex)
+  AddTextureToCache(entry);
+  if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
+      std::max(texture_size, palette_size) <=
+          (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
   {
-    basename = HiresTexture::GenBaseName(src_data, texture_size, &texMem[tlutaddr], palette_size,
-                                         width, height, texformat, use_mipmaps, true);
-    DumpTexture(entry, basename, 0);
+    textures_by_hash.Insert(full_hash, entry);
+    entry->in_hash_cache = true;
   }
 
-  if (hires_tex)
+  if (g_ActiveConfig.bDumpTextures && !hires_tex)
   {
-    for (u32 level_index = 1; level_index != texLevels; ++level_index)
-    {
-      const auto& level = hires_tex->m_levels[level_index];
-      entry->texture->Load(level_index, level.width, level.height, level.row_length,
-                           level.data.get(), level.data_size);
-    }
-  }
-  else
-  {
-    // load mips - TODO: Loading mipmaps from tmem is untested!
-    src_data += texture_size;
-
-    const u8* ptr_even = nullptr;
-    const u8* ptr_odd = nullptr;
-    if (from_tmem)
-    {
-      ptr_even = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE +
-                         texture_size];
-      ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
-    }
-
-    for (u32 level = 1; level != texLevels; ++level)
-    {
-      const u32 mip_width = CalculateLevelSize(width, level);
-      const u32 mip_height = CalculateLevelSize(height, level);
-      const u32 expanded_mip_width = Common::AlignUp(mip_width, bsw);
-      const u32 expanded_mip_height = Common::AlignUp(mip_height, bsh);
-
-      const u8*& mip_src_data = from_tmem ? ((level % 2) ? ptr_odd : ptr_even) : src_data;
-      size_t mip_size =
-          TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
-
-      if (decode_on_gpu)
-      {
-        u32 row_stride = bytes_per_block * (expanded_mip_width / bsw);
-        g_texture_cache->DecodeTextureOnGPU(entry, level, mip_src_data, mip_size, texformat,
-                                            mip_width, mip_height, expanded_mip_width,
-                                            expanded_mip_height, row_stride, tlut, tlutfmt);
-      }
-      else
-      {
-        // No need to call CheckTempSize here, as mips will always be smaller than the base level.
-        size_t decoded_mip_size = expanded_mip_width * sizeof(u32) * expanded_mip_height;
-        TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat,
-                          tlut, tlutfmt);
-        entry->texture->Load(level, mip_width, mip_height, expanded_mip_width, temp,
-                             decoded_mip_size);
-      }
-
-      mip_src_data += mip_size;
-
-      if (g_ActiveConfig.bDumpTextures)
-        DumpTexture(entry, basename, level);
-    }
+    std::string basename =
+        HiresTexture::GenBaseName(src_data, texture_size, &texMem[tlutaddr], palette_size, width,
+                                  height, texformat, use_mipmaps, true);
+    for (u32 level = 0; level != texLevels; ++level)
+      DumpTexture(entry, basename, level);
   }
 
   INCSTAT(stats.numTexturesUploaded);
-  SETSTAT(stats.numTexturesAlive, textures_by_address.size());
+  SETSTAT(stats.numTexturesAlive, textures_by_address.Size());
 
-  entry = DoPartialTextureUpdates(iter->second, &texMem[tlutaddr], tlutfmt);
+  entry = DoPartialTextureUpdates(entry, &texMem[tlutaddr], tlutfmt);
 
   return ReturnEntry(stage, entry);
 }
@@ -1300,32 +1414,23 @@ void TextureCacheBase::CopyRenderTargetToTexture(u32 dstAddr, EFBCopyFormat dstF
   // as our efb copy are marked to check them for partial texture updates.
   // TODO: The logic to detect overlapping strided efb copies is not 100% accurate.
   bool strided_efb_copy = dstStride != bytes_per_row;
-  auto iter = FindOverlappingTextures(dstAddr, covered_range);
-  while (iter.first != iter.second)
+  FindOverlappingTextures(dstAddr, covered_range);
+  for (TCacheEntry* entry : overlapping_textures)
   {
-    TCacheEntry* entry = iter.first->second;
-    if (entry->OverlapsMemoryRange(dstAddr, covered_range))
+    u32 overlap_range = std::min(entry->addr + entry->size_in_bytes, dstAddr + covered_range) -
+                        std::max(entry->addr, dstAddr);
+    if (!copy_to_vram || entry->memory_stride != dstStride ||
+        (!strided_efb_copy && entry->size_in_bytes == overlap_range) ||
+        (strided_efb_copy && entry->size_in_bytes == overlap_range && entry->addr == dstAddr))
     {
-      u32 overlap_range = std::min(entry->addr + entry->size_in_bytes, dstAddr + covered_range) -
-                          std::max(entry->addr, dstAddr);
-      if (!copy_to_vram || entry->memory_stride != dstStride ||
-          (!strided_efb_copy && entry->size_in_bytes == overlap_range) ||
-          (strided_efb_copy && entry->size_in_bytes == overlap_range && entry->addr == dstAddr))
-      {
-        iter.first = InvalidateTexture(iter.first);
-        continue;
-      }
-      entry->may_have_overlapping_textures = true;
-
-      // Do not load textures by hash, if they were at least partly overwritten by an efb copy.
-      // In this case, comparing the hash is not enough to check, if two textures are identical.
-      if (entry->textures_by_hash_iter != textures_by_hash.end())
-      {
-        textures_by_hash.erase(entry->textures_by_hash_iter);
-        entry->textures_by_hash_iter = textures_by_hash.end();
-      }
+      InvalidateTexture(entry);
+      continue;
     }
-    ++iter.first;
+    entry->may_have_overlapping_textures = true;
+
+    // Do not load textures by hash, if they were at least partly overwritten by an efb copy.
+    // In this case, comparing the hash is not enough to check, if two textures are identical.
+    RemoveTextureFromHashCache(entry);
   }
 
   if (copy_to_vram)
@@ -1363,7 +1468,7 @@ void TextureCacheBase::CopyRenderTargetToTexture(u32 dstAddr, EFBCopyFormat dstF
                              0);
       }
 
-      textures_by_address.emplace(dstAddr, entry);
+      AddTextureToCache(entry);
     }
   }
 }
@@ -1376,19 +1481,31 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::AllocateCacheEntry(const Textur
   {
     return nullptr;
   }
-  TCacheEntry* cacheEntry = new TCacheEntry(std::move(texture));
-  cacheEntry->textures_by_hash_iter = textures_by_hash.end();
+
+  if (free_entries.empty())
+  {
+    entry_slabs.emplace_back(new TCacheEntry[ENTRY_SLAB_SIZE]);
+    TCacheEntry* slab = entry_slabs.back().get();
+
+    // Hand out the entries of a new slab in ascending order.
+    for (size_t i = ENTRY_SLAB_SIZE; i > 0; i--)
+      free_entries.push_back(&slab[i - 1]);
+  }
+
+  TCacheEntry* cacheEntry = free_entries.back();
+  free_entries.pop_back();
+  cacheEntry->texture = std::move(texture);
+  cacheEntry->id = next_entry_id++;
   return cacheEntry;
 }
 
 std::unique_ptr<AbstractTexture> TextureCacheBase::AllocateTexture(const TextureConfig& config)
 {
-  TexPool::iterator iter = FindMatchingTextureFromPool(config);
+  s32 index = FindMatchingTextureFromPool(config);
   std::unique_ptr<AbstractTexture> entry;
-  if (iter != texture_pool.end())
+  if (index >= 0)
   {
-    entry = std::move(iter->second.texture);
-    texture_pool.erase(iter);
+    entry = TakeTextureFromPool(static_cast<u32>(index));
   }
   else
   {
@@ -1402,68 +1519,96 @@ std::unique_ptr<AbstractTexture> TextureCacheBase::AllocateTexture(const Texture
   return entry;
 }
 
-TextureCacheBase::TexPool::iterator
-TextureCacheBase::FindMatchingTextureFromPool(const TextureConfig& config)
+s32 TextureCacheBase::FindMatchingTextureFromPool(const TextureConfig& config)
 {
   // Find a texture from the pool that does not have a frameCount of FRAMECOUNT_INVALID.
   // This prevents a texture from being used twice in a single frame with different data,
   // which potentially means that a driver has to maintain two copies of the texture anyway.
   // Render-target textures are fine through, as they have to be generated in a seperated pass.
   // As non-render-target textures are usually static, this should not matter much.
-  auto range = texture_pool.equal_range(config);
-  auto matching_iter = std::find_if(range.first, range.second, [](const auto& iter) {
-    return iter.first.rendertarget || iter.second.frameCount != FRAMECOUNT_INVALID;
-  });
-  return matching_iter != range.second ? matching_iter : texture_pool.end();
+  const u32* index =
+      texture_pool_by_config.FindIf(std::hash<TextureConfig>{}(config), [&](u32 i) {
+        const TexPoolEntry& pool_entry = texture_pool[i];
+        return pool_entry.texture->GetConfig() == config &&
+               (config.rendertarget || pool_entry.frameCount != FRAMECOUNT_INVALID);
+      });
+  return index ? static_cast<s32>(*index) : -1;
 }
 
-TextureCacheBase::TexAddrCache::iterator
-TextureCacheBase::GetTexCacheIter(TextureCacheBase::TCacheEntry* entry)
+void TextureCacheBase::AddTextureToPool(std::unique_ptr<AbstractTexture> texture)
 {
-  auto iter_range = textures_by_address.equal_range(entry->addr);
-  TexAddrCache::iterator iter = iter_range.first;
-  while (iter != iter_range.second)
+  const size_t config_hash = std::hash<TextureConfig>{}(texture->GetConfig());
+  texture_pool_by_config.Insert(config_hash, static_cast<u32>(texture_pool.size()));
+  texture_pool.emplace_back(std::move(texture));
+}
+
+std::unique_ptr<AbstractTexture> TextureCacheBase::TakeTextureFromPool(u32 index)
+{
+  std::unique_ptr<AbstractTexture> texture = std::move(texture_pool[index].texture);
+  texture_pool_by_config.Erase(std::hash<TextureConfig>{}(texture->GetConfig()), index);
+
+  // Move the last texture into the gap, so the pool stays contiguous
+  const u32 last_index = static_cast<u32>(texture_pool.size() - 1);
+  if (index != last_index)
   {
-    if (iter->second == entry)
-    {
-      return iter;
-    }
-    ++iter;
+    const size_t config_hash =
+        std::hash<TextureConfig>{}(texture_pool[last_index].texture->GetConfig());
+    texture_pool_by_config.Erase(config_hash, last_index);
+    texture_pool_by_config.Insert(config_hash, index);
+    texture_pool[index] = std::move(texture_pool[last_index]);
   }
-  return textures_by_address.end();
+  texture_pool.pop_back();
+
+  return texture;
 }
 
-std::pair<TextureCacheBase::TexAddrCache::iterator, TextureCacheBase::TexAddrCache::iterator>
-TextureCacheBase::FindOverlappingTextures(u32 addr, u32 size_in_bytes)
+void TextureCacheBase::AddTextureToCache(TCacheEntry* entry)
 {
-  // We index by the starting address only, so there is no way to query all textures
-  // which end after the given addr. But the GC textures have a limited size, so we
-  // look for all textures which have a start address bigger than addr minus the maximal
-  // texture size. But this yields false-positives which must be checked later on.
-
-  // 1024 x 1024 texel times 8 nibbles per texel
-  constexpr u32 max_texture_size = 1024 * 1024 * 4;
-  u32 lower_addr = addr > max_texture_size ? addr - max_texture_size : 0;
-  auto begin = textures_by_address.lower_bound(lower_addr);
-  auto end = textures_by_address.upper_bound(addr + size_in_bytes);
-
-  return std::make_pair(begin, end);
+  textures_by_address.Insert(entry->addr, entry);
+
+  const u32 range_mask = ~(TEXTURE_RANGE_MAP_ELEMENTS - 1);
+  const u64 end = static_cast<u64>(entry->addr) + std::max(entry->size_in_bytes, 1u);
+  for (u64 range = entry->addr & range_mask; range < end; range += TEXTURE_RANGE_MAP_ELEMENTS)
+    textures_by_range.Insert(static_cast<u32>(range), entry);
 }
 
-TextureCacheBase::TexAddrCache::iterator
-TextureCacheBase::InvalidateTexture(TexAddrCache::iterator iter)
+void TextureCacheBase::FindOverlappingTextures(u32 addr, u32 size_in_bytes)
 {
-  if (iter == textures_by_address.end())
-    return textures_by_address.end();
-
-  TCacheEntry* entry = iter->second;
+  overlapping_textures.clear();
 
-  if (entry->textures_by_hash_iter != textures_by_hash.end())
+  const u32 range_mask = ~(TEXTURE_RANGE_MAP_ELEMENTS - 1);
+  const u64 end = static_cast<u64>(addr) + std::max(size_in_bytes, 1u);
+  for (u64 range = addr & range_mask; range < end; range += TEXTURE_RANGE_MAP_ELEMENTS)
   {
-    textures_by_hash.erase(entry->textures_by_hash_iter);
-    entry->textures_by_hash_iter = textures_by_hash.end();
+    textures_by_range.ForEach(static_cast<u32>(range), [&](TCacheEntry* entry) {
+      if (entry->OverlapsMemoryRange(addr, size_in_bytes))
+        overlapping_textures.push_back(entry);
+    });
   }
 
+  // Textures which span several range elements are found more than once. Newer EFB copies have
+  // to be applied after older ones, so order them by age after the address.
+  std::sort(overlapping_textures.begin(), overlapping_textures.end(),
+            [](const TCacheEntry* a, const TCacheEntry* b) {
+              return std::tie(a->addr, a->id) < std::tie(b->addr, b->id);
+            });
+  overlapping_textures.erase(std::unique(overlapping_textures.begin(), overlapping_textures.end()),
+                             overlapping_textures.end());
+}
+
+void TextureCacheBase::RemoveTextureFromHashCache(TCacheEntry* entry)
+{
+  if (!entry->in_hash_cache)
+    return;
+
+  textures_by_hash.Erase(entry->hash, entry);
+  entry->in_hash_cache = false;
+}
+
+void TextureCacheBase::InvalidateTexture(TCacheEntry* entry)
+{
+  RemoveTextureFromHashCache(entry);
+
   for (size_t i = 0; i < bound_textures.size(); ++i)
   {
     // If the entry is currently bound and not invalidated, keep it, but mark it as invalidated.
@@ -1472,14 +1617,22 @@ TextureCacheBase::InvalidateTexture(TexAddrCache::iterator iter)
     if (bound_textures[i] == entry && IsValidBindPoint(static_cast<u32>(i)))
     {
       bound_textures[i]->tmem_only = true;
-      return ++iter;
+      return;
     }
   }
 
-  auto config = entry->texture->GetConfig();
-  texture_pool.emplace(config, TexPoolEntry(std::move(entry->texture)));
+  textures_by_address.Erase(entry->addr, entry);
+
+  const u32 range_mask = ~(TEXTURE_RANGE_MAP_ELEMENTS - 1);
+  const u64 end = static_cast<u64>(entry->addr) + std::max(entry->size_in_bytes, 1u);
+  for (u64 range = entry->addr & range_mask; range < end; range += TEXTURE_RANGE_MAP_ELEMENTS)
+    textures_by_range.Erase(static_cast<u32>(range), entry);
 
-  return textures_by_address.erase(iter);
+  AddTextureToPool(std::move(entry->texture));
+
+  entry->UnlinkReferences();
+  *entry = TCacheEntry();
+  free_entries.push_back(entry);
 }
 
 u32 TextureCacheBase::TCacheEntry::BytesPerRow() const
@@ -1516,12 +1669,52 @@ void TextureCacheBase::TCacheEntry::SetEfbCopy(u32 stride)
   size_in_bytes = memory_stride * NumBlocksY();
 }
 
+u64 TextureCacheBase::HashMemory(u32 address, u32 size)
+{
+  const u8* ptr = Memory::GetPointer(address);
+  const u32 samples = g_ActiveConfig.iSafeTextureCache_ColorSamples;
+  if (!g_ActiveConfig.bIncrementalTextureHash || samples != 0)
+    return GetHash64(ptr, size, samples);
+
+  constexpr u32 PAGE_SIZE = Memory::WRITE_TRACKING_PAGE_SIZE;
+  const u32 num_pages = (address % PAGE_SIZE + size + PAGE_SIZE - 1) / PAGE_SIZE;
+  page_write_counts.resize(num_pages);
+  if (!Memory::TrackWrites(address, size, page_write_counts.data()))
+    return GetHash64(ptr, size, 0);
+
+  // Stale entries are only dropped by invalidating, so keep them from piling up
+  if (page_hashes.size() > 0x10000)
+    page_hashes.clear();
+
+  u64 hash = size;
+  u32 offset = 0;
+  for (u32 i = 0; i < num_pages; ++i)
+  {
+    const u32 part_address = address + offset;
+    const u32 part_size = std::min(size - offset, PAGE_SIZE - part_address % PAGE_SIZE);
+    const u64 key = static_cast<u64>(part_address) << 32 | part_size;
+
+    auto insert_result = page_hashes.try_emplace(key);
+    PageHash& page_hash = insert_result.first->second;
+    if (insert_result.second || page_hash.write_count != page_write_counts[i])
+    {
+      page_hash.write_count = page_write_counts[i];
+      page_hash.hash = GetHash64(ptr + offset, part_size, 0);
+    }
+
+    hash = (hash * 397) ^ page_hash.hash;
+    offset += part_size;
+  }
+  return hash;
+}
+
 u64 TextureCacheBase::TCacheEntry::CalculateHash() const
 {
   u8* ptr = Memory::GetPointer(addr);
   if (memory_stride == BytesPerRow())
   {
-    return GetHash64(ptr, size_in_bytes, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+    // Must match the hash of a texture loaded from the same memory
+    return g_texture_cache->HashMemory(addr, size_in_bytes);
   }
   else
   {
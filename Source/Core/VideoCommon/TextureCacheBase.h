@@ -4,23 +4,30 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <bitset>
-#include <map>
 #include <memory>
 #include <tuple>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/FlatHashMultiMap.h"
 #include "VideoCommon/AbstractTexture.h"
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/TextureConfig.h"
 #include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/TextureDiskCache.h"
 #include "VideoCommon/VideoCommon.h"
 
 struct VideoConfig;
 
+namespace Common
+{
+class ThreadPool;
+}
+
 struct TextureAndTLUTFormat
 {
   TextureAndTLUTFormat(TextureFormat texfmt_ = TextureFormat::I4,
@@ -90,18 +97,17 @@ public:
     // used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
     int frameCount = FRAMECOUNT_INVALID;
 
-    // Keep an iterator to the entry in textures_by_hash, so it does not need to be searched when
-    // removing the cache entry
-    std::multimap<u64, TCacheEntry*>::iterator textures_by_hash_iter;
+    // Increases with every allocated entry, so entries at the same address can be ordered by age
+    u64 id = 0;
+
+    // Whether the entry is listed in textures_by_hash under its hash
+    bool in_hash_cache = false;
 
     // This is used to keep track of both:
     //   * efb copies used by this partially updated texture
     //   * partially updated textures which refer to this efb copy
-    std::unordered_set<TCacheEntry*> references;
-
-    explicit TCacheEntry(std::unique_ptr<AbstractTexture> tex);
-
-    ~TCacheEntry();
+    // There are only ever a few of them, so a vector is cheaper than a set.
+    std::vector<TCacheEntry*> references;
 
     void SetGeneralParameters(u32 _addr, u32 _size, TextureAndTLUTFormat _format)
     {
@@ -129,10 +135,18 @@ public:
     void CreateReference(TCacheEntry* other_entry)
     {
       // References are two-way, so they can easily be destroyed later
-      this->references.emplace(other_entry);
-      other_entry->references.emplace(this);
+      this->references.push_back(other_entry);
+      other_entry->references.push_back(this);
+    }
+
+    bool HasReference(const TCacheEntry* other_entry) const
+    {
+      return std::find(references.begin(), references.end(), other_entry) != references.end();
     }
 
+    // Removes this entry from the references of all entries it refers to
+    void UnlinkReferences();
+
     void SetEfbCopy(u32 stride);
 
     bool OverlapsMemoryRange(u32 range_address, u32 range_size) const;
@@ -168,6 +182,9 @@ public:
   virtual void DeleteShaders() = 0;
 
   TCacheEntry* Load(const u32 stage);
+  // Hashes texture data in RAM. With incremental hashing, only the pages which were written to
+  // since they were last hashed are read again.
+  u64 HashMemory(u32 address, u32 size);
   static void InvalidateAllBindPoints() { valid_bind_points.reset(); }
   static bool IsValidBindPoint(u32 i) { return valid_bind_points.test(i); }
   void BindTextures();
@@ -205,16 +222,13 @@ protected:
   static std::bitset<8> valid_bind_points;
 
 private:
-  // Minimal version of TCacheEntry just for TexPool
+  // Minimal version of TCacheEntry just for the texture pool
   struct TexPoolEntry
   {
     std::unique_ptr<AbstractTexture> texture;
     int frameCount = FRAMECOUNT_INVALID;
     TexPoolEntry(std::unique_ptr<AbstractTexture> tex) : texture(std::move(tex)) {}
   };
-  using TexAddrCache = std::multimap<u32, TCacheEntry*>;
-  using TexHashCache = std::multimap<u64, TCacheEntry*>;
-  using TexPool = std::unordered_multimap<TextureConfig, TexPoolEntry>;
 
   void SetBackupConfig(const VideoConfig& config);
 
@@ -224,18 +238,40 @@ private:
   TCacheEntry* DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* palette,
                                        TLUTFormat tlutfmt);
 
+  // A level of a texture which is decoded on the CPU
+  struct DecodeLevel
+  {
+    const u8* src;
+    u32 size;  // of the encoded data
+    u32 width, height;
+    u32 expanded_width, expanded_height;  // aligned to the block size
+    size_t decoded_offset;                // into temp
+
+    size_t GetDecodedSize() const { return expanded_width * sizeof(u32) * expanded_height; }
+  };
+
+  // Decodes the levels into temp. Large levels are split into bands of rows, which are decoded
+  // in parallel by decode_pool.
+  void DecodeTextureLevels(const DecodeLevel* levels, size_t num_levels, TextureFormat texformat,
+                           const u8* tlut, TLUTFormat tlutfmt);
+
   void DumpTexture(TCacheEntry* entry, std::string basename, unsigned int level);
   void CheckTempSize(size_t required_size);
 
   TCacheEntry* AllocateCacheEntry(const TextureConfig& config);
   std::unique_ptr<AbstractTexture> AllocateTexture(const TextureConfig& config);
-  TexPool::iterator FindMatchingTextureFromPool(const TextureConfig& config);
-  TexAddrCache::iterator GetTexCacheIter(TCacheEntry* entry);
+  // Returns the index of a matching texture in texture_pool, or -1
+  s32 FindMatchingTextureFromPool(const TextureConfig& config);
+  void AddTextureToPool(std::unique_ptr<AbstractTexture> texture);
+  // Removes the texture at index from the pool. The last texture of the pool takes its place.
+  std::unique_ptr<AbstractTexture> TakeTextureFromPool(u32 index);
+
+  // Adds an entry to the address indexes. Its address and size must not change afterwards.
+  void AddTextureToCache(TCacheEntry* entry);
 
-  // Return all possible overlapping textures. As addr+size of the textures is not
-  // indexed, this may return false positives.
-  std::pair<TexAddrCache::iterator, TexAddrCache::iterator>
-  FindOverlappingTextures(u32 addr, u32 size_in_bytes);
+  // Fills overlapping_textures with all textures which overlap the given range, sorted by
+  // address and then by age.
+  void FindOverlappingTextures(u32 addr, u32 size_in_bytes);
 
   virtual std::unique_ptr<AbstractTexture> CreateTexture(const TextureConfig& config) = 0;
 
@@ -243,19 +279,56 @@ private:
                                    const EFBRectangle& src_rect, bool scale_by_half,
                                    unsigned int cbuf_id, const float* colmat) = 0;
 
-  // Removes and unlinks texture from texture cache and returns it to the pool
-  TexAddrCache::iterator InvalidateTexture(TexAddrCache::iterator t_iter);
+  // Removes and unlinks texture from texture cache and returns it to the pool. Unless it is still
+  // bound, the entry is freed afterwards.
+  void InvalidateTexture(TCacheEntry* entry);
+  void RemoveTextureFromHashCache(TCacheEntry* entry);
 
   TCacheEntry* ReturnEntry(unsigned int stage, TCacheEntry* entry);
 
-  TexAddrCache textures_by_address;
-  TexHashCache textures_by_hash;
-  TexPool texture_pool;
+  // All entries by their exact address, and by the hash of their contents if they were fully
+  // hashed.
+  Common::FlatHashMultiMap<u32, TCacheEntry*> textures_by_address;
+  Common::FlatHashMultiMap<u64, TCacheEntry*> textures_by_hash;
+
+  // Entries indexed by the masked addresses of the memory they cover, so that textures overlapping
+  // a range can be found without looking at all of them. An entry is listed once per range element.
+  static constexpr u32 TEXTURE_RANGE_MAP_ELEMENTS = 0x10000;
+  Common::FlatHashMultiMap<u32, TCacheEntry*> textures_by_range;
+
+  // Entries are allocated in slabs, so that pointers to them stay valid and walking over all of
+  // them is cheap. Invalidated entries go to the free list.
+  static constexpr size_t ENTRY_SLAB_SIZE = 256;
+  std::vector<std::unique_ptr<TCacheEntry[]>> entry_slabs;
+  std::vector<TCacheEntry*> free_entries;
+  u64 next_entry_id = 0;
+
+  // Scratch space for lookups which invalidate entries, kept around to avoid reallocations
+  std::vector<TCacheEntry*> textures_at_address;
+  std::vector<TCacheEntry*> overlapping_textures;
+
+  // Unused textures, indexed by the hash of their config
+  std::vector<TexPoolEntry> texture_pool;
+  Common::FlatHashMultiMap<size_t, u32> texture_pool_by_config;  // config hash -> pool index
+
+  std::unique_ptr<Common::ThreadPool> decode_pool;
+  TextureDiskCache disk_cache;
+
+  // Hashes of the parts of pages read by HashMemory, keyed by their address and size
+  struct PageHash
+  {
+    u32 write_count;
+    u64 hash;
+  };
+  std::unordered_map<u64, PageHash> page_hashes;
+  std::vector<u32> page_write_counts;
 
   // Backup configuration values
   struct BackupConfig
   {
     int color_samples;
+    bool incremental_hash;
+    bool disk_cache;
     bool texfmt_overlay;
     bool texfmt_overlay_center;
     bool hires_textures;
@@ -100,6 +100,12 @@ TextureFormat TexDecoder_GetEFBCopyBaseFormat(EFBCopyFormat format);
 
 void TexDecoder_Decode(u8* dst, const u8* src, int width, int height, TextureFormat texformat,
                        const u8* tlut, TLUTFormat tlutfmt);
+// Decodes num_rows rows of texels starting at first_row, which must both be multiples of the block
+// height. dst and src point to the start of the whole texture. Different rows of the same texture
+// can be decoded concurrently.
+void TexDecoder_DecodeRows(u8* dst, const u8* src, int width, int height, int first_row,
+                           int num_rows, TextureFormat texformat, const u8* tlut,
+                           TLUTFormat tlutfmt);
 void TexDecoder_DecodeRGBA8FromTmem(u8* dst, const u8* src_ar, const u8* src_gb, int width,
                                     int height);
 void TexDecoder_DecodeTexel(u8* dst, const u8* src, int s, int t, int imageWidth,
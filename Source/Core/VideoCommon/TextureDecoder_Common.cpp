@@ -253,7 +253,9 @@ static const char* texfmt[] = {
     "CZ16L", "0x3D", "0x3E", "0x3F",
 };
 
-static void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat texformat)
+// Only draws the rows in [first_row, end_row), so that bands of a texture can be drawn separately
+static void TexDecoder_DrawOverlay(u8* dst, int width, int height, int first_row, int end_row,
+                                   TextureFormat texformat)
 {
   int w = std::min(width, 40);
   int h = std::min(height, 10);
@@ -284,6 +286,12 @@ static void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat
 
     for (int y = 0; y < 10; y++)
     {
+      if (y + yoff < first_row || y + yoff >= end_row)
+      {
+        ptr += 9;
+        continue;
+      }
+
       for (int x = 0; x < xcnt; x++)
       {
         int* dtp = (int*)dst;
@@ -299,10 +307,20 @@ static void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat
 void TexDecoder_Decode(u8* dst, const u8* src, int width, int height, TextureFormat texformat,
                        const u8* tlut, TLUTFormat tlutfmt)
 {
-  _TexDecoder_DecodeImpl((u32*)dst, src, width, height, texformat, tlut, tlutfmt);
+  TexDecoder_DecodeRows(dst, src, width, height, 0, height, texformat, tlut, tlutfmt);
+}
+
+void TexDecoder_DecodeRows(u8* dst, const u8* src, int width, int height, int first_row,
+                           int num_rows, TextureFormat texformat, const u8* tlut,
+                           TLUTFormat tlutfmt)
+{
+  // Blocks are stored row by row, so the source of a band of block rows is contiguous
+  const u8* band_src = src + TexDecoder_GetTextureSizeInBytes(width, first_row, texformat);
+  _TexDecoder_DecodeImpl(reinterpret_cast<u32*>(dst) + first_row * width, band_src, width,
+                         num_rows, texformat, tlut, tlutfmt);
 
   if (TexFmt_Overlay_Enable)
-    TexDecoder_DrawOverlay(dst, width, height, texformat);
+    TexDecoder_DrawOverlay(dst, width, height, first_row, first_row + num_rows, texformat);
 }
 
 static inline u32 DecodePixel_IA8(u16 val)
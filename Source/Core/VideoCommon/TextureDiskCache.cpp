@@ -0,0 +1,265 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/TextureDiskCache.h"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <lzo/lzo1x.h>
+#include <tuple>
+#include <utility>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/Logging/Log.h"
+#include "Common/Version.h"
+
+bool TextureDiskCache::Key::operator<(const Key& other) const
+{
+  return std::tie(full_hash, base_hash, width, height, levels, format) <
+         std::tie(other.full_hash, other.base_hash, other.width, other.height, other.levels,
+                  other.format);
+}
+
+TextureDiskCache::~TextureDiskCache()
+{
+  Close(true);
+}
+
+TextureDiskCache::Header TextureDiskCache::MakeHeader(HashMode hash_mode)
+{
+  Header header = {};
+  std::memcpy(&header.id, "DTEX", sizeof(header.id));
+  header.key_size = sizeof(Key);
+
+  std::array<u8, 256> check_data;
+  for (size_t i = 0; i < check_data.size(); ++i)
+    check_data[i] = static_cast<u8>(i * 37);
+  header.hash_check = GetHash64(check_data.data(), static_cast<u32>(check_data.size()), 0);
+  header.hash_mode = static_cast<u64>(hash_mode);
+
+  // Null-terminator is intentionally not copied.
+  std::memcpy(header.ver, Common::scm_rev_git_str.c_str(),
+              std::min(Common::scm_rev_git_str.size(), sizeof(header.ver)));
+  return header;
+}
+
+bool TextureDiskCache::Open(const std::string& filename, HashMode hash_mode, u64 max_size)
+{
+  Close();
+
+  if (lzo_init() != LZO_E_OK)
+    return false;
+
+  m_filename = filename;
+  m_hash_mode = hash_mode;
+  m_max_size = max_size;
+
+  const Header header = MakeHeader(hash_mode);
+  u64 end_offset = 0;
+  if (m_mapping.Open(filename) && m_mapping.GetSize() >= sizeof(Header) &&
+      std::memcmp(m_mapping.GetData(), &header, sizeof(Header)) == 0)
+  {
+    end_offset = ReadEntries();
+    m_file.Open(filename, "r+b");
+    m_file.Seek(end_offset, SEEK_SET);
+  }
+  else
+  {
+    // Missing, corrupt or written by a different version or hash mode, so start over
+    m_mapping.Close();
+    m_file.Open(filename, "wb");
+    m_file.WriteArray(&header, 1);
+  }
+
+  if (!m_file.IsOpen())
+  {
+    ERROR_LOG(VIDEO, "Failed to open texture cache %s", filename.c_str());
+    Close();
+    return false;
+  }
+
+  m_writer.Reset([this](PendingEntry entry) { WriteEntry(std::move(entry)); });
+
+  INFO_LOG(VIDEO, "Loaded %u textures from %s", m_num_loaded, filename.c_str());
+  return true;
+}
+
+void TextureDiskCache::Close(bool compact)
+{
+  m_writer.Shutdown();
+
+  bool oversized = false;
+  if (m_file.IsOpen())
+  {
+    INFO_LOG(VIDEO, "Texture cache: %u of %u stored textures were used", m_num_hits,
+             m_num_loaded);
+    oversized = m_file.GetSize() > m_max_size;
+  }
+
+  m_file.Close();
+  m_mapping.Close();
+  if (compact && oversized)
+    Compact();
+
+  m_entries.clear();
+  m_written.clear();
+  m_filename.clear();
+  m_num_loaded = 0;
+  m_num_hits = 0;
+  m_num_entries = 0;
+}
+
+// Rewrites the closed file with the entries worth keeping, until it is back at three quarters of
+// its size limit, so that it isn't compacted again by every session.
+void TextureDiskCache::Compact()
+{
+  std::vector<std::pair<Key, Entry>> entries;
+  for (const auto& entry : m_entries)
+  {
+    if (entry.second.used && entry.second.offset != 0)
+      entries.push_back(entry);
+  }
+  entries.insert(entries.end(), m_written.begin(), m_written.end());
+
+  // Entries of earlier sessions which weren't used, from the most recently added
+  const size_t num_preferred = entries.size();
+  for (const auto& entry : m_entries)
+  {
+    if (!entry.second.used && entry.second.offset != 0)
+      entries.push_back(entry);
+  }
+  std::sort(entries.begin() + num_preferred, entries.end(),
+            [](const auto& a, const auto& b) { return a.second.offset > b.second.offset; });
+
+  const std::string temp_filename = m_filename + ".tmp";
+  File::IOFile in(m_filename, "rb");
+  File::IOFile out(temp_filename, "wb");
+  const Header header = MakeHeader(m_hash_mode);
+  out.WriteArray(&header, 1);
+
+  const u64 budget = m_max_size / 4 * 3;
+  u64 size = sizeof(Header);
+  u32 num_entries = 0;
+  std::vector<u8> data;
+  for (const auto& entry : entries)
+  {
+    const u32 value_size = entry.second.size;
+    const u64 entry_size = sizeof(value_size) + sizeof(Key) + value_size + sizeof(num_entries);
+    if (size + entry_size > budget)
+      continue;
+
+    data.resize(value_size);
+    if (!in.Seek(entry.second.offset, SEEK_SET) || !in.ReadBytes(data.data(), value_size))
+      break;
+
+    num_entries++;
+    out.WriteArray(&value_size, 1);
+    out.WriteArray(&entry.first, 1);
+    out.WriteBytes(data.data(), value_size);
+    out.WriteArray(&num_entries, 1);
+    size += entry_size;
+  }
+
+  in.Close();
+  if (!out.Close() || !File::Rename(temp_filename, m_filename))
+  {
+    ERROR_LOG(VIDEO, "Failed to compact texture cache %s", m_filename.c_str());
+    File::Delete(temp_filename);
+    return;
+  }
+
+  INFO_LOG(VIDEO, "Compacted texture cache %s to %u of %zu textures", m_filename.c_str(),
+           num_entries, entries.size());
+}
+
+// Indexes the entries of the mapping, and returns the offset after the last valid one
+u64 TextureDiskCache::ReadEntries()
+{
+  const u8* data = m_mapping.GetData();
+  const u64 size = m_mapping.GetSize();
+
+  u64 offset = sizeof(Header);
+  while (size - offset >= sizeof(u32) + sizeof(Key))
+  {
+    u32 value_size;
+    Key key;
+    std::memcpy(&value_size, data + offset, sizeof(value_size));
+    std::memcpy(&key, data + offset + sizeof(value_size), sizeof(key));
+
+    const u64 value_offset = offset + sizeof(value_size) + sizeof(key);
+    if (size - value_offset < u64{value_size} + sizeof(u32))
+      break;
+
+    u32 entry_number;
+    std::memcpy(&entry_number, data + value_offset + value_size, sizeof(entry_number));
+    if (entry_number != m_num_entries + 1)
+      break;
+
+    // Later entries replace earlier ones, which might have failed to decompress
+    m_entries[key] = {value_offset, value_size, false};
+    m_num_entries++;
+    offset = value_offset + value_size + sizeof(entry_number);
+  }
+
+  m_num_loaded = static_cast<u32>(m_entries.size());
+  return offset;
+}
+
+bool TextureDiskCache::Read(const Key& key, u8* dst, size_t size)
+{
+  auto iter = m_entries.find(key);
+  if (iter == m_entries.end() || iter->second.offset == 0)
+    return false;
+
+  lzo_uint new_len = static_cast<lzo_uint>(size);
+  const int res = lzo1x_decompress_safe(m_mapping.GetData() + iter->second.offset,
+                                        iter->second.size, dst, &new_len, nullptr);
+  if (res != LZO_E_OK || new_len != size)
+  {
+    ERROR_LOG(VIDEO, "Failed to decompress cached texture %016" PRIx64 " (%d)", key.full_hash,
+              res);
+    m_entries.erase(iter);
+    return false;
+  }
+
+  iter->second.used = true;
+  m_num_hits++;
+  return true;
+}
+
+void TextureDiskCache::Append(const Key& key, const u8* data, size_t size)
+{
+  if (!IsOpen() || !m_entries.emplace(key, Entry{0, 0, false}).second)
+    return;
+
+  m_writer.EmplaceItem(PendingEntry{key, std::vector<u8>(data, data + size)});
+}
+
+void TextureDiskCache::WriteEntry(PendingEntry entry)
+{
+  std::vector<lzo_align_t> work_memory(LZO1X_1_MEM_COMPRESS / sizeof(lzo_align_t) + 1);
+
+  // Worst case size of incompressible data, from the LZO documentation
+  std::vector<u8> compressed(entry.data.size() + entry.data.size() / 16 + 64 + 3);
+  lzo_uint compressed_size = 0;
+  if (lzo1x_1_compress(entry.data.data(), static_cast<lzo_uint>(entry.data.size()),
+                       compressed.data(), &compressed_size, work_memory.data()) != LZO_E_OK)
+  {
+    ERROR_LOG(VIDEO, "Failed to compress texture %016" PRIx64, entry.key.full_hash);
+    return;
+  }
+
+  const u32 value_size = static_cast<u32>(compressed_size);
+  m_num_entries++;
+  m_file.WriteArray(&value_size, 1);
+  m_file.WriteArray(&entry.key, 1);
+  m_written.emplace_back(entry.key, Entry{m_file.Tell(), value_size, false});
+  m_file.WriteBytes(compressed.data(), value_size);
+  m_file.WriteArray(&m_num_entries, 1);
+}
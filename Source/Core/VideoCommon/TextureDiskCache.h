@@ -0,0 +1,113 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/MappedFile.h"
+#include "Common/WorkQueueThread.h"
+
+// Keeps decoded textures between sessions, so that textures seen before don't need to be decoded.
+//
+// The file is laid out like a LinearDiskCache: a header followed by entries which are only ever
+// appended, each made of the value size, the key, the LZO compressed RGBA data of all levels and a
+// running entry number. Entries of earlier sessions are decompressed straight from a mapping of
+// the file, so only the textures which are used again are read from disk. New textures are
+// compressed and appended by a separate thread, and can be read from the next session on.
+//
+// Files which grow past their size limit are compacted when the cache is destroyed: the textures
+// used or added by the session are kept, followed by the most recently added others. Closing the
+// cache for a config change doesn't compact it, since that would stall the video thread.
+class TextureDiskCache final
+{
+public:
+  struct Key
+  {
+    u64 base_hash;
+    u64 full_hash;
+    u32 width;
+    u32 height;
+    u32 levels;
+    u32 format;  // TextureFormat | (TLUTFormat << 8)
+
+    bool operator<(const Key& other) const;
+  };
+
+  // How the hashes of the keys were calculated. Files of another mode are started over.
+  enum class HashMode : u32
+  {
+    Full,
+    // The base hashes of single level textures are calculated per page, see HashMemory
+    Incremental,
+  };
+
+  static constexpr u64 DEFAULT_MAX_SIZE = 512 * 1024 * 1024;
+
+  ~TextureDiskCache();
+
+  bool Open(const std::string& filename, HashMode hash_mode, u64 max_size = DEFAULT_MAX_SIZE);
+  // Waits for all queued textures to be written. Oversized files are only compacted if compact is
+  // set.
+  void Close(bool compact = false);
+  bool IsOpen() const { return m_file.IsOpen(); }
+
+  // Decompresses the texture stored for key into dst. Fails unless the stored texture was written
+  // by an earlier session and is exactly size bytes long.
+  bool Read(const Key& key, u8* dst, size_t size);
+
+  // Queues a texture to be written, unless one with the same key is already stored.
+  void Append(const Key& key, const u8* data, size_t size);
+
+private:
+  struct Header
+  {
+    u32 id;
+    u32 key_size;
+    // Hashes of other hash functions don't identify the same textures
+    u64 hash_check;
+    u64 hash_mode;
+    char ver[40];
+  };
+
+  struct Entry
+  {
+    // Of the compressed data in the file. Entries written by this session have no offset until
+    // they are in m_written.
+    u64 offset;
+    u32 size;
+    bool used;  // read by this session
+  };
+
+  struct PendingEntry
+  {
+    Key key;
+    std::vector<u8> data;
+  };
+
+  static Header MakeHeader(HashMode hash_mode);
+  u64 ReadEntries();
+  void WriteEntry(PendingEntry entry);
+  void Compact();
+
+  std::string m_filename;
+  HashMode m_hash_mode = HashMode::Full;
+  u64 m_max_size = DEFAULT_MAX_SIZE;
+  File::MappedFile m_mapping;
+  std::map<Key, Entry> m_entries;
+  u32 m_num_loaded = 0;
+  u32 m_num_hits = 0;
+
+  // Only used by the writer thread while the file is open
+  File::IOFile m_file;
+  u32 m_num_entries = 0;
+  // Where the entries of this session were written to
+  std::vector<std::pair<Key, Entry>> m_written;
+  Common::WorkQueueThread<PendingEntry> m_writer;
+};
@@ -280,9 +280,12 @@ int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bo
   DataReader dst = g_vertex_manager->PrepareForAdditionalData(
       primitive, count, loader->m_native_vtx_decl.stride, cullall);
 
-  count = loader->RunVertices(src, dst, count);
+  {
+    ScopedStatTimer timer(&stats.thisFrame.vertexLoaderTimeNs);
+    count = loader->RunVertices(src, dst, count);
 
-  IndexGenerator::AddIndices(primitive, count);
+    IndexGenerator::AddIndices(primitive, count);
+  }
 
   g_vertex_manager->FlushData(count, loader->m_native_vtx_decl.stride);
 
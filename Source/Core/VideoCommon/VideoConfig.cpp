@@ -70,6 +70,8 @@ void VideoConfig::Refresh()
   bUseXFB = Config::Get(Config::GFX_USE_XFB);
   bUseRealXFB = Config::Get(Config::GFX_USE_REAL_XFB);
   iSafeTextureCache_ColorSamples = Config::Get(Config::GFX_SAFE_TEXTURE_CACHE_COLOR_SAMPLES);
+  bIncrementalTextureHash = Config::Get(Config::GFX_INCREMENTAL_TEXTURE_HASH);
+  bTextureDiskCache = Config::Get(Config::GFX_TEXTURE_DISK_CACHE);
   bShowFPS = Config::Get(Config::GFX_SHOW_FPS);
   bShowNetPlayPing = Config::Get(Config::GFX_SHOW_NETPLAY_PING);
   bShowNetPlayMessages = Config::Get(Config::GFX_SHOW_NETPLAY_MESSAGES);
@@ -90,6 +92,7 @@ void VideoConfig::Refresh()
   iBitrateKbps = Config::Get(Config::GFX_BITRATE_KBPS);
   bInternalResolutionFrameDumps = Config::Get(Config::GFX_INTERNAL_RESOLUTION_FRAME_DUMPS);
   bEnableGPUTextureDecoding = Config::Get(Config::GFX_ENABLE_GPU_TEXTURE_DECODING);
+  iTextureDecodeThreads = Config::Get(Config::GFX_TEXTURE_DECODE_THREADS);
   bEnablePixelLighting = Config::Get(Config::GFX_ENABLE_PIXEL_LIGHTING);
   bFastDepthCalc = Config::Get(Config::GFX_FAST_DEPTH_CALC);
   iMultisamples = Config::Get(Config::GFX_MSAA);
@@ -117,6 +120,8 @@ void VideoConfig::Refresh()
   bDumpTevTextureFetches = Config::Get(Config::GFX_SW_DUMP_TEV_TEX_FETCHES);
   drawStart = Config::Get(Config::GFX_SW_DRAW_START);
   drawEnd = Config::Get(Config::GFX_SW_DRAW_END);
+  iSWRasterizerThreads = Config::Get(Config::GFX_SW_RASTERIZER_THREADS);
+  bSWHeadless = Config::Get(Config::GFX_SW_HEADLESS);
 
   bForceFiltering = Config::Get(Config::GFX_ENHANCE_FORCE_FILTERING);
   iMaxAnisotropy = Config::Get(Config::GFX_ENHANCE_MAX_ANISOTROPY);
@@ -207,6 +212,24 @@ u32 VideoConfig::GetShaderPrecompilerThreads() const
     return GetNumAutoShaderCompilerThreads();
 }
 
+u32 VideoConfig::GetSWRasterizerThreads() const
+{
+  if (iSWRasterizerThreads > 0)
+    return static_cast<u32>(iSWRasterizerThreads);
+
+  // Automatic number. The CPU thread is usually busy as well, so leave one core for it.
+  return static_cast<u32>(std::max(cpu_info.num_cores - 1, 1));
+}
+
+u32 VideoConfig::GetTextureDecodeThreads() const
+{
+  if (iTextureDecodeThreads > 0)
+    return static_cast<u32>(iTextureDecodeThreads);
+
+  // Automatic number, including the GPU thread. We use clamp(cpus - 1, 1, 4).
+  return static_cast<u32>(std::min(std::max(cpu_info.num_cores - 1, 1), 4));
+}
+
 bool VideoConfig::CanPrecompileUberShaders() const
 {
   // We don't want to precompile ubershaders if they're never going to be used.
@@ -107,6 +107,7 @@ struct VideoConfig final
   bool bFreeLook;
   bool bBorderlessFullscreen;
   bool bEnableGPUTextureDecoding;
+  int iTextureDecodeThreads;
   int iBitrateKbps;
 
   // Hacks
@@ -120,6 +121,8 @@ struct VideoConfig final
   bool bSkipEFBCopyToRam;
   bool bCopyEFBScaled;
   int iSafeTextureCache_ColorSamples;
+  bool bIncrementalTextureHash;
+  bool bTextureDiskCache;
   ProjectionHackConfig phack;
   float fAspectRatioHackW, fAspectRatioHackH;
   bool bEnablePixelLighting;
@@ -148,6 +151,8 @@ struct VideoConfig final
   bool bDumpObjects;
   bool bDumpTevStages;
   bool bDumpTevTextureFetches;
+  int iSWRasterizerThreads;
+  bool bSWHeadless;
 
   // Enable API validation layers, currently only supported with Vulkan.
   bool bEnableValidationLayer;
@@ -247,6 +252,8 @@ struct VideoConfig final
   bool UseVertexRounding() const { return bVertexRounding && iEFBScale != 1; }
   u32 GetShaderCompilerThreads() const;
   u32 GetShaderPrecompilerThreads() const;
+  u32 GetSWRasterizerThreads() const;
+  u32 GetTextureDecodeThreads() const;
   bool CanPrecompileUberShaders() const;
   bool CanBackgroundCompileShaders() const;
 };
@@ -0,0 +1,142 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <iostream>
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <random>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/Timer.h"
+
+namespace
+{
+std::vector<u8> RandomData(size_t size, u32 seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<u8> data(size);
+  for (u8& byte : data)
+    byte = static_cast<u8>(rng());
+  return data;
+}
+
+// Runs a test once with the accelerated implementations if the CPU has them, and once with
+// the generic ones.
+template <typename Function>
+void ForEachImplementation(Function function)
+{
+  const bool has_aes = cpu_info.bAES;
+  const bool has_sha1 = cpu_info.bSHA1;
+  function();
+  cpu_info.bAES = false;
+  cpu_info.bSHA1 = false;
+  function();
+  cpu_info.bAES = has_aes;
+  cpu_info.bSHA1 = has_sha1;
+}
+
+template <typename Function>
+void Benchmark(const char* name, size_t bytes_per_run, Function function)
+{
+  constexpr int RUNS = 64;
+  const u64 start = Common::Timer::GetTimeUs();
+  for (int i = 0; i < RUNS; ++i)
+    function();
+  const u64 elapsed_us = std::max<u64>(Common::Timer::GetTimeUs() - start, 1);
+  std::cout << name << ": " << bytes_per_run * RUNS / elapsed_us << " MB/s" << std::endl;
+}
+}  // Anonymous namespace
+
+TEST(AES, MatchesReference)
+{
+  ForEachImplementation([] {
+    for (u32 seed = 0; seed < 20; ++seed)
+    {
+      const std::vector<u8> key = RandomData(16, seed);
+      const std::vector<u8> iv = RandomData(16, seed + 100);
+      // Sizes around the number of blocks decrypted at once.
+      const std::vector<u8> plaintext = RandomData(16 * (seed * 3 + 1), seed + 200);
+
+      mbedtls_aes_context reference;
+      mbedtls_aes_setkey_enc(&reference, key.data(), 128);
+      std::vector<u8> expected(plaintext.size());
+      std::array<u8, 16> expected_iv;
+      std::copy(iv.begin(), iv.end(), expected_iv.begin());
+      mbedtls_aes_crypt_cbc(&reference, MBEDTLS_AES_ENCRYPT, plaintext.size(), expected_iv.data(),
+                            plaintext.data(), expected.data());
+
+      std::vector<u8> ciphertext(plaintext.size());
+      std::array<u8, 16> current_iv;
+      std::copy(iv.begin(), iv.end(), current_iv.begin());
+      ASSERT_TRUE(Common::AES::Encrypt(key.data(), current_iv.data(), plaintext.data(),
+                                       ciphertext.data(), plaintext.size()));
+      EXPECT_EQ(expected, ciphertext);
+      EXPECT_EQ(expected_iv, current_iv);
+
+      // In place, in two parts chained through the IV.
+      const auto context = Common::AES::CreateContext(key.data(), Common::AES::Mode::Decrypt);
+      std::copy(iv.begin(), iv.end(), current_iv.begin());
+      const size_t first_part = ciphertext.size() / 32 * 16;
+      ASSERT_TRUE(context->Crypt(current_iv.data(), ciphertext.data(), ciphertext.data(),
+                                 first_part));
+      ASSERT_TRUE(context->Crypt(current_iv.data(), ciphertext.data() + first_part,
+                                 ciphertext.data() + first_part, ciphertext.size() - first_part));
+      EXPECT_EQ(plaintext, ciphertext);
+      EXPECT_EQ(expected_iv, current_iv);
+    }
+  });
+}
+
+TEST(AES, InvalidSize)
+{
+  ForEachImplementation([] {
+    const std::vector<u8> key(16);
+    std::array<u8, 16> iv{};
+    std::vector<u8> data(17);
+    EXPECT_FALSE(Common::AES::Decrypt(key.data(), iv.data(), data.data(), data.data(), 17));
+  });
+}
+
+TEST(SHA1, MatchesReference)
+{
+  ForEachImplementation([] {
+    // Every size around the block boundaries, where the padding changes.
+    for (size_t size = 0; size < 200; ++size)
+    {
+      const std::vector<u8> data = RandomData(size, static_cast<u32>(size));
+      Common::SHA1::Digest expected;
+      mbedtls_sha1(data.data(), data.size(), expected.data());
+      EXPECT_EQ(expected, Common::SHA1::CalculateDigest(data.data(), data.size())) << size;
+    }
+  });
+}
+
+TEST(Crypto, Throughput)
+{
+  // A Wii disc cluster.
+  std::vector<u8> data = RandomData(0x8000, 1);
+  const std::vector<u8> key = RandomData(16, 2);
+
+  ForEachImplementation([&] {
+    const char* implementation = cpu_info.bAES ? "accelerated" : "generic";
+    std::cout << implementation << std::endl;
+
+    const auto decrypt = Common::AES::CreateContext(key.data(), Common::AES::Mode::Decrypt);
+    const auto encrypt = Common::AES::CreateContext(key.data(), Common::AES::Mode::Encrypt);
+    std::array<u8, 16> iv{};
+    Benchmark("AES-CBC decrypt", data.size(),
+              [&] { decrypt->Crypt(iv.data(), data.data(), data.data(), data.size()); });
+    Benchmark("AES-CBC encrypt", data.size(),
+              [&] { encrypt->Crypt(iv.data(), data.data(), data.data(), data.size()); });
+    Benchmark("SHA-1", data.size(),
+              [&] { Common::SHA1::CalculateDigest(data.data(), data.size()); });
+  });
+}
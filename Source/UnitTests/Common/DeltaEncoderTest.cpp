@@ -0,0 +1,87 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "Common/DeltaEncoder.h"
+
+static std::vector<u8> RandomData(size_t size, u32 seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<u8> data(size);
+  for (u8& byte : data)
+    byte = static_cast<u8>(rng());
+  return data;
+}
+
+static void ExpectRoundTrip(const Common::DeltaEncoder& encoder, const std::vector<u8>& data,
+                            size_t max_delta_size)
+{
+  const std::vector<u8> delta = encoder.Encode(data.data(), data.size());
+  EXPECT_LE(delta.size(), max_delta_size);
+
+  std::vector<u8> decoded;
+  ASSERT_TRUE(encoder.Decode(delta, &decoded));
+  EXPECT_EQ(data, decoded);
+}
+
+TEST(DeltaEncoder, Unchanged)
+{
+  const std::vector<u8> base = RandomData(1024 * 1024 + 123, 1);
+  Common::DeltaEncoder encoder(base);
+  ExpectRoundTrip(encoder, base, 200);
+}
+
+TEST(DeltaEncoder, ChangedPages)
+{
+  const std::vector<u8> base = RandomData(1024 * 1024, 2);
+  Common::DeltaEncoder encoder(base);
+
+  std::vector<u8> data = base;
+  data[5000] ^= 1;
+  data[700000] ^= 1;
+  data.back() ^= 1;
+  // Three modified pages, plus some bytes for the operations.
+  ExpectRoundTrip(encoder, data, 3 * 4096 + 200);
+}
+
+TEST(DeltaEncoder, ShiftedData)
+{
+  const std::vector<u8> base = RandomData(1024 * 1024, 3);
+  Common::DeltaEncoder encoder(base);
+
+  // Something near the start grew by a few bytes, moving everything after it.
+  std::vector<u8> data = base;
+  data.insert(data.begin() + 100, {1, 2, 3, 4, 5, 6, 7});
+  data.erase(data.begin() + 500000, data.begin() + 500013);
+  ExpectRoundTrip(encoder, data, 4 * 4096 + 200);
+}
+
+TEST(DeltaEncoder, UnrelatedData)
+{
+  Common::DeltaEncoder encoder(RandomData(64 * 1024, 4));
+  const std::vector<u8> data = RandomData(100 * 1024 + 1, 5);
+  ExpectRoundTrip(encoder, data, data.size() + 200);
+
+  const std::vector<u8> small = RandomData(10, 6);
+  ExpectRoundTrip(encoder, small, small.size() + 200);
+  ExpectRoundTrip(encoder, {}, 200);
+}
+
+TEST(DeltaEncoder, WrongEncoder)
+{
+  const std::vector<u8> base = RandomData(64 * 1024, 7);
+  Common::DeltaEncoder encoder(base);
+  Common::DeltaEncoder other_encoder(base);
+
+  const std::vector<u8> delta = encoder.Encode(base.data(), base.size());
+  std::vector<u8> decoded;
+  EXPECT_FALSE(other_encoder.Decode(delta, &decoded));
+
+  std::vector<u8> truncated(delta.begin(), delta.end() - 1);
+  EXPECT_FALSE(encoder.Decode(truncated, &decoded));
+}
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
 #include <thread>
 
 #include "Common/FifoQueue.h"
@@ -69,3 +71,115 @@ TEST(FifoQueue, MultiThreaded)
   popper_thread.join();
   inserter_thread.join();
 }
+
+TEST(RingFifoQueue, Simple)
+{
+  // Small capacity, so that the overflow path gets exercised.
+  Common::RingFifoQueue<u32, true, 4> q;
+
+  EXPECT_EQ(0u, q.Size());
+  EXPECT_TRUE(q.Empty());
+
+  q.Push(1);
+  EXPECT_EQ(1u, q.Size());
+  EXPECT_FALSE(q.Empty());
+  EXPECT_EQ(1u, q.Front());
+
+  u32 v;
+  EXPECT_TRUE(q.Pop(v));
+  EXPECT_EQ(1u, v);
+  EXPECT_EQ(0u, q.Size());
+  EXPECT_TRUE(q.Empty());
+  EXPECT_FALSE(q.Pop(v));
+
+  // Test the FIFO order, across several overflows.
+  for (u32 i = 0; i < 1000; ++i)
+    q.Push(i);
+  EXPECT_EQ(1000u, q.Size());
+  for (u32 i = 0; i < 1000; ++i)
+  {
+    EXPECT_EQ(i, q.Front());
+    q.Pop();
+  }
+  EXPECT_TRUE(q.Empty());
+
+  // Interleaved pushes and pops which wrap around the ring.
+  u32 next_pop = 0;
+  for (u32 i = 0; i < 1000; ++i)
+  {
+    q.Push(i);
+    if (i % 3 != 0)
+    {
+      ASSERT_TRUE(q.Pop(v));
+      EXPECT_EQ(next_pop++, v);
+    }
+  }
+  EXPECT_EQ(1000u - next_pop, q.Size());
+
+  q.Clear();
+  EXPECT_TRUE(q.Empty());
+  EXPECT_EQ(0u, q.Size());
+}
+
+TEST(RingFifoQueue, MultiThreaded)
+{
+  Common::RingFifoQueue<u32, true, 16> q;
+
+  auto inserter = [&q]() {
+    for (u32 i = 0; i < 100000; ++i)
+      q.Push(i);
+  };
+
+  auto popper = [&q]() {
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      while (q.Empty())
+        ;
+      u32 v;
+      q.Pop(v);
+      EXPECT_EQ(i, v);
+    }
+  };
+
+  std::thread popper_thread(popper);
+  std::thread inserter_thread(inserter);
+
+  popper_thread.join();
+  inserter_thread.join();
+}
+
+template <typename Queue>
+static std::chrono::microseconds MeasureThroughput(u32 count)
+{
+  Queue q;
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  std::thread popper_thread([&q, count]() {
+    u64 sum = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+      u32 v;
+      while (!q.Pop(v))
+        std::this_thread::yield();
+      sum += v;
+    }
+    EXPECT_EQ(static_cast<u64>(count) * (count - 1) / 2, sum);
+  });
+  for (u32 i = 0; i < count; ++i)
+    q.Push(i);
+  popper_thread.join();
+
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::high_resolution_clock::now() - start);
+}
+
+TEST(RingFifoQueue, Benchmark)
+{
+  constexpr u32 COUNT = 1000000;
+  const auto node_time = MeasureThroughput<Common::FifoQueue<u32, false>>(COUNT);
+  const auto ring_time = MeasureThroughput<Common::RingFifoQueue<u32, false>>(COUNT);
+
+  printf("%u elements through FifoQueue: %8llu us, RingFifoQueue: %8llu us\n", COUNT,
+         static_cast<unsigned long long>(node_time.count()),
+         static_cast<unsigned long long>(ring_time.count()));
+}
@@ -0,0 +1,112 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Common/FlatHashMultiMap.h"
+
+TEST(FlatHashMultiMap, Simple)
+{
+  Common::FlatHashMultiMap<u32, int> map;
+  EXPECT_TRUE(map.Empty());
+
+  map.Insert(0x80000000, 1);
+  map.Insert(0x80000000, 2);
+  map.Insert(0x80000100, 3);
+  EXPECT_EQ(3u, map.Size());
+  EXPECT_TRUE(map.Contains(0x80000000, 2));
+  EXPECT_FALSE(map.Contains(0x80000100, 2));
+
+  int sum = 0;
+  map.ForEach(0x80000000, [&sum](int value) { sum += value; });
+  EXPECT_EQ(3, sum);
+
+  const int* found = map.FindIf(0x80000000, [](int value) { return value > 1; });
+  ASSERT_NE(nullptr, found);
+  EXPECT_EQ(2, *found);
+  EXPECT_EQ(nullptr, map.FindIf(0x80000200, [](int) { return true; }));
+
+  EXPECT_TRUE(map.Erase(0x80000000, 1));
+  EXPECT_FALSE(map.Erase(0x80000000, 1));
+  EXPECT_EQ(2u, map.Size());
+
+  map.Clear();
+  EXPECT_TRUE(map.Empty());
+  EXPECT_FALSE(map.Contains(0x80000000, 2));
+}
+
+TEST(FlatHashMultiMap, Duplicates)
+{
+  Common::FlatHashMultiMap<u32, int> map;
+  map.Insert(4, 7);
+  map.Insert(4, 7);
+  EXPECT_FALSE(map.InsertUnique(4, 7));
+  EXPECT_TRUE(map.InsertUnique(4, 8));
+  EXPECT_EQ(3u, map.Size());
+
+  EXPECT_EQ(2u, map.EraseAll(4, 7));
+  EXPECT_EQ(1u, map.Size());
+  EXPECT_TRUE(map.Contains(4, 8));
+}
+
+// Compares against std::multimap under a random mix of operations, which exercises growing
+// and the backward shift deletion with long probe sequences.
+TEST(FlatHashMultiMap, MatchesMultimap)
+{
+  Common::FlatHashMultiMap<u32, u32> map;
+  std::multimap<u32, u32> reference;
+  std::mt19937 rng(1234);
+
+  for (int i = 0; i < 100000; ++i)
+  {
+    // Few distinct, aligned keys to provoke collisions.
+    const u32 key = 0x80000000 + (rng() % 256) * 0x100;
+    const u32 value = rng() % 8;
+    if (rng() % 3 != 0)
+    {
+      map.Insert(key, value);
+      reference.emplace(key, value);
+    }
+    else
+    {
+      bool erased = false;
+      auto range = reference.equal_range(key);
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        if (it->second == value)
+        {
+          reference.erase(it);
+          erased = true;
+          break;
+        }
+      }
+      EXPECT_EQ(erased, map.Erase(key, value));
+    }
+  }
+
+  ASSERT_EQ(reference.size(), map.Size());
+  for (u32 key = 0x80000000; key < 0x80010000; key += 0x100)
+  {
+    std::vector<u32> expected;
+    auto range = reference.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+      expected.push_back(it->second);
+
+    std::vector<u32> actual;
+    map.ForEach(key, [&actual](u32 value) { actual.push_back(value); });
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+  }
+
+  size_t count = 0;
+  map.ForEachEntry([&count](u32, u32) { count++; });
+  EXPECT_EQ(reference.size(), count);
+}
@@ -0,0 +1,118 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+
+namespace
+{
+class HashTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_had_avx2 = cpu_info.bAVX2;
+    m_had_sse42 = cpu_info.bSSE4_2;
+
+    std::mt19937 rng(1234);
+    m_data.resize(0x40000 + 64);
+    for (u8& byte : m_data)
+      byte = static_cast<u8>(rng());
+  }
+
+  void TearDown() override
+  {
+    cpu_info.bAVX2 = m_had_avx2;
+    cpu_info.bSSE4_2 = m_had_sse42;
+    SetHash64Function();
+  }
+
+  static void UseHash(bool avx2, bool sse42)
+  {
+    cpu_info.bAVX2 = avx2;
+    cpu_info.bSSE4_2 = sse42;
+    SetHash64Function();
+  }
+
+  std::vector<u8> m_data;
+  bool m_had_avx2;
+  bool m_had_sse42;
+};
+}  // namespace
+
+#if defined(_M_X86_64)
+TEST_F(HashTest, AVX2MatchesScalar)
+{
+  if (!m_had_avx2)
+    return;
+
+  std::vector<u32> lengths;
+  for (u32 len = 1; len <= 2100; ++len)
+    lengths.push_back(len);
+  lengths.push_back(0x40000);
+
+  for (u32 offset : {0, 1, 8, 61})
+  {
+    for (u32 len : lengths)
+    {
+      UseHash(false, false);
+      const u64 scalar = GetHash64(&m_data[offset], len, 0);
+      UseHash(true, true);
+      const u64 avx2 = GetHash64(&m_data[offset], len, 0);
+      ASSERT_EQ(scalar, avx2) << "offset " << offset << " length " << len;
+    }
+  }
+}
+#endif
+
+TEST_F(HashTest, EveryByteCounts)
+{
+  // The data is hashed in 64 byte stripes with a scramble every 1024 bytes, and the last stripe
+  // overlaps the previous one, so check every position around those.
+  for (u32 len : {7, 64, 65, 1000, 1024, 1100, 4096})
+  {
+    const u64 hash = GetHash64(m_data.data(), len, 0);
+    for (u32 i = 0; i < len; ++i)
+    {
+      m_data[i] ^= 0x10;
+      EXPECT_NE(hash, GetHash64(m_data.data(), len, 0)) << "length " << len << " byte " << i;
+      m_data[i] ^= 0x10;
+    }
+    EXPECT_NE(hash, GetHash64(m_data.data(), len + 1, 0));
+  }
+}
+
+TEST_F(HashTest, Throughput)
+{
+  struct Backend
+  {
+    const char* name;
+    bool avx2;
+    bool sse42;
+  };
+  for (const Backend& backend : {Backend{"Portable", false, false},
+                                 Backend{"SSE4.2 CRC32", false, true}, Backend{"AVX2", true, true}})
+  {
+    if ((backend.avx2 && !m_had_avx2) || (backend.sse42 && !m_had_sse42))
+      continue;
+
+    UseHash(backend.avx2, backend.sse42);
+    const auto start = std::chrono::steady_clock::now();
+    u64 sum = 0;
+    constexpr int ITERATIONS = 16000;
+    for (int i = 0; i < ITERATIONS; ++i)
+      sum += GetHash64(m_data.data(), 0x4000, 0);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%s: %.1f GB/s (%llx)\n", backend.name, 0x4000 * ITERATIONS / seconds / 1e9,
+                static_cast<unsigned long long>(sum));
+  }
+}
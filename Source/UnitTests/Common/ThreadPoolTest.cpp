@@ -0,0 +1,64 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/ThreadPool.h"
+
+using Common::ThreadPool;
+
+TEST(ThreadPool, CallsEveryIndexOnce)
+{
+  ThreadPool pool(4, "ThreadPoolTest");
+  EXPECT_EQ(4u, pool.GetNumThreads());
+
+  for (size_t count : {0, 1, 3, 1000})
+  {
+    std::vector<std::atomic<int>> calls(count);
+    for (std::atomic<int>& c : calls)
+      c = 0;
+
+    pool.ParallelFor(count, [&](size_t i, size_t thread_index) {
+      EXPECT_LT(thread_index, pool.GetNumThreads());
+      ++calls[i];
+    });
+
+    for (const std::atomic<int>& c : calls)
+      EXPECT_EQ(1, c);
+  }
+}
+
+TEST(ThreadPool, ThreadIndicesAreExclusive)
+{
+  ThreadPool pool(4, "ThreadPoolTest");
+  std::vector<std::atomic<bool>> in_use(pool.GetNumThreads());
+  for (std::atomic<bool>& b : in_use)
+    b = false;
+
+  for (int run = 0; run < 100; ++run)
+  {
+    pool.ParallelFor(64, [&](size_t, size_t thread_index) {
+      EXPECT_FALSE(in_use[thread_index].exchange(true));
+      in_use[thread_index] = false;
+    });
+  }
+}
+
+TEST(ThreadPool, SingleThreadRunsInline)
+{
+  ThreadPool pool(1, "ThreadPoolTest");
+  EXPECT_EQ(1u, pool.GetNumThreads());
+
+  std::vector<size_t> order;
+  pool.ParallelFor(10, [&](size_t i, size_t thread_index) {
+    EXPECT_EQ(0u, thread_index);
+    order.push_back(i);
+  });
+
+  ASSERT_EQ(10u, order.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    EXPECT_EQ(i, order[i]);
+}
@@ -4,9 +4,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
 #include <string>
+#include <vector>
 
 #include "Common/Config/Config.h"
 #include "Common/FileUtil.h"
@@ -347,3 +349,63 @@ TEST(CoreTiming, Overclocking)
   SConfig::GetInstance().m_OCFactor = 1.0;
   AdvanceAndCheck(4, MAX_SLICE_LENGTH);
 }
+
+namespace RemoveEventTest
+{
+static std::vector<u64> s_ran;
+
+static void RecordCallback(u64 userdata, s64 lateness)
+{
+  s_ran.push_back(userdata);
+}
+}
+
+TEST(CoreTiming, RemoveEvent)
+{
+  using namespace RemoveEventTest;
+
+  ScopeInit guard;
+
+  CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", RecordCallback);
+  CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", RecordCallback);
+  CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", RecordCallback);
+  const std::array<CoreTiming::EventType*, 3> types{{cb_a, cb_b, cb_c}};
+
+  // Enter slice 0
+  CoreTiming::Advance();
+
+  // Interleave the types, with times out of order and some shared, to get a messy heap.
+  // The userdata is the expected position in the execution order.
+  constexpr u64 NUM_EVENTS = 300;
+  for (u64 i = 0; i < NUM_EVENTS; ++i)
+  {
+    const u64 slot = (i * 7) % NUM_EVENTS;
+    CoreTiming::ScheduleEvent(100 + slot / 2 * 10, types[slot % 3], slot);
+  }
+
+  CoreTiming::RemoveEvent(cb_b);
+  CoreTiming::RemoveEvent(cb_b);  // Nothing left, must be harmless.
+
+  // Every slice ends at the next event, so this takes one slice per distinct time.
+  s_ran.clear();
+  for (u64 i = 0; i < NUM_EVENTS; ++i)
+  {
+    PowerPC::ppcState.downcount = 0;
+    CoreTiming::Advance();
+  }
+
+  std::vector<u64> expected;
+  for (u64 slot = 0; slot < NUM_EVENTS; ++slot)
+  {
+    if (slot % 3 != 1)
+      expected.push_back(slot);
+  }
+
+  // Events with the same time run in the order they were scheduled, so only compare the order
+  // of the times.
+  ASSERT_EQ(expected.size(), s_ran.size());
+  for (size_t i = 1; i < s_ran.size(); ++i)
+    EXPECT_LE(s_ran[i - 1] / 2, s_ran[i] / 2);
+  std::sort(s_ran.begin(), s_ran.end());
+  EXPECT_EQ(expected, s_ran);
+}
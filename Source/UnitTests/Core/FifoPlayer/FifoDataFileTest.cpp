@@ -0,0 +1,252 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+
+namespace
+{
+// The layout of version 4 files, which were written uncompressed
+#pragma pack(push, 1)
+struct V4FileHeader
+{
+  u32 fileId;
+  u32 file_version;
+  u32 min_loader_version;
+  u64 bpMemOffset;
+  u32 bpMemSize;
+  u64 cpMemOffset;
+  u32 cpMemSize;
+  u64 xfMemOffset;
+  u32 xfMemSize;
+  u64 xfRegsOffset;
+  u32 xfRegsSize;
+  u64 frameListOffset;
+  u32 frameCount;
+  u32 flags;
+  u64 texMemOffset;
+  u32 texMemSize;
+  u8 reserved[40];
+};
+
+struct V4FrameInfo
+{
+  u64 fifoDataOffset;
+  u32 fifoDataSize;
+  u32 fifoStart;
+  u32 fifoEnd;
+  u64 memoryUpdatesOffset;
+  u32 numMemoryUpdates;
+  u8 reserved[32];
+};
+
+struct V4MemoryUpdate
+{
+  u32 fifoPosition;
+  u32 address;
+  u64 dataOffset;
+  u32 dataSize;
+  u8 type;
+  u8 reserved[3];
+};
+#pragma pack(pop)
+
+FifoFrameInfo MakeFrame(u32 seed)
+{
+  FifoFrameInfo frame;
+  frame.fifoStart = 0x00200000 + seed * 32;
+  frame.fifoEnd = 0x00220000;
+  // Repetitive, like real fifo data, so that it compresses
+  for (u32 i = 0; i < 4096 + seed; ++i)
+    frame.fifoData.push_back(static_cast<u8>(i % 13 == 0 ? seed : 0x61));
+
+  for (u32 i = 0; i < seed % 3; ++i)
+  {
+    MemoryUpdate update;
+    update.fifoPosition = i * 100;
+    update.address = 0x00300000 + seed * 0x1000;
+    update.data.assign(512 + i, static_cast<u8>(seed + i));
+    update.type = MemoryUpdate::TEXTURE_MAP;
+    frame.memoryUpdates.push_back(update);
+  }
+  return frame;
+}
+
+void ExpectFramesEqual(const FifoFrameInfo& expected, const FifoFrameInfo& actual)
+{
+  EXPECT_EQ(expected.fifoStart, actual.fifoStart);
+  EXPECT_EQ(expected.fifoEnd, actual.fifoEnd);
+  EXPECT_EQ(expected.fifoData, actual.fifoData);
+  ASSERT_EQ(expected.memoryUpdates.size(), actual.memoryUpdates.size());
+  for (size_t i = 0; i < expected.memoryUpdates.size(); ++i)
+  {
+    EXPECT_EQ(expected.memoryUpdates[i].fifoPosition, actual.memoryUpdates[i].fifoPosition);
+    EXPECT_EQ(expected.memoryUpdates[i].address, actual.memoryUpdates[i].address);
+    EXPECT_EQ(expected.memoryUpdates[i].data, actual.memoryUpdates[i].data);
+    EXPECT_EQ(expected.memoryUpdates[i].type, actual.memoryUpdates[i].type);
+  }
+}
+
+class FifoDataFileTest : public testing::Test
+{
+protected:
+  void SetUp() override { m_temp_dir = File::CreateTempDir(); }
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  std::string m_temp_dir;
+};
+}  // namespace
+
+TEST_F(FifoDataFileTest, SaveAndLoad)
+{
+  const std::string path = m_temp_dir + "/test.dff";
+
+  FifoDataFile file;
+  file.SetIsWii(true);
+  file.GetBPMem()[0x10] = 0x12345678;
+  file.GetTexMem()[1000] = 0x42;
+  for (u32 i = 0; i < 20; ++i)
+    file.AddFrame(MakeFrame(i));
+  ASSERT_TRUE(file.Save(path));
+
+  // Every frame was compressed
+  u64 raw_size = 0;
+  for (u32 i = 0; i < 20; ++i)
+    raw_size += MakeFrame(i).fifoData.size();
+  EXPECT_LT(File::GetSize(path), FifoDataFile::TEX_MEM_SIZE + 0x10000 + raw_size / 4);
+
+  std::unique_ptr<FifoDataFile> loaded = FifoDataFile::Load(path, false);
+  ASSERT_TRUE(loaded);
+  EXPECT_TRUE(loaded->GetIsWii());
+  EXPECT_FALSE(loaded->HasBrokenEFBCopies());
+  EXPECT_EQ(0x12345678u, loaded->GetBPMem()[0x10]);
+  EXPECT_EQ(0x42, loaded->GetTexMem()[1000]);
+  ASSERT_EQ(20u, loaded->GetFrameCount());
+
+  // Frames can be read in any order, and more of them than are cached at once
+  for (u32 i : {7, 19, 0, 7, 3, 12, 1, 2, 4, 5, 19, 7})
+    ExpectFramesEqual(MakeFrame(i), *loaded->GetFrame(i));
+
+  // A frame that is held stays valid after it was evicted from the cache
+  const auto held = loaded->GetFrame(9);
+  for (u32 i = 0; i < 20; ++i)
+    loaded->GetFrame(i);
+  ExpectFramesEqual(MakeFrame(9), *held);
+}
+
+TEST_F(FifoDataFileTest, LoadVersion4)
+{
+  const std::string path = m_temp_dir + "/v4.dff";
+  const FifoFrameInfo frame = MakeFrame(5);
+
+  std::vector<u8> data(sizeof(V4FileHeader) + sizeof(V4FrameInfo));
+  auto append = [&data](const void* src, size_t size) {
+    const u64 offset = data.size();
+    data.insert(data.end(), static_cast<const u8*>(src), static_cast<const u8*>(src) + size);
+    return offset;
+  };
+
+  std::vector<u32> bp_mem(FifoDataFile::BP_MEM_SIZE, 0x11);
+  std::vector<u32> zero_regs(FifoDataFile::XF_MEM_SIZE);
+  std::vector<u8> tex_mem(FifoDataFile::TEX_MEM_SIZE, 0x22);
+
+  V4FileHeader header = {};
+  header.fileId = 0x0d01f1f0;
+  header.file_version = 4;
+  header.min_loader_version = 1;
+  header.bpMemSize = FifoDataFile::BP_MEM_SIZE;
+  header.bpMemOffset = append(bp_mem.data(), header.bpMemSize * 4);
+  header.cpMemSize = FifoDataFile::CP_MEM_SIZE;
+  header.cpMemOffset = append(zero_regs.data(), header.cpMemSize * 4);
+  header.xfMemSize = FifoDataFile::XF_MEM_SIZE;
+  header.xfMemOffset = append(zero_regs.data(), header.xfMemSize * 4);
+  header.xfRegsSize = FifoDataFile::XF_REGS_SIZE;
+  header.xfRegsOffset = append(zero_regs.data(), header.xfRegsSize * 4);
+  header.texMemSize = FifoDataFile::TEX_MEM_SIZE;
+  header.texMemOffset = append(tex_mem.data(), tex_mem.size());
+  header.frameListOffset = sizeof(V4FileHeader);
+  header.frameCount = 1;
+
+  V4FrameInfo frame_info = {};
+  frame_info.fifoDataSize = static_cast<u32>(frame.fifoData.size());
+  frame_info.fifoDataOffset = append(frame.fifoData.data(), frame.fifoData.size());
+  frame_info.fifoStart = frame.fifoStart;
+  frame_info.fifoEnd = frame.fifoEnd;
+  frame_info.numMemoryUpdates = static_cast<u32>(frame.memoryUpdates.size());
+  std::vector<V4MemoryUpdate> updates(frame.memoryUpdates.size());
+  for (size_t i = 0; i < updates.size(); ++i)
+  {
+    updates[i].fifoPosition = frame.memoryUpdates[i].fifoPosition;
+    updates[i].address = frame.memoryUpdates[i].address;
+    updates[i].dataSize = static_cast<u32>(frame.memoryUpdates[i].data.size());
+    updates[i].dataOffset =
+        append(frame.memoryUpdates[i].data.data(), frame.memoryUpdates[i].data.size());
+    updates[i].type = frame.memoryUpdates[i].type;
+  }
+  frame_info.memoryUpdatesOffset = append(updates.data(), updates.size() * sizeof(V4MemoryUpdate));
+
+  std::memcpy(data.data(), &header, sizeof(header));
+  std::memcpy(data.data() + sizeof(header), &frame_info, sizeof(frame_info));
+  ASSERT_TRUE(File::IOFile(path, "wb").WriteBytes(data.data(), data.size()));
+
+  std::unique_ptr<FifoDataFile> loaded = FifoDataFile::Load(path, false);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(0x11u, loaded->GetBPMem()[0xff]);
+  EXPECT_EQ(0x22, loaded->GetTexMem()[FifoDataFile::TEX_MEM_SIZE - 1]);
+  ASSERT_EQ(1u, loaded->GetFrameCount());
+  ExpectFramesEqual(frame, *loaded->GetFrame(0));
+
+  // Saving converts the file to the current version
+  const std::string converted_path = m_temp_dir + "/converted.dff";
+  ASSERT_TRUE(loaded->Save(converted_path));
+  std::unique_ptr<FifoDataFile> converted = FifoDataFile::Load(converted_path, false);
+  ASSERT_TRUE(converted);
+  ExpectFramesEqual(frame, *converted->GetFrame(0));
+}
+
+TEST_F(FifoDataFileTest, CorruptFrameIsEmpty)
+{
+  const std::string path = m_temp_dir + "/corrupt.dff";
+
+  FifoDataFile file;
+  file.AddFrame(MakeFrame(1));
+  file.AddFrame(MakeFrame(2));
+  ASSERT_TRUE(file.Save(path));
+
+  // Overwrite the end of the last compressed frame
+  {
+    File::IOFile corrupt(path, "r+b");
+    ASSERT_TRUE(corrupt.Seek(-16, SEEK_END));
+    const std::vector<u8> garbage(16, 0xff);
+    ASSERT_TRUE(corrupt.WriteBytes(garbage.data(), garbage.size()));
+  }
+
+  std::unique_ptr<FifoDataFile> loaded = FifoDataFile::Load(path, false);
+  ASSERT_TRUE(loaded);
+  ExpectFramesEqual(MakeFrame(1), *loaded->GetFrame(0));
+  EXPECT_TRUE(loaded->GetFrame(1)->fifoData.empty());
+}
+
+TEST_F(FifoDataFileTest, RejectsTruncatedFile)
+{
+  const std::string path = m_temp_dir + "/truncated.dff";
+
+  FifoDataFile file;
+  file.AddFrame(MakeFrame(1));
+  ASSERT_TRUE(file.Save(path));
+
+  std::string data;
+  ASSERT_TRUE(File::ReadFileToString(path, data));
+  ASSERT_TRUE(File::WriteStringToFile(data.substr(0, 1000), path));
+  EXPECT_FALSE(FifoDataFile::Load(path, false));
+  EXPECT_TRUE(FifoDataFile::Load(path, true));
+}
@@ -0,0 +1,106 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/FifoPlayer/FifoAnalyzer.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+#include "Core/FifoPlayer/FifoPlaybackAnalyzer.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
+#include "UICommon/UICommon.h"
+#include "VideoCommon/OpcodeDecoding.h"
+
+namespace
+{
+void PushU32(std::vector<u8>* data, u32 value)
+{
+  for (int shift = 24; shift >= 0; shift -= 8)
+    data->push_back(static_cast<u8>(value >> shift));
+}
+
+void LoadCPReg(std::vector<u8>* data, u8 reg, u32 value)
+{
+  data->push_back(OpcodeDecoder::GX_LOAD_CP_REG);
+  data->push_back(reg);
+  PushU32(data, value);
+}
+
+// Sets up VAT 0 for vertices with just a direct float xyz position
+FifoFrameInfo MakeSetupFrame()
+{
+  FifoFrameInfo frame;
+  LoadCPReg(&frame.fifoData, 0x50, 1 << 9);
+  LoadCPReg(&frame.fifoData, 0x70, 1 | (4 << 1));
+  return frame;
+}
+
+// One triangle, which ends with a BP write. Its vertices are BP writes as well if they're taken
+// for commands.
+FifoFrameInfo MakeDrawFrame()
+{
+  FifoFrameInfo frame;
+  frame.fifoData.push_back(0x80 | OpcodeDecoder::GX_DRAW_TRIANGLES
+                                      << OpcodeDecoder::GX_PRIMITIVE_SHIFT);
+  frame.fifoData.push_back(0);
+  frame.fifoData.push_back(3);
+  frame.fifoData.insert(frame.fifoData.end(), 3 * 12, OpcodeDecoder::GX_LOAD_BP_REG);
+  frame.fifoData.push_back(OpcodeDecoder::GX_LOAD_BP_REG);
+  PushU32(&frame.fifoData, 0);
+  return frame;
+}
+}  // namespace
+
+TEST(FifoPlaybackAnalyzerTest, VertexFormatsCarryOverToLaterFrames)
+{
+  FifoDataFile file;
+  FifoAnalyzer::CPMemory cp_mem = FifoPlaybackAnalyzer::GetInitialCPMemory(&file);
+
+  AnalyzedFrameInfo setup;
+  ASSERT_TRUE(FifoPlaybackAnalyzer::AnalyzeFrame(MakeSetupFrame(), &cp_mem, &setup));
+  EXPECT_TRUE(setup.objectStarts.empty());
+
+  AnalyzedFrameInfo draw;
+  ASSERT_TRUE(FifoPlaybackAnalyzer::AnalyzeFrame(MakeDrawFrame(), &cp_mem, &draw));
+  EXPECT_EQ(std::vector<u32>{0}, draw.objectStarts);
+  EXPECT_EQ(std::vector<u32>{3 + 3 * 12}, draw.objectEnds);
+
+  // Without the setup, the vertices have no size
+  cp_mem = FifoPlaybackAnalyzer::GetInitialCPMemory(&file);
+  AnalyzedFrameInfo unformatted;
+  ASSERT_TRUE(FifoPlaybackAnalyzer::AnalyzeFrame(MakeDrawFrame(), &cp_mem, &unformatted));
+  EXPECT_EQ(std::vector<u32>{3}, unformatted.objectEnds);
+}
+
+TEST(FifoPlaybackAnalyzerTest, PlayerAnalyzesFramesWhenAskedFor)
+{
+  const std::string temp_dir = File::CreateTempDir();
+  const std::string path = temp_dir + "/test.dff";
+  UICommon::SetUserDirectory(temp_dir);
+  Config::Init();
+  SConfig::Init();
+
+  FifoDataFile file;
+  file.AddFrame(MakeSetupFrame());
+  for (int i = 0; i < 3; ++i)
+    file.AddFrame(MakeDrawFrame());
+  ASSERT_TRUE(file.Save(path));
+
+  FifoPlayer& player = FifoPlayer::GetInstance();
+  ASSERT_TRUE(player.Open(path));
+  // Asking for a later frame first still analyzes the ones before it
+  EXPECT_EQ(std::vector<u32>{3 + 3 * 12}, player.GetAnalyzedFrameInfo(3).objectEnds);
+  EXPECT_TRUE(player.GetAnalyzedFrameInfo(0).objectStarts.empty());
+  EXPECT_EQ(std::vector<u32>{3 + 3 * 12}, player.GetAnalyzedFrameInfo(1).objectEnds);
+  player.Close();
+
+  SConfig::Shutdown();
+  Config::Shutdown();
+  File::DeleteDirRecursively(temp_dir);
+}
@@ -0,0 +1,125 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+#include <thread>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
+#include "Core/MemTools.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+namespace
+{
+constexpr u32 PAGE_SIZE = Memory::WRITE_TRACKING_PAGE_SIZE;
+
+class MemmapTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_profile_path = File::CreateTempDir();
+    UICommon::SetUserDirectory(m_profile_path);
+    Config::Init();
+    SConfig::Init();
+    SConfig::GetInstance().bWii = false;
+    Memory::Init();
+    EMM::InstallExceptionHandler();
+    Memory::EnableWriteTracking();
+  }
+
+  void TearDown() override
+  {
+    Memory::DisableWriteTracking();
+    EMM::UninstallExceptionHandler();
+    Memory::Shutdown();
+    SConfig::Shutdown();
+    Config::Shutdown();
+    File::DeleteDirRecursively(m_profile_path);
+  }
+
+  std::string m_profile_path;
+};
+}  // namespace
+
+#if defined(_M_X86_64) && !defined(__APPLE__)
+TEST_F(MemmapTest, TracksWrites)
+{
+  // Three pages, starting and ending in the middle of one
+  const u32 address = 0x10000 - 0x20;
+  std::array<u32, 3> before;
+  ASSERT_TRUE(Memory::TrackWrites(address, 0x1040, before.data()));
+
+  Memory::Write_U32(0x12345678, 0x10000 + 0x800);
+  Memory::Write_U32(0x9abcdef0, 0x10000 + 0x804);
+  EXPECT_EQ(0x12345678u, Memory::Read_U32(0x10000 + 0x800));
+
+  std::array<u32, 3> after;
+  ASSERT_TRUE(Memory::TrackWrites(address, 0x1040, after.data()));
+  EXPECT_EQ(before[0], after[0]);
+  EXPECT_EQ(before[1] + 1, after[1]);
+  EXPECT_EQ(before[2], after[2]);
+
+  // Writes from other threads are caught as well
+  std::thread([] { Memory::Write_U8(1, 0x11000 + 5); }).join();
+  std::array<u32, 3> from_thread;
+  ASSERT_TRUE(Memory::TrackWrites(address, 0x1040, from_thread.data()));
+  EXPECT_EQ(after[2] + 1, from_thread[2]);
+  EXPECT_EQ(after[1], from_thread[1]);
+}
+
+TEST_F(MemmapTest, TracksWritesThroughLogicalViews)
+{
+  // Map 0x80000000 to physical address 0, like the usual BAT setup
+  PowerPC::BatTable dbat_table{};
+  for (u32 i = 0; i < 16; ++i)
+  {
+    dbat_table[(0x80000000 >> PowerPC::BAT_INDEX_SHIFT) + i] =
+        (i << PowerPC::BAT_INDEX_SHIFT) | PowerPC::BAT_MAPPED_BIT | PowerPC::BAT_PHYSICAL_BIT;
+  }
+  Memory::UpdateLogicalMemory(dbat_table);
+
+  u32 before;
+  ASSERT_TRUE(Memory::TrackWrites(0x3000, PAGE_SIZE, &before));
+  Memory::logical_base[0x80003000 + 12] = 0x55;
+  EXPECT_EQ(0x55, Memory::Read_U8(0x3000 + 12));
+
+  u32 after;
+  ASSERT_TRUE(Memory::TrackWrites(0x3000, PAGE_SIZE, &after));
+  EXPECT_EQ(before + 1, after);
+
+  // Replacing the views counts the tracked pages as written, since they lose their protection
+  Memory::UpdateLogicalMemory(dbat_table);
+  ASSERT_TRUE(Memory::TrackWrites(0x3000, PAGE_SIZE, &before));
+  EXPECT_EQ(after + 1, before);
+}
+
+TEST_F(MemmapTest, ClearCountsAsWrite)
+{
+  u32 before;
+  ASSERT_TRUE(Memory::TrackWrites(0, PAGE_SIZE, &before));
+  Memory::Clear();
+  u32 after;
+  ASSERT_TRUE(Memory::TrackWrites(0, PAGE_SIZE, &after));
+  EXPECT_NE(before, after);
+}
+#endif
+
+TEST_F(MemmapTest, RejectsUntrackableRanges)
+{
+  u32 count;
+  EXPECT_FALSE(Memory::TrackWrites(0, 0, &count));
+  EXPECT_FALSE(Memory::TrackWrites(Memory::REALRAM_SIZE - 4, 8, &count));
+  EXPECT_FALSE(Memory::TrackWrites(0x10000000, 4, &count));
+
+  Memory::DisableWriteTracking();
+  EXPECT_FALSE(Memory::TrackWrites(0, 4, &count));
+}
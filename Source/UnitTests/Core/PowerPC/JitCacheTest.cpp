@@ -0,0 +1,317 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/PowerPC.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class FakeJit : public JitBase
+{
+public:
+  // CPUCoreBase methods
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override {}
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() override { return nullptr; }
+  // JitBase methods
+  JitBaseBlockCache* GetBlockCache() override { return nullptr; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+};
+
+class FakeBlockCache : public JitBaseBlockCache
+{
+public:
+  explicit FakeBlockCache(JitBase& jit) : JitBaseBlockCache(jit) {}
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override {}
+};
+
+constexpr u32 CODE_BASE = 0x80003100;
+constexpr u32 BLOCK_SPACING = 0x40;
+
+// Adds a block of num_instructions contiguous instructions, which links to the next block.
+JitBlock* AddBlock(JitBaseBlockCache& cache, u32 address, u32 num_instructions)
+{
+  JitBlock* block = cache.AllocateBlock(address);
+  block->checkedEntry = nullptr;
+  block->normalEntry = nullptr;
+  block->codeSize = 0;
+  block->originalSize = num_instructions;
+  block->linkData.push_back({nullptr, address + BLOCK_SPACING, false, false});
+
+  std::set<u32> physical_addresses;
+  for (u32 i = 0; i < num_instructions; ++i)
+    physical_addresses.insert(address + i * 4);
+  cache.FinalizeBlock(*block, true, physical_addresses);
+  return block;
+}
+
+// A copy of the node-based indexes the block cache used to have, for comparison.
+struct NodeBasedLayout
+{
+  std::multimap<u32, JitBlock> block_map;
+  std::map<u32, std::set<JitBlock*>> block_range_map;
+  std::map<JitBlock*, std::set<u32>> physical_addresses;
+
+  void Add(u32 address, u32 num_instructions)
+  {
+    JitBlock& block = block_map.emplace(address, JitBlock())->second;
+    block.effectiveAddress = address;
+    block.physicalAddress = address;
+    block.msrBits = 0;
+    for (u32 i = 0; i < num_instructions; ++i)
+    {
+      physical_addresses[&block].insert(address + i * 4);
+      block_range_map[(address + i * 4) & ~0xFFu].insert(&block);
+    }
+  }
+
+  JitBlock* Find(u32 address)
+  {
+    auto iter = block_map.equal_range(address);
+    for (; iter.first != iter.second; iter.first++)
+    {
+      if (iter.first->second.effectiveAddress == address)
+        return &iter.first->second;
+    }
+    return nullptr;
+  }
+
+  void Erase(u32 address, u32 length)
+  {
+    auto start = block_range_map.lower_bound(address & ~0xFFu);
+    auto end = block_range_map.lower_bound(address + length);
+    while (start != end)
+    {
+      auto iter = start->second.begin();
+      while (iter != start->second.end())
+      {
+        JitBlock* block = *iter;
+        const std::set<u32>& addresses = physical_addresses[block];
+        if (addresses.lower_bound(address) != addresses.lower_bound(address + length))
+        {
+          for (u32 addr : addresses)
+            if ((addr & ~0xFFu) != start->first)
+              block_range_map[addr & ~0xFFu].erase(block);
+          physical_addresses.erase(block);
+
+          auto block_map_iter = block_map.equal_range(block->physicalAddress);
+          while (block_map_iter.first != block_map_iter.second)
+          {
+            if (&block_map_iter.first->second == block)
+            {
+              block_map.erase(block_map_iter.first);
+              break;
+            }
+            block_map_iter.first++;
+          }
+          iter = start->second.erase(iter);
+        }
+        else
+        {
+          iter++;
+        }
+      }
+
+      if (start->second.empty())
+        start = block_range_map.erase(start);
+      else
+        start++;
+    }
+  }
+};
+
+class JitCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    MSR = 0;
+    m_cache.Clear();
+  }
+
+  FakeJit m_jit;
+  FakeBlockCache m_cache{m_jit};
+};
+}  // Anonymous namespace
+
+TEST(ValidBlockBitSet, SetTestClear)
+{
+  ValidBlockBitSet valid_block;
+  EXPECT_FALSE(valid_block.Test(0));
+  EXPECT_FALSE(valid_block.Test(0xFFFFFFE0 / 32));
+
+  // Clearing a bit of a region without any set bits must not need any memory.
+  valid_block.Clear(0x10000000 / 32);
+  EXPECT_FALSE(valid_block.Test(0x10000000 / 32));
+
+  valid_block.Set(0x00003100 / 32);
+  valid_block.Set(0x13FFFFE0 / 32);
+  EXPECT_TRUE(valid_block.Test(0x00003100 / 32));
+  EXPECT_FALSE(valid_block.Test(0x00003120 / 32));
+  EXPECT_TRUE(valid_block.Test(0x13FFFFE0 / 32));
+
+  valid_block.Clear(0x00003100 / 32);
+  EXPECT_FALSE(valid_block.Test(0x00003100 / 32));
+  EXPECT_TRUE(valid_block.Test(0x13FFFFE0 / 32));
+
+  valid_block.ClearAll();
+  EXPECT_FALSE(valid_block.Test(0x13FFFFE0 / 32));
+}
+
+// Mirrors the lookup emitted by the JITs for dcb* instructions.
+TEST(ValidBlockBitSet, JitLookup)
+{
+  ValidBlockBitSet valid_block;
+  const u32 addresses[] = {0x80003100, 0x817FFFE0, 0x90100020, 0x93FFFFE0};
+  for (u32 address : addresses)
+    valid_block.Set((address & 0x1FFFFFFF) / 32);
+
+  for (u32 address : addresses)
+  {
+    for (u32 line = address - 64; line != address + 64; line += 32)
+    {
+      const u32 region = (line & 0x1FFFFFFF) >> ValidBlockBitSet::REGION_SHIFT;
+      const u32* chunk = valid_block.m_chunks[region];
+      const u32 word = chunk[(line >> 10) & (ValidBlockBitSet::WORDS_PER_CHUNK - 1)];
+      const bool bit = (word >> ((line >> 5) % 32)) & 1;
+      EXPECT_EQ(valid_block.Test((line & 0x1FFFFFFF) / 32), bit);
+      EXPECT_EQ(line == address, bit);
+    }
+  }
+}
+
+TEST_F(JitCacheTest, Lookup)
+{
+  JitBlock* a = AddBlock(m_cache, CODE_BASE, 4);
+  JitBlock* b = AddBlock(m_cache, CODE_BASE + BLOCK_SPACING, 4);
+
+  EXPECT_EQ(a, m_cache.GetBlockFromStartAddress(CODE_BASE, 0));
+  EXPECT_EQ(b, m_cache.GetBlockFromStartAddress(CODE_BASE + BLOCK_SPACING, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + 4, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE, 0x30));
+}
+
+TEST_F(JitCacheTest, EraseOverlappingBlocksOnly)
+{
+  AddBlock(m_cache, CODE_BASE, 4);
+  AddBlock(m_cache, CODE_BASE + BLOCK_SPACING, 4);
+
+  // The gap between the two blocks doesn't contain code.
+  m_cache.ErasePhysicalRange(CODE_BASE + 0x10, 0x20);
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE, 0));
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + BLOCK_SPACING, 0));
+
+  m_cache.ErasePhysicalRange(CODE_BASE + 0xC, 4);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE, 0));
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + BLOCK_SPACING, 0));
+}
+
+TEST_F(JitCacheTest, EraseBlockSpanningMacroBlocks)
+{
+  // 0x80 instructions span three macro blocks of 0x100 bytes.
+  AddBlock(m_cache, CODE_BASE + 0xC0, 0x80);
+
+  m_cache.ErasePhysicalRange(CODE_BASE + 0x2BC, 4);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + 0xC0, 0));
+
+  // A new block in the same place must be found and erased normally again.
+  AddBlock(m_cache, CODE_BASE + 0xC0, 0x80);
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + 0xC0, 0));
+  m_cache.ErasePhysicalRange(CODE_BASE + 0xC0, 4);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + 0xC0, 0));
+}
+
+TEST_F(JitCacheTest, EraseHugeRange)
+{
+  for (u32 i = 0; i < 16; ++i)
+    AddBlock(m_cache, CODE_BASE + i * BLOCK_SPACING, 8);
+  AddBlock(m_cache, 0x81000000, 8);
+
+  m_cache.ErasePhysicalRange(0x80000000, 0x01000000);
+  for (u32 i = 0; i < 16; ++i)
+    EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + i * BLOCK_SPACING, 0));
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(0x81000000, 0));
+}
+
+TEST_F(JitCacheTest, Benchmark)
+{
+  constexpr u32 NUM_BLOCKS = 20000;
+  constexpr u32 NUM_LOOKUPS = 1000000;
+
+  std::mt19937 rng(42);
+  std::vector<u32> sizes(NUM_BLOCKS);
+  for (u32& size : sizes)
+    size = 1 + rng() % (BLOCK_SPACING / 4);
+  std::vector<u32> lookups(NUM_LOOKUPS);
+  for (u32& address : lookups)
+    address = CODE_BASE + (rng() % NUM_BLOCKS) * BLOCK_SPACING;
+
+  NodeBasedLayout old_layout;
+  for (u32 i = 0; i < NUM_BLOCKS; ++i)
+  {
+    AddBlock(m_cache, CODE_BASE + i * BLOCK_SPACING, sizes[i]);
+    old_layout.Add(CODE_BASE + i * BLOCK_SPACING, sizes[i]);
+  }
+
+  using Clock = std::chrono::high_resolution_clock;
+  const auto as_us = [](Clock::duration d) {
+    return static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+  };
+
+  u32 found = 0;
+  auto start = Clock::now();
+  for (u32 address : lookups)
+    found += m_cache.GetBlockFromStartAddress(address, 0) != nullptr;
+  const auto new_lookup = Clock::now() - start;
+  EXPECT_EQ(NUM_LOOKUPS, found);
+
+  found = 0;
+  start = Clock::now();
+  for (u32 address : lookups)
+    found += old_layout.Find(address) != nullptr;
+  const auto old_lookup = Clock::now() - start;
+  EXPECT_EQ(NUM_LOOKUPS, found);
+
+  // Invalidate everything one cache line at a time, like dcbi/icbi loops do.
+  const u32 end = CODE_BASE + NUM_BLOCKS * BLOCK_SPACING;
+  start = Clock::now();
+  for (u32 address = CODE_BASE; address < end; address += 32)
+    m_cache.ErasePhysicalRange(address, 32);
+  const auto new_erase = Clock::now() - start;
+
+  start = Clock::now();
+  for (u32 address = CODE_BASE; address < end; address += 32)
+    old_layout.Erase(address, 32);
+  const auto old_erase = Clock::now() - start;
+
+  for (u32 i = 0; i < NUM_BLOCKS; i += 1000)
+    EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(CODE_BASE + i * BLOCK_SPACING, 0));
+  EXPECT_TRUE(old_layout.block_map.empty());
+
+  printf("JIT block cache, %u blocks:\n", NUM_BLOCKS);
+  printf("%u lookups:      %8llu us (node-based: %8llu us)\n", NUM_LOOKUPS, as_us(new_lookup),
+         as_us(old_lookup));
+  printf("line invalidation: %8llu us (node-based: %8llu us)\n", as_us(new_erase),
+         as_us(old_erase));
+}
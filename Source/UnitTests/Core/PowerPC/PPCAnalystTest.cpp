@@ -0,0 +1,159 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+constexpr u32 FUNCTION_ADDRESS = 0x00003000;
+constexpr u32 FUNCTION_SIZE = 0x40;
+constexpr u32 BLOCK_SIZE = 64;
+
+constexpr u32 NOP = 0x60000000;
+constexpr u32 BLR = 0x4E800020;
+
+constexpr u32 Branch(u32 from, u32 to)
+{
+  return 0x48000000 | ((to - from) & 0x03FFFFFC);
+}
+
+class PPCAnalystTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    Interpreter::getInstance()->Init();
+    MSR = 0;
+
+    m_ram.resize(Memory::REALRAM_SIZE);
+    Memory::m_pRAM = m_ram.data();
+    for (u32 address = FUNCTION_ADDRESS; address < FUNCTION_ADDRESS + FUNCTION_SIZE; address += 4)
+      WriteInstruction(address, NOP);
+    WriteInstruction(FUNCTION_ADDRESS + FUNCTION_SIZE - 4, BLR);
+
+    m_block.m_stats = &m_stats;
+    m_block.m_gpa = &m_gpa;
+    m_block.m_fpa = &m_fpa;
+  }
+
+  void TearDown() override
+  {
+    g_symbolDB.Clear();
+    Memory::m_pRAM = nullptr;
+  }
+
+  void WriteInstruction(u32 address, u32 instruction)
+  {
+    const u32 value = Common::swap32(instruction);
+    std::memcpy(&m_ram[address], &value, sizeof(value));
+  }
+
+  // Writes a b instruction, with both addresses relative to the start of the function
+  void WriteJump(u32 offset, u32 target_offset)
+  {
+    const u32 address = FUNCTION_ADDRESS + offset;
+    WriteInstruction(address, Branch(address, FUNCTION_ADDRESS + target_offset));
+  }
+
+  // Returns the addresses of the instructions the analyzer put in the block
+  std::vector<u32> Analyze(PPCAnalyst::PPCAnalyzer& analyzer)
+  {
+    analyzer.Analyze(FUNCTION_ADDRESS, &m_block, &m_buffer, BLOCK_SIZE);
+    std::vector<u32> addresses;
+    for (u32 i = 0; i < m_block.m_num_instructions; ++i)
+      addresses.push_back(m_buffer.codebuffer[i].address);
+    return addresses;
+  }
+
+  std::vector<u8> m_ram;
+  PPCAnalyst::CodeBlock m_block;
+  PPCAnalyst::BlockStats m_stats;
+  PPCAnalyst::BlockRegStats m_gpa;
+  PPCAnalyst::BlockRegStats m_fpa;
+  PPCAnalyst::CodeBuffer m_buffer{BLOCK_SIZE};
+};
+}  // namespace
+
+TEST_F(PPCAnalystTest, TraceFollowsJumpsWithinTheFunction)
+{
+  WriteJump(0x04, 0x30);
+  g_symbolDB.AddKnownSymbol(FUNCTION_ADDRESS, FUNCTION_SIZE, "function");
+
+  PPCAnalyst::PPCAnalyzer analyzer;
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  const std::vector<u32> expected{FUNCTION_ADDRESS, FUNCTION_ADDRESS + 0x04,
+                                  FUNCTION_ADDRESS + 0x30, FUNCTION_ADDRESS + 0x34,
+                                  FUNCTION_ADDRESS + 0x38, FUNCTION_ADDRESS + 0x3C};
+  EXPECT_EQ(expected, Analyze(analyzer));
+}
+
+TEST_F(PPCAnalystTest, TraceIsANoOpWithoutASymbol)
+{
+  WriteJump(0x04, 0x30);
+
+  PPCAnalyst::PPCAnalyzer analyzer;
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  const std::vector<u32> expected{FUNCTION_ADDRESS, FUNCTION_ADDRESS + 0x04};
+  EXPECT_EQ(expected, Analyze(analyzer));
+}
+
+TEST_F(PPCAnalystTest, TraceDoesNotLeaveTheFunction)
+{
+  WriteJump(0x04, FUNCTION_SIZE);
+  g_symbolDB.AddKnownSymbol(FUNCTION_ADDRESS, FUNCTION_SIZE, "function");
+
+  PPCAnalyst::PPCAnalyzer analyzer;
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  const std::vector<u32> expected{FUNCTION_ADDRESS, FUNCTION_ADDRESS + 0x04};
+  EXPECT_EQ(expected, Analyze(analyzer));
+}
+
+TEST_F(PPCAnalystTest, TraceTakesOverAfterTheFollowLimit)
+{
+  // Three jumps forward, the first two of which are taken by the regular branch following
+  WriteJump(0x04, 0x10);
+  WriteJump(0x10, 0x20);
+  WriteJump(0x20, 0x38);
+  g_symbolDB.AddKnownSymbol(FUNCTION_ADDRESS, FUNCTION_SIZE, "function");
+
+  PPCAnalyst::PPCAnalyzer analyzer;
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+  const std::vector<u32> followed{FUNCTION_ADDRESS, FUNCTION_ADDRESS + 0x04,
+                                  FUNCTION_ADDRESS + 0x10, FUNCTION_ADDRESS + 0x20};
+  EXPECT_EQ(followed, Analyze(analyzer));
+
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  const std::vector<u32> traced{FUNCTION_ADDRESS,        FUNCTION_ADDRESS + 0x04,
+                                FUNCTION_ADDRESS + 0x10, FUNCTION_ADDRESS + 0x20,
+                                FUNCTION_ADDRESS + 0x38, FUNCTION_ADDRESS + 0x3C};
+  EXPECT_EQ(traced, Analyze(analyzer));
+}
+
+TEST_F(PPCAnalystTest, TraceDoesNotSaveFollowsForLaterJumps)
+{
+  // The jumps within the function use up the regular branch following, so there's nothing left
+  // for the jump out of it.
+  WriteJump(0x04, 0x10);
+  WriteJump(0x10, 0x20);
+  WriteJump(0x20, 0x100);
+  WriteInstruction(FUNCTION_ADDRESS + 0x100, BLR);
+  g_symbolDB.AddKnownSymbol(FUNCTION_ADDRESS, FUNCTION_SIZE, "function");
+
+  PPCAnalyst::PPCAnalyzer analyzer;
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  const std::vector<u32> expected{FUNCTION_ADDRESS, FUNCTION_ADDRESS + 0x04,
+                                  FUNCTION_ADDRESS + 0x10, FUNCTION_ADDRESS + 0x20};
+  EXPECT_EQ(expected, Analyze(analyzer));
+}
@@ -0,0 +1,180 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <functional>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/DeltaEncoder.h"
+#include "Core/Rewind.h"
+
+namespace
+{
+constexpr size_t STATE_SIZE = 64 * 1024;
+
+// Stands in for the emulated system, whose state is just a buffer here
+class RewindTest : public testing::Test
+{
+protected:
+  void SetUp() override { m_state = RandomData(STATE_SIZE); }
+  void TearDown() override { Rewind::Shutdown(); }
+
+  void Init(u32 interval, size_t memory_budget)
+  {
+    Rewind::Hooks hooks;
+    hooks.save_state = [this](std::vector<u8>& buffer) { buffer = m_state; };
+    hooks.load_state = [this](const Common::DeltaEncoder& keyframe,
+                              const std::vector<u8>& delta) {
+      return keyframe.Decode(delta, &m_state);
+    };
+    hooks.queue_host_job = [this](std::function<void()> job) { m_host_jobs.push_back(job); };
+    Rewind::Init(interval, memory_budget, std::move(hooks));
+  }
+
+  std::vector<u8> RandomData(size_t size)
+  {
+    std::vector<u8> data(size);
+    for (u8& byte : data)
+      byte = static_cast<u8>(m_rng());
+    return data;
+  }
+
+  // Runs a frame which changes a small part of the state, and returns the state at its end.
+  std::vector<u8> SmallFrame()
+  {
+    for (size_t i = 0; i < 16; ++i)
+      m_state[m_rng() % 256] ^= 0xFF;
+    return EndFrame();
+  }
+
+  // Runs a frame which changes the whole state, so its snapshot can't be stored as a delta.
+  std::vector<u8> BigFrame()
+  {
+    m_state = RandomData(STATE_SIZE);
+    return EndFrame();
+  }
+
+  std::vector<u8> EndFrame()
+  {
+    Rewind::FrameAdvanced();
+    for (const auto& job : m_host_jobs)
+      job();
+    m_host_jobs.clear();
+    Rewind::WaitForEncoding();
+    return m_state;
+  }
+
+  std::mt19937 m_rng{1234};
+  std::vector<u8> m_state;
+  std::vector<std::function<void()>> m_host_jobs;
+};
+}  // namespace
+
+TEST_F(RewindTest, StepsBackOneSnapshotAtATime)
+{
+  Init(1, 16 << 20);
+  std::vector<std::vector<u8>> frames;
+  for (int i = 0; i < 5; ++i)
+    frames.push_back(SmallFrame());
+  EXPECT_EQ(5u, Rewind::GetStats().num_snapshots);
+  EXPECT_EQ(1u, Rewind::GetStats().num_keyframes);
+
+  // The newest snapshot is of the current frame, so going back starts with the one before it.
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[3], m_state);
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[2], m_state);
+  EXPECT_EQ(3u, Rewind::GetStats().num_snapshots);
+
+  ASSERT_TRUE(Rewind::StepBack());
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[0], m_state);
+  EXPECT_FALSE(Rewind::StepBack());
+  EXPECT_EQ(frames[0], m_state);
+}
+
+TEST_F(RewindTest, SnapshotsAfterSteppingBackReplaceTheOldOnes)
+{
+  Init(1, 16 << 20);
+  const std::vector<u8> first = SmallFrame();
+  SmallFrame();
+  SmallFrame();
+
+  ASSERT_TRUE(Rewind::StepBack());
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(first, m_state);
+
+  const std::vector<u8> second = SmallFrame();
+  SmallFrame();
+  EXPECT_EQ(3u, Rewind::GetStats().num_snapshots);
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(second, m_state);
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(first, m_state);
+}
+
+TEST_F(RewindTest, OnlyEveryIntervalFramesIsCaptured)
+{
+  Init(3, 16 << 20);
+  std::vector<std::vector<u8>> frames;
+  for (int i = 0; i < 7; ++i)
+    frames.push_back(SmallFrame());
+  EXPECT_EQ(2u, Rewind::GetStats().num_snapshots);
+
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[5], m_state);
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[2], m_state);
+  EXPECT_FALSE(Rewind::StepBack());
+}
+
+TEST_F(RewindTest, OldestSnapshotsAreEvictedFromTheBudget)
+{
+  // Every snapshot is a keyframe of its own, and there is room for three of them.
+  Init(1, STATE_SIZE * 7 / 2);
+  std::vector<std::vector<u8>> frames;
+  for (int i = 0; i < 6; ++i)
+    frames.push_back(BigFrame());
+
+  const Rewind::Stats stats = Rewind::GetStats();
+  EXPECT_EQ(3u, stats.num_snapshots);
+  EXPECT_EQ(3u, stats.num_keyframes);
+  EXPECT_LE(stats.resident_bytes, STATE_SIZE * 7 / 2);
+
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[4], m_state);
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(frames[3], m_state);
+  EXPECT_FALSE(Rewind::StepBack());
+}
+
+TEST_F(RewindTest, LoadingAStateForgetsAllSnapshots)
+{
+  Init(1, 16 << 20);
+  SmallFrame();
+  SmallFrame();
+
+  Rewind::Reset();
+  EXPECT_EQ(0u, Rewind::GetStats().num_snapshots);
+  EXPECT_EQ(0u, Rewind::GetStats().resident_bytes);
+  EXPECT_FALSE(Rewind::StepBack());
+
+  const std::vector<u8> after_load = SmallFrame();
+  SmallFrame();
+  ASSERT_TRUE(Rewind::StepBack());
+  EXPECT_EQ(after_load, m_state);
+  EXPECT_FALSE(Rewind::StepBack());
+}
+
+TEST_F(RewindTest, NothingIsCapturedWhenDisabled)
+{
+  Init(0, 16 << 20);
+  EXPECT_FALSE(Rewind::IsEnabled());
+  SmallFrame();
+  EXPECT_TRUE(m_host_jobs.empty());
+  EXPECT_EQ(0u, Rewind::GetStats().num_snapshots);
+  EXPECT_FALSE(Rewind::StepBack());
+}
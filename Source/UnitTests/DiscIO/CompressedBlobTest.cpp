@@ -0,0 +1,94 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+
+namespace
+{
+constexpr int BLOCK_SIZE = 0x4000;
+
+class CompressedBlobTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_temp_dir = File::CreateTempDir();
+    m_iso_path = m_temp_dir + "/disc.iso";
+    m_gcz_path = m_temp_dir + "/disc.gcz";
+
+    // Half compressible, half random, and not a whole number of blocks
+    m_data.resize(200 * BLOCK_SIZE + 123);
+    for (size_t i = 0; i < m_data.size(); ++i)
+      m_data[i] = (i / BLOCK_SIZE) % 2 ? static_cast<u8>(m_rng()) : static_cast<u8>(i / 1000);
+    File::IOFile(m_iso_path, "wb").WriteBytes(m_data.data(), m_data.size());
+    const auto callback = [](const std::string&, float, void*) { return true; };
+    ASSERT_TRUE(DiscIO::CompressFileToBlob(m_iso_path, m_gcz_path, 0, BLOCK_SIZE, callback));
+  }
+
+  void TearDown() override
+  {
+    DiscIO::SetGCZCacheSize(32 << 20);
+    File::DeleteDirRecursively(m_temp_dir);
+  }
+
+  void ExpectRandomReadsMatch(DiscIO::BlobReader* reader, int count)
+  {
+    std::vector<u8> buffer;
+    for (int i = 0; i < count; ++i)
+    {
+      const u64 offset = m_rng() % m_data.size();
+      const u64 size = std::min<u64>(m_rng() % (3 * BLOCK_SIZE) + 1, m_data.size() - offset);
+      buffer.assign(size, 0);
+      ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+      ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), m_data.begin() + offset))
+          << "offset " << offset << ", size " << size;
+    }
+  }
+
+  std::mt19937 m_rng{42};
+  std::string m_temp_dir;
+  std::string m_iso_path;
+  std::string m_gcz_path;
+  std::vector<u8> m_data;
+};
+}  // namespace
+
+TEST_F(CompressedBlobTest, RandomReads)
+{
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_gcz_path);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(DiscIO::BlobType::GCZ, reader->GetBlobType());
+  EXPECT_EQ(m_data.size(), reader->GetDataSize());
+  ExpectRandomReadsMatch(reader.get(), 500);
+}
+
+TEST_F(CompressedBlobTest, RandomReadsWithEvictions)
+{
+  // Room for two chunks of blocks, out of 26
+  DiscIO::SetGCZCacheSize(2 * 8 * BLOCK_SIZE);
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_gcz_path);
+  ASSERT_NE(nullptr, reader);
+  ExpectRandomReadsMatch(reader.get(), 500);
+}
+
+TEST_F(CompressedBlobTest, ReadsPastTheEndFail)
+{
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_gcz_path);
+  ASSERT_NE(nullptr, reader);
+  u8 buffer[16];
+  EXPECT_FALSE(reader->Read(m_data.size() + BLOCK_SIZE, sizeof(buffer), buffer));
+  EXPECT_TRUE(reader->Read(m_data.size() - sizeof(buffer), sizeof(buffer), buffer));
+}
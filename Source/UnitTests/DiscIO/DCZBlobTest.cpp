@@ -0,0 +1,220 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Swap.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/DCZBlob.h"
+#include "DiscIO/VolumeWii.h"
+
+namespace
+{
+constexpr int BLOCK_SIZE = 0x8000;
+
+constexpr u64 PARTITION_OFFSET = 0x50000;
+constexpr u64 PARTITION_DATA_OFFSET = PARTITION_OFFSET + 0x20000;
+// One group of clusters, so that all of the H0 to H2 hashes are filled in.
+constexpr u64 NUM_CLUSTERS = 64;
+constexpr u32 CLUSTER_SIZE = DiscIO::VolumeWii::BLOCK_TOTAL_SIZE;
+constexpr u32 CLUSTER_HEADER_SIZE = DiscIO::VolumeWii::BLOCK_HEADER_SIZE;
+constexpr u32 CLUSTER_DATA_SIZE = DiscIO::VolumeWii::BLOCK_DATA_SIZE;
+
+class DCZBlobTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_temp_dir = File::CreateTempDir();
+    m_iso_path = m_temp_dir + "/disc.iso";
+    m_dcz_path = m_temp_dir + "/disc.dcz";
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  // Mostly compressible, with some random blocks which have to be stored uncompressed
+  void Fill(u8* data, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i)
+      data[i] = (i / BLOCK_SIZE) % 3 == 1 ? static_cast<u8>(m_rng()) : static_cast<u8>(i / 100);
+  }
+
+  void Convert(size_t size)
+  {
+    m_data.resize(size);
+    Fill(m_data.data(), m_data.size());
+    File::IOFile(m_iso_path, "wb").WriteBytes(m_data.data(), m_data.size());
+    ASSERT_TRUE(DiscIO::ConvertToDCZ(m_iso_path, m_dcz_path, BLOCK_SIZE));
+  }
+
+  void Write32(u64 offset, u32 value)
+  {
+    const u32 swapped = Common::swap32(value);
+    std::memcpy(&m_data[offset], &swapped, sizeof(swapped));
+  }
+
+  // Builds a Wii disc with a single partition whose clusters are hashed and encrypted like on
+  // real discs, followed by some unencrypted data.
+  void ConvertWii()
+  {
+    m_plaintext.resize(NUM_CLUSTERS * CLUSTER_DATA_SIZE);
+    Fill(m_plaintext.data(), m_plaintext.size());
+
+    m_data.assign(PARTITION_DATA_OFFSET + NUM_CLUSTERS * CLUSTER_SIZE + 3 * BLOCK_SIZE + 123, 0);
+    Fill(&m_data[PARTITION_DATA_OFFSET + NUM_CLUSTERS * CLUSTER_SIZE],
+         m_data.size() - PARTITION_DATA_OFFSET - NUM_CLUSTERS * CLUSTER_SIZE);
+    Write32(0x18, 0x5D1C9EA3);
+    Write32(0x40000, 1);
+    Write32(0x40004, 0x40020 >> 2);
+    Write32(0x40020, PARTITION_OFFSET >> 2);
+    Write32(0x40024, 0);
+
+    IOS::ES::Ticket ticket = {};
+    ticket.signature.type = static_cast<IOS::SignatureType>(Common::swap32(0x00010001));
+    for (u8& byte : ticket.title_key)
+      byte = static_cast<u8>(m_rng());
+    std::memcpy(&m_data[PARTITION_OFFSET], &ticket, sizeof(ticket));
+    Write32(PARTITION_OFFSET + 0x2b8, (PARTITION_DATA_OFFSET - PARTITION_OFFSET) >> 2);
+    Write32(PARTITION_OFFSET + 0x2bc, (NUM_CLUSTERS * CLUSTER_SIZE) >> 2);
+
+    std::vector<u8> ticket_bytes(sizeof(ticket));
+    std::memcpy(ticket_bytes.data(), &ticket, sizeof(ticket));
+    const std::array<u8, 16> title_key = IOS::ES::TicketReader(ticket_bytes).GetTitleKey();
+    const auto key = Common::AES::CreateContext(title_key.data(), Common::AES::Mode::Encrypt);
+
+    // H0: one hash per 0x400 bytes of data. H1: the H0 tables of the eight clusters of a
+    // subgroup. H2: the H1 tables of the eight subgroups of the group.
+    std::vector<std::array<u8, CLUSTER_HEADER_SIZE>> headers(NUM_CLUSTERS);
+    for (u64 i = 0; i < NUM_CLUSTERS; ++i)
+    {
+      headers[i].fill(0);
+      for (u32 j = 0; j < CLUSTER_DATA_SIZE / 0x400; ++j)
+      {
+        const auto h0 = Common::SHA1::CalculateDigest(
+            &m_plaintext[i * CLUSTER_DATA_SIZE + j * 0x400], 0x400);
+        std::copy(h0.begin(), h0.end(), headers[i].begin() + j * h0.size());
+      }
+    }
+    for (u64 i = 0; i < NUM_CLUSTERS; ++i)
+    {
+      const auto h1 = Common::SHA1::CalculateDigest(headers[i].data(), 0x26c);
+      for (u64 j = i / 8 * 8; j < i / 8 * 8 + 8; ++j)
+        std::copy(h1.begin(), h1.end(), headers[j].begin() + 0x280 + i % 8 * h1.size());
+    }
+    for (u64 i = 0; i < NUM_CLUSTERS; i += 8)
+    {
+      const auto h2 = Common::SHA1::CalculateDigest(headers[i].data() + 0x280, 0xa0);
+      for (u64 j = 0; j < NUM_CLUSTERS; ++j)
+        std::copy(h2.begin(), h2.end(), headers[j].begin() + 0x340 + i / 8 * h2.size());
+    }
+
+    for (u64 i = 0; i < NUM_CLUSTERS; ++i)
+    {
+      u8* cluster = &m_data[PARTITION_DATA_OFFSET + i * CLUSTER_SIZE];
+      u8 iv[16] = {};
+      key->Crypt(iv, headers[i].data(), cluster, CLUSTER_HEADER_SIZE);
+      std::memcpy(iv, cluster + 0x3d0, sizeof(iv));
+      key->Crypt(iv, &m_plaintext[i * CLUSTER_DATA_SIZE], cluster + CLUSTER_HEADER_SIZE,
+                 CLUSTER_DATA_SIZE);
+    }
+
+    File::IOFile(m_iso_path, "wb").WriteBytes(m_data.data(), m_data.size());
+    ASSERT_TRUE(DiscIO::ConvertToDCZ(m_iso_path, m_dcz_path, 4 * BLOCK_SIZE));
+  }
+
+  void ExpectRandomReadsMatch(DiscIO::BlobReader* reader, int count)
+  {
+    std::vector<u8> buffer;
+    for (int i = 0; i < count; ++i)
+    {
+      const u64 offset = m_rng() % m_data.size();
+      const u64 size = std::min<u64>(m_rng() % (5 * BLOCK_SIZE) + 1, m_data.size() - offset);
+      buffer.assign(size, 0);
+      ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+      ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), m_data.begin() + offset))
+          << "offset " << offset << ", size " << size;
+    }
+  }
+
+  std::mt19937 m_rng{7};
+  std::string m_temp_dir;
+  std::string m_iso_path;
+  std::string m_dcz_path;
+  std::vector<u8> m_data;
+  std::vector<u8> m_plaintext;
+};
+}  // namespace
+
+TEST_F(DCZBlobTest, RoundTripsRandomReads)
+{
+  Convert(40 * BLOCK_SIZE + 777);
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_dcz_path);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(DiscIO::BlobType::DCZ, reader->GetBlobType());
+  EXPECT_EQ(m_data.size(), reader->GetDataSize());
+  EXPECT_LT(reader->GetRawSize(), m_data.size());
+  EXPECT_FALSE(reader->SupportsReadWiiDecrypted());
+  ExpectRandomReadsMatch(reader.get(), 300);
+}
+
+TEST_F(DCZBlobTest, RoundTripsWholeDisc)
+{
+  Convert(7 * BLOCK_SIZE);
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_dcz_path);
+  ASSERT_NE(nullptr, reader);
+  std::vector<u8> buffer(m_data.size());
+  ASSERT_TRUE(reader->Read(0, buffer.size(), buffer.data()));
+  EXPECT_EQ(m_data, buffer);
+  EXPECT_FALSE(reader->Read(m_data.size() - 1, 2, buffer.data()));
+}
+
+TEST_F(DCZBlobTest, DCZFilesAreNotConvertedAgain)
+{
+  Convert(3 * BLOCK_SIZE);
+  EXPECT_FALSE(DiscIO::ConvertToDCZ(m_dcz_path, m_temp_dir + "/again.dcz", BLOCK_SIZE));
+  EXPECT_FALSE(File::Exists(m_temp_dir + "/again.dcz"));
+}
+
+TEST_F(DCZBlobTest, RoundTripsWiiPartitions)
+{
+  ConvertWii();
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(m_dcz_path);
+  ASSERT_NE(nullptr, reader);
+  ASSERT_TRUE(reader->SupportsReadWiiDecrypted());
+  // Only possible if the partition was stored decrypted
+  EXPECT_LT(reader->GetRawSize(), m_data.size() / 2);
+
+  std::vector<u8> buffer(m_data.size());
+  ASSERT_TRUE(reader->Read(0, buffer.size(), buffer.data()));
+  EXPECT_EQ(m_data, buffer);
+  ExpectRandomReadsMatch(reader.get(), 300);
+
+  buffer.resize(m_plaintext.size());
+  ASSERT_TRUE(reader->ReadWiiDecrypted(0, buffer.size(), buffer.data(), PARTITION_OFFSET));
+  EXPECT_EQ(m_plaintext, buffer);
+  for (int i = 0; i < 100; ++i)
+  {
+    const u64 offset = m_rng() % m_plaintext.size();
+    const u64 size = std::min<u64>(m_rng() % (3 * CLUSTER_SIZE) + 1, m_plaintext.size() - offset);
+    buffer.assign(size, 0);
+    ASSERT_TRUE(reader->ReadWiiDecrypted(offset, size, buffer.data(), PARTITION_OFFSET));
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), m_plaintext.begin() + offset))
+        << "offset " << offset << ", size " << size;
+  }
+  EXPECT_FALSE(reader->ReadWiiDecrypted(0, 1, buffer.data(), PARTITION_OFFSET + CLUSTER_SIZE));
+}
@@ -0,0 +1,188 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <mbedtls/aes.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Common/Timer.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeWii.h"
+
+namespace
+{
+constexpr u64 PARTITION_OFFSET = 0x50000;
+constexpr u64 DATA_OFFSET = PARTITION_OFFSET + 0x20000;
+constexpr u64 NUM_BLOCKS = 512;
+constexpr u64 PARTITION_DATA_SIZE = NUM_BLOCKS * DiscIO::VolumeWii::BLOCK_DATA_SIZE;
+
+class MemoryBlobReader final : public DiscIO::BlobReader
+{
+public:
+  explicit MemoryBlobReader(const std::vector<u8>* data) : m_data(data) {}
+  DiscIO::BlobType GetBlobType() const override { return DiscIO::BlobType::PLAIN; }
+  u64 GetRawSize() const override { return m_data->size(); }
+  u64 GetDataSize() const override { return m_data->size(); }
+  bool Read(u64 offset, u64 size, u8* out_ptr) override
+  {
+    if (offset + size > m_data->size())
+      return false;
+    std::memcpy(out_ptr, m_data->data() + offset, size);
+    m_num_reads++;
+    return true;
+  }
+
+  size_t m_num_reads = 0;
+
+private:
+  const std::vector<u8>* m_data;
+};
+
+void Write32(std::vector<u8>* data, u64 offset, u32 value)
+{
+  value = Common::swap32(value);
+  std::memcpy(data->data() + offset, &value, sizeof(value));
+}
+
+// Builds a disc with one partition, and returns the data in the partition in plaintext.
+std::vector<u8> BuildDisc(std::vector<u8>* disc)
+{
+  constexpr u32 header_size = DiscIO::VolumeWii::BLOCK_HEADER_SIZE;
+  constexpr u32 block_size = DiscIO::VolumeWii::BLOCK_TOTAL_SIZE;
+  constexpr u32 block_data_size = DiscIO::VolumeWii::BLOCK_DATA_SIZE;
+
+  std::mt19937 rng(0);
+  disc->assign(DATA_OFFSET + NUM_BLOCKS * block_size, 0);
+  Write32(disc, 0x18, 0x5D1C9EA3);
+  Write32(disc, 0x40000, 1);
+  Write32(disc, 0x40004, 0x40020 >> 2);
+  Write32(disc, 0x40020, PARTITION_OFFSET >> 2);
+
+  IOS::ES::Ticket ticket{};
+  ticket.signature.type = static_cast<IOS::SignatureType>(
+      Common::swap32(static_cast<u32>(IOS::SignatureType::RSA2048)));
+  for (u8& byte : ticket.title_key)
+    byte = static_cast<u8>(rng());
+  std::memcpy(disc->data() + PARTITION_OFFSET, &ticket, sizeof(ticket));
+  Write32(disc, PARTITION_OFFSET + 0x2b8, (DATA_OFFSET - PARTITION_OFFSET) >> 2);
+  Write32(disc, PARTITION_OFFSET + 0x2bc, (NUM_BLOCKS * block_size) >> 2);
+
+  std::vector<u8> ticket_bytes(sizeof(ticket));
+  std::memcpy(ticket_bytes.data(), &ticket, sizeof(ticket));
+  const std::array<u8, 16> key = IOS::ES::TicketReader(std::move(ticket_bytes)).GetTitleKey();
+  mbedtls_aes_context aes_context;
+  mbedtls_aes_setkey_enc(&aes_context, key.data(), 128);
+
+  std::vector<u8> plaintext(PARTITION_DATA_SIZE);
+  for (u8& byte : plaintext)
+    byte = static_cast<u8>(rng());
+
+  for (u64 i = 0; i < NUM_BLOCKS; ++i)
+  {
+    u8* block = disc->data() + DATA_OFFSET + i * block_size;
+    for (u32 j = 0; j < header_size; ++j)
+      block[j] = static_cast<u8>(rng());
+
+    u8 iv[16];
+    std::memcpy(iv, block + 0x3D0, sizeof(iv));
+    mbedtls_aes_crypt_cbc(&aes_context, MBEDTLS_AES_ENCRYPT, block_data_size, iv,
+                          &plaintext[i * block_data_size], block + header_size);
+  }
+
+  return plaintext;
+}
+}  // Anonymous namespace
+
+class VolumeWiiTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_plaintext = BuildDisc(&m_disc);
+    auto reader = std::make_unique<MemoryBlobReader>(&m_disc);
+    m_reader = reader.get();
+    m_volume = std::make_unique<DiscIO::VolumeWii>(std::move(reader));
+    const std::vector<DiscIO::Partition> partitions = m_volume->GetPartitions();
+    ASSERT_EQ(1u, partitions.size());
+    m_partition = partitions[0];
+  }
+
+  std::vector<u8> m_disc;
+  std::vector<u8> m_plaintext;
+  MemoryBlobReader* m_reader;
+  std::unique_ptr<DiscIO::VolumeWii> m_volume;
+  DiscIO::Partition m_partition;
+};
+
+TEST_F(VolumeWiiTest, RandomReads)
+{
+  std::mt19937 rng(1);
+  std::vector<u8> buffer;
+  for (int i = 0; i < 2000; ++i)
+  {
+    const u64 offset = rng() % PARTITION_DATA_SIZE;
+    // Mostly small reads, with some spanning many blocks.
+    const u64 max_size = i % 10 == 0 ? 0x100000 : 0x100;
+    const u64 size = std::min<u64>(rng() % max_size + 1, PARTITION_DATA_SIZE - offset);
+    buffer.resize(size);
+    ASSERT_TRUE(m_volume->Read(offset, size, buffer.data(), m_partition));
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), m_plaintext.begin() + offset))
+        << "offset " << offset << ", size " << size;
+  }
+
+  EXPECT_FALSE(m_volume->Read(PARTITION_DATA_SIZE, 1, buffer.data(), m_partition));
+}
+
+TEST_F(VolumeWiiTest, RepeatedReadsAreCached)
+{
+  constexpr u32 block_data_size = DiscIO::VolumeWii::BLOCK_DATA_SIZE;
+  u8 buffer[0x20];
+  m_reader->m_num_reads = 0;
+
+  // Reads straddling two blocks, going back and forth between them.
+  for (int i = 0; i < 10; ++i)
+  {
+    ASSERT_TRUE(m_volume->Read(block_data_size - 0x10, 0x20, buffer, m_partition));
+    ASSERT_TRUE(m_volume->Read(0, 0x20, buffer, m_partition));
+  }
+  EXPECT_EQ(2u, m_reader->m_num_reads);
+
+  // Many blocks in one read only cause a few reads from the blob.
+  std::vector<u8> large(block_data_size * 64);
+  m_reader->m_num_reads = 0;
+  ASSERT_TRUE(m_volume->Read(block_data_size * 100, large.size(), large.data(), m_partition));
+  EXPECT_EQ(4u, m_reader->m_num_reads);
+}
+
+TEST_F(VolumeWiiTest, Throughput)
+{
+  std::vector<u8> buffer(0x8000);
+  u64 bytes_read = 0;
+  const u64 start = Common::Timer::GetTimeUs();
+
+  // Sequential reads of 32 KiB, as done by the DVD thread. These don't line up with blocks.
+  for (int pass = 0; pass < 4; ++pass)
+  {
+    for (u64 offset = 0; offset + buffer.size() <= PARTITION_DATA_SIZE; offset += buffer.size())
+    {
+      ASSERT_TRUE(m_volume->Read(offset, buffer.size(), buffer.data(), m_partition));
+      bytes_read += buffer.size();
+    }
+  }
+
+  const u64 elapsed_us = std::max<u64>(Common::Timer::GetTimeUs() - start, 1);
+  std::cout << "Decrypted " << bytes_read / (1024 * 1024) << " MiB at "
+            << bytes_read / elapsed_us << " MB/s" << std::endl;
+}
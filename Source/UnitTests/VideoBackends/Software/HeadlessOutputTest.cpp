@@ -0,0 +1,44 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "VideoBackends/Software/SWHeadlessOutput.h"
+
+TEST(SWHeadlessOutput, KeepsLastFrame)
+{
+  SWHeadlessOutput output;
+  const u64 start_count = SWHeadlessOutput::GetFrameCount();
+
+  // 2x2 pixels, with a padded stride
+  const int stride = 12;
+  std::vector<u8> image(stride * 2);
+  for (size_t i = 0; i < image.size(); ++i)
+    image[i] = static_cast<u8>(i);
+
+  int calls = 0;
+  SWHeadlessOutput::SetFrameCallback([&](const u8* data, int callback_stride, int width,
+                                         int height) {
+    ++calls;
+    EXPECT_EQ(image.data(), data);
+    EXPECT_EQ(stride, callback_stride);
+    EXPECT_EQ(2, width);
+    EXPECT_EQ(2, height);
+  });
+  output.ShowImage(image.data(), stride, 2, 2, 1.0f);
+  SWHeadlessOutput::SetFrameCallback(nullptr);
+
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(start_count + 1, SWHeadlessOutput::GetFrameCount());
+
+  std::vector<u8> frame;
+  int width, height;
+  ASSERT_TRUE(SWHeadlessOutput::GetLastFrame(&frame, &width, &height));
+  EXPECT_EQ(2, width);
+  EXPECT_EQ(2, height);
+  const std::vector<u8> expected = {0,  1,  2,  3,  4,  5,  6,  7,
+                                    12, 13, 14, 15, 16, 17, 18, 19};
+  EXPECT_EQ(expected, frame);
+}
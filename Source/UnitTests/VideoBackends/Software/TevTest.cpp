@@ -0,0 +1,261 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/BoundingBox.h"
+#include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/VideoConfig.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace
+{
+constexpr size_t EFB_PLANE_SIZE = EFB_WIDTH * EFB_HEIGHT * 3;
+
+class SoftwareTevTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_had_sse41 = cpu_info.bSSE4_1;
+    m_had_avx2 = cpu_info.bAVX2;
+
+    g_ActiveConfig.iSWRasterizerThreads = 1;
+    g_ActiveConfig.bZComploc = true;
+
+    std::memset(&bpmem, 0, sizeof(bpmem));
+    bpmem.genMode.numcolchans = 2;
+    bpmem.scissorOffset.x = 171;
+    bpmem.scissorOffset.y = 171;
+    bpmem.scissorTL.x = 342;
+    bpmem.scissorTL.y = 342;
+    bpmem.scissorBR.x = 981;
+    bpmem.scissorBR.y = 869;
+    bpmem.zmode.testenable = 1;
+    bpmem.zmode.updateenable = 1;
+    bpmem.zmode.func = ZMode::LEQUAL;
+    bpmem.blendmode.colorupdate = 1;
+    bpmem.blendmode.alphaupdate = 1;
+
+    Rasterizer::Init();
+  }
+
+  void TearDown() override
+  {
+    Rasterizer::Shutdown();
+    cpu_info.bSSE4_1 = m_had_sse41;
+    cpu_info.bAVX2 = m_had_avx2;
+  }
+
+  // Picks a random TEV configuration. Textures are left disabled, since they would need
+  // emulated memory.
+  static void RandomizeTev(std::mt19937* rng)
+  {
+    bpmem.genMode.numtevstages = (*rng)() % 4;
+    for (int i = 0; i < 16; ++i)
+    {
+      // Mostly clamp, so that the output isn't saturated after a few stages
+      bpmem.combiners[i].colorC.hex = (*rng)();
+      bpmem.combiners[i].colorC.clamp = (*rng)() % 4 != 0;
+      bpmem.combiners[i].alphaC.hex = (*rng)();
+      bpmem.combiners[i].alphaC.clamp = (*rng)() % 4 != 0;
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+      bpmem.tevorders[i].hex = (*rng)();
+      bpmem.tevorders[i].enable0 = 0;
+      bpmem.tevorders[i].enable1 = 0;
+      bpmem.tevksel[i].hex = (*rng)();
+    }
+    static constexpr PEControl::PixelFormat formats[] = {
+        PEControl::RGB8_Z24, PEControl::RGBA6_Z24, PEControl::Z24, PEControl::RGB565_Z16};
+    bpmem.zcontrol.pixel_format = formats[(*rng)() % 4];
+
+    bpmem.zmode.func = static_cast<ZMode::CompareMode>((*rng)() % 8);
+    bpmem.zmode.updateenable = (*rng)() % 4 != 0;
+    bpmem.blendmode.hex = (*rng)();
+    bpmem.blendmode.colorupdate = (*rng)() % 4 != 0;
+    bpmem.dstalpha.hex = (*rng)();
+    bpmem.ztex1.hex = (*rng)();
+    bpmem.ztex2.hex = ((*rng)() % 2 == 0) ? (*rng)() : 0;
+
+    // Keep the fog parameters in a range where the fog isn't always fully on or off
+    bpmem.fog.a.hex = (*rng)();
+    bpmem.fog.a.exponent = 120 + (*rng)() % 10;
+    bpmem.fog.b_magnitude = (*rng)() % 0x1000000;
+    bpmem.fog.b_shift = (*rng)() % 32;
+    bpmem.fog.c_proj_fsel.hex = (*rng)();
+    bpmem.fog.c_proj_fsel.c_exp = 120 + (*rng)() % 10;
+    bpmem.fog.color.hex = (*rng)();
+    bpmem.fogRange.Base.hex = (*rng)();
+    for (FogRangeKElement& k : bpmem.fogRange.K)
+      k.HEX = (*rng)();
+    xfmem.viewport.wd = 320.0f;
+
+    // A random alpha test would reject most pixels, so only use one every few tries
+    bpmem.alpha_test.hex = (*rng)();
+    if ((*rng)() % 4 != 0)
+    {
+      bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+      bpmem.alpha_test.logic = 1;  // or
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int comp = 0; comp < 4; ++comp)
+      {
+        PixelShaderManager::constants.colors[i][comp] = static_cast<int>((*rng)() % 320) - 32;
+        Rasterizer::SetTevReg(i, comp, static_cast<s16>((*rng)() % 320) - 32);
+      }
+    }
+  }
+
+  // Draws the same random triangles with the current configuration, and returns the EFB.
+  static std::vector<u8> DrawTriangles(u32 seed, int num_triangles, double* seconds)
+  {
+    std::memset(EfbInterface::GetPixelPointer(0, 0, false), 0, EFB_PLANE_SIZE);
+    std::memset(EfbInterface::GetPixelPointer(0, 0, true), 0xff, EFB_PLANE_SIZE);
+    BoundingBox::coords[BoundingBox::LEFT] = 0xffff;
+    BoundingBox::coords[BoundingBox::RIGHT] = 0;
+    BoundingBox::coords[BoundingBox::TOP] = 0xffff;
+    BoundingBox::coords[BoundingBox::BOTTOM] = 0;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-20.0f, 660.0f);
+    std::uniform_real_distribution<float> depth(0.0f, 16777215.0f);
+    std::uniform_real_distribution<float> size(2.0f, 200.0f);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_triangles; ++i)
+    {
+      OutputVertexData vertices[3];
+      const float center_x = position(rng);
+      const float center_y = position(rng) * 0.8f;
+      const float triangle_size = size(rng);
+      for (OutputVertexData& vertex : vertices)
+      {
+        vertex.screenPosition = Vec3(center_x + (rng() % 1000 / 1000.0f - 0.5f) * triangle_size,
+                                     center_y + (rng() % 1000 / 1000.0f - 0.5f) * triangle_size,
+                                     depth(rng));
+        vertex.projectedPosition.w = 1.0f;
+        for (auto& color : vertex.color)
+        {
+          for (u8& comp : color)
+            comp = rng() & 0xff;
+        }
+      }
+      Rasterizer::DrawTriangleFrontFace(&vertices[0], &vertices[1], &vertices[2]);
+    }
+    Rasterizer::Flush();
+    if (seconds)
+      *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const u8* efb = EfbInterface::GetPixelPointer(0, 0, false);
+    return std::vector<u8>(efb, efb + EFB_PLANE_SIZE * 2);
+  }
+
+  bool m_had_sse41;
+  bool m_had_avx2;
+};
+}  // namespace
+
+TEST_F(SoftwareTevTest, SIMDMatchesScalar)
+{
+  if (!m_had_sse41)
+    return;
+
+  for (u32 seed = 1; seed <= 100; ++seed)
+  {
+    std::mt19937 rng(seed);
+    RandomizeTev(&rng);
+
+    cpu_info.bSSE4_1 = false;
+    const std::vector<u8> scalar = DrawTriangles(seed, 50, nullptr);
+    const std::vector<u16> scalar_bbox(BoundingBox::coords, BoundingBox::coords + 4);
+
+    cpu_info.bSSE4_1 = true;
+    cpu_info.bAVX2 = false;
+    const std::vector<u8> simd = DrawTriangles(seed, 50, nullptr);
+    const std::vector<u16> simd_bbox(BoundingBox::coords, BoundingBox::coords + 4);
+
+    EXPECT_TRUE(scalar == simd) << "seed " << seed;
+    EXPECT_EQ(scalar_bbox, simd_bbox) << "seed " << seed;
+
+    if (!m_had_avx2)
+      continue;
+
+    cpu_info.bAVX2 = true;
+    const std::vector<u8> avx2 = DrawTriangles(seed, 50, nullptr);
+    const std::vector<u16> avx2_bbox(BoundingBox::coords, BoundingBox::coords + 4);
+
+    EXPECT_TRUE(scalar == avx2) << "seed " << seed;
+    EXPECT_EQ(scalar_bbox, avx2_bbox) << "seed " << seed;
+  }
+}
+
+TEST_F(SoftwareTevTest, ThreadsMatchSingleThread)
+{
+  for (u32 seed = 1; seed <= 50; ++seed)
+  {
+    std::mt19937 rng(seed);
+    RandomizeTev(&rng);
+
+    // The thread count changes at the end of a batch
+    g_ActiveConfig.iSWRasterizerThreads = 1;
+    Rasterizer::Flush();
+    const std::vector<u8> serial = DrawTriangles(seed, 200, nullptr);
+    const std::vector<u16> serial_bbox(BoundingBox::coords, BoundingBox::coords + 4);
+
+    g_ActiveConfig.iSWRasterizerThreads = 4;
+    Rasterizer::Flush();
+    const std::vector<u8> threaded = DrawTriangles(seed, 200, nullptr);
+    const std::vector<u16> threaded_bbox(BoundingBox::coords, BoundingBox::coords + 4);
+
+    EXPECT_TRUE(serial == threaded) << "seed " << seed;
+    EXPECT_EQ(serial_bbox, threaded_bbox) << "seed " << seed;
+  }
+}
+
+TEST_F(SoftwareTevTest, Throughput)
+{
+  std::mt19937 rng(0);
+  RandomizeTev(&rng);
+  bpmem.genMode.numtevstages = 7;
+  bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+  bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+  bpmem.zmode.func = ZMode::ALWAYS;
+
+  bpmem.zmode.updateenable = 1;
+  bpmem.blendmode.blendenable = 1;
+  bpmem.blendmode.srcfactor = BlendMode::SRCALPHA;
+  bpmem.blendmode.dstfactor = BlendMode::INVSRCALPHA;
+
+  const struct
+  {
+    const char* name;
+    bool sse41;
+    bool avx2;
+  } modes[] = {{"Scalar", false, false}, {"SSE4.1", true, false}, {"AVX2", true, true}};
+  for (const auto& mode : modes)
+  {
+    if ((mode.sse41 && !m_had_sse41) || (mode.avx2 && !m_had_avx2))
+      break;
+
+    cpu_info.bSSE4_1 = mode.sse41;
+    cpu_info.bAVX2 = mode.avx2;
+    double seconds;
+    DrawTriangles(0, 2000, &seconds);
+    std::printf("%s: %.1f ms for 2000 triangles\n", mode.name, seconds * 1000);
+  }
+}
@@ -0,0 +1,83 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "VideoCommon/Statistics.h"
+
+namespace
+{
+class StatisticsTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    stats.ResetFrame();
+    Statistics::SetFrameCallback(
+        [this](const Statistics::ThisFrame& frame) { m_frames.push_back(frame); });
+  }
+
+  void TearDown() override
+  {
+    Statistics::SetFrameCallback(nullptr);
+    Statistics::EnableTimings(false);
+  }
+
+  std::vector<Statistics::ThisFrame> m_frames;
+};
+}  // namespace
+
+TEST_F(StatisticsTest, FrameCallbackGetsFinishedFrame)
+{
+  INCSTAT(stats.thisFrame.numPixelShadersGenerated);
+  INCSTAT(stats.thisFrame.numPixelShadersGenerated);
+  stats.ResetFrame();
+  INCSTAT(stats.thisFrame.numVertexShadersGenerated);
+  stats.ResetFrame();
+
+  ASSERT_EQ(2u, m_frames.size());
+  EXPECT_EQ(2, m_frames[0].numPixelShadersGenerated);
+  EXPECT_EQ(0, m_frames[0].numVertexShadersGenerated);
+  EXPECT_EQ(0, m_frames[1].numPixelShadersGenerated);
+  EXPECT_EQ(1, m_frames[1].numVertexShadersGenerated);
+}
+
+TEST_F(StatisticsTest, TimingsOnlyCollectedWhenEnabled)
+{
+  {
+    ScopedStatTimer timer(&stats.thisFrame.vertexLoaderTimeNs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stats.BeginGPUTime();
+  stats.EndGPUTime();
+  EXPECT_EQ(0u, stats.thisFrame.vertexLoaderTimeNs);
+  EXPECT_EQ(0u, stats.thisFrame.gpuTimeNs);
+
+  Statistics::EnableTimings(true);
+  {
+    ScopedStatTimer timer(&stats.thisFrame.vertexLoaderTimeNs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GE(stats.thisFrame.vertexLoaderTimeNs, 1000000u);
+}
+
+TEST_F(StatisticsTest, GPUTimeIsSplitAtFrameEnd)
+{
+  Statistics::EnableTimings(true);
+
+  // A swap in the middle of a run of commands ends the frame
+  stats.BeginGPUTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  stats.ResetFrame();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  stats.EndGPUTime();
+  stats.ResetFrame();
+
+  ASSERT_EQ(2u, m_frames.size());
+  EXPECT_GE(m_frames[0].gpuTimeNs, 5000000u);
+  EXPECT_GE(m_frames[1].gpuTimeNs, 5000000u);
+}
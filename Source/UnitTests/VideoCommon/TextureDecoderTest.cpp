@@ -0,0 +1,67 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+constexpr TextureFormat FORMATS[] = {TextureFormat::I4,     TextureFormat::I8,
+                                     TextureFormat::IA4,    TextureFormat::IA8,
+                                     TextureFormat::RGB565, TextureFormat::RGB5A3,
+                                     TextureFormat::RGBA8,  TextureFormat::C4,
+                                     TextureFormat::C8,     TextureFormat::C14X2,
+                                     TextureFormat::CMPR};
+
+class TextureDecoderTest : public testing::TestWithParam<bool>
+{
+protected:
+  void SetUp() override
+  {
+    std::mt19937 rng(42);
+    for (u8& byte : m_src)
+      byte = static_cast<u8>(rng());
+    for (u8& byte : m_tlut)
+      byte = static_cast<u8>(rng());
+
+    TexDecoder_SetTexFmtOverlayOptions(GetParam(), true);
+  }
+
+  void TearDown() override { TexDecoder_SetTexFmtOverlayOptions(false, false); }
+
+  // Large enough for a 64x64 RGBA8 texture and a full C14X2 palette
+  std::vector<u8> m_src = std::vector<u8>(64 * 64 * 4);
+  std::vector<u8> m_tlut = std::vector<u8>(0x4000 * 2);
+};
+}  // namespace
+
+TEST_P(TextureDecoderTest, RowsMatchWholeTexture)
+{
+  constexpr int WIDTH = 64;
+  constexpr int HEIGHT = 64;
+
+  for (TextureFormat format : FORMATS)
+  {
+    const int block_height = TexDecoder_GetBlockHeightInTexels(format);
+    std::vector<u8> expected(WIDTH * HEIGHT * 4);
+    TexDecoder_Decode(expected.data(), m_src.data(), WIDTH, HEIGHT, format, m_tlut.data(),
+                      TLUTFormat::RGB5A3);
+
+    // Decode one block row at a time, in reverse, so no band can depend on the one before it
+    std::vector<u8> bands(WIDTH * HEIGHT * 4);
+    for (int row = HEIGHT - block_height; row >= 0; row -= block_height)
+    {
+      TexDecoder_DecodeRows(bands.data(), m_src.data(), WIDTH, HEIGHT, row, block_height, format,
+                            m_tlut.data(), TLUTFormat::RGB5A3);
+    }
+
+    EXPECT_EQ(expected, bands) << "format " << static_cast<int>(format);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(Overlay, TextureDecoderTest, testing::Bool());
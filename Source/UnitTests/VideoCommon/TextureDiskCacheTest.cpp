@@ -0,0 +1,163 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "VideoCommon/TextureDiskCache.h"
+
+namespace
+{
+class TextureDiskCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    SetHash64Function();
+    m_temp_dir = File::CreateTempDir();
+    m_path = m_temp_dir + "/Textures.cache";
+  }
+
+  void TearDown() override
+  {
+    m_cache.Close();
+    File::DeleteDirRecursively(m_temp_dir);
+  }
+
+  static TextureDiskCache::Key MakeKey(u64 hash)
+  {
+    return {hash, hash ^ 0x5555, 64, 32, 1, 0xE};
+  }
+
+  static std::vector<u8> MakeTexture(u8 seed)
+  {
+    std::vector<u8> data(64 * 32 * 4);
+    for (size_t i = 0; i < data.size(); ++i)
+      data[i] = static_cast<u8>(seed + i / 64);
+    return data;
+  }
+
+  std::string m_temp_dir;
+  std::string m_path;
+  TextureDiskCache m_cache;
+};
+}  // namespace
+
+TEST_F(TextureDiskCacheTest, TexturesAreReadInLaterSessions)
+{
+  const std::vector<u8> texture = MakeTexture(1);
+  std::vector<u8> decoded(texture.size());
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  m_cache.Append(MakeKey(1), texture.data(), texture.size());
+  // Only written by the next session
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  m_cache.Close();
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  ASSERT_TRUE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  EXPECT_EQ(texture, decoded);
+  EXPECT_FALSE(m_cache.Read(MakeKey(2), decoded.data(), decoded.size()));
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size() - 4));
+}
+
+TEST_F(TextureDiskCacheTest, TruncatedEntriesAreDropped)
+{
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  m_cache.Append(MakeKey(1), MakeTexture(1).data(), MakeTexture(1).size());
+  m_cache.Append(MakeKey(2), MakeTexture(2).data(), MakeTexture(2).size());
+  m_cache.Close();
+
+  u64 size;
+  {
+    File::IOFile file(m_path, "r+b");
+    size = file.GetSize();
+    ASSERT_TRUE(file.Resize(size - 1));
+  }
+
+  std::vector<u8> decoded(MakeTexture(1).size());
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  ASSERT_TRUE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  EXPECT_EQ(MakeTexture(1), decoded);
+  EXPECT_FALSE(m_cache.Read(MakeKey(2), decoded.data(), decoded.size()));
+
+  // The broken entry is overwritten
+  m_cache.Append(MakeKey(2), MakeTexture(2).data(), MakeTexture(2).size());
+  m_cache.Close();
+  EXPECT_EQ(size, File::GetSize(m_path));
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  ASSERT_TRUE(m_cache.Read(MakeKey(2), decoded.data(), decoded.size()));
+  EXPECT_EQ(MakeTexture(2), decoded);
+}
+
+TEST_F(TextureDiskCacheTest, InvalidFilesStartOver)
+{
+  ASSERT_TRUE(File::WriteStringToFile("DCAC not a texture cache", m_path));
+
+  std::vector<u8> decoded(MakeTexture(1).size());
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  m_cache.Append(MakeKey(1), MakeTexture(1).data(), MakeTexture(1).size());
+  m_cache.Close();
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  EXPECT_TRUE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+}
+
+TEST_F(TextureDiskCacheTest, FilesOfAnotherHashModeStartOver)
+{
+  std::vector<u8> decoded(MakeTexture(1).size());
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Incremental));
+  m_cache.Append(MakeKey(1), MakeTexture(1).data(), MakeTexture(1).size());
+  m_cache.Close();
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  m_cache.Close();
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Incremental));
+  EXPECT_FALSE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+}
+
+TEST_F(TextureDiskCacheTest, OversizedFilesKeepTheUsedAndNewestTextures)
+{
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  for (u8 i = 1; i <= 8; ++i)
+    m_cache.Append(MakeKey(i), MakeTexture(i).data(), MakeTexture(i).size());
+  m_cache.Close();
+
+  // Nothing is dropped while the file is within its limit
+  const u64 size = File::GetSize(m_path);
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full, size));
+  m_cache.Close(true);
+  EXPECT_EQ(size, File::GetSize(m_path));
+
+  // Nor when the cache is only closed for a config change
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full, size - 1));
+  m_cache.Close();
+  EXPECT_EQ(size, File::GetSize(m_path));
+
+  std::vector<u8> decoded(MakeTexture(1).size());
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full, size - 1));
+  ASSERT_TRUE(m_cache.Read(MakeKey(1), decoded.data(), decoded.size()));
+  m_cache.Append(MakeKey(9), MakeTexture(9).data(), MakeTexture(9).size());
+  m_cache.Close(true);
+  EXPECT_LE(File::GetSize(m_path), (size - 1) / 4 * 3);
+  EXPECT_FALSE(File::Exists(m_path + ".tmp"));
+
+  ASSERT_TRUE(m_cache.Open(m_path, TextureDiskCache::HashMode::Full));
+  for (u8 i : {1, 9, 8, 7})
+  {
+    ASSERT_TRUE(m_cache.Read(MakeKey(i), decoded.data(), decoded.size())) << int{i};
+    EXPECT_EQ(MakeTexture(i), decoded);
+  }
+  EXPECT_FALSE(m_cache.Read(MakeKey(2), decoded.data(), decoded.size()));
+}